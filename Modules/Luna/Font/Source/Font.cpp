@@ -18,6 +18,7 @@ namespace Luna
 		struct FontModule : public Module
 		{
 			virtual const c8* get_name() override { return "Font"; }
+			virtual bool supports_concurrent_init() override { return true; }
 			virtual RV on_init() override
 			{
 				register_boxed_type<FontFileTTF>();
@@ -283,6 +283,7 @@ namespace Luna
 		struct ImageModule : public Module
 		{
 			virtual const c8* get_name() override { return "Image"; }
+			virtual bool supports_concurrent_init() override { return true; }
 			virtual RV on_init() override
 			{
 				stbi_init();
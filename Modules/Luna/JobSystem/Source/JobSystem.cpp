@@ -363,6 +363,7 @@ namespace Luna
 		struct JobSystemModule : public Module
 		{
 			virtual const c8* get_name() override { return "JobSystem"; }
+			virtual bool supports_concurrent_init() override { return true; }
 			virtual RV on_init() override
 			{
 				return job_system_init();
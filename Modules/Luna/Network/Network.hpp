@@ -90,6 +90,12 @@ namespace Luna
 
 			//! Permits incoming connection attempt on this socket.
 			virtual R<Ref<ISocket>> accept(SocketAddress& address) = 0;
+
+			//! Shuts down sending and receiving on this socket, so that blocking calls on this socket 
+			//! from other threads return. Data already written is still sent to the peer.
+			//! @details Sockets that cannot be shut down on this platform, like listening sockets on some 
+			//! platforms, are closed instead. The socket cannot be used after this is called.
+			virtual RV shutdown() = 0;
 		};
 
 		enum class SocketType : u32
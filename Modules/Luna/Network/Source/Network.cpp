@@ -18,6 +18,7 @@ namespace Luna
         struct NetworkModule : public Module
         {
             virtual const c8* get_name() override { return "Network"; }
+            virtual bool supports_concurrent_init() override { return true; }
 			virtual RV on_init() override
 			{
 				return platform_init();
@@ -51,6 +51,7 @@ namespace Luna
             virtual RV listen(i32 len) override;
             virtual RV connect(const SocketAddress& address) override;
             virtual R<Ref<ISocket>> accept(SocketAddress& address) override;
+            virtual RV shutdown() override;
         };
 
         inline ErrCode translate_error(int err)
@@ -109,7 +110,7 @@ namespace Luna
 			{
 				sockaddr_in addr;
 				addr.sin_family = AF_INET;
-				addr.sin_port = address.ipv4.port;
+				addr.sin_port = hton(address.ipv4.port);
 				memcpy(&addr.sin_addr.s_addr, &address.ipv4.address, 4);
 				auto r = ::bind(m_socket, (sockaddr*)&addr, sizeof(addr));
 				if (r == -1)
@@ -135,7 +136,7 @@ namespace Luna
 			{
 				sockaddr_in addr;
 				addr.sin_family = AF_INET;
-				addr.sin_port = address.ipv4.port;
+				addr.sin_port = hton(address.ipv4.port);
 				memcpy(&addr.sin_addr.s_addr, &address.ipv4.address, 4);
 				int r = ::connect(m_socket, (sockaddr*)&addr, sizeof(addr));
 				if (r == -1)
@@ -158,14 +159,29 @@ namespace Luna
 				{
 					return translate_error(errno);
 				}
-				address.ipv4.port = addr.sin_port;
+				address.family = AddressFamily::ipv4;
+				address.ipv4.port = ntoh(addr.sin_port);
 				memcpy(&address.ipv4.address, & addr.sin_addr.s_addr, 4);
 				Ref<Socket> s = new_object<Socket>();
+				s->m_af = m_af;
 				s->m_socket = r;
 				return Ref<ISocket>(s);
 			}
 			return NetworkError::address_not_supported();
 		}
+        RV Socket::shutdown()
+        {
+            if(m_socket == -1) return ok;
+            if(::shutdown(m_socket, SHUT_RDWR) == -1)
+            {
+                int err = errno;
+                if(err != ENOTCONN) return translate_error(err);
+                // Listening sockets cannot be shut down on some platforms, closing the socket wakes up `accept`.
+                ::close(m_socket);
+                m_socket = -1;
+            }
+            return ok;
+        }
         RV platform_init()
 		{
 			register_boxed_type<Socket>();
@@ -192,7 +208,20 @@ namespace Luna
 		{
 			return ntohs(netshort);
 		}
-        LUNA_NETWORK_API R<Ref<ISocket>> new_socket(AddressFamily af, SocketType type)
+        inline int encode_protocol(Protocol protocol)
+        {
+            switch(protocol)
+            {
+                case Protocol::unspecified: return 0;
+                case Protocol::icmp: return IPPROTO_ICMP;
+                case Protocol::igmp: return IPPROTO_IGMP;
+                case Protocol::tcp: return IPPROTO_TCP;
+                case Protocol::udp: return IPPROTO_UDP;
+                case Protocol::icmpv6: return IPPROTO_ICMPV6;
+                default: lupanic(); return 0;
+            }
+        }
+        LUNA_NETWORK_API R<Ref<ISocket>> new_socket(AddressFamily af, SocketType type, Protocol protocol)
         {
             int iaf = 0;
 			int itype = 0;
@@ -216,7 +245,7 @@ namespace Luna
 				break;
 			default: lupanic(); break;
 			}
-            int r = ::socket(iaf, itype, 0);
+            int r = ::socket(iaf, itype, encode_protocol(protocol));
             if(r == -1)
             {
                 return translate_error(errno);
@@ -45,6 +45,7 @@ namespace Luna
 			virtual RV listen(i32 len) override;
 			virtual RV connect(const SocketAddress& address) override;
 			virtual R<Ref<ISocket>> accept(SocketAddress& address) override;
+			virtual RV shutdown() override;
 		};
 		inline ErrCode translate_error(int err)
 		{
@@ -184,6 +185,19 @@ namespace Luna
 			}
 			return NetworkError::address_not_supported();
 		}
+		RV Socket::shutdown()
+		{
+			if (m_socket == INVALID_SOCKET) return ok;
+			if (::shutdown(m_socket, SD_BOTH) == SOCKET_ERROR)
+			{
+				int err = WSAGetLastError();
+				if (err != WSAENOTCONN) return translate_error(err);
+				// Listening sockets cannot be shut down, closing the socket wakes up `accept`.
+				closesocket(m_socket);
+				m_socket = INVALID_SOCKET;
+			}
+			return ok;
+		}
 		RV platform_init()
 		{
 			register_boxed_type<Socket>();
@@ -144,6 +144,33 @@ namespace Luna
 	//! * `file` must be opened with @ref FileOpenFlag::read flag.
 	LUNA_RUNTIME_API R<Blob> load_file_data(IFile* file);
 
+	//! @interface IFileMapping
+	//! Represents one read-only memory mapping of one file. See @ref map_file for details.
+	struct IFileMapping : virtual Interface
+	{
+		luiid("{5d3ce42a-7a53-4f0a-9d4b-4b2d0c6f6a1e}");
+
+		//! Gets the mapped file data.
+		//! @return Returns one pointer to the mapped file data. The pointer is valid until the mapping object is released.
+		//! Returns `nullptr` if the file is empty.
+		virtual const void* get_data() = 0;
+
+		//! Gets the size of the mapped file data in bytes.
+		virtual usize get_size() = 0;
+	};
+
+	//! Maps the whole file to the virtual address space of the process for reading.
+	//! @details Pages of the file are loaded on demand by the system, and are shared by all mappings 
+	//! of the same file, so mapping one file is much cheaper than loading its data when the file is large 
+	//! or is used by multiple users.
+	//! @param[in] path The path of the file.
+	//! @return Returns the new file mapping object.
+	//! @par Possible Errors
+	//! * @ref BasicError::access_denied
+	//! * @ref BasicError::not_found
+	//! * @ref BasicError::bad_platform_call for all errors that cannot be identified.
+	LUNA_RUNTIME_API R<Ref<IFileMapping>> map_file(const c8* path);
+
 	//! Gets the file attribute.
 	//! @param[in] path The path of the file.
 	//! @return Returns the file attribute structure.
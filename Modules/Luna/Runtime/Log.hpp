@@ -107,6 +107,53 @@ namespace Luna
 	//! @param[in] args Arguments used to format the log message.
 	LUNA_RUNTIME_API void logv_error(const c8* tag, const c8* format, VarList args);
 
+	//! The state of one call site of @ref log_rate_limited.
+	//! @details This should be declared as one static variable at the call site, see @ref lulog_rate_limited.
+	struct LogRateLimiter
+	{
+		//! The ticks before which messages of this call site are suppressed.
+		volatile u64 next_log_ticks = 0;
+		//! The number of messages suppressed since the last message is emitted.
+		volatile u64 num_suppressed = 0;
+		//! The verbosity, tag and format of the call site, recorded when the first message is suppressed
+		//! so that suppressed messages can be reported by @ref flush_suppressed_logs.
+		LogVerbosity verbosity = LogVerbosity::info;
+		const c8* tag = nullptr;
+		const c8* format = nullptr;
+		//! The next call site in the list of call sites that have suppressed messages.
+		LogRateLimiter* next = nullptr;
+		//! 1 if this call site is added to the list of call sites that have suppressed messages.
+		volatile u32 registered = 0;
+	};
+
+	//! Logs one message at most once per interval for one call site.
+	//! @details Messages of the call site in the interval after one message is emitted are not formatted, 
+	//! only the number of such messages is counted. The count is appended to the next message emitted, so
+	//! messages emitted continuously are summarized once per interval. Messages suppressed after the last
+	//! emitted message are reported by @ref flush_suppressed_logs.
+	//! 
+	//! `limiter`, `tag` and `format` must be valid until the log system is closed, which is always true
+	//! when this is called by @ref lulog_rate_limited with string literals.
+	//! This function is thread-safe.
+	//! @param[in] limiter The state of the call site.
+	//! @param[in] interval The minimum interval between two messages in seconds. Specify a negative value
+	//! to emit the message only once.
+	//! @param[in] verbosity The log verbosity.
+	//! @param[in] tag The log tag. Used by the implementation to filter logs.
+	//! @param[in] format The log message format.
+	LUNA_RUNTIME_API void log_rate_limited(LogRateLimiter& limiter, f64 interval, LogVerbosity verbosity, const c8* tag, const c8* format, ...);
+
+	//! Reports the number of messages suppressed by @ref log_rate_limited for every call site whose
+	//! interval has passed since the last message is emitted.
+	//! @details This should be called periodically (like once per frame), so that messages suppressed
+	//! after the last emitted message are reported. All suppressed messages, including ones of call sites
+	//! with negative intervals, are reported when the log system is closed.
+	//! This function is thread-safe.
+	LUNA_RUNTIME_API void flush_suppressed_logs();
+
+//! Logs one message at most once per `_interval` seconds for this call site using @ref log_rate_limited.
+#define lulog_rate_limited(_interval, _verbosity, _tag, ...) do { static Luna::LogRateLimiter _luna_log_rate_limiter; Luna::log_rate_limited(_luna_log_rate_limiter, _interval, _verbosity, _tag, __VA_ARGS__); } while(false)
+
 	//! Registers one custom log handler that will be called when a new log message is spawned.
 	//! @param[in] handler The handler to register.
 	//! @return Returns one handler identifier that can be used to register the handler.
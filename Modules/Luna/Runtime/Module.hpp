@@ -11,6 +11,7 @@
 #pragma once
 #include "Base.hpp"
 #include "Result.hpp"
+#include "Span.hpp"
 
 #ifndef LUNA_RUNTIME_API
 #define LUNA_RUNTIME_API
@@ -42,6 +43,12 @@ namespace Luna
 		
 		//! Called when the module is closed.
 		virtual void on_close() {}
+
+		//! Whether `on_init` can be called on one worker thread by @ref init_modules, concurrently with `on_init` of 
+		//! other modules that this module does not depend on.
+		//! @details Modules that must be initialized on the main thread, or that access other modules in `on_init` 
+		//! without declaring them as dependencies, must return `false`, which is the default.
+		virtual bool supports_concurrent_init() { return false; }
 		
 		virtual ~Module() {}
 	};
@@ -128,7 +135,30 @@ namespace Luna
 	LUNA_RUNTIME_API RV init_module(Module* handle);
 
 	//! @brief Initializes all uninitialized modules.
+	//! @details Modules that support concurrent initialization (see @ref Module::supports_concurrent_init) are initialized 
+	//! on worker threads as soon as all their dependencies are initialized, while other modules are initialized on 
+	//! the calling thread. If one module fails to initialize, this function waits for modules that are being initialized
+	//! on worker threads and returns the error.
 	LUNA_RUNTIME_API RV init_modules();
+
+	//! The initialization time of one module.
+	struct ModuleInitTime
+	{
+		//! The initialized module.
+		Module* module;
+		//! The ticks when `Module::on_init` is called and when it returns, see @ref get_ticks.
+		u64 begin_ticks;
+		u64 end_ticks;
+		//! Whether `Module::on_init` is called on one worker thread.
+		bool on_worker_thread;
+	};
+
+	//! @brief Gets the initialization time of all initialized modules, sorted by their initialization order.
+	//! @details The initialization of every module also emits one @ref ProfilerEventId::MODULE_INIT_BEGIN and 
+	//! one @ref ProfilerEventId::MODULE_INIT_END profiler event on the thread that initializes the module.
+	//! @return Returns the initialization time of modules. The returned span is valid until more modules are
+	//! initialized or the module system is closed.
+	LUNA_RUNTIME_API Span<const ModuleInitTime> get_module_init_times();
 	
 	//! @}
 }
\ No newline at end of file
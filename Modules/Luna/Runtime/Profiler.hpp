@@ -22,6 +22,7 @@
 namespace Luna
 {
     struct IThread;
+    struct Module;
 
     //! @addtogroup Runtime
     //! @{
@@ -100,6 +101,10 @@ namespace Luna
         constexpr u64 SET_MEMORY_TYPE = strhash64("SET_MEMORY_TYPE");
         //! The set memory domain event ID.
         constexpr u64 SET_MEMORY_DOMAIN = strhash64("SET_MEMORY_DOMAIN");
+        //! The module initialization begin event ID.
+        constexpr u64 MODULE_INIT_BEGIN = strhash64("MODULE_INIT_BEGIN");
+        //! The module initialization end event ID.
+        constexpr u64 MODULE_INIT_END = strhash64("MODULE_INIT_END");
     }
     namespace ProfilerEventData
     {
@@ -152,6 +157,12 @@ namespace Luna
             //! so long as this structure is valid.
             const c8 domain[1];
         };
+        //! The module initialization begin and end event data.
+        struct ModuleInit
+        {
+            //! The module being initialized.
+            Module* module;
+        };
     }
 
 #ifdef LUNA_MEMORY_PROFILER_ENABLED
@@ -47,6 +47,19 @@ namespace Luna
 		lucatchret;
 		return ret;
 	}
+	LUNA_RUNTIME_API R<Ref<IFileMapping>> map_file(const c8* path)
+	{
+		Ref<IFileMapping> ret;
+		lutry
+		{
+			lulet(handle, OS::map_file(path));
+			auto mapping = new_object<FileMapping>();
+			mapping->m_handle = handle;
+			ret = mapping;
+		}
+		lucatchret;
+		return ret;
+	}
 	LUNA_RUNTIME_API R<FileAttribute> get_file_attribute(const c8* filename)
 	{
 		return OS::get_file_attribute(filename);
@@ -60,6 +60,31 @@ namespace Luna
 			OS::flush_file(m_file);
 		}
 	};
+	struct FileMapping : IFileMapping
+	{
+		lustruct("FileMapping", "{0b6a3c4e-2f1d-4a8b-9e57-6c8d1f2a3b49}");
+		luiimpl();
+
+		opaque_t m_handle;
+
+		FileMapping() :
+			m_handle(nullptr) {}
+		~FileMapping()
+		{
+			if (m_handle)
+			{
+				OS::unmap_file(m_handle);
+			}
+		}
+		virtual const void* get_data() override
+		{
+			return OS::get_file_mapping_data(m_handle);
+		}
+		virtual usize get_size() override
+		{
+			return OS::get_file_mapping_size(m_handle);
+		}
+	};
 	struct FileIterator : IFileIterator
 	{
 		lustruct("FileIterator", "{bd87c27c-34ed-4764-8417-6ef37c316ed3}");
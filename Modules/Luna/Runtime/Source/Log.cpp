@@ -13,6 +13,7 @@
 #include "../Mutex.hpp"
 #include "../File.hpp"
 #include "../Event.hpp"
+#include "../Atomic.hpp"
 #include "OS.hpp"
 
 namespace Luna
@@ -105,8 +106,10 @@ namespace Luna
 		g_filelog->filename = "./Log.txt";
 		register_log_handler(file_log);
 	}
+	static void report_suppressed_logs(bool all);
 	void log_close()
 	{
+		report_suppressed_logs(true);
 		flush_log_file();
 		memdelete(g_filelog);
 		g_log_callbacks.clear();
@@ -120,22 +123,102 @@ namespace Luna
 		va_end(args);
 	}
 	constexpr usize LOG_STACK_BUFFER_SIZE = 256;
-	LUNA_RUNTIME_API void logv(LogVerbosity verbosity, const c8* tag, const c8* format, VarList args)
+	//! Formats one log message to `buf`, or to one new heap buffer if `buf` is too small.
+	//! The returned buffer must be freed by `memfree` if it is not `buf`.
+	static c8* format_log_message(c8* buf, i32& len, const c8* format, VarList args)
 	{
-		c8 buf[LOG_STACK_BUFFER_SIZE];
-		c8* abuf = nullptr;
-		i32 len = vsnprintf(buf, LOG_STACK_BUFFER_SIZE, format, args);
-		if (len >= LOG_STACK_BUFFER_SIZE)
+		VarList args_copy;
+		va_copy(args_copy, args);
+		c8* r = buf;
+		len = vsnprintf(buf, LOG_STACK_BUFFER_SIZE, format, args);
+		if (len >= (i32)LOG_STACK_BUFFER_SIZE)
 		{
-			abuf = (c8*)memalloc(sizeof(c8) * (len + 1));
-			len = vsnprintf(abuf, len + 1, format, args);
+			r = (c8*)memalloc(sizeof(c8) * (len + 1));
+			len = vsnprintf(r, len + 1, format, args_copy);
 		}
-		c8* use_buf = abuf ? abuf : buf;
+		va_end(args_copy);
+		return r;
+	}
+	LUNA_RUNTIME_API void logv(LogVerbosity verbosity, const c8* tag, const c8* format, VarList args)
+	{
+		c8 buf[LOG_STACK_BUFFER_SIZE];
+		i32 len;
+		c8* use_buf = format_log_message(buf, len, format, args);
 		MutexGuard guard(g_log_mutex);
 		if(!tag) tag = "";
 		g_log_callbacks(verbosity, tag, strlen(tag), use_buf, len);
 		guard.unlock();
-		if (abuf) memfree(abuf);
+		if (use_buf != buf) memfree(use_buf);
+	}
+	//! The list of call sites of `log_rate_limited` that have suppressed messages. Call sites are
+	//! only prepended and never removed, so the list can be iterated without locks.
+	static LogRateLimiter* volatile g_rate_limiters = nullptr;
+	static void report_suppressed_logs(bool all)
+	{
+		u64 ticks = OS::get_ticks();
+		for (LogRateLimiter* limiter = g_rate_limiters; limiter; limiter = limiter->next)
+		{
+			// Call sites whose interval has not passed report suppressed messages with the next message.
+			if (!all && ticks < limiter->next_log_ticks) continue;
+			u64 num_suppressed = atom_exchange_u64(&limiter->num_suppressed, 0);
+			if (num_suppressed)
+			{
+				log(limiter->verbosity, limiter->tag, "%llu similar messages suppressed: %s", (unsigned long long)num_suppressed, limiter->format);
+			}
+		}
+	}
+	//! Adds one call site to `g_rate_limiters` when its first message is suppressed.
+	static void register_rate_limiter(LogRateLimiter& limiter, LogVerbosity verbosity, const c8* tag, const c8* format)
+	{
+		if (limiter.registered || atom_compare_exchange_u32(&limiter.registered, 1, 0) != 0) return;
+		limiter.verbosity = verbosity;
+		limiter.tag = tag;
+		limiter.format = format;
+		LogRateLimiter* head;
+		do
+		{
+			head = g_rate_limiters;
+			limiter.next = head;
+		} while (atom_compare_exchange_pointer(&g_rate_limiters, &limiter, head) != head);
+	}
+	LUNA_RUNTIME_API void flush_suppressed_logs()
+	{
+		report_suppressed_logs(false);
+	}
+	LUNA_RUNTIME_API void log_rate_limited(LogRateLimiter& limiter, f64 interval, LogVerbosity verbosity, const c8* tag, const c8* format, ...)
+	{
+		u64 ticks = OS::get_ticks();
+		u64 next_log_ticks = limiter.next_log_ticks;
+		if (ticks < next_log_ticks)
+		{
+			register_rate_limiter(limiter, verbosity, tag, format);
+			atom_inc_u64(&limiter.num_suppressed);
+			return;
+		}
+		u64 new_next_log_ticks = interval < 0.0 ? U64_MAX : ticks + (u64)(interval * OS::get_ticks_per_second());
+		if (atom_compare_exchange_u64(&limiter.next_log_ticks, new_next_log_ticks, next_log_ticks) != next_log_ticks)
+		{
+			// Another thread emits the message.
+			register_rate_limiter(limiter, verbosity, tag, format);
+			atom_inc_u64(&limiter.num_suppressed);
+			return;
+		}
+		u64 num_suppressed = atom_exchange_u64(&limiter.num_suppressed, 0);
+		VarList args;
+		va_start(args, format);
+		if (!num_suppressed)
+		{
+			logv(verbosity, tag, format, args);
+		}
+		else
+		{
+			c8 buf[LOG_STACK_BUFFER_SIZE];
+			i32 len;
+			c8* message = format_log_message(buf, len, format, args);
+			log(verbosity, tag, "%s (%llu similar messages suppressed)", message, (unsigned long long)num_suppressed);
+			if (message != buf) memfree(message);
+		}
+		va_end(args);
 	}
 	LUNA_RUNTIME_API usize register_log_handler(const Function<log_callback_t>& handler)
 	{
@@ -18,6 +18,11 @@
 #include "../Name.hpp"
 #include "../Result.hpp"
 #include "../RingDeque.hpp"
+#include "../Thread.hpp"
+#include "../Semaphore.hpp"
+#include "../Atomic.hpp"
+#include "../Time.hpp"
+#include "../Profiler.hpp"
 namespace Luna
 {
 	struct ModuleEntry
@@ -33,6 +38,9 @@ namespace Luna
 	// Records all initialized modules, sorted by their initialization order.
 	Vector<Module*> g_initialized_modules;
 
+	// Records the initialization time of all initialized modules, sorted by their initialization order.
+	Vector<ModuleInitTime> g_module_init_times;
+
 	void module_init()
 	{
 	}
@@ -45,6 +53,8 @@ namespace Luna
 		}
 		g_initialized_modules.clear();
 		g_initialized_modules.shrink_to_fit();
+		g_module_init_times.clear();
+		g_module_init_times.shrink_to_fit();
 		g_modules.clear();
 		g_modules.shrink_to_fit();	
 	}
@@ -146,6 +156,34 @@ namespace Luna
 		}
 		return init_queue;
 	}
+	static void submit_module_init_event(u64 event_id, Module* handle)
+	{
+		ProfilerEventData::ModuleInit* data = (ProfilerEventData::ModuleInit*)allocate_profiler_event_data(
+			sizeof(ProfilerEventData::ModuleInit),
+			alignof(ProfilerEventData::ModuleInit)
+		);
+		data->module = handle;
+		submit_profiler_event(event_id);
+	}
+	// Calls `on_init` of one module and records the time. This may be called from worker threads.
+	static RV call_module_on_init(Module* handle, ModuleInitTime& time)
+	{
+		time.module = handle;
+		time.on_worker_thread = get_current_thread() != get_main_thread();
+		submit_module_init_event(ProfilerEventId::MODULE_INIT_BEGIN, handle);
+		time.begin_ticks = get_ticks();
+		RV r = handle->on_init();
+		time.end_ticks = get_ticks();
+		submit_module_init_event(ProfilerEventId::MODULE_INIT_END, handle);
+		return r;
+	}
+	static void mark_module_initialized(Module* handle, const ModuleInitTime& time)
+	{
+		auto entry = g_modules.find(handle);
+		entry->second.m_initialized = true;
+		g_initialized_modules.push_back(handle);
+		g_module_init_times.push_back(time);
+	}
 	static RV init_single_module(Module* handle)
 	{
 		lutry
@@ -153,9 +191,9 @@ namespace Luna
 			auto entry = g_modules.find(handle);
 			if (!entry->second.m_initialized)
 			{
-				luexp(entry->first->on_init());
-				entry->second.m_initialized = true;
-				g_initialized_modules.push_back(entry->first);
+				ModuleInitTime time;
+				luexp(call_module_on_init(handle, time));
+				mark_module_initialized(handle, time);
 			}
 		}
 		lucatch
@@ -164,6 +202,146 @@ namespace Luna
 		}
 		return ok;
 	}
+	// The state of one module initialized by `init_modules`.
+	struct ModuleInitTask
+	{
+		Module* m_module;
+		// The number of dependencies in the same `init_modules` call that are not initialized.
+		usize m_num_pending_dependencies = 0;
+		// The indices of tasks that depend on this module.
+		Vector<usize> m_dependents;
+		// Worker thread states, written by the worker thread before `m_finished` is set.
+		Ref<IThread> m_thread;
+		ModuleInitTime m_time;
+		RV m_result = ok;
+		String m_error_message;
+		ISemaphore* m_finish_semaphore = nullptr;
+		u32 m_finished = 0;
+	};
+	static void module_init_worker_run(void* params)
+	{
+		ModuleInitTask* task = (ModuleInitTask*)params;
+		RV r = call_module_on_init(task->m_module, task->m_time);
+		if (failed(r))
+		{
+			// Error messages are stored per thread, so they are fetched here.
+			task->m_result = r;
+			task->m_error_message = explain(r.errcode());
+		}
+		atom_exchange_u32(&task->m_finished, 1);
+		task->m_finish_semaphore->release();
+	}
+	static RV init_modules_concurrently(const Vector<Module*>& queue)
+	{
+		Vector<ModuleInitTask> tasks(queue.size());
+		HashMap<Module*, usize> task_indices;
+		for (usize i = 0; i < queue.size(); ++i)
+		{
+			tasks[i].m_module = queue[i];
+			task_indices.insert(make_pair(queue[i], i));
+		}
+		for (usize i = 0; i < queue.size(); ++i)
+		{
+			for (Module* dep : g_modules.find(queue[i])->second.m_dependencies)
+			{
+				auto iter = task_indices.find(dep);
+				if (iter == task_indices.end()) continue;
+				++tasks[i].m_num_pending_dependencies;
+				tasks[iter->second].m_dependents.push_back(i);
+			}
+		}
+		// Tasks whose dependencies are initialized, sorted by the initialization queue order.
+		Vector<usize> ready_tasks;
+		for (usize i = 0; i < tasks.size(); ++i)
+		{
+			if (!tasks[i].m_num_pending_dependencies) ready_tasks.push_back(i);
+		}
+		Ref<ISemaphore> finish_semaphore;
+		usize num_running_workers = 0;
+		RV result = ok;
+		auto finish_task = [&](usize index, RV r, const c8* error_message)
+		{
+			ModuleInitTask& task = tasks[index];
+			if (failed(r))
+			{
+				if (succeeded(result))
+				{
+					result = set_error(r.errcode(), "Failed to initialize module %s: %s", task.m_module->get_name(), error_message);
+				}
+				return;
+			}
+			mark_module_initialized(task.m_module, task.m_time);
+			for (usize dependent : task.m_dependents)
+			{
+				if (!(--tasks[dependent].m_num_pending_dependencies))
+				{
+					ready_tasks.push_back(dependent);
+				}
+			}
+		};
+		auto collect_finished_workers = [&]()
+		{
+			for (usize i = 0; i < tasks.size(); ++i)
+			{
+				ModuleInitTask& task = tasks[i];
+				if (task.m_thread && atom_add_u32(&task.m_finished, 0))
+				{
+					task.m_thread->wait();
+					task.m_thread.reset();
+					--num_running_workers;
+					finish_task(i, task.m_result, task.m_error_message.c_str());
+				}
+			}
+		};
+		while (true)
+		{
+			// Collects finished workers without blocking, so that modules depending on them are started
+			// before the next module is initialized on this thread.
+			if (num_running_workers && finish_semaphore->try_wait()) collect_finished_workers();
+			if (succeeded(result))
+			{
+				// Starts all ready modules that support concurrent initialization first, so that they
+				// are initialized while modules on this thread are initialized.
+				usize main_thread_task = USIZE_MAX;
+				for (auto iter = ready_tasks.begin(); iter != ready_tasks.end();)
+				{
+					ModuleInitTask& task = tasks[*iter];
+					if (task.m_module->supports_concurrent_init())
+					{
+						if (!finish_semaphore) finish_semaphore = new_semaphore(0, (i32)tasks.size());
+						task.m_finish_semaphore = finish_semaphore.get();
+						task.m_thread = new_thread(module_init_worker_run, &task, task.m_module->get_name());
+					}
+					if (task.m_thread)
+					{
+						++num_running_workers;
+						iter = ready_tasks.erase(iter);
+					}
+					else
+					{
+						if (main_thread_task == USIZE_MAX) main_thread_task = *iter;
+						++iter;
+					}
+				}
+				if (main_thread_task != USIZE_MAX)
+				{
+					ready_tasks.erase(find(ready_tasks.begin(), ready_tasks.end(), main_thread_task));
+					RV r = call_module_on_init(tasks[main_thread_task].m_module, tasks[main_thread_task].m_time);
+					finish_task(main_thread_task, r, failed(r) ? explain(r.errcode()) : nullptr);
+					continue;
+				}
+			}
+			if (!num_running_workers) break;
+			// Waits for at least one worker to finish. The semaphore may also be released by workers
+			// that are already collected, in which case no worker is collected and the loop waits again.
+			finish_semaphore->wait();
+			collect_finished_workers();
+		}
+		if (failed(result)) return result;
+		// All tasks must be initialized if no error occurs, otherwise the dependency graph is broken.
+		luassert(ready_tasks.empty());
+		return ok;
+	}
 	LUNA_RUNTIME_API RV init_module_dependencies(Module* handle)
 	{
 		lucheck_msg(handle, "init_module_dependencies failed: handle is nullptr");
@@ -228,13 +406,13 @@ namespace Luna
 		lutry
 		{
 			lulet(queue, get_module_init_queue());
-			// Initialize all modules by order.
-			for (auto i : queue)
-			{
-				luexp(init_single_module(i));
-			}
+			luexp(init_modules_concurrently(queue));
 		}
 		lucatchret;
 		return ok;
 	}
+	LUNA_RUNTIME_API Span<const ModuleInitTime> get_module_init_times()
+	{
+		return { g_module_init_times.data(), g_module_init_times.size() };
+	}
 }
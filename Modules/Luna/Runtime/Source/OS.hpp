@@ -375,6 +375,28 @@ namespace Luna
 		//! @param[in] file The file handle opened by `open_file`.
 		void flush_file(opaque_t file);
 
+		//! Maps one file to memory for reading.
+		//! @param[in] path The path of the file.
+		//! @return The new file mapping handle if succeeds. Returns one error code if failed.
+		//! Possible errors:
+		//! * BasicError::access_denied
+		//! * BasicError::not_found
+		//! * BasicError::bad_platform_call for all errors that cannot be identified.
+		R<opaque_t> map_file(const c8* path);
+
+		//! Unmaps one file mapping created by `map_file`.
+		//! @param[in] mapping The file mapping handle created by `map_file`.
+		void unmap_file(opaque_t mapping);
+
+		//! Gets the mapped data of one file mapping.
+		//! @param[in] mapping The file mapping handle created by `map_file`.
+		//! @return Returns the mapped data, or `nullptr` if the file is empty.
+		const void* get_file_mapping_data(opaque_t mapping);
+
+		//! Gets the size of the mapped data of one file mapping.
+		//! @param[in] mapping The file mapping handle created by `map_file`.
+		usize get_file_mapping_size(opaque_t mapping);
+
 		//! Gets the attribute/status of one file or directory.
 		//! @param[in] path The path of the file to get.
 		//! @return The file attribute structure if succeeded, returns error code if failed.
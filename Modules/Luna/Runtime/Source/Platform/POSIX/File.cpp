@@ -23,6 +23,7 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <dirent.h>
+#include <sys/mman.h>
 
 #ifdef LUNA_PLATFORM_MACOS
 #include <libproc.h>
@@ -507,6 +508,70 @@ namespace Luna
 			if (f->buffered) flush_buffered_file(f->handle);
 			else flush_unbuffered_file(f->handle);
 		}
+		struct FileMapping
+		{
+			void* data;
+			usize size;
+		};
+		R<opaque_t> map_file(const c8* path)
+		{
+			lucheck(path);
+			int fd = ::open(path, O_RDONLY, 0);
+			if (fd == -1)
+			{
+				auto err = errno;
+				switch (err)
+				{
+				case EPERM:
+				case EACCES:
+					return BasicError::access_denied();
+				case ENOENT:
+					return BasicError::not_found();
+				default:
+					return BasicError::bad_platform_call();
+				}
+			}
+			struct stat st;
+			if (::fstat(fd, &st) != 0)
+			{
+				::close(fd);
+				return BasicError::bad_platform_call();
+			}
+			FileMapping* mapping = Luna::memnew<FileMapping>();
+			mapping->data = nullptr;
+			mapping->size = (usize)st.st_size;
+			if (mapping->size)
+			{
+				void* data = ::mmap(nullptr, mapping->size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (data == MAP_FAILED)
+				{
+					::close(fd);
+					Luna::memdelete(mapping);
+					return BasicError::bad_platform_call();
+				}
+				mapping->data = data;
+			}
+			// The mapping is still valid after the file descriptor is closed.
+			::close(fd);
+			return mapping;
+		}
+		void unmap_file(opaque_t mapping)
+		{
+			FileMapping* m = (FileMapping*)mapping;
+			if (m->data)
+			{
+				::munmap(m->data, m->size);
+			}
+			Luna::memdelete(m);
+		}
+		const void* get_file_mapping_data(opaque_t mapping)
+		{
+			return ((FileMapping*)mapping)->data;
+		}
+		usize get_file_mapping_size(opaque_t mapping)
+		{
+			return ((FileMapping*)mapping)->size;
+		}
 		R<FileAttribute> get_file_attribute(const c8* path)
 		{
 			struct stat s;
@@ -180,14 +180,12 @@ namespace Luna
         {
             Semaphore* o = (Semaphore*)sema;
             luassert_msg_always(pthread_mutex_lock(&o->m_mutex) == 0, "pthread_mutex_lock failed.");
-            if (o->m_counter > 0)
+            // The loop also handles spurious wakeups.
+            while (o->m_counter <= 0)
             {
-                atom_dec_i32(&o->m_counter);
-                luassert_msg_always(pthread_mutex_unlock(&o->m_mutex) == 0, "pthread_mutex_unlock failed.");
+                luassert_msg_always(pthread_cond_wait(&o->m_cond, &o->m_mutex) == 0, "pthread_cond_wait failed.");
             }
             atom_dec_i32(&o->m_counter);
-            luassert_msg_always(pthread_cond_wait(&o->m_cond, &o->m_mutex) == 0, "pthread_cond_wait failed.");
-            atom_inc_i32(&o->m_counter);
             luassert_msg_always(pthread_mutex_unlock(&o->m_mutex) == 0, "pthread_mutex_unlock failed.");
         }
         bool try_acquire_semaphore(opaque_t sema)
@@ -207,17 +205,10 @@ namespace Luna
         {
             Semaphore* o = (Semaphore*)sema;
             luassert_msg_always(pthread_mutex_lock(&o->m_mutex) == 0, "pthread_mutex_lock failed.");
-            bool ret = false;
             if (o->m_counter < o->m_max_count)
             {
-                if (o->m_counter < 0)
-                {
-                    luassert_msg_always(pthread_cond_signal(&o->m_cond) == 0, "pthread_cond_signal failed.");
-                }
-                else
-                {
-                    atom_inc_i32(&o->m_counter);
-                }
+                atom_inc_i32(&o->m_counter);
+                luassert_msg_always(pthread_cond_signal(&o->m_cond) == 0, "pthread_cond_signal failed.");
             }
             luassert_msg_always(pthread_mutex_unlock(&o->m_mutex) == 0, "pthread_mutex_unlock failed.");
         }
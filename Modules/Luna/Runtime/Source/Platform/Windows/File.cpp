@@ -511,6 +511,74 @@ namespace Luna
 
 			return ((LONGLONG)(ui.QuadPart - 116444736000000000) / 10000000);
 		}
+		struct FileMapping
+		{
+			void* data;
+			usize size;
+		};
+		R<opaque_t> map_file(const c8* path)
+		{
+			lucheck(path);
+			usize buffer_size = utf8_to_utf16_len(path) + 1;
+			wchar_t* pathbuffer = (wchar_t*)alloca(sizeof(wchar_t) * buffer_size);
+			utf8_to_utf16((char16_t*)pathbuffer, buffer_size, path);
+			HANDLE file_handle = ::CreateFileW(pathbuffer, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file_handle == INVALID_HANDLE_VALUE)
+			{
+				DWORD dw = ::GetLastError();
+				return translate_last_error(dw);
+			}
+			LARGE_INTEGER size;
+			if (!::GetFileSizeEx(file_handle, &size))
+			{
+				DWORD dw = ::GetLastError();
+				::CloseHandle(file_handle);
+				return translate_last_error(dw);
+			}
+			FileMapping* mapping = Luna::memnew<FileMapping>();
+			mapping->data = nullptr;
+			mapping->size = (usize)size.QuadPart;
+			if (mapping->size)
+			{
+				HANDLE mapping_handle = ::CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				if (!mapping_handle)
+				{
+					DWORD dw = ::GetLastError();
+					::CloseHandle(file_handle);
+					Luna::memdelete(mapping);
+					return translate_last_error(dw);
+				}
+				mapping->data = ::MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+				DWORD dw = ::GetLastError();
+				// The view keeps the mapping object alive, so handles can be closed here.
+				::CloseHandle(mapping_handle);
+				if (!mapping->data)
+				{
+					::CloseHandle(file_handle);
+					Luna::memdelete(mapping);
+					return translate_last_error(dw);
+				}
+			}
+			::CloseHandle(file_handle);
+			return mapping;
+		}
+		void unmap_file(opaque_t mapping)
+		{
+			FileMapping* m = (FileMapping*)mapping;
+			if (m->data)
+			{
+				::UnmapViewOfFile(m->data);
+			}
+			Luna::memdelete(m);
+		}
+		const void* get_file_mapping_data(opaque_t mapping)
+		{
+			return ((FileMapping*)mapping)->data;
+		}
+		usize get_file_mapping_size(opaque_t mapping)
+		{
+			return ((FileMapping*)mapping)->size;
+		}
 		R<FileAttribute> get_file_attribute(const c8* path)
 		{
 			lucheck(path);
@@ -46,6 +46,8 @@ namespace Luna
 		impl_interface_for_type<Semaphore, IWaitable, ISemaphore>();
 		register_boxed_type<File>();
 		impl_interface_for_type<File, IFile, ISeekableStream, IStream>();
+		register_boxed_type<FileMapping>();
+		impl_interface_for_type<FileMapping, IFileMapping>();
 		register_boxed_type<FileIterator>();
 		impl_interface_for_type<FileIterator, IFileIterator>();
 		register_boxed_type<Thread>();
@@ -149,10 +149,33 @@ namespace Luna
 			//! The returned span is empty if `compile` throws errors, or if no valid compiled data exists in the compiler.
 			virtual Span<const byte_t> get_output() = 0;
 
-
+			//! Gets the key used to look up the compiled data of the current settings in the shader cache.
+			//! The key is hashed from the source code and all compile settings. The DXC version is not hashed, but
+			//! is stored in shader cache files, and files compiled by other DXC versions are not used once DXC is
+			//! initialized in this process.
+			//! @return Returns the cache key, or `0` if the current settings cannot be cached. Sources that include 
+			//! other files and the `none` target format are never cached, since included files are not hashed.
+			virtual u64 get_cache_key() = 0;
 		};
 
 		LUNA_SHADER_COMPILER_API Ref<ICompiler> new_compiler();
+
+		//! Sets the directory to store compiled shaders. 
+		//! If one directory is set, `ICompiler::compile` loads the compiled data from the directory if the cache key 
+		//! matches, and writes the compiled data to the directory after the source is compiled.
+		//! Every compiled shader is stored in one file named by the cache key in hexadecimal, with `.bin` extension.
+		//! @param[in] path The directory path. The directory is created if it does not exist. Specify one empty path
+		//! to disable the on-disk shader cache, which is the default.
+		LUNA_SHADER_COMPILER_API void set_cache_dir(const Path& path);
+
+		//! Adds compiled shaders embedded into the program, which are looked up before the on-disk shader cache.
+		//! Every shader is one shader cache file written by the compiler (see `set_cache_dir`), which can be embedded
+		//! at build time, for example by the `utils.bin2c` rule of xmake.
+		//! Files that are not valid or are written by other cache file versions are ignored. Files compiled by 
+		//! other DXC versions are skipped when looked up after DXC is initialized.
+		//! @param[in] files The data of shader cache files. The data is not copied, and must be valid until 
+		//! the module is closed.
+		LUNA_SHADER_COMPILER_API void add_precompiled_shaders(Span<const Span<const byte_t>> files);
 	}
 
 	struct Module;
@@ -21,12 +21,295 @@
 #include <Luna/Runtime/HashSet.hpp>
 #include <Luna/Runtime/Module.hpp>
 #include <Luna/Runtime/File.hpp>
+#include <Luna/Runtime/Log.hpp>
+#include <Luna/Runtime/Time.hpp>
+#include <Luna/Runtime/SpinLock.hpp>
+#include <Luna/Runtime/Algorithm.hpp>
 #include <spirv_cross/spirv_msl.hpp>
 
 namespace Luna
 {
 	namespace ShaderCompiler
 	{
+		//! The state shared by all compilers.
+		struct ShaderCache
+		{
+			//! The on-disk shader cache directory, empty if disabled.
+			Path cache_dir;
+			//! The shader cache files of precompiled shaders, indexed by cache keys.
+			HashMap<u64, Span<const byte_t>> precompiled_shaders;
+			//! The DXC version of this process, valid if `dxc_version_valid` is `true`. This is checked against
+			//! the version stored in shader cache files, and is not hashed into cache keys, so that cache hits
+			//! do not need to create DXC instances to read the version.
+			u32 dxc_version[3] = { 0, 0, 0 };
+			bool dxc_version_valid = false;
+		};
+		static ShaderCache* g_shader_cache = nullptr;
+		static SpinLock g_shader_cache_lock;
+
+		//! Checks one shader cache file, returns the header if the file is valid.
+		static const ShaderCacheFileHeader* check_cache_file(Span<const byte_t> file, bool check_data)
+		{
+			if (file.size() < sizeof(ShaderCacheFileHeader)) return nullptr;
+			const ShaderCacheFileHeader* header = (const ShaderCacheFileHeader*)file.data();
+			if (header->magic != SHADER_CACHE_FILE_MAGIC || header->version != SHADER_CACHE_FILE_VERSION) return nullptr;
+			if (header->data_size != file.size() - sizeof(ShaderCacheFileHeader)) return nullptr;
+			if (check_data && memhash32(header + 1, (usize)header->data_size) != header->data_check) return nullptr;
+			return header;
+		}
+		LUNA_SHADER_COMPILER_API void set_cache_dir(const Path& path)
+		{
+			LockGuard guard(g_shader_cache_lock);
+			if (!g_shader_cache) g_shader_cache = memnew<ShaderCache>();
+			g_shader_cache->cache_dir = path;
+			if (!path.empty())
+			{
+				// The error is ignored if the directory already exists.
+				auto _ = create_dir(path.encode().c_str());
+			}
+		}
+		LUNA_SHADER_COMPILER_API void add_precompiled_shaders(Span<const Span<const byte_t>> files)
+		{
+			LockGuard guard(g_shader_cache_lock);
+			if (!g_shader_cache) g_shader_cache = memnew<ShaderCache>();
+			for (auto& file : files)
+			{
+				const ShaderCacheFileHeader* header = check_cache_file(file, true);
+				if (!header)
+				{
+					log_warning("ShaderCompiler", "One precompiled shader is ignored because it is not valid or is written by another compiler version.");
+					continue;
+				}
+				g_shader_cache->precompiled_shaders.insert_or_assign(header->key, file);
+			}
+		}
+		//! Reads the DXC version stored by the first compiler that initializes DXC.
+		static bool get_dxc_version(u32 out_version[3])
+		{
+			LockGuard guard(g_shader_cache_lock);
+			if (!g_shader_cache || !g_shader_cache->dxc_version_valid) return false;
+			memcpy(out_version, g_shader_cache->dxc_version, sizeof(g_shader_cache->dxc_version));
+			return true;
+		}
+		//! Checks whether one shader cache file is compiled by the DXC version of this process.
+		//! Files are accepted if the version is not known yet, since no DXC instance is created in this process.
+		//! `g_shader_cache_lock` must be locked when calling this.
+		static bool check_dxc_version(const ShaderCacheFileHeader* header)
+		{
+			if (!g_shader_cache->dxc_version_valid) return true;
+			return !memcmp(header->dxc_version, g_shader_cache->dxc_version, sizeof(g_shader_cache->dxc_version));
+		}
+		RV Compiler::init_dxc()
+		{
+			HRESULT hr;
+			if (!m_dxc_compiler)
+			{
+				hr = DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&m_dxc_compiler));
+				if (FAILED(hr)) return BasicError::bad_platform_call();
+				// Fetches the compiler version for cache keys.
+				u32 dxc_version[3] = { 0, 0, 0 };
+				ComPtr<IDxcVersionInfo> version_info;
+				if (SUCCEEDED(m_dxc_compiler->QueryInterface(IID_PPV_ARGS(&version_info))))
+				{
+					UINT32 major, minor;
+					if (SUCCEEDED(version_info->GetVersion(&major, &minor)))
+					{
+						dxc_version[0] = major;
+						dxc_version[1] = minor;
+					}
+				}
+				ComPtr<IDxcVersionInfo2> version_info2;
+				if (SUCCEEDED(m_dxc_compiler->QueryInterface(IID_PPV_ARGS(&version_info2))))
+				{
+					UINT32 commit_count;
+					char* commit_hash = nullptr;
+					if (SUCCEEDED(version_info2->GetCommitInfo(&commit_count, &commit_hash)))
+					{
+						dxc_version[2] = commit_count;
+						CoTaskMemFree(commit_hash);
+					}
+				}
+				LockGuard guard(g_shader_cache_lock);
+				if (!g_shader_cache) g_shader_cache = memnew<ShaderCache>();
+				memcpy(g_shader_cache->dxc_version, dxc_version, sizeof(dxc_version));
+				g_shader_cache->dxc_version_valid = true;
+			}
+			if (!m_dxc_utils)
+			{
+				hr = DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&m_dxc_utils));
+				if (FAILED(hr)) return BasicError::bad_platform_call();
+			}
+			if (!m_default_include_handler)
+			{
+				hr = m_dxc_utils->CreateDefaultIncludeHandler(&m_default_include_handler);
+				if (FAILED(hr)) return BasicError::bad_platform_call();
+			}
+			return ok;
+		}
+		inline void append_key_data(String& data, const void* src, usize size)
+		{
+			data.append((const c8*)src, size);
+		}
+		inline void append_key_string(String& data, const c8* src, usize size)
+		{
+			u64 size64 = size;
+			append_key_data(data, &size64, sizeof(u64));
+			append_key_data(data, src, size);
+		}
+		//! Checks whether the source has one `#include` directive, which may be preceded by whitespaces.
+		static bool has_include_directive(Span<const c8> source)
+		{
+			const c8 include_str[] = "include";
+			usize include_len = sizeof(include_str) - 1;
+			usize i = 0;
+			while (i < source.size())
+			{
+				// Skips whitespaces at the beginning of one line.
+				while (i < source.size() && (source[i] == ' ' || source[i] == '\t')) ++i;
+				if (i < source.size() && source[i] == '#')
+				{
+					++i;
+					while (i < source.size() && (source[i] == ' ' || source[i] == '\t')) ++i;
+					if (i + include_len <= source.size() && !memcmp(source.data() + i, include_str, include_len)) return true;
+				}
+				// Moves to the next line.
+				while (i < source.size() && source[i] != '\n') ++i;
+				++i;
+			}
+			return false;
+		}
+		bool Compiler::build_cache_key(u64& key, u32& key_check)
+		{
+			if (m_target_format == TargetFormat::none) return false;
+			// Included files are not hashed, so sources that include files are not cached.
+			if (has_include_directive(m_source)) return false;
+			String data;
+			u32 version = SHADER_CACHE_FILE_VERSION;
+			append_key_data(data, &version, sizeof(u32));
+			append_key_string(data, m_source.data(), m_source.size());
+			append_key_string(data, m_source_name.c_str(), m_source_name.size());
+			append_key_string(data, m_entry_point.c_str(), m_entry_point.size());
+			u32 settings[] = {
+				m_shader_model_major, m_shader_model_minor, (u32)m_optimization_level, (u32)m_target_format,
+				(u32)m_shader_type, (u32)m_matrix_pack_mode, (u32)m_debug, (u32)m_skip_validation, (u32)m_msl_platform
+			};
+			append_key_data(data, settings, sizeof(settings));
+			// Definitions are sorted, since the iteration order of `HashMap` is not specified.
+			Vector<String> definitions;
+			for (auto& def : m_definitions)
+			{
+				String define_entry;
+				define_entry.append(def.first.c_str());
+				define_entry.push_back('=');
+				define_entry.append(def.second.c_str());
+				definitions.push_back(move(define_entry));
+			}
+			sort(definitions.begin(), definitions.end(), [](const String& a, const String& b) { return strcmp(a.c_str(), b.c_str()) < 0; });
+			for (auto& def : definitions)
+			{
+				append_key_string(data, def.c_str(), def.size());
+			}
+			String additional_arguments = VariantUtils::write_json(m_additional_arguments);
+			append_key_string(data, additional_arguments.c_str(), additional_arguments.size());
+			key = memhash64(data.data(), data.size());
+			// 0 is reserved for settings that cannot be cached.
+			if (key == 0) key = 1;
+			key_check = memhash32(data.data(), data.size());
+			return true;
+		}
+		u64 Compiler::get_cache_key()
+		{
+			lutsassert();
+			u64 key;
+			u32 key_check;
+			return build_cache_key(key, key_check) ? key : 0;
+		}
+		inline Path get_cache_file_path(const Path& cache_dir, u64 key)
+		{
+			c8 name[32];
+			snprintf(name, 32, "%016llx.bin", (unsigned long long)key);
+			Path path = cache_dir;
+			path.push_back(name);
+			return path;
+		}
+		bool Compiler::load_cached_output(u64 key, u32 key_check)
+		{
+			Path cache_dir;
+			{
+				LockGuard guard(g_shader_cache_lock);
+				if (!g_shader_cache) return false;
+				auto iter = g_shader_cache->precompiled_shaders.find(key);
+				if (iter != g_shader_cache->precompiled_shaders.end())
+				{
+					// Precompiled shaders are checked when added.
+					const ShaderCacheFileHeader* header = (const ShaderCacheFileHeader*)iter->second.data();
+					if (header->key_check == key_check && check_dxc_version(header))
+					{
+						m_out_data = (const byte_t*)(header + 1);
+						m_out_size = (usize)header->data_size;
+						return true;
+					}
+				}
+				cache_dir = g_shader_cache->cache_dir;
+			}
+			if (cache_dir.empty()) return false;
+			auto f = open_file(get_cache_file_path(cache_dir, key).encode().c_str(), FileOpenFlag::read, FileCreationMode::open_existing);
+			if (failed(f)) return false;
+			auto data = load_file_data(f.get());
+			if (failed(data)) return false;
+			const ShaderCacheFileHeader* header = check_cache_file({ data.get().data(), data.get().size() }, true);
+			if (!header || header->key != key || header->key_check != key_check) return false;
+			{
+				LockGuard guard(g_shader_cache_lock);
+				if (!g_shader_cache || !check_dxc_version(header)) return false;
+			}
+			m_cache_file_data = move(data.get());
+			m_out_data = m_cache_file_data.data() + sizeof(ShaderCacheFileHeader);
+			m_out_size = (usize)header->data_size;
+			return true;
+		}
+		void Compiler::write_cached_output(u64 key, u32 key_check)
+		{
+			Path cache_dir;
+			{
+				LockGuard guard(g_shader_cache_lock);
+				if (!g_shader_cache) return;
+				cache_dir = g_shader_cache->cache_dir;
+			}
+			if (cache_dir.empty()) return;
+			ShaderCacheFileHeader header;
+			// Every cached target format is compiled by DXC, so the version is known here.
+			if (!get_dxc_version(header.dxc_version)) return;
+			header.magic = SHADER_CACHE_FILE_MAGIC;
+			header.version = SHADER_CACHE_FILE_VERSION;
+			header.key = key;
+			header.data_size = m_out_size;
+			header.key_check = key_check;
+			header.data_check = memhash32(m_out_data, m_out_size);
+			header.reserved = 0;
+			Path path = get_cache_file_path(cache_dir, key);
+			// The file is written to one temporary file and then renamed, so that other processes
+			// never read partially written files.
+			c8 temp_name[64];
+			snprintf(temp_name, 64, "%016llx.%llx.tmp", (unsigned long long)key, (unsigned long long)get_ticks());
+			Path temp_path = cache_dir;
+			temp_path.push_back(temp_name);
+			String temp_path_str = temp_path.encode();
+			lutry
+			{
+				{
+					lulet(f, open_file(temp_path_str.c_str(), FileOpenFlag::write, FileCreationMode::create_always));
+					luexp(f->write(&header, sizeof(ShaderCacheFileHeader)));
+					luexp(f->write(m_out_data, m_out_size));
+				}
+				luexp(move_file(temp_path_str.c_str(), path.encode().c_str()));
+			}
+			lucatch
+			{
+				log_warning("ShaderCompiler", "Failed to write shader cache file %s: %s", path.encode().c_str(), explain(luerr));
+				auto _ = delete_file(temp_path_str.c_str());
+			}
+		}
 		RV Compiler::compile_none()
 		{
 			RV r = dxc_compile(DxcTargetType::dxil);
@@ -99,22 +382,9 @@ namespace Luna
 		RV Compiler::dxc_compile(DxcTargetType target_type)
 		{
 			if (m_shader_model_major < 6) return set_error(BasicError::not_supported(), "Shader model 5.1 and olders are not supported.");
+			auto r = init_dxc();
+			if (failed(r)) return r;
 			HRESULT hr;
-			if (!m_dxc_compiler)
-			{
-				hr = DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&m_dxc_compiler));
-				if (FAILED(hr)) return BasicError::bad_platform_call();
-			}
-			if (!m_dxc_utils)
-			{
-				hr = DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&m_dxc_utils));
-				if (FAILED(hr)) return BasicError::bad_platform_call();
-			}
-			if (!m_default_include_handler)
-			{
-				hr = m_dxc_utils->CreateDefaultIncludeHandler(&m_default_include_handler);
-				if (FAILED(hr)) return BasicError::bad_platform_call();
-			}
 			// Build arguments.
 			Vector<WString> arguments;
 			Vector<LPCWSTR> argument_pointers;
@@ -292,20 +562,27 @@ namespace Luna
 		{
 			lutsassert();
 			clear_output();
+			// The key is built before compiling, since `spirv_compile` changes settings.
+			u64 key;
+			u32 key_check;
+			bool cached = build_cache_key(key, key_check);
+			if (cached && load_cached_output(key, key_check)) return ok;
+			RV r;
 			switch (m_target_format)
 			{
 			case TargetFormat::none:
 				return compile_none();
 			case TargetFormat::dxil:
-				return dxc_compile(DxcTargetType::dxil);
+				r = dxc_compile(DxcTargetType::dxil); break;
 			case TargetFormat::spir_v:
-				return dxc_compile(DxcTargetType::spir_v);
+				r = dxc_compile(DxcTargetType::spir_v); break;
 			case TargetFormat::msl:
-				return spirv_compile(SpirvOutputType::msl);
+				r = spirv_compile(SpirvOutputType::msl); break;
 			default:
 				lupanic_msg("Unsupportted output format.");
 			}
-			return ok;
+			if (succeeded(r) && cached) write_cached_output(key, key_check);
+			return r;
 		}
 		Span<const byte_t> Compiler::get_output()
 		{
@@ -322,12 +599,22 @@ namespace Luna
 		struct ShaderCompilerModule : public Module
 		{
 			virtual const c8* get_name() override { return "ShaderCompiler"; }
+			virtual bool supports_concurrent_init() override { return true; }
 			virtual RV on_init() override
 			{
 				register_boxed_type<Compiler>();
 				impl_interface_for_type<Compiler, ICompiler>();
 				return ok;
 			}
+			virtual void on_close() override
+			{
+				LockGuard guard(g_shader_cache_lock);
+				if (g_shader_cache)
+				{
+					memdelete(g_shader_cache);
+					g_shader_cache = nullptr;
+				}
+			}
 		};
 	}
 	LUNA_SHADER_COMPILER_API Module* module_shader_compiler()
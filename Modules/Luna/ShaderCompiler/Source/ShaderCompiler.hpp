@@ -17,6 +17,7 @@
 #include <dxc/WinAdapter.h>
 #endif
 #include <Luna/Runtime/TSAssert.hpp>
+#include <Luna/Runtime/Blob.hpp>
 #include "../ShaderCompiler.hpp"
 #include <string>
 
@@ -85,6 +86,30 @@ namespace Luna
 		{
 			msl = 0
 		};
+		//! The header of one shader cache file, followed by the compiled data.
+		struct ShaderCacheFileHeader
+		{
+			//! `SHADER_CACHE_FILE_MAGIC`.
+			u32 magic;
+			//! `SHADER_CACHE_FILE_VERSION`.
+			u32 version;
+			//! The cache key of the compiled data.
+			u64 key;
+			//! The size of the compiled data in bytes.
+			u64 data_size;
+			//! The 32-bit hash of the key data, checked with `key` to reduce false hits.
+			u32 key_check;
+			//! The 32-bit hash of the compiled data, used to detect broken files.
+			u32 data_check;
+			//! The major, minor and commit count version of the DXC compiler that compiled the data.
+			u32 dxc_version[3];
+			u32 reserved;
+		};
+		//! "LSCC" in little endian.
+		constexpr u32 SHADER_CACHE_FILE_MAGIC = 0x4343534C;
+		//! Increase this if the file format or the output of the compiler is changed in a way that is not
+		//! described by the cache key, for example if the spirv-cross package or MSL options are updated.
+		constexpr u32 SHADER_CACHE_FILE_VERSION = 2;
 		struct Compiler : public ICompiler
 		{
 			lustruct("ShaderCompiler::Compiler", "{E89511FE-424E-4076-8478-6BE1254714E0}");
@@ -120,6 +145,8 @@ namespace Luna
 			ComPtr<IDxcBlob> m_dxc_blob;
 			
             String m_msl_compiled_data;
+			//! The shader cache file loaded from disk, whose compiled data is the output.
+			Blob m_cache_file_data;
             
 			// Pointer to the final output data.
 			const byte_t* m_out_data;
@@ -135,6 +162,7 @@ namespace Luna
 				m_dxc_result.reset();
 				m_dxc_blob.reset();
                 m_msl_compiled_data.clear();
+				m_cache_file_data.clear();
 				m_out_data = nullptr;
 				m_out_size = 0;
 			}
@@ -176,11 +204,19 @@ namespace Luna
 			virtual HashMap<Name, Name>& get_definitions() override { return m_definitions; }
 			virtual Variant& get_additional_arguments() override { return m_additional_arguments; }
 			virtual void set_msl_platform(MSLPlatform platform) override { m_msl_platform = platform; }
+			RV init_dxc();
+			//! Builds the cache key and key check of the current settings. Returns `false` if the settings cannot be cached.
+			bool build_cache_key(u64& key, u32& key_check);
+			//! Sets the output to the compiled data in precompiled shaders or the on-disk shader cache if found.
+			bool load_cached_output(u64 key, u32 key_check);
+			//! Writes the output to the on-disk shader cache.
+			void write_cached_output(u64 key, u32 key_check);
 			RV compile_none();
 			RV dxc_compile(DxcTargetType output_type);
 			RV spirv_compile(SpirvOutputType output_type);
             virtual RV compile() override;
             virtual Span<const byte_t> get_output() override;
+			virtual u64 get_cache_key() override;
 		};
 	}
 }
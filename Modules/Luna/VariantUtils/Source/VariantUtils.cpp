@@ -22,6 +22,7 @@ namespace Luna
         struct ModuleVariantUtils : public Module
         {
             virtual const c8* get_name() override { return "VariantUtils"; }
+            virtual bool supports_concurrent_init() override { return true; }
 			virtual RV on_init() override
 			{
                 xml_init();
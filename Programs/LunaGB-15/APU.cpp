@@ -2,7 +2,6 @@
 #include "Emulator.hpp"
 #include <Luna/Runtime/Log.hpp>
 #include <Luna/Runtime/Math/Math.hpp>
-#include "App.hpp"
 void APU::tick_div_apu(Emulator* emu)
 {
     u8 div = emu->timer.read_div();
@@ -405,6 +404,18 @@ void APU::tick(Emulator* emu)
         {
             tick_ch4(emu);
         }
+        // Skip mixing if nobody listens to audio output.
+        if(!emu->audio_sample_callback && !emu->audio_capture) return;
+        if(emu->audio_capture && emu->audio_capture->source == AudioCaptureSource::stems)
+        {
+            f32 stems[4] = {
+                ch1_dac_on() ? ch1_output_sample : 0.0f,
+                ch2_dac_on() ? ch2_output_sample : 0.0f,
+                ch3_dac_on() ? ch3_output_sample : 0.0f,
+                ch4_output_sample
+            };
+            emu->audio_capture->push(stems);
+        }
         // Mixer.
         // Output volume range in [-4, 4].
         f32 sample_l = 0.0f;
@@ -424,12 +435,13 @@ void APU::tick(Emulator* emu)
         sample_l *= ((f32)left_volume()) / 7.0f;
         sample_r *= ((f32)right_volume()) / 7.0f;
         // Write to histroy buffer.
-        sample_sum_l -= history_samples_l[history_sample_cursor];
-        sample_sum_r -= history_samples_r[history_sample_cursor];
-        history_samples_l[history_sample_cursor] = (u16)((sample_l + 1.0f) / 2.0f * 60.0f);
-        history_samples_r[history_sample_cursor] = (u16)((sample_r + 1.0f) / 2.0f * 60.0f);
-        sample_sum_l += history_samples_l[history_sample_cursor];
-        sample_sum_r += history_samples_r[history_sample_cursor];
+        APUSampleHistory* history = emu->apu_history.get();
+        sample_sum_l -= history->samples_l[history_sample_cursor];
+        sample_sum_r -= history->samples_r[history_sample_cursor];
+        history->samples_l[history_sample_cursor] = (u16)((sample_l + 1.0f) / 2.0f * 60.0f);
+        history->samples_r[history_sample_cursor] = (u16)((sample_r + 1.0f) / 2.0f * 60.0f);
+        sample_sum_l += history->samples_l[history_sample_cursor];
+        sample_sum_r += history->samples_r[history_sample_cursor];
         history_sample_cursor = (history_sample_cursor + 1) % 65536;
         // High-pass filter.
         f32 average_level_l = ((((f32)sample_sum_l) / 65536.0f) / 60.0f * 2.0f) - 1.0f;
@@ -440,13 +452,15 @@ void APU::tick(Emulator* emu)
         sample_l = clamp(sample_l, -1.0f, 1.0f);
         sample_r = clamp(sample_r, -1.0f, 1.0f);
         // Output samples.
-        LockGuard guard(g_app->audio_buffer_lock);
-        // Restrict audio buffer size to store at most 65536 samples
-        // (about 1/16 second of audio data).
-        if(g_app->audio_buffer_l.size() >= AUDIO_BUFFER_MAX_SIZE) g_app->audio_buffer_l.pop_front();
-        if(g_app->audio_buffer_r.size() >= AUDIO_BUFFER_MAX_SIZE) g_app->audio_buffer_r.pop_front();
-        g_app->audio_buffer_l.push_back(sample_l);
-        g_app->audio_buffer_r.push_back(sample_r);
+        if(emu->audio_capture && emu->audio_capture->source == AudioCaptureSource::mixer)
+        {
+            f32 frame[2] = {sample_l, sample_r};
+            emu->audio_capture->push(frame);
+        }
+        if(emu->audio_sample_callback)
+        {
+            emu->audio_sample_callback(emu, sample_l, sample_r, emu->audio_sample_callback_userdata);
+        }
     }
 }
 u8 APU::bus_read(u16 addr)
@@ -521,7 +535,8 @@ u8 APU::bus_read(u16 addr)
     {
         return wave_pattern_ram[addr - 0xFF30];
     }
-    log_error("LunaGB", "Unsupported bus read address: 0x%04X", (u32)addr);
+    // Unmapped APU registers are open bus.
+    lulog_rate_limited(1.0, LogVerbosity::warning, "LunaGB", "Unmapped APU register read: 0x%04X", (u32)addr);
     return 0xFF;
 }
 void APU::bus_write(u16 addr, u8 data)
@@ -652,5 +667,5 @@ void APU::bus_write(u16 addr, u8 data)
         wave_pattern_ram[addr - 0xFF30] = data;
         return;
     }
-    log_error("LunaGB", "Unsupported bus write address: 0x%04X", (u32)addr);
+    lulog_rate_limited(1.0, LogVerbosity::warning, "LunaGB", "Unmapped APU register write: 0x%04X", (u32)addr);
 }
\ No newline at end of file
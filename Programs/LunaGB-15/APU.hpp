@@ -2,7 +2,19 @@
 #include <Luna/Runtime/MemoryUtils.hpp>
 using namespace Luna;
 
+//! The sample rate of samples generated by APU. APU is ticked once per sample.
+constexpr u32 APU_SAMPLE_RATE = 1048576;
+
 struct Emulator;
+
+//! The history of mixed samples used for high-pass filtering. The history is only accessed when
+//! audio samples are mixed, so it is allocated out of `APU` to keep the emulation state compact.
+struct APUSampleHistory
+{
+    u8 samples_l[65536];
+    u8 samples_r[65536];
+};
+
 struct APU
 {
     // Registers.
@@ -229,10 +241,9 @@ struct APU
     void tick_ch4_length();
     void tick_ch4(Emulator* emu);
 
-    //! Used for high-pass filtering.
-    u8 history_samples_l[65536];
-    u8 history_samples_r[65536];
+    //! The position of the next sample in `APUSampleHistory`.
     u16 history_sample_cursor;
+    //! The sums of all samples in `APUSampleHistory`.
     u32 sample_sum_l;
     u32 sample_sum_r;
 
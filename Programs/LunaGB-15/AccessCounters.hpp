@@ -0,0 +1,31 @@
+#pragma once
+#include <Luna/Runtime/MemoryUtils.hpp>
+using namespace Luna;
+
+//! The number of bytes counted by one access counter.
+constexpr usize ACCESS_COUNTER_PAGE_SIZE = 256;
+//! The number of access counters of every access type.
+constexpr usize ACCESS_COUNTER_NUM_PAGES = 65536 / ACCESS_COUNTER_PAGE_SIZE;
+
+//! Counts memory accesses performed by CPU. Accesses are counted for every 256-byte page of the
+//! address space.
+struct AccessCounters
+{
+    //! The number of bytes read by instructions, including immediate data.
+    u64 reads[ACCESS_COUNTER_NUM_PAGES];
+    //! The number of bytes written by instructions and interrupts.
+    u64 writes[ACCESS_COUNTER_NUM_PAGES];
+    //! The number of instructions fetched.
+    u64 executes[ACCESS_COUNTER_NUM_PAGES];
+
+    AccessCounters()
+    {
+        reset();
+    }
+    void reset()
+    {
+        memzero(reads, sizeof(reads));
+        memzero(writes, sizeof(writes));
+        memzero(executes, sizeof(executes));
+    }
+};
\ No newline at end of file
@@ -1,10 +1,12 @@
 #include "App.hpp"
+#include "RomCache.hpp"
 #include <Luna/Runtime/Log.hpp>
 #include <Luna/ImGui/ImGui.hpp>
 #include <Luna/Window/FileDialog.hpp>
 #include <Luna/Window/MessageBox.hpp>
 #include <Luna/Runtime/File.hpp>
 #include <Luna/Runtime/Time.hpp>
+#include <Luna/Runtime/Thread.hpp>
 #include <Luna/ShaderCompiler/ShaderCompiler.hpp>
 #include <Luna/RHI/ShaderCompileHelper.hpp>
 #include <Luna/RHI/Utility.hpp>
@@ -185,6 +187,16 @@ float4 main(PS_INPUT input) : SV_Target
     lucatchret;
     return ok;
 }
+void on_emulator_audio_sample(Emulator* emu, f32 sample_l, f32 sample_r, void* userdata)
+{
+    LockGuard guard(g_app->audio_buffer_lock);
+    // Restrict audio buffer size to store at most 65536 samples
+    // (about 1/16 second of audio data).
+    if(g_app->audio_buffer_l.size() >= AUDIO_BUFFER_MAX_SIZE) g_app->audio_buffer_l.pop_front();
+    if(g_app->audio_buffer_r.size() >= AUDIO_BUFFER_MAX_SIZE) g_app->audio_buffer_r.pop_front();
+    g_app->audio_buffer_l.push_back(sample_l);
+    g_app->audio_buffer_r.push_back(sample_r);
+}
 u32 on_playback_audio(void* dst_buffer, const AHI::WaveFormat& format, u32 num_frames)
 {
     LockGuard guard(g_app->audio_buffer_lock);
@@ -192,7 +204,7 @@ u32 on_playback_audio(void* dst_buffer, const AHI::WaveFormat& format, u32 num_f
     while(num_frames_read < num_frames)
     {
         f64 timestamp = (f64)num_frames_read / (f64)format.sample_rate;
-        f64 sample_index = timestamp * 1048576.0;
+        f64 sample_index = timestamp * APU_SAMPLE_RATE;
         // Perform linear interpolation between two sample values if the sample index is not integral.
         u32 sample_1_index = (u32)floor(sample_index);
         u32 sample_2_index = (u32)ceil(sample_index);
@@ -206,11 +218,18 @@ u32 on_playback_audio(void* dst_buffer, const AHI::WaveFormat& format, u32 num_f
         ((f32*)dst_buffer)[num_frames_read * 2 + 1] = lerp(sample_1_r, sample_2_r, (f32)sample_index - (f32)sample_1_index);
         ++num_frames_read;
     }
+    if(g_app->host_audio_capture)
+    {
+        for(u32 i = 0; i < num_frames_read; ++i)
+        {
+            g_app->host_audio_capture->push((f32*)dst_buffer + i * 2);
+        }
+    }
     if(num_frames_read)
     {
         // Remove read audio samples from buffer.
         f64 delta_time = (f64)num_frames_read / (f64)format.sample_rate;
-        usize num_samples = (usize)(delta_time * 1048576.0);
+        usize num_samples = (usize)(delta_time * APU_SAMPLE_RATE);
         num_samples = min(num_samples, g_app->audio_buffer_l.size());
         g_app->audio_buffer_l.erase(g_app->audio_buffer_l.begin(), g_app->audio_buffer_l.begin() + num_samples);
         g_app->audio_buffer_r.erase(g_app->audio_buffer_r.begin(), g_app->audio_buffer_r.begin() + num_samples);
@@ -271,20 +290,40 @@ RV App::update()
         if(emulator)
         {
             update_emulator_input();
+            emulator->run_ahead_frames = (u32)run_ahead_frames;
+            emulator->set_ppu_render_worker_enabled(ppu_render_worker);
+            emulator->serial.link = link_port.get();
             emulator->update(delta_time);
         }
         last_frame_ticks = ticks;
         // Draw GUI.
         draw_gui();
 
-        // Upload emulator screen pixels.
-        if(emulator)
+        // Upload emulator screen pixels if they are changed.
+        bool display_uploaded = false;
+        if(emulator && emulator->display_version != emulator_display_version)
         {
-            u8* src = emulator->ppu.pixels + ((emulator->ppu.current_back_buffer + 1) % 2) * PPU_XRES * PPU_YRES * 4;
+            const u8* src = emulator->get_display_buffer();
             // Copy display data to texture for rendering.
             luexp(RHI::copy_resource_data(g_app->cmdbuf, {
                 RHI::CopyResourceData::write_texture(emulator_display_tex, {0, 0}, 0, 0, 0, src, PPU_XRES * 4, PPU_XRES * PPU_YRES * 4, PPU_XRES, PPU_YRES, 1)
             }));
+            emulator_display_version = emulator->display_version;
+            display_uploaded = true;
+        }
+        // Skip rendering and presenting if neither the emulator screen nor GUI is changed.
+        // Debug windows update textures that are not tracked here, so frames are always presented
+        // when debug windows are shown.
+        bool frame_changed = update_frame_draw_data();
+        if(!display_uploaded && !frame_changed && !debug_window.show)
+        {
+            // Presenting waits for vertical sync, so waits for one frame interval instead.
+            f64 elapsed = (f64)(get_ticks() - ticks) / get_ticks_per_second();
+            if(elapsed < IDLE_FRAME_INTERVAL)
+            {
+                sleep((u32)((IDLE_FRAME_INTERVAL - elapsed) * 1000.0));
+            }
+            return ok;
         }
         // Clear back buffer.
         lulet(back_buffer, swap_chain->get_current_back_buffer());
@@ -309,6 +348,39 @@ RV App::update()
     lucatchret;
     return ok;
 }
+bool App::update_frame_draw_data()
+{
+    frame_draw_data.clear();
+    auto append = [this](const void* data, usize size)
+    {
+        frame_draw_data.insert(frame_draw_data.end(), (const u8*)data, (const u8*)data + size);
+    };
+    auto framebuffer_size = window->get_framebuffer_size();
+    append(&framebuffer_size, sizeof(framebuffer_size));
+    bool emulator_drawn = emulator.get() != nullptr;
+    append(&emulator_drawn, sizeof(emulator_drawn));
+    ImDrawData* draw_data = ImGui::GetDrawData();
+    if(draw_data)
+    {
+        append(&draw_data->DisplayPos, sizeof(ImVec2));
+        append(&draw_data->DisplaySize, sizeof(ImVec2));
+        append(&draw_data->FramebufferScale, sizeof(ImVec2));
+        for(i32 i = 0; i < draw_data->CmdListsCount; ++i)
+        {
+            const ImDrawList* list = draw_data->CmdLists[i];
+            i32 sizes[3] = { list->VtxBuffer.Size, list->IdxBuffer.Size, list->CmdBuffer.Size };
+            append(sizes, sizeof(sizes));
+            append(list->VtxBuffer.Data, list->VtxBuffer.Size * sizeof(ImDrawVert));
+            append(list->IdxBuffer.Data, list->IdxBuffer.Size * sizeof(ImDrawIdx));
+            // `ImDrawCmd` zeroes its padding bytes.
+            append(list->CmdBuffer.Data, list->CmdBuffer.Size * sizeof(ImDrawCmd));
+        }
+    }
+    bool changed = frame_draw_data.size() != last_frame_draw_data.size() ||
+        memcmp(frame_draw_data.data(), last_frame_draw_data.data(), frame_draw_data.size()) != 0;
+    last_frame_draw_data.swap(frame_draw_data);
+    return changed;
+}
 void App::update_emulator_input()
 {
     auto& joypad = emulator->joypad;
@@ -445,7 +517,7 @@ void App::draw_main_menu_bar()
             {
                 if(emulator)
                 {
-                    emulator->paused = false;
+                    emulator->resume();
                 }
             }
             if(ImGui::MenuItem("Pause"))
@@ -455,6 +527,75 @@ void App::draw_main_menu_bar()
                     emulator->paused = true;
                 }
             }
+            if(emulator && !emulator->movie && ImGui::MenuItem("Record movie"))
+            {
+                start_movie_recording();
+            }
+            if(emulator && emulator->movie && ImGui::MenuItem("Stop recording movie"))
+            {
+                stop_movie_recording();
+            }
+            if(emulator && ImGui::MenuItem("Save screenshot"))
+            {
+                save_screenshot();
+            }
+            if(emulator && !emulator->video_capture && ImGui::MenuItem("Record video"))
+            {
+                start_video_capture();
+            }
+            if(emulator && emulator->video_capture && ImGui::MenuItem("Stop recording video"))
+            {
+                stop_video_capture();
+            }
+            if(emulator && !emulator->audio_capture && !host_audio_capture && ImGui::BeginMenu("Record audio"))
+            {
+                ImGui::Checkbox("32-bit float samples", &audio_capture_float);
+                if(ImGui::MenuItem("Mixer output (1048576 Hz)"))
+                {
+                    start_audio_capture(AudioCaptureSource::mixer, false);
+                }
+                if(ImGui::MenuItem("Mixer output (host rate)"))
+                {
+                    start_audio_capture(AudioCaptureSource::mixer, true);
+                }
+                if(ImGui::MenuItem("CH1~CH4 stems (1048576 Hz)"))
+                {
+                    start_audio_capture(AudioCaptureSource::stems, false);
+                }
+                ImGui::EndMenu();
+            }
+            if(emulator && (emulator->audio_capture || host_audio_capture) && ImGui::MenuItem("Stop recording audio"))
+            {
+                stop_audio_capture();
+            }
+            ImGui::Separator();
+            ImGui::SliderInt("Run-ahead frames", &run_ahead_frames, 0, 4);
+            ImGui::MenuItem("Draw on render worker", nullptr, &ppu_render_worker);
+            if(ImGui::BeginMenu("Link cable"))
+            {
+                if(link_port)
+                {
+                    ImGui::Text(link_port->is_connected() ? "Connected." : "Waiting for connection...");
+                    if(ImGui::MenuItem("Disconnect"))
+                    {
+                        stop_link();
+                    }
+                }
+                else
+                {
+                    ImGui::InputText("Address", link_address, sizeof(link_address));
+                    ImGui::InputInt("Port", &link_port_number);
+                    if(ImGui::MenuItem("Host"))
+                    {
+                        start_link(true);
+                    }
+                    if(ImGui::MenuItem("Connect"))
+                    {
+                        start_link(false);
+                    }
+                }
+                ImGui::EndMenu();
+            }
             ImGui::EndMenu();
         }
         if (ImGui::BeginMenu("Debug"))
@@ -481,11 +622,12 @@ void App::open_cartridge()
         {
             close_cartridge(); // Close previous cartridge if present.
             Path& path = result.get()[0];
-            lulet(f, open_file(path.encode().c_str(), FileOpenFlag::read, FileCreationMode::open_existing));
-            lulet(rom_data, load_file_data(f));
+            lulet(rom, open_rom(path));
             UniquePtr<Emulator> emu(memnew<Emulator>());
-            luexp(emu->init(path, rom_data.data(), rom_data.size()));
+            luexp(emu->init(path, rom));
+            emu->audio_sample_callback = on_emulator_audio_sample;
             emulator = move(emu);
+            emulator_display_version = U64_MAX;
         }
     }
     lucatch
@@ -496,4 +638,182 @@ void App::open_cartridge()
 void App::close_cartridge()
 {
     emulator.reset();
+}
+void App::start_movie_recording()
+{
+    lutry
+    {
+        Window::FileDialogFilter filter;
+        filter.name = "LunaGB movie file";
+        const c8* extension = "lgbmovie";
+        filter.extensions = {&extension, 1};
+        lulet(movie_path, Window::save_file_dialog("Save", {&filter, 1}));
+        if(movie_path.empty()) return;
+        if(movie_path.extension() == Name())
+        {
+            movie_path.replace_extension("lgbmovie");
+        }
+        // Restart the cartridge so that the movie starts from power on.
+        // The previous emulator saves cartridge RAM data when closed, which is then loaded by the new emulator.
+        Path cartridge_path = emulator->cartridge_path;
+        Ref<IFileMapping> rom = emulator->rom;
+        emulator.reset();
+        UniquePtr<Emulator> emu(memnew<Emulator>());
+        luexp(emu->init(cartridge_path, rom));
+        emu->audio_sample_callback = on_emulator_audio_sample;
+        UniquePtr<Movie> movie(memnew<Movie>());
+        movie->begin_recording(emu.get(), movie_path);
+        emu->movie = move(movie);
+        emulator = move(emu);
+        emulator_display_version = U64_MAX;
+    }
+    lucatch
+    {
+        Window::message_box(explain(luerr), "Record movie failed", Window::MessageBoxType::ok, Window::MessageBoxIcon::error);
+    }
+}
+void App::stop_movie_recording()
+{
+    auto r = emulator->movie->end();
+    if(failed(r))
+    {
+        Window::message_box(explain(r.errcode()), "Save movie failed", Window::MessageBoxType::ok, Window::MessageBoxIcon::error);
+    }
+    emulator->movie.reset();
+}
+void App::save_screenshot()
+{
+    // Copy the frame before opening the dialog, which may take a while.
+    Blob pixels(emulator->get_display_buffer(), VIDEO_FRAME_SIZE);
+    Window::FileDialogFilter filter;
+    filter.name = "PNG image";
+    const c8* extension = "png";
+    filter.extensions = {&extension, 1};
+    auto path = Window::save_file_dialog("Save", {&filter, 1});
+    if(failed(path) || path.get().empty()) return;
+    if(path.get().extension() == Name())
+    {
+        path.get().replace_extension("png");
+    }
+    auto r = ::save_screenshot(path.get().encode().c_str(), pixels.data());
+    if(failed(r))
+    {
+        Window::message_box(explain(r.errcode()), "Save screenshot failed", Window::MessageBoxType::ok, Window::MessageBoxIcon::error);
+    }
+}
+void App::start_video_capture()
+{
+    lutry
+    {
+        Window::FileDialogFilter filters[2];
+        filters[0].name = "LunaGB video file";
+        const c8* video_extension = "lgbvideo";
+        filters[0].extensions = {&video_extension, 1};
+        filters[1].name = "PNG image sequence";
+        const c8* png_extension = "png";
+        filters[1].extensions = {&png_extension, 1};
+        lulet(video_path, Window::save_file_dialog("Save", {filters, 2}));
+        if(video_path.empty()) return;
+        VideoCaptureFormat format = VideoCaptureFormat::lgbvideo;
+        if(video_path.extension() == Name("png"))
+        {
+            // Frames are saved as <name>_<frame index>.png.
+            format = VideoCaptureFormat::png;
+            video_path.replace_extension("");
+        }
+        else if(video_path.extension() == Name())
+        {
+            video_path.replace_extension("lgbvideo");
+        }
+        UniquePtr<VideoCapture> capture(memnew<VideoCapture>());
+        luexp(capture->begin(video_path.encode().c_str(), format));
+        emulator->video_capture = move(capture);
+    }
+    lucatch
+    {
+        Window::message_box(explain(luerr), "Record video failed", Window::MessageBoxType::ok, Window::MessageBoxIcon::error);
+    }
+}
+void App::stop_video_capture()
+{
+    emulator->video_capture.reset();
+}
+void App::start_audio_capture(AudioCaptureSource source, bool host_rate)
+{
+    lutry
+    {
+        Window::FileDialogFilter filters[2];
+        filters[0].name = "WAV file";
+        const c8* wav_extension = "wav";
+        filters[0].extensions = {&wav_extension, 1};
+        filters[1].name = "Raw PCM file";
+        const c8* raw_extension = "raw";
+        filters[1].extensions = {&raw_extension, 1};
+        lulet(audio_path, Window::save_file_dialog("Save", {filters, 2}));
+        if(audio_path.empty()) return;
+        if(audio_path.extension() == Name())
+        {
+            audio_path.replace_extension("wav");
+        }
+        AudioCaptureDesc desc;
+        desc.format = audio_capture_float ? AudioCaptureSampleFormat::f32 : AudioCaptureSampleFormat::s16;
+        desc.wav = audio_path.extension() != Name("raw");
+        desc.num_channels = source == AudioCaptureSource::stems ? 4 : 2;
+        UniquePtr<AudioCapture> capture(memnew<AudioCapture>());
+        capture->source = source;
+        if(host_rate)
+        {
+            // The audio thread must never wait, drop samples instead.
+            desc.sample_rate = audio_device->get_sample_rate();
+            desc.wait_when_full = false;
+            luexp(capture->begin(audio_path.encode().c_str(), desc));
+            LockGuard guard(audio_buffer_lock);
+            host_audio_capture = move(capture);
+        }
+        else
+        {
+            luexp(capture->begin(audio_path.encode().c_str(), desc));
+            emulator->audio_capture = move(capture);
+        }
+    }
+    lucatch
+    {
+        Window::message_box(explain(luerr), "Record audio failed", Window::MessageBoxType::ok, Window::MessageBoxIcon::error);
+    }
+}
+void App::stop_audio_capture()
+{
+    if(emulator) emulator->audio_capture.reset();
+    UniquePtr<AudioCapture> capture;
+    audio_buffer_lock.lock();
+    capture = move(host_audio_capture);
+    audio_buffer_lock.unlock();
+}
+void App::start_link(bool host)
+{
+    lutry
+    {
+        UniquePtr<SocketLinkPort> port(memnew<SocketLinkPort>());
+        if(host)
+        {
+            luexp(port->host((u16)link_port_number));
+        }
+        else
+        {
+            luexp(port->connect(link_address, (u16)link_port_number));
+        }
+        link_port = move(port);
+    }
+    lucatch
+    {
+        Window::message_box(explain(luerr), "Link cable failed", Window::MessageBoxType::ok, Window::MessageBoxIcon::error);
+    }
+}
+void App::stop_link()
+{
+    if(emulator)
+    {
+        emulator->serial.link = nullptr;
+    }
+    link_port.reset();
 }
\ No newline at end of file
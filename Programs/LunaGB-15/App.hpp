@@ -3,12 +3,15 @@
 #include "Emulator.hpp"
 #include <Luna/Runtime/UniquePtr.hpp>
 #include "DebugWindow.hpp"
+#include "Link.hpp"
 #include <Luna/AHI/Device.hpp>
 #include <Luna/Runtime/RingDeque.hpp>
 #include <Luna/Runtime/SpinLock.hpp>
 using namespace Luna;
 
 constexpr usize AUDIO_BUFFER_MAX_SIZE = 65536;
+//! The update interval in seconds when one frame is not presented because nothing is changed.
+constexpr f64 IDLE_FRAME_INTERVAL = 1.0 / 60.0;
 
 struct App
 {
@@ -32,6 +35,15 @@ struct App
     UniquePtr<Emulator> emulator;
     //! The ticks for last frame.
     u64 last_frame_ticks;
+    //! The number of frames to run ahead, see `Emulator::run_ahead_frames`.
+    i32 run_ahead_frames = 0;
+    //! Whether scan lines are drawn on the render worker thread, see `Emulator::set_ppu_render_worker_enabled`.
+    bool ppu_render_worker = true;
+
+    //! The link cable connected to another LunaGB process. `nullptr` if no link cable is connected.
+    UniquePtr<SocketLinkPort> link_port;
+    c8 link_address[64] = "127.0.0.1";
+    i32 link_port_number = 5738;
 
     //! The debug window context.
     DebugWindow debug_window;
@@ -45,13 +57,26 @@ struct App
     Ref<RHI::IDescriptorSet> emulator_display_desc_set;
     Ref<RHI::IPipelineLayout> emulator_display_playout;
     Ref<RHI::IPipelineState> emulator_display_pso;
+    //! The `Emulator::display_version` of the pixels uploaded to `emulator_display_tex`.
+    //! `U64_MAX` if pixels of the current emulator are not uploaded.
+    u64 emulator_display_version = U64_MAX;
+    //! The data that affects the rendered frame of the last update, including GUI draw data.
+    //! See `update_frame_draw_data`.
+    Vector<u8> last_frame_draw_data;
+    //! The buffer used to record the data of the current update.
+    Vector<u8> frame_draw_data;
 
+    //! The audio capture of host audio output, protected by `audio_buffer_lock`.
+    //! `nullptr` if host audio is not being captured. This is declared before `audio_device`,
+    //! so that it is destroyed after the audio device stops calling the playback callback.
+    UniquePtr<AudioCapture> host_audio_capture;
     //! The audio device.
     Ref<AHI::IDevice> audio_device;
     // Stores samples generated by APU.
     RingDeque<f32> audio_buffer_l;
     RingDeque<f32> audio_buffer_r;
     SpinLock audio_buffer_lock;
+    bool audio_capture_float = false;
 
     RV init();
     RV init_render_resources();
@@ -59,11 +84,28 @@ struct App
     RV update();
     void update_emulator_input();
     RV draw_emulator_screen(RHI::ITexture* back_buffer);
+    //! Records data that affects the rendered frame to `last_frame_draw_data`. Returns `true` if the
+    //! data is different from the last update.
+    bool update_frame_draw_data();
     void draw_gui();
     void draw_main_menu_bar();
 
     void open_cartridge();
     void close_cartridge();
+    //! Restarts the current cartridge and records input movie from power on.
+    void start_movie_recording();
+    void stop_movie_recording();
+    //! Saves the current frame to one PNG file.
+    void save_screenshot();
+    void start_video_capture();
+    void stop_video_capture();
+    //! Starts capturing audio to one WAV or raw PCM file.
+    //! @param[in] host_rate If `true`, captures mixer output resampled to the host sample rate.
+    void start_audio_capture(AudioCaptureSource source, bool host_rate);
+    void stop_audio_capture();
+    //! Hosts or connects the link cable.
+    void start_link(bool host);
+    void stop_link();
 };
 
 extern App* g_app;
\ No newline at end of file
@@ -0,0 +1,170 @@
+#include "AudioCapture.hpp"
+#include <Luna/Runtime/Log.hpp>
+#include <Luna/Runtime/Math/Math.hpp>
+
+//! The canonical 44-byte WAV header. Sizes are patched when the capture ends.
+struct WavHeader
+{
+    c8 riff[4];
+    u32 riff_size;
+    c8 wave[4];
+    c8 fmt[4];
+    u32 fmt_size;
+    u16 format_tag;
+    u16 num_channels;
+    u32 sample_rate;
+    u32 byte_rate;
+    u16 block_align;
+    u16 bits_per_sample;
+    c8 data[4];
+    u32 data_size;
+};
+static_assert(sizeof(WavHeader) == 44, "Wrong WAV header size");
+
+constexpr u16 WAVE_FORMAT_PCM = 1;
+constexpr u16 WAVE_FORMAT_IEEE_FLOAT = 3;
+
+inline u32 get_sample_size(AudioCaptureSampleFormat format)
+{
+    return format == AudioCaptureSampleFormat::s16 ? 2 : 4;
+}
+static WavHeader make_wav_header(const AudioCaptureDesc& desc, u64 data_size)
+{
+    WavHeader h;
+    u32 sample_size = get_sample_size(desc.format);
+    memcpy(h.riff, "RIFF", 4);
+    h.riff_size = (u32)min<u64>(data_size + sizeof(WavHeader) - 8, U32_MAX);
+    memcpy(h.wave, "WAVE", 4);
+    memcpy(h.fmt, "fmt ", 4);
+    h.fmt_size = 16;
+    h.format_tag = desc.format == AudioCaptureSampleFormat::s16 ? WAVE_FORMAT_PCM : WAVE_FORMAT_IEEE_FLOAT;
+    h.num_channels = (u16)desc.num_channels;
+    h.sample_rate = desc.sample_rate;
+    h.byte_rate = desc.sample_rate * desc.num_channels * sample_size;
+    h.block_align = (u16)(desc.num_channels * sample_size);
+    h.bits_per_sample = (u16)(sample_size * 8);
+    memcpy(h.data, "data", 4);
+    h.data_size = (u32)min<u64>(data_size, U32_MAX);
+    return h;
+}
+static void write_audio_block(void* userdata, u32 index)
+{
+    AudioCapture* capture = (AudioCapture*)userdata;
+    const f32* block = capture->samples + (usize)(index % capture->desc.ring_blocks) * AUDIO_CAPTURE_BLOCK_FRAMES * capture->desc.num_channels;
+    auto r = capture->write_frames(block, AUDIO_CAPTURE_BLOCK_FRAMES);
+    if(failed(r))
+    {
+        log_error("LunaGB", "Failed to write audio capture: %s", explain(r.errcode()));
+    }
+}
+RV AudioCapture::begin(const c8* path, const AudioCaptureDesc& desc)
+{
+    lutry
+    {
+        end();
+        luassert(desc.ring_blocks >= 2 && desc.num_channels);
+        this->desc = desc;
+        luset(file, open_file(path, FileOpenFlag::write, FileCreationMode::create_always));
+        if(desc.wav)
+        {
+            WavHeader header = make_wav_header(desc, 0);
+            luexp(file->write(&header, sizeof(WavHeader)));
+        }
+        samples = (f32*)memalloc(sizeof(f32) * AUDIO_CAPTURE_BLOCK_FRAMES * desc.num_channels * desc.ring_blocks);
+        write_block = 0;
+        write_offset = 0;
+        num_frames = 0;
+        num_dropped_frames = 0;
+        num_overruns = 0;
+        data_size = 0;
+        luexp(writer.start(desc.ring_blocks, write_audio_block, this, "Audio capture writer"));
+    }
+    lucatch
+    {
+        file.reset();
+        memfree(samples);
+        samples = nullptr;
+        return luerr;
+    }
+    return ok;
+}
+void AudioCapture::end()
+{
+    if(!file) return;
+    writer.stop();
+    // Write the last partial block.
+    if(write_offset)
+    {
+        const f32* block = samples + (usize)(write_block % desc.ring_blocks) * AUDIO_CAPTURE_BLOCK_FRAMES * desc.num_channels;
+        auto r = write_frames(block, write_offset);
+        if(failed(r))
+        {
+            log_error("LunaGB", "Failed to write audio capture: %s", explain(r.errcode()));
+        }
+        write_offset = 0;
+    }
+    if(desc.wav)
+    {
+        WavHeader header = make_wav_header(desc, data_size);
+        auto r = file->seek(0, SeekMode::begin);
+        if(succeeded(r)) r = file->write(&header, sizeof(WavHeader));
+        if(failed(r))
+        {
+            log_error("LunaGB", "Failed to write WAV header: %s", explain(r.errcode()));
+        }
+    }
+    file.reset();
+    memfree(samples);
+    samples = nullptr;
+    if(num_overruns)
+    {
+        log_warning("LunaGB", "Audio capture finished, %llu frames written, %llu frames dropped in %u overruns.",
+            (unsigned long long)(num_frames - num_dropped_frames), (unsigned long long)num_dropped_frames, num_overruns);
+    }
+    else
+    {
+        log_info("LunaGB", "Audio capture finished, %llu frames written.", (unsigned long long)num_frames);
+    }
+}
+void AudioCapture::commit_block()
+{
+    write_offset = 0;
+    if(desc.wait_when_full)
+    {
+        writer.wait_for_slot(write_block + 1);
+    }
+    else if(writer.is_full(write_block + 1))
+    {
+        // The next block is still being written, drop this block and fill it again.
+        num_dropped_frames += AUDIO_CAPTURE_BLOCK_FRAMES;
+        ++num_overruns;
+        return;
+    }
+    ++write_block;
+    writer.commit(write_block);
+}
+RV AudioCapture::write_frames(const f32* frames, u32 num_frames)
+{
+    usize num_samples = (usize)num_frames * desc.num_channels;
+    const void* data = frames;
+    usize size = num_samples * sizeof(f32);
+    if(desc.format == AudioCaptureSampleFormat::s16)
+    {
+        converted.resize(num_samples * sizeof(i16));
+        i16* dst = (i16*)converted.data();
+        for(usize i = 0; i < num_samples; ++i)
+        {
+            f32 v = clamp(frames[i], -1.0f, 1.0f);
+            dst[i] = (i16)(v * 32767.0f);
+        }
+        data = converted.data();
+        size = converted.size();
+    }
+    lutry
+    {
+        luexp(file->write(data, size));
+        data_size += size;
+    }
+    lucatchret;
+    return ok;
+}
\ No newline at end of file
@@ -0,0 +1,111 @@
+#pragma once
+#include <Luna/Runtime/Result.hpp>
+#include <Luna/Runtime/File.hpp>
+#include <Luna/Runtime/Vector.hpp>
+#include "APU.hpp"
+#include "RingWriter.hpp"
+using namespace Luna;
+
+//! The number of frames in one ring block. The ring is handed over to the writer thread
+//! block by block, so shared counters are only touched once per block.
+constexpr u32 AUDIO_CAPTURE_BLOCK_FRAMES = 4096;
+
+enum class AudioCaptureSampleFormat : u8
+{
+    //! 16-bit signed integer samples.
+    s16,
+    //! 32-bit float samples.
+    f32,
+};
+
+//! The audio captured from APU.
+enum class AudioCaptureSource : u8
+{
+    //! The stereo mixer output.
+    mixer,
+    //! The output of CH1~CH4 before panning and master volume, one channel per stem.
+    stems,
+};
+
+struct AudioCaptureDesc
+{
+    u32 sample_rate = APU_SAMPLE_RATE;
+    u32 num_channels = 2;
+    AudioCaptureSampleFormat format = AudioCaptureSampleFormat::s16;
+    //! Writes one WAV file if `true`, or raw interleaved samples if `false`.
+    bool wav = true;
+    //! If `true`, the producer waits for the writer thread when the ring is full, so that no sample
+    //! is dropped. Otherwise, blocks that cannot be handed over are dropped and counted as overruns.
+    //! This must be `false` if samples are pushed from the host audio thread.
+    bool wait_when_full = true;
+    //! The number of blocks of the ring buffer.
+    u32 ring_blocks = 64;
+};
+
+//! Writes audio samples to one WAV or raw PCM file on one background thread.
+//! Samples are pushed to one single-producer single-consumer ring, and handed over to the
+//! writer thread block by block through atomic counters, so pushing samples never locks.
+//! If the ring is full, the producer waits for the writer thread or drops the block, see
+//! `AudioCaptureDesc::wait_when_full`.
+struct AudioCapture
+{
+    AudioCaptureDesc desc;
+    //! The audio captured when this is attached to `Emulator::audio_capture`.
+    AudioCaptureSource source = AudioCaptureSource::mixer;
+
+    //! The ring buffer storing `desc.ring_blocks * AUDIO_CAPTURE_BLOCK_FRAMES` frames.
+    f32* samples = nullptr;
+
+    // Producer states, only accessed by the producer thread.
+
+    //! The number of blocks filled by the producer.
+    u32 write_block = 0;
+    //! The number of frames written to the current block.
+    u32 write_offset = 0;
+    //! The number of frames pushed.
+    u64 num_frames = 0;
+    //! The number of frames dropped because the ring is full.
+    u64 num_dropped_frames = 0;
+    //! The number of blocks dropped because the ring is full.
+    u32 num_overruns = 0;
+
+    //! Writes committed blocks to `file`.
+    RingWriter writer;
+
+    // Writer states, only accessed by the writer thread.
+
+    Ref<IFile> file;
+    //! The size of sample data written to the file.
+    u64 data_size = 0;
+    //! The conversion buffer.
+    Vector<byte_t> converted;
+
+    //! Opens the file and starts the writer thread.
+    RV begin(const c8* path, const AudioCaptureDesc& desc);
+    //! Writes all pushed frames, patches the WAV header and closes the file.
+    void end();
+    ~AudioCapture()
+    {
+        end();
+    }
+    bool is_capturing() const { return file.valid(); }
+
+    //! Pushes one frame of `desc.num_channels` samples in [-1, 1].
+    void push(const f32* frame)
+    {
+        f32* dst = samples + ((usize)(write_block % desc.ring_blocks) * AUDIO_CAPTURE_BLOCK_FRAMES + write_offset) * desc.num_channels;
+        for(u32 i = 0; i < desc.num_channels; ++i)
+        {
+            dst[i] = frame[i];
+        }
+        ++num_frames;
+        ++write_offset;
+        if(write_offset == AUDIO_CAPTURE_BLOCK_FRAMES)
+        {
+            commit_block();
+        }
+    }
+    void commit_block();
+    //! Converts and writes `num_frames` frames. Called by the writer thread.
+    RV write_frames(const f32* frames, u32 num_frames);
+};
\ No newline at end of file
@@ -0,0 +1,159 @@
+#include "BatterySave.hpp"
+#include "Emulator.hpp"
+#include "Cartridge.hpp"
+#include <Luna/Runtime/File.hpp>
+#include <Luna/Runtime/Log.hpp>
+#include <Luna/Runtime/Time.hpp>
+
+static RV write_save_file(BatterySave* save, const Blob& data, const RTC& rtc, i64 timestamp)
+{
+    lutry
+    {
+        // Write to one temporary file and replace the save file with it, so that
+        // the save file is never left partially written.
+        String save_path = save->save_path.encode();
+        String temp_path = save_path;
+        temp_path.append(".tmp");
+        {
+            lulet(f, open_file(temp_path.c_str(), FileOpenFlag::write, FileCreationMode::create_always));
+            luexp(f->write(data.data(), data.size()));
+            if(save->has_rtc)
+            {
+                luexp(f->write(&rtc, sizeof(RTC)));
+                luexp(f->write(&timestamp, sizeof(i64)));
+            }
+            f->flush();
+        }
+        luexp(move_file(temp_path.c_str(), save_path.c_str()));
+        log_info("LunaGB", "Save cartridge RAM data to %s.", save_path.c_str());
+    }
+    lucatchret;
+    return ok;
+}
+static void battery_save_writer_run(void* params)
+{
+    BatterySave* save = (BatterySave*)params;
+    Blob data;
+    RTC rtc;
+    i64 timestamp;
+    while(true)
+    {
+        save->data_signal->wait();
+        save->lock.lock();
+        bool pending = save->pending;
+        bool exiting = save->exiting;
+        if(pending)
+        {
+            rtc = save->snapshot_rtc;
+            timestamp = save->snapshot_timestamp;
+            save->pending = false;
+            save->copying = true;
+        }
+        save->lock.unlock();
+        if(pending)
+        {
+            // `flush` does not modify the snapshot until `copying` is cleared.
+            data = save->snapshot;
+            save->lock.lock();
+            save->copying = false;
+            save->lock.unlock();
+            auto r = write_save_file(save, data, rtc, timestamp);
+            if(failed(r))
+            {
+                log_error("LunaGB", "Failed to save cartridge RAM data: %s", explain(r.errcode()));
+            }
+        }
+        if(exiting) break;
+    }
+}
+void BatterySave::init(Emulator* emu)
+{
+    luassert(emu->cram_size <= CRAM_MAX_PAGES * CRAM_PAGE_SIZE);
+    save_path = emu->cartridge_path;
+    save_path.replace_extension("sav");
+    has_rtc = is_cart_timer(get_cartridge_header(emu->rom_data)->cartridge_type);
+    memzero(dirty_pages, sizeof(dirty_pages));
+    dirty = false;
+    snapshot = Blob(emu->cram, emu->cram_size);
+    pending = false;
+    copying = false;
+    exiting = false;
+    data_signal = new_signal(false);
+    writer_thread = new_thread(battery_save_writer_run, this, "Battery save writer");
+    if(!writer_thread)
+    {
+        log_error("LunaGB", "Failed to start the battery save writer thread, cartridge RAM data is saved on the emulation thread.");
+    }
+}
+void BatterySave::update(Emulator* emu)
+{
+    if(dirty && emu->clock_cycles - last_write_cycles >= BATTERY_SAVE_DELAY_CYCLES)
+    {
+        flush(emu);
+    }
+}
+bool BatterySave::flush(Emulator* emu)
+{
+    lock.lock();
+    if(copying)
+    {
+        lock.unlock();
+        return false;
+    }
+    usize num_pages = (emu->cram_size + CRAM_PAGE_SIZE - 1) / CRAM_PAGE_SIZE;
+    for(usize i = 0; i < num_pages; ++i)
+    {
+        if(bit_test(dirty_pages, i))
+        {
+            usize offset = i * CRAM_PAGE_SIZE;
+            memcpy(snapshot.data() + offset, emu->cram + offset, min(CRAM_PAGE_SIZE, emu->cram_size - offset));
+        }
+    }
+    if(has_rtc)
+    {
+        snapshot_rtc = emu->rtc;
+        snapshot_timestamp = get_utc_timestamp();
+    }
+    pending = true;
+    lock.unlock();
+    memzero(dirty_pages, sizeof(dirty_pages));
+    dirty = false;
+    if(!writer_thread)
+    {
+        // The writer thread is not started, write the file on this thread.
+        pending = false;
+        auto r = write_save_file(this, snapshot, snapshot_rtc, snapshot_timestamp);
+        if(failed(r))
+        {
+            log_error("LunaGB", "Failed to save cartridge RAM data: %s", explain(r.errcode()));
+        }
+        return true;
+    }
+    data_signal->trigger();
+    return true;
+}
+void BatterySave::close(Emulator* emu)
+{
+    if(!data_signal) return;
+    // RTC keeps running after the last write, so always save RTC state when closing.
+    if(dirty || has_rtc)
+    {
+        // The writer thread only copies the snapshot for a short time.
+        while(!flush(emu))
+        {
+            yield_current_thread();
+        }
+    }
+    if(!writer_thread)
+    {
+        data_signal.reset();
+        return;
+    }
+    lock.lock();
+    exiting = true;
+    lock.unlock();
+    data_signal->trigger();
+    writer_thread->wait();
+    writer_thread.reset();
+    data_signal.reset();
+}
\ No newline at end of file
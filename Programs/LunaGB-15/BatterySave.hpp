@@ -0,0 +1,77 @@
+#pragma once
+#include <Luna/Runtime/Result.hpp>
+#include <Luna/Runtime/Path.hpp>
+#include <Luna/Runtime/Blob.hpp>
+#include <Luna/Runtime/Thread.hpp>
+#include <Luna/Runtime/Signal.hpp>
+#include <Luna/Runtime/SpinLock.hpp>
+#include <Luna/Runtime/MemoryUtils.hpp>
+#include "RTC.hpp"
+using namespace Luna;
+
+//! The granularity of dirty tracking of cartridge RAM.
+constexpr usize CRAM_PAGE_SIZE = 256;
+//! The maximum number of cartridge RAM pages (128KB).
+constexpr usize CRAM_MAX_PAGES = 128_kb / CRAM_PAGE_SIZE;
+//! Cartridge RAM data is saved after the game stops writing cartridge RAM for this many clock cycles (0.5 seconds).
+constexpr u64 BATTERY_SAVE_DELAY_CYCLES = 4194304 / 2;
+
+struct Emulator;
+//! Saves battery-backed cartridge RAM data to the .sav file in background.
+struct BatterySave
+{
+    //! The .sav file path.
+    Path save_path;
+    bool has_rtc = false;
+
+    // Emulation thread states.
+
+    //! One bit per cartridge RAM page written since the last flush.
+    u64 dirty_pages[CRAM_MAX_PAGES / 64];
+    //! `true` if cartridge RAM or RTC is written since the last flush.
+    bool dirty = false;
+    //! The clock cycles of the last write.
+    u64 last_write_cycles = 0;
+
+    // States shared with the writer thread, protected by `lock`.
+
+    SpinLock lock;
+    //! The copy of cartridge RAM data to be saved. Only dirty pages are copied from cartridge RAM on every flush.
+    Blob snapshot;
+    RTC snapshot_rtc;
+    i64 snapshot_timestamp = 0;
+    //! `true` if `snapshot` is updated and not written yet.
+    bool pending = false;
+    //! `true` while the writer thread copies `snapshot` outside of `lock`. `flush` does not modify
+    //! `snapshot` during the copy, and keeps dirty pages to be flushed later instead.
+    bool copying = false;
+    bool exiting = false;
+
+    Ref<IThread> writer_thread;
+    Ref<ISignal> data_signal;
+
+    //! Starts the writer thread. This should be called after cartridge RAM data is loaded.
+    //! If the writer thread cannot be started, cartridge RAM data is saved on the emulation thread.
+    void init(Emulator* emu);
+    //! Marks the cartridge RAM page containing `offset` dirty.
+    void mark_dirty(usize offset, u64 clock_cycles)
+    {
+        bit_set(dirty_pages, offset / CRAM_PAGE_SIZE);
+        dirty = true;
+        last_write_cycles = clock_cycles;
+    }
+    //! Marks the RTC state dirty.
+    void mark_rtc_dirty(u64 clock_cycles)
+    {
+        dirty = true;
+        last_write_cycles = clock_cycles;
+    }
+    //! Flushes dirty pages if the game stops writing cartridge RAM for `BATTERY_SAVE_DELAY_CYCLES`.
+    void update(Emulator* emu);
+    //! Copies dirty pages to the snapshot and wakes up the writer thread. This does not wait for file I/O.
+    //! @return Returns `false` if the writer thread is copying the snapshot, in which case dirty pages
+    //! are kept and should be flushed again later.
+    bool flush(Emulator* emu);
+    //! Flushes dirty pages and waits for the writer thread to finish.
+    void close(Emulator* emu);
+};
\ No newline at end of file
@@ -0,0 +1,181 @@
+#include "Breakpoints.hpp"
+#include "Emulator.hpp"
+#include "Cartridge.hpp"
+
+//! Gets the bank mapped to `addr`, or -1 if the address is not banked.
+inline i32 get_mapped_bank(const Emulator* emu, u16 addr)
+{
+    if(addr <= 0x7FFF) return (i32)get_cartridge_rom_bank(emu, addr);
+    if(addr >= 0xA000 && addr <= 0xBFFF) return emu->ram_bank_number;
+    return -1;
+}
+inline bool match_bank(const Emulator* emu, u16 addr, i32 bank)
+{
+    return bank < 0 || get_mapped_bank(emu, addr) == bank;
+}
+inline bool match_condition(WatchpointCondition condition, u8 value, u8 data, u8 old_data)
+{
+    switch(condition)
+    {
+        case WatchpointCondition::always: return true;
+        case WatchpointCondition::equal: return data == value;
+        case WatchpointCondition::not_equal: return data != value;
+        case WatchpointCondition::less: return data < value;
+        case WatchpointCondition::greater: return data > value;
+        case WatchpointCondition::changed: return data != old_data;
+        default: lupanic(); return false;
+    }
+}
+void Breakpoints::update_bitmaps(Emulator* emu)
+{
+    memzero(execute_bitmap, sizeof(execute_bitmap));
+    memzero(read_bitmap, sizeof(read_bitmap));
+    memzero(write_bitmap, sizeof(write_bitmap));
+    for(const Breakpoint& b : breakpoints)
+    {
+        if(b.enabled) bit_set(execute_bitmap, b.addr);
+    }
+    for(const Watchpoint& w : watchpoints)
+    {
+        if(!w.enabled) continue;
+        for(u32 addr = w.addr_begin; addr <= w.addr_end; ++addr)
+        {
+            if((u8)w.access & (u8)WatchpointAccess::read) bit_set(read_bitmap, addr);
+            if((u8)w.access & (u8)WatchpointAccess::write) bit_set(write_bitmap, addr);
+        }
+    }
+    has_io_triggers = false;
+    for(IOTrigger& t : io_triggers)
+    {
+        if(!t.enabled) continue;
+        has_io_triggers = true;
+        if(emu) t.last_value = emu->peek(t.addr);
+    }
+}
+bool Breakpoints::has_execute_checks() const
+{
+    for(const Breakpoint& b : breakpoints)
+    {
+        if(b.enabled) return true;
+    }
+    return has_io_triggers;
+}
+bool Breakpoints::has_memory_checks() const
+{
+    for(const Watchpoint& w : watchpoints)
+    {
+        if(w.enabled) return true;
+    }
+    return false;
+}
+bool Breakpoints::check_io_triggers(Emulator* emu, u16 pc)
+{
+    bool triggered = false;
+    for(IOTrigger& t : io_triggers)
+    {
+        if(!t.enabled) continue;
+        u8 value = emu->peek(t.addr);
+        if(value != t.last_value)
+        {
+            if(!triggered)
+            {
+                hit.type = BreakpointHitType::io_trigger;
+                hit.pc = pc;
+                hit.addr = t.addr;
+                hit.value = value;
+                hit.old_value = t.last_value;
+                triggered = true;
+            }
+            t.last_value = value;
+        }
+    }
+    return triggered;
+}
+bool Breakpoints::match_execute(Emulator* emu, u16 pc)
+{
+    for(const Breakpoint& b : breakpoints)
+    {
+        if(b.enabled && b.addr == pc && match_bank(emu, pc, b.bank))
+        {
+            hit.type = BreakpointHitType::breakpoint;
+            hit.pc = pc;
+            hit.addr = pc;
+            hit.value = 0;
+            hit.old_value = 0;
+            return true;
+        }
+    }
+    return false;
+}
+bool Breakpoints::match_read(Emulator* emu, u16 addr, u8 data)
+{
+    for(const Watchpoint& w : watchpoints)
+    {
+        if(w.enabled && ((u8)w.access & (u8)WatchpointAccess::read) && addr >= w.addr_begin && addr <= w.addr_end &&
+            match_bank(emu, addr, w.bank) && w.condition != WatchpointCondition::changed &&
+            match_condition(w.condition, w.value, data, data))
+        {
+            hit.type = BreakpointHitType::watchpoint_read;
+            hit.pc = instruction_pc;
+            hit.addr = addr;
+            hit.value = data;
+            hit.old_value = data;
+            return true;
+        }
+    }
+    return false;
+}
+bool Breakpoints::match_write(Emulator* emu, u16 addr, u8 data)
+{
+    u8 old_data = emu->peek(addr);
+    for(const Watchpoint& w : watchpoints)
+    {
+        if(w.enabled && ((u8)w.access & (u8)WatchpointAccess::write) && addr >= w.addr_begin && addr <= w.addr_end &&
+            match_bank(emu, addr, w.bank) && match_condition(w.condition, w.value, data, old_data))
+        {
+            hit.type = BreakpointHitType::watchpoint_write;
+            hit.pc = instruction_pc;
+            hit.addr = addr;
+            hit.value = data;
+            hit.old_value = old_data;
+            return true;
+        }
+    }
+    return false;
+}
+const c8* get_watchpoint_condition_name(WatchpointCondition condition)
+{
+    switch(condition)
+    {
+        case WatchpointCondition::always: return "always";
+        case WatchpointCondition::equal: return "==";
+        case WatchpointCondition::not_equal: return "!=";
+        case WatchpointCondition::less: return "<";
+        case WatchpointCondition::greater: return ">";
+        case WatchpointCondition::changed: return "changed";
+        default: lupanic(); return "";
+    }
+}
+String describe_breakpoint_hit(const BreakpointHit& hit)
+{
+    c8 buf[128];
+    switch(hit.type)
+    {
+        case BreakpointHitType::breakpoint:
+            snprintf(buf, 128, "Breakpoint at %04X.", (u32)hit.pc);
+            break;
+        case BreakpointHitType::watchpoint_read:
+            snprintf(buf, 128, "Instruction at %04X read %02X from %04X.", (u32)hit.pc, (u32)hit.value, (u32)hit.addr);
+            break;
+        case BreakpointHitType::watchpoint_write:
+            snprintf(buf, 128, "Instruction at %04X wrote %02X to %04X (was %02X).", (u32)hit.pc, (u32)hit.value, (u32)hit.addr, (u32)hit.old_value);
+            break;
+        case BreakpointHitType::io_trigger:
+            snprintf(buf, 128, "IO register %04X changed from %02X to %02X after instruction at %04X.",
+                (u32)hit.addr, (u32)hit.old_value, (u32)hit.value, (u32)hit.pc);
+            break;
+        default:
+            return String();
+    }
+    return String(buf);
+}
\ No newline at end of file
@@ -0,0 +1,168 @@
+#pragma once
+#include <Luna/Runtime/Vector.hpp>
+#include <Luna/Runtime/String.hpp>
+#include <Luna/Runtime/MemoryUtils.hpp>
+using namespace Luna;
+
+//! One execution breakpoint.
+struct Breakpoint
+{
+    u16 addr = 0;
+    //! The ROM bank that `addr` must be mapped to for 0x0000~0x7FFF. -1 matches all banks.
+    i32 bank = -1;
+    bool enabled = true;
+};
+
+//! The access types that trigger one watchpoint.
+enum class WatchpointAccess : u8
+{
+    read = 1,
+    write = 2,
+    read_write = 3,
+};
+
+//! The value condition of one watchpoint.
+enum class WatchpointCondition : u8
+{
+    //! Triggers on every access.
+    always,
+    //! Triggers if the value read or written equals `Watchpoint::value`.
+    equal,
+    //! Triggers if the value read or written does not equal `Watchpoint::value`.
+    not_equal,
+    //! Triggers if the value read or written is less than `Watchpoint::value`.
+    less,
+    //! Triggers if the value read or written is greater than `Watchpoint::value`.
+    greater,
+    //! Triggers if the value written differs from the current value. Reads never trigger this condition.
+    changed,
+};
+
+//! One memory watchpoint covering one address range.
+struct Watchpoint
+{
+    //! The first address (inclusive).
+    u16 addr_begin = 0;
+    //! The last address (inclusive).
+    u16 addr_end = 0;
+    //! The ROM or cartridge RAM bank that the address must be mapped to for 0x0000~0x7FFF and 0xA000~0xBFFF.
+    //! -1 matches all banks.
+    i32 bank = -1;
+    WatchpointAccess access = WatchpointAccess::write;
+    WatchpointCondition condition = WatchpointCondition::always;
+    u8 value = 0;
+    bool enabled = true;
+};
+
+//! Pauses the emulation when the value of one IO register changes, whether changed by the game or the hardware.
+struct IOTrigger
+{
+    //! The IO register address (0xFF00~0xFF7F, 0xFFFF).
+    u16 addr = 0xFF44;
+    bool enabled = true;
+    //! The register value seen after the last instruction.
+    u8 last_value = 0;
+};
+
+enum class BreakpointHitType : u8
+{
+    none,
+    breakpoint,
+    watchpoint_read,
+    watchpoint_write,
+    io_trigger,
+};
+
+//! Describes why the emulation is paused by breakpoints.
+struct BreakpointHit
+{
+    BreakpointHitType type = BreakpointHitType::none;
+    //! The PC register of the instruction that triggers the hit.
+    u16 pc = 0;
+    //! The address accessed.
+    u16 addr = 0;
+    //! The value read or written. For IO triggers, this is the new register value.
+    u8 value = 0;
+    //! For IO triggers and write watchpoints, the value before the change.
+    u8 old_value = 0;
+};
+
+struct Emulator;
+//! Execution breakpoints, memory watchpoints and IO triggers.
+//! Every address is first looked up in one bitmap covering the whole address space, so checking
+//! addresses without breakpoints costs only one load and test.
+struct Breakpoints
+{
+    Vector<Breakpoint> breakpoints;
+    Vector<Watchpoint> watchpoints;
+    Vector<IOTrigger> io_triggers;
+
+    //! One bit per address that has at least one enabled breakpoint.
+    u64 execute_bitmap[65536 / 64];
+    //! One bit per address that has at least one enabled read watchpoint.
+    u64 read_bitmap[65536 / 64];
+    //! One bit per address that has at least one enabled write watchpoint.
+    u64 write_bitmap[65536 / 64];
+    //! `true` if any IO trigger is enabled.
+    bool has_io_triggers = false;
+
+    //! The breakpoint at this address is ignored once, so that the emulation can be resumed
+    //! from one breakpoint. U32_MAX if not set. See `Emulator::resume`.
+    u32 skip_pc = U32_MAX;
+    //! The PC register of the instruction being executed, used to report watchpoint hits.
+    u16 instruction_pc = 0;
+    //! The last hit.
+    BreakpointHit hit;
+
+    Breakpoints()
+    {
+        update_bitmaps(nullptr);
+    }
+    //! Rebuilds lookup bitmaps. This must be called after breakpoints, watchpoints or IO triggers are changed.
+    //! The current values of IO registers are captured if `emu` is not `nullptr`.
+    void update_bitmaps(Emulator* emu);
+    //! `true` if CPU needs to check execution breakpoints or IO triggers.
+    bool has_execute_checks() const;
+    //! `true` if CPU needs to check memory watchpoints.
+    bool has_memory_checks() const;
+    //! Ignores the breakpoint at `pc` once.
+    void skip(u16 pc)
+    {
+        skip_pc = bit_test(execute_bitmap, pc) ? pc : U32_MAX;
+    }
+
+    //! Checks whether the instruction at `pc` hits one breakpoint.
+    bool check_execute(Emulator* emu, u16 pc)
+    {
+        if(!bit_test(execute_bitmap, pc)) return false;
+        if(skip_pc == pc)
+        {
+            skip_pc = U32_MAX;
+            return false;
+        }
+        return match_execute(emu, pc);
+    }
+    //! Checks whether reading `data` from `addr` hits one watchpoint.
+    bool check_read(Emulator* emu, u16 addr, u8 data)
+    {
+        if(!bit_test(read_bitmap, addr)) return false;
+        return match_read(emu, addr, data);
+    }
+    //! Checks whether writing `data` to `addr` hits one watchpoint. This must be called before the data is written.
+    bool check_write(Emulator* emu, u16 addr, u8 data)
+    {
+        if(!bit_test(write_bitmap, addr)) return false;
+        return match_write(emu, addr, data);
+    }
+    //! Checks whether any IO register watched by IO triggers is changed.
+    bool check_io_triggers(Emulator* emu, u16 pc);
+
+    bool match_execute(Emulator* emu, u16 pc);
+    bool match_read(Emulator* emu, u16 addr, u8 data);
+    bool match_write(Emulator* emu, u16 addr, u8 data);
+};
+
+//! Gets the name of one watchpoint condition.
+const c8* get_watchpoint_condition_name(WatchpointCondition condition);
+//! Describes one breakpoint hit.
+String describe_breakpoint_hit(const BreakpointHit& hit);
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+#include <Luna/Runtime/Math/Math.hpp>
+using namespace Luna;
+
+// Wrappers of 16-byte SIMD vectors used by byte processing code like line compositing and RAM search.
+// `BYTE_VECTOR_SIMD` is defined if SSE2 or Neon is available, otherwise callers use scalar code.
+
+#if defined(LUNA_SSE2_INTRINSICS)
+#define BYTE_VECTOR_SIMD
+using byte_vec_t = __m128i;
+inline byte_vec_t vec_load(const u8* p) { return _mm_loadu_si128((const __m128i*)p); }
+inline void vec_store(u8* p, byte_vec_t v) { _mm_storeu_si128((__m128i*)p, v); }
+inline byte_vec_t vec_splat(u8 v) { return _mm_set1_epi8((i8)v); }
+inline byte_vec_t vec_and(byte_vec_t a, byte_vec_t b) { return _mm_and_si128(a, b); }
+inline byte_vec_t vec_or(byte_vec_t a, byte_vec_t b) { return _mm_or_si128(a, b); }
+inline byte_vec_t vec_not(byte_vec_t a) { return _mm_xor_si128(a, _mm_set1_epi8(-1)); }
+inline byte_vec_t vec_eq(byte_vec_t a, byte_vec_t b) { return _mm_cmpeq_epi8(a, b); }
+//! Unsigned `a >= b`. SSE2 only has signed byte comparisons, so this is computed by `max(a, b) == a`.
+inline byte_vec_t vec_ge(byte_vec_t a, byte_vec_t b) { return _mm_cmpeq_epi8(_mm_max_epu8(a, b), a); }
+inline byte_vec_t vec_gt(byte_vec_t a, byte_vec_t b) { return _mm_andnot_si128(_mm_cmpeq_epi8(a, b), vec_ge(a, b)); }
+//! `mask ? a : b` for every byte, `mask` bytes must be 0x00 or 0xFF.
+inline byte_vec_t vec_select(byte_vec_t mask, byte_vec_t a, byte_vec_t b) { return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)); }
+//! Shifts every byte right. Bits shifted in from the next byte are only in the high bits, which
+//! are masked out by callers.
+template <i32 _Bits>
+inline byte_vec_t vec_shr(byte_vec_t a) { return _mm_srli_epi16(a, _Bits); }
+//! Gets the highest bit of every byte as one 16-bit mask.
+inline u64 vec_movemask(byte_vec_t a) { return (u64)(u32)_mm_movemask_epi8(a); }
+//! Interleaves 16 pixels of 4 channels and stores 64 bytes.
+inline void vec_store_rgba(u8* p, byte_vec_t r, byte_vec_t g, byte_vec_t b, byte_vec_t a)
+{
+    __m128i rg_lo = _mm_unpacklo_epi8(r, g);
+    __m128i rg_hi = _mm_unpackhi_epi8(r, g);
+    __m128i ba_lo = _mm_unpacklo_epi8(b, a);
+    __m128i ba_hi = _mm_unpackhi_epi8(b, a);
+    _mm_storeu_si128((__m128i*)p, _mm_unpacklo_epi16(rg_lo, ba_lo));
+    _mm_storeu_si128((__m128i*)(p + 16), _mm_unpackhi_epi16(rg_lo, ba_lo));
+    _mm_storeu_si128((__m128i*)(p + 32), _mm_unpacklo_epi16(rg_hi, ba_hi));
+    _mm_storeu_si128((__m128i*)(p + 48), _mm_unpackhi_epi16(rg_hi, ba_hi));
+}
+#elif defined(LUNA_NEON_INTRINSICS) && defined(LUNA_PLATFORM_ARM64)
+#define BYTE_VECTOR_SIMD
+using byte_vec_t = uint8x16_t;
+inline byte_vec_t vec_load(const u8* p) { return vld1q_u8(p); }
+inline void vec_store(u8* p, byte_vec_t v) { vst1q_u8(p, v); }
+inline byte_vec_t vec_splat(u8 v) { return vdupq_n_u8(v); }
+inline byte_vec_t vec_and(byte_vec_t a, byte_vec_t b) { return vandq_u8(a, b); }
+inline byte_vec_t vec_or(byte_vec_t a, byte_vec_t b) { return vorrq_u8(a, b); }
+inline byte_vec_t vec_not(byte_vec_t a) { return vmvnq_u8(a); }
+inline byte_vec_t vec_eq(byte_vec_t a, byte_vec_t b) { return vceqq_u8(a, b); }
+inline byte_vec_t vec_ge(byte_vec_t a, byte_vec_t b) { return vcgeq_u8(a, b); }
+inline byte_vec_t vec_gt(byte_vec_t a, byte_vec_t b) { return vcgtq_u8(a, b); }
+inline byte_vec_t vec_select(byte_vec_t mask, byte_vec_t a, byte_vec_t b) { return vbslq_u8(mask, a, b); }
+template <i32 _Bits>
+inline byte_vec_t vec_shr(byte_vec_t a) { return vshrq_n_u8(a, _Bits); }
+inline u64 vec_movemask(byte_vec_t a)
+{
+    // Neon does not have movemask, weight every lane by its bit and sum up each half.
+    static const u8 weights[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    uint8x16_t bits = vandq_u8(a, vld1q_u8(weights));
+    return (u64)vaddv_u8(vget_low_u8(bits)) | ((u64)vaddv_u8(vget_high_u8(bits)) << 8);
+}
+inline void vec_store_rgba(u8* p, byte_vec_t r, byte_vec_t g, byte_vec_t b, byte_vec_t a)
+{
+    uint8x16x4_t v = { r, g, b, a };
+    vst4q_u8(p, v);
+}
+#endif
\ No newline at end of file
@@ -2,7 +2,6 @@
 #include "Emulator.hpp"
 #include <Luna/Runtime/Log.hpp>
 #include "Instructions.hpp"
-#include "App.hpp"
 void CPU::init()
 {
     // ref: https://github.com/rockytriton/LLD_gbemu/raw/main/docs/The%20Cycle-Accurate%20Game%20Boy%20Docs.pdf
@@ -16,52 +15,52 @@ void CPU::init()
     interrupt_master_enabled = false;
     interrupt_master_enabling_countdown = 0;
 }
-void CPU::log(Emulator* emu)
-{
-    c8 buf[256];
-    c8 flags[16];
-    snprintf(flags, 16, "%c%c%c%c", 
-        fz() ? 'Z' : '-',
-        fn() ? 'N' : '-',
-        fh() ? 'H' : '-',
-        fc() ? 'C' : '-'
-    );
-    snprintf(buf, 256, "%02X %02X %02X A: %02X F: %s BC: %04X DE: %04X HL: %04X PC: %04X SP: %04X\n", 
-        //get_opcode_name(emu->bus_read(emu->cpu.pc)),
-        emu->bus_read(emu->cpu.pc),
-        emu->bus_read(emu->cpu.pc + 1),
-        emu->bus_read(emu->cpu.pc + 2),
-        (u32)emu->cpu.a, 
-        flags,
-        (u32)emu->cpu.bc(), 
-        (u32)emu->cpu.de(),
-        (u32)emu->cpu.hl(),
-        (u32)emu->cpu.pc,
-        (u32)emu->cpu.sp
-        );
-    g_app->debug_window.cpu_log.append(buf);
-}
+template <u32 _Features>
 void CPU::step(Emulator* emu)
 {
+    // Used by the profiler and IO triggers.
+    u64 begin_cycles = emu->clock_cycles;
+    u16 begin_pc = pc;
+    u16 begin_sp = sp;
+    if constexpr((_Features & EMULATOR_FEATURE_BREAKPOINTS) != 0)
+    {
+        if(!halted && emu->breakpoints->check_execute(emu, pc))
+        {
+            emu->paused = true;
+            return;
+        }
+    }
+    if constexpr((_Features & EMULATOR_FEATURE_WATCHPOINTS) != 0)
+    {
+        emu->breakpoints->instruction_pc = pc;
+    }
     if(!halted)
     {
         // Handle interruptions.
         if(interrupt_master_enabled && (emu->int_flags & emu->int_enable_flags))
         {
-            service_interrupt(emu);
+            service_interrupt<_Features>(emu);
+            if constexpr((_Features & EMULATOR_FEATURE_PROFILER) != 0)
+            {
+                emu->profiler->on_interrupt(emu, emu->clock_cycles - begin_cycles);
+            }
         }
         else
         {
-            if(g_app->debug_window.cpu_logging)
+            if constexpr((_Features & EMULATOR_FEATURE_TRACE) != 0)
+            {
+                emu->trace_recorder->record(emu);
+            }
+            if constexpr((_Features & EMULATOR_FEATURE_ACCESS_COUNTERS) != 0)
             {
-                log(emu);
+                ++emu->access_counters->executes[pc / ACCESS_COUNTER_PAGE_SIZE];
             }
             // fetch opcode.
             u8 opcode = emu->bus_read(pc);
             // increase counter.
             ++pc;
             // execute opcode.
-            instruction_func_t* instruction = instructions_map[opcode];
+            instruction_func_t* instruction = Instructions<_Features & EMULATOR_BUS_FEATURES>::map[opcode];
             if(!instruction)
             {
                 log_error("LunaGB", "Instruction 0x%02X not present.", (u32)opcode);
@@ -70,12 +69,20 @@ void CPU::step(Emulator* emu)
             else
             {
                 instruction(emu);
+                if constexpr((_Features & EMULATOR_FEATURE_PROFILER) != 0)
+                {
+                    emu->profiler->on_instruction(emu, begin_pc, opcode, begin_sp, emu->clock_cycles - begin_cycles);
+                }
             }
         }
     }
     else
     {
         emu->tick(1);
+        if constexpr((_Features & EMULATOR_FEATURE_PROFILER) != 0)
+        {
+            emu->profiler->on_halt(emu, emu->clock_cycles - begin_cycles);
+        }
         // Wake up CPU if any interruption is pending.
         // This happens even if IME is disabled (interruption_enabled == false).
         if(emu->int_flags & emu->int_enable_flags)
@@ -92,13 +99,61 @@ void CPU::step(Emulator* emu)
             interrupt_master_enabled = true;
         }
     }
+    if constexpr((_Features & EMULATOR_FEATURE_BREAKPOINTS) != 0)
+    {
+        if(emu->breakpoints->has_io_triggers && emu->breakpoints->check_io_triggers(emu, begin_pc))
+        {
+            emu->paused = true;
+        }
+    }
+}
+template <u32 _Features>
+static void step_cpu(Emulator* emu)
+{
+    emu->cpu.step<_Features>(emu);
+}
+template <u32 _Features>
+static void run_cpu(Emulator* emu, u64 end_cycles)
+{
+    CPU& cpu = emu->cpu;
+    while(emu->clock_cycles < end_cycles && !emu->paused)
+    {
+        cpu.step<_Features>(emu);
+    }
+}
+using cpu_step_func_t = void(Emulator* emu);
+using cpu_run_func_t = void(Emulator* emu, u64 end_cycles);
+//! CPU cores specialized for every combination of debug features, indexed by `Emulator::features`.
+static cpu_step_func_t* const cpu_step_funcs[EMULATOR_NUM_FEATURE_SETS] = 
+{
+    step_cpu<0>,  step_cpu<1>,  step_cpu<2>,  step_cpu<3>,  step_cpu<4>,  step_cpu<5>,  step_cpu<6>,  step_cpu<7>,
+    step_cpu<8>,  step_cpu<9>,  step_cpu<10>, step_cpu<11>, step_cpu<12>, step_cpu<13>, step_cpu<14>, step_cpu<15>,
+    step_cpu<16>, step_cpu<17>, step_cpu<18>, step_cpu<19>, step_cpu<20>, step_cpu<21>, step_cpu<22>, step_cpu<23>,
+    step_cpu<24>, step_cpu<25>, step_cpu<26>, step_cpu<27>, step_cpu<28>, step_cpu<29>, step_cpu<30>, step_cpu<31>
+};
+static cpu_run_func_t* const cpu_run_funcs[EMULATOR_NUM_FEATURE_SETS] = 
+{
+    run_cpu<0>,  run_cpu<1>,  run_cpu<2>,  run_cpu<3>,  run_cpu<4>,  run_cpu<5>,  run_cpu<6>,  run_cpu<7>,
+    run_cpu<8>,  run_cpu<9>,  run_cpu<10>, run_cpu<11>, run_cpu<12>, run_cpu<13>, run_cpu<14>, run_cpu<15>,
+    run_cpu<16>, run_cpu<17>, run_cpu<18>, run_cpu<19>, run_cpu<20>, run_cpu<21>, run_cpu<22>, run_cpu<23>,
+    run_cpu<24>, run_cpu<25>, run_cpu<26>, run_cpu<27>, run_cpu<28>, run_cpu<29>, run_cpu<30>, run_cpu<31>
+};
+void CPU::step(Emulator* emu)
+{
+    cpu_step_funcs[emu->features](emu);
+}
+void CPU::run(Emulator* emu, u64 end_cycles)
+{
+    cpu_run_funcs[emu->features](emu, end_cycles);
 }
+template <u32 _Features>
 inline void push_16(Emulator* emu, u16 v)
 {
     emu->cpu.sp -= 2;
-    emu->bus_write(emu->cpu.sp + 1, (u8)((v >> 8) & 0xFF));
-    emu->bus_write(emu->cpu.sp, (u8)(v & 0xFF));
+    emu->bus_write<_Features>(emu->cpu.sp + 1, (u8)((v >> 8) & 0xFF));
+    emu->bus_write<_Features>(emu->cpu.sp, (u8)(v & 0xFF));
 }
+template <u32 _Features>
 void CPU::service_interrupt(Emulator* emu)
 {
     u8 int_flags = emu->int_flags & emu->int_enable_flags;
@@ -111,7 +166,7 @@ void CPU::service_interrupt(Emulator* emu)
     emu->int_flags &= ~service_int;
     emu->cpu.disable_interrupt_master();
     emu->tick(2);
-    push_16(emu, emu->cpu.pc);
+    push_16<_Features>(emu, emu->cpu.pc);
     emu->tick(2);
     switch(service_int)
     {
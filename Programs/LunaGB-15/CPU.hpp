@@ -2,25 +2,32 @@
 #include <Luna/Runtime/Base.hpp>
 using namespace Luna;
 
+#if defined(LUNA_COMPILER_MSVC) || defined(LUNA_COMPILER_GCC) || defined(LUNA_COMPILER_CLANG)
+#define CPU_REGISTER_PAIRS
+#endif
+
+#if defined(CPU_REGISTER_PAIRS) && defined(LUNA_PLATFORM_LITTLE_ENDIAN)
+#define CPU_REGISTER_PAIR(_pair, _high, _low) union { u16 _pair; struct { u8 _low; u8 _high; }; };
+#elif defined(CPU_REGISTER_PAIRS)
+#define CPU_REGISTER_PAIR(_pair, _high, _low) union { u16 _pair; struct { u8 _high; u8 _low; }; };
+#else
+#define CPU_REGISTER_PAIR(_pair, _high, _low) u8 _high; u8 _low;
+#endif
+
 struct Emulator;
 struct CPU
 {
     //! A register.
     u8 a;
-    //! F register.
-    u8 f;
-    //! B register.
-    u8 b;
-    //! C register.
-    u8 c;
-    //! D register.
-    u8 d;
-    //! E register.
-    u8 e;
-    //! H register.
-    u8 h;
-    //! L register.
-    u8 l;
+    // Register pairs are stored as 16-bit values if the compiler supports anonymous structs in
+    // unions, so that `bc()`, `de()` and `hl()` do not need to combine two 8-bit registers. The
+    // order of the two registers in one pair follows the host byte order.
+    //! BC register, B is the high register and C is the low register.
+    CPU_REGISTER_PAIR(bc_pair, b, c)
+    //! DE register, D is the high register and E is the low register.
+    CPU_REGISTER_PAIR(de_pair, d, e)
+    //! HL register, H is the high register and L is the low register.
+    CPU_REGISTER_PAIR(hl_pair, h, l)
     //! SP register (Stack Pointer).
     u16 sp;
     //! PC register (Program Counter/Pointer).
@@ -32,32 +39,67 @@ struct CPU
     //! Interrupt master enableing countdown.
     u8 interrupt_master_enabling_countdown;
 
-    u16 af() const { return (((u16)a) << 8) + (u16)f; }
+    // F register is not stored directly. ALU instructions store their results and carries
+    // instead, and every flag is evaluated only when it is read. Use `f()` to get F.
+
+    //! Z flag is 1 if this is 0. ALU instructions store their results here.
+    u8 flag_z_result;
+    //! N flag.
+    bool flag_n;
+    //! H flag is bit 4 of this. ALU instructions store `v1 ^ v2 ^ result` here, whose bit 4 is
+    //! the carry (or borrow) from bit 3 to bit 4.
+    u8 flag_h_carries;
+    //! C flag.
+    bool flag_c;
+
+    u8 f() const { return (fz() ? 0x80 : 0) | (fn() ? 0x40 : 0) | (fh() ? 0x20 : 0) | (fc() ? 0x10 : 0); }
+    void f(u8 v)
+    {
+        flag_z_result = (v & 0x80) ? 0 : 1;
+        flag_n = (v & 0x40) != 0;
+        flag_h_carries = (v & 0x20) ? 0x10 : 0;
+        flag_c = (v & 0x10) != 0;
+    }
+
+    u16 af() const { return (((u16)a) << 8) + (u16)f(); }
+    void af(u16 v) { a = (u8)(v >> 8); f((u8)(v & 0xF0)); } // The lower 4 bits of F should always be 0.
+#ifdef CPU_REGISTER_PAIRS
+    u16 bc() const { return bc_pair; }
+    u16 de() const { return de_pair; }
+    u16 hl() const { return hl_pair; }
+    void bc(u16 v) { bc_pair = v; }
+    void de(u16 v) { de_pair = v; }
+    void hl(u16 v) { hl_pair = v; }
+#else
     u16 bc() const { return (((u16)b) << 8) + (u16)c; }
     u16 de() const { return (((u16)d) << 8) + (u16)e; }
     u16 hl() const { return (((u16)h) << 8) + (u16)l; }
-    void af(u16 v) { a = (u8)(v >> 8); f = (u8)(v & 0xF0); } // The lower 4 bits of F should always be 0.
     void bc(u16 v) { b = (u8)(v >> 8); c = (u8)(v & 0xFF); }
     void de(u16 v) { d = (u8)(v >> 8); e = (u8)(v & 0xFF); }
     void hl(u16 v) { h = (u8)(v >> 8); l = (u8)(v & 0xFF); }
+#endif
 
-    bool fz() const { return (f & 0x80) != 0; }
-    bool fn() const { return (f & 0x40) != 0; }
-    bool fh() const { return (f & 0x20) != 0; }
-    bool fc() const { return (f & 0x10) != 0; }
-    void set_fz() { f |= 0x80; }
-    void reset_fz() { f &= 0x7F; }
-    void set_fn() { f |= 0x40; }
-    void reset_fn() { f &= 0xBF; }
-    void set_fh() { f |= 0x20; }
-    void reset_fh() { f &= 0xDF; }
-    void set_fc() { f |= 0x10; }
-    void reset_fc() { f &= 0xEF; }
+    bool fz() const { return flag_z_result == 0; }
+    bool fn() const { return flag_n; }
+    bool fh() const { return (flag_h_carries & 0x10) != 0; }
+    bool fc() const { return flag_c; }
+    void set_fz() { flag_z_result = 0; }
+    void reset_fz() { flag_z_result = 1; }
+    void set_fn() { flag_n = true; }
+    void reset_fn() { flag_n = false; }
+    void set_fh() { flag_h_carries = 0x10; }
+    void reset_fh() { flag_h_carries = 0; }
+    void set_fc() { flag_c = true; }
+    void reset_fc() { flag_c = false; }
 
     void init();
+    //! Executes one instruction using the CPU core specialized for `emu->features`.
     void step(Emulator* emu);
-
-    void log(Emulator* emu);
+    //! Executes one instruction with debug features in `_Features` enabled.
+    template <u32 _Features>
+    void step(Emulator* emu);
+    //! Executes instructions until `emu->clock_cycles` reaches `end_cycles` or the emulation is paused.
+    void run(Emulator* emu, u64 end_cycles);
 
     void enable_interrupt_master()
     {
@@ -68,5 +110,6 @@ struct CPU
         interrupt_master_enabled = false;
         interrupt_master_enabling_countdown = 0;
     }
+    template <u32 _Features>
     void service_interrupt(Emulator* emu);
 };
\ No newline at end of file
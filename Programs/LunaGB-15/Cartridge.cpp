@@ -136,13 +136,12 @@ u8 mbc1_read(Emulator* emu, u16 addr)
     {
         if(emu->banking_mode && emu->num_rom_banks > 32)
         {
-            usize bank_index = emu->ram_bank_number;
-            usize bank_offset = bank_index * 32 * 16_kb;
-            return emu->rom_data[bank_offset + addr];
+            usize bank_index = emu->ram_bank_number * 32;
+            return emu->rom_banks[bank_index][addr];
         }
         else
         {
-            return emu->rom_data[addr];
+            return emu->rom_banks[0][addr];
         }
     }
     if(addr >= 0x4000 && addr <= 0x7FFF)
@@ -151,14 +150,12 @@ u8 mbc1_read(Emulator* emu, u16 addr)
         if(emu->banking_mode && emu->num_rom_banks > 32)
         {
             usize bank_index = emu->rom_bank_number + (emu->ram_bank_number << 5);
-            usize bank_offset = bank_index * 16_kb;
-            return emu->rom_data[bank_offset + (addr - 0x4000)];
+            return emu->rom_banks[bank_index][addr - 0x4000];
         }
         else
         {
             usize bank_index = emu->rom_bank_number;
-            usize bank_offset = bank_index * 16_kb;
-            return emu->rom_data[bank_offset + (addr - 0x4000)];
+            return emu->rom_banks[bank_index][addr - 0x4000];
         }
     }
     if(addr >= 0xA000 && addr <= 0xBFFF)
@@ -188,7 +185,7 @@ u8 mbc1_read(Emulator* emu, u16 addr)
             }
         }
     }
-    log_error("LunaGB", "Unsupported MBC1 cartridge read address: 0x%04X", (u32)addr);
+    lulog_rate_limited(1.0, LogVerbosity::error, "LunaGB", "Unsupported MBC1 cartridge read address: 0x%04X", (u32)addr);
     return 0xFF;
 }
 void mbc1_write(Emulator* emu, u16 addr, u8 data)
@@ -281,36 +278,35 @@ void mbc1_write(Emulator* emu, u16 addr, u8 data)
                     // Advanced banking mode.
                     usize bank_offset = emu->ram_bank_number * 8_kb;
                     luassert(bank_offset + (addr - 0xA000) <= emu->cram_size);
-                    emu->cram[bank_offset + (addr - 0xA000)] = data;
+                    emu->cram_write(bank_offset + (addr - 0xA000), data);
                 }
                 else
                 {
                     // Simple banking mode.
-                    emu->cram[addr - 0xA000] = data;
+                    emu->cram_write(addr - 0xA000, data);
                 }
             }
             else
             {
                 // ram_bank_number is used for switching ROM banks, use 1 ram page.
-                emu->cram[addr - 0xA000] = data;
+                emu->cram_write(addr - 0xA000, data);
             }
             return;
         }
     }
-    log_error("LunaGB", "Unsupported MBC1 cartridge write address: 0x%04X", (u32)addr);
+    lulog_rate_limited(1.0, LogVerbosity::error, "LunaGB", "Unsupported MBC1 cartridge write address: 0x%04X", (u32)addr);
 }
 u8 mbc2_read(Emulator* emu, u16 addr)
 {
     if(addr <= 0x3FFF)
     {
-        return emu->rom_data[addr];
+        return emu->rom_banks[0][addr];
     }
     if(addr >= 0x4000 && addr <= 0x7FFF)
     {
         // Cartridge ROM bank 01-0F.
         usize bank_index = emu->rom_bank_number;
-        usize bank_offset = bank_index * 16_kb;
-        return emu->rom_data[bank_offset + (addr - 0x4000)];
+        return emu->rom_banks[bank_index][addr - 0x4000];
     }
     if(addr >= 0xA000 && addr <= 0xBFFF)
     {
@@ -319,7 +315,7 @@ u8 mbc2_read(Emulator* emu, u16 addr)
         data_offset %= 512;
         return (emu->cram[data_offset] & 0x0F) | 0xF0;
     }
-    log_error("LunaGB", "Unsupported MBC2 cartridge read address: 0x%04X", (u32)addr);
+    lulog_rate_limited(1.0, LogVerbosity::error, "LunaGB", "Unsupported MBC2 cartridge read address: 0x%04X", (u32)addr);
     return 0xFF;
 }
 void mbc2_write(Emulator* emu, u16 addr, u8 data)
@@ -370,23 +366,22 @@ void mbc2_write(Emulator* emu, u16 addr, u8 data)
         if(!emu->cram_enable) return;
         u16 data_offset = addr - 0xA000;
         data_offset %= 512;
-        emu->cram[data_offset] = data & 0x0F;
+        emu->cram_write(data_offset, data & 0x0F);
         return;
     }
-    log_error("LunaGB", "Unsupported MBC2 cartridge write address: 0x%04X", (u32)addr);
+    lulog_rate_limited(1.0, LogVerbosity::error, "LunaGB", "Unsupported MBC2 cartridge write address: 0x%04X", (u32)addr);
 }
 u8 mbc3_read(Emulator* emu, u16 addr)
 {
     if(addr <= 0x3FFF)
     {
-        return emu->rom_data[addr];
+        return emu->rom_banks[0][addr];
     }
     if(addr >= 0x4000 && addr <= 0x7FFF)
     {
         // Cartridge ROM bank 01-7F.
         usize bank_index = emu->rom_bank_number;
-        usize bank_offset = bank_index * 16_kb;
-        return emu->rom_data[bank_offset + (addr - 0x4000)];
+        return emu->rom_banks[bank_index][addr - 0x4000];
     }
     if(addr >= 0xA000 && addr <= 0xBFFF)
     {
@@ -406,7 +401,7 @@ u8 mbc3_read(Emulator* emu, u16 addr)
             return ((u8*)(&emu->rtc.s))[emu->ram_bank_number - 0x08];
         }
     }
-    log_error("LunaGB", "Unsupported MBC3 cartridge read address: 0x%04X", (u32)addr);
+    lulog_rate_limited(1.0, LogVerbosity::error, "LunaGB", "Unsupported MBC3 cartridge read address: 0x%04X", (u32)addr);
     return 0xFF;
 }
 void mbc3_write(Emulator* emu, u16 addr, u8 data)
@@ -468,7 +463,7 @@ void mbc3_write(Emulator* emu, u16 addr, u8 data)
                 if(!emu->cram_enable) return;
                 usize bank_offset = emu->ram_bank_number * 8_kb;
                 luassert(bank_offset + (addr - 0xA000) <= emu->cram_size);
-                emu->cram[bank_offset + (addr - 0xA000)] = data;
+                emu->cram_write(bank_offset + (addr - 0xA000), data);
                 return;
             }
         }
@@ -477,10 +472,11 @@ void mbc3_write(Emulator* emu, u16 addr, u8 data)
         {
             ((u8*)(&emu->rtc.s))[emu->ram_bank_number - 0x08] = data;
             emu->rtc.update_timestamp();
+            if(emu->battery_save) emu->battery_save->mark_rtc_dirty(emu->clock_cycles);
             return;
         }
     }
-    log_error("LunaGB", "Unsupported MBC3 cartridge write address: 0x%04X", (u32)addr);
+    lulog_rate_limited(1.0, LogVerbosity::error, "LunaGB", "Unsupported MBC3 cartridge write address: 0x%04X", (u32)addr);
 }
 u8 cartridge_read(Emulator* emu, u16 addr)
 {
@@ -501,16 +497,34 @@ u8 cartridge_read(Emulator* emu, u16 addr)
     {
         if(addr <= 0x7FFF)
         {
-            return emu->rom_data[addr];
+            return emu->rom_banks[addr / 16_kb][addr % 16_kb];
         }
         if(addr >= 0xA000 && addr <= 0xBFFF && emu->cram)
         {
             return emu->cram[addr - 0xA000];
         }
     }
-    log_error("LunaGB", "Unsupported cartridge read address: 0x%04X", (u32)addr);
+    lulog_rate_limited(1.0, LogVerbosity::error, "LunaGB", "Unsupported cartridge read address: 0x%04X", (u32)addr);
     return 0xFF;
 }
+usize get_cartridge_rom_bank(const Emulator* emu, u16 addr)
+{
+    u8 cartridge_type = get_cartridge_header(emu->rom_data)->cartridge_type;
+    if(is_cart_mbc1(cartridge_type))
+    {
+        bool advanced_banking = emu->banking_mode && emu->num_rom_banks > 32;
+        if(addr <= 0x3FFF)
+        {
+            return advanced_banking ? emu->ram_bank_number * 32 : 0;
+        }
+        return advanced_banking ? emu->rom_bank_number + (emu->ram_bank_number << 5) : emu->rom_bank_number;
+    }
+    else if(is_cart_mbc2(cartridge_type) || is_cart_mbc3(cartridge_type))
+    {
+        return addr <= 0x3FFF ? 0 : emu->rom_bank_number;
+    }
+    return addr / 16_kb;
+}
 void cartridge_write(Emulator* emu, u16 addr, u8 data)
 {
     u8 cartridge_type = get_cartridge_header(emu->rom_data)->cartridge_type;
@@ -533,9 +547,9 @@ void cartridge_write(Emulator* emu, u16 addr, u8 data)
     {
         if(addr >= 0xA000 && addr <= 0xBFFF && emu->cram)
         {
-            emu->cram[addr - 0xA000] = data;
+            emu->cram_write(addr - 0xA000, data);
             return;
         }
     }
-    log_error("LunaGB", "Unsupported cartridge write address: 0x%04X", (u32)addr);
+    lulog_rate_limited(1.0, LogVerbosity::error, "LunaGB", "Unsupported cartridge write address: 0x%04X", (u32)addr);
 }
\ No newline at end of file
@@ -21,9 +21,9 @@ struct CartridgeHeader
     u8 global_checksum[2];
 };
 
-inline CartridgeHeader* get_cartridge_header(byte_t* rom_data)
+inline const CartridgeHeader* get_cartridge_header(const byte_t* rom_data)
 {
-    return (CartridgeHeader*)(rom_data + 0x0100);
+    return (const CartridgeHeader*)(rom_data + 0x0100);
 }
 
 const c8* get_cartridge_type_name(u8 type);
@@ -33,6 +33,9 @@ const c8* get_cartridge_lic_code_name(u8 lic_code);
 struct Emulator;
 u8 cartridge_read(Emulator* emu, u16 addr);
 void cartridge_write(Emulator* emu, u16 addr, u8 data);
+//! Gets the index of `Emulator::rom_banks` mapped to the specified ROM address (0x0000~0x7FFF)
+//! by the current MBC states.
+usize get_cartridge_rom_bank(const Emulator* emu, u16 addr);
 
 inline bool is_cart_battery(u8 cartridge_type)
 {
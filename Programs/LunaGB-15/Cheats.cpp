@@ -0,0 +1,159 @@
+#include "Cheats.hpp"
+#include "Emulator.hpp"
+#include "Cartridge.hpp"
+
+//! Parses hexadecimal digits of one code, ignoring dashes and spaces.
+//! Returns the number of digits, or USIZE_MAX if the code contains invalid characters.
+static usize parse_hex_digits(const c8* code, u8* out_digits, usize max_digits)
+{
+    usize num_digits = 0;
+    for(const c8* c = code; *c; ++c)
+    {
+        u8 digit;
+        if(*c >= '0' && *c <= '9') digit = (u8)(*c - '0');
+        else if(*c >= 'A' && *c <= 'F') digit = (u8)(*c - 'A' + 10);
+        else if(*c >= 'a' && *c <= 'f') digit = (u8)(*c - 'a' + 10);
+        else if(*c == '-' || *c == ' ') continue;
+        else return USIZE_MAX;
+        if(num_digits == max_digits) return USIZE_MAX;
+        out_digits[num_digits++] = digit;
+    }
+    return num_digits;
+}
+R<Cheat> parse_cheat_code(const c8* code)
+{
+    Cheat cheat;
+    cheat.code = code;
+    u8 d[9];
+    usize num_digits = parse_hex_digits(code, d, 9);
+    if(num_digits == 6 || num_digits == 9)
+    {
+        // Game Genie: ABC-DEF-GHI.
+        // AB: new data. FCDE: address XORed by 0xF000. GI: old data XORed by 0xBA and rotated left by 2.
+        cheat.type = CheatType::game_genie;
+        cheat.value = (u8)((d[0] << 4) | d[1]);
+        cheat.addr = (u16)(((d[5] ^ 0x0F) << 12) | (d[2] << 8) | (d[3] << 4) | d[4]);
+        if(num_digits == 9)
+        {
+            u8 v = (u8)((d[6] << 4) | d[8]);
+            cheat.compare = (u8)(((v >> 2) | (v << 6)) ^ 0xBA);
+        }
+        if(cheat.addr > 0x7FFF)
+        {
+            return set_error(BasicError::bad_arguments(), "Game Genie code %s patches address %04X, which is not cartridge ROM.", code, (u32)cheat.addr);
+        }
+        return cheat;
+    }
+    if(num_digits == 8)
+    {
+        // GameShark: ABCDEFGH.
+        // AB: code type, 80~8F selects the cartridge RAM bank. CD: new data. GHEF: address.
+        cheat.type = CheatType::gameshark;
+        u8 type = (u8)((d[0] << 4) | d[1]);
+        cheat.value = (u8)((d[2] << 4) | d[3]);
+        cheat.addr = (u16)((d[6] << 12) | (d[7] << 8) | (d[4] << 4) | d[5]);
+        if((type & 0xF0) == 0x80) cheat.ram_bank = (i8)(type & 0x0F);
+        if(!((cheat.addr >= 0xA000 && cheat.addr <= 0xFDFF) || (cheat.addr >= 0xFF80 && cheat.addr <= 0xFFFE)))
+        {
+            return set_error(BasicError::bad_arguments(), "GameShark code %s writes address %04X, which is not RAM.", code, (u32)cheat.addr);
+        }
+        return cheat;
+    }
+    return set_error(BasicError::bad_arguments(), "%s is not a valid Game Genie or GameShark code.", code);
+}
+//! Checks whether the specified bank can be mapped to 0x0000~0x3FFF. MBC1 cartridges with more than
+//! 32 banks map bank 0x20, 0x40 or 0x60 there in advanced banking mode, these banks are never mapped
+//! to 0x4000~0x7FFF.
+static bool is_low_rom_bank(const Emulator* emu, usize bank)
+{
+    if(bank == 0) return true;
+    u8 cartridge_type = get_cartridge_header(emu->rom_data)->cartridge_type;
+    return is_cart_mbc1(cartridge_type) && emu->num_rom_banks > 32 && bank % 32 == 0;
+}
+void Cheats::update(Emulator* emu)
+{
+    emu->map_rom_banks();
+    // Find banks to patch. Patches for 0x0000~0x3FFF apply to banks that can be mapped there,
+    // patches for 0x4000~0x7FFF apply to all other banks.
+    Vector<u32> banks;
+    for(usize bank = 0; bank < emu->num_rom_banks; ++bank)
+    {
+        const byte_t* data = emu->rom_data + bank * 16_kb;
+        bool low_bank = is_low_rom_bank(emu, bank);
+        for(const Cheat& c : cheats)
+        {
+            if(!c.enabled || c.type != CheatType::game_genie) continue;
+            if((c.addr <= 0x3FFF) != low_bank) continue;
+            u16 offset = c.addr & 0x3FFF;
+            if(c.compare >= 0 && data[offset] != (u8)c.compare) continue;
+            banks.push_back((u32)bank);
+            break;
+        }
+    }
+    patched_banks.resize(banks.size() * 16_kb, false);
+    for(usize i = 0; i < banks.size(); ++i)
+    {
+        u32 bank = banks[i];
+        byte_t* data = patched_banks.data() + i * 16_kb;
+        bool low_bank = is_low_rom_bank(emu, bank);
+        memcpy(data, emu->rom_data + bank * 16_kb, 16_kb);
+        for(const Cheat& c : cheats)
+        {
+            if(!c.enabled || c.type != CheatType::game_genie) continue;
+            if((c.addr <= 0x3FFF) != low_bank) continue;
+            u16 offset = c.addr & 0x3FFF;
+            // Compare with the original data, so that codes do not affect each other.
+            if(c.compare >= 0 && emu->rom_data[bank * 16_kb + offset] != (u8)c.compare) continue;
+            data[offset] = c.value;
+        }
+        // Bank numbers larger than the number of banks are mirrored.
+        for(usize j = bank; j < EMULATOR_MAX_ROM_BANKS; j += emu->num_rom_banks)
+        {
+            emu->rom_banks[j] = data;
+        }
+    }
+    ram_pokes.clear();
+    for(const Cheat& c : cheats)
+    {
+        if(!c.enabled || c.type != CheatType::gameshark) continue;
+        CheatRamPoke poke;
+        poke.value = c.value;
+        poke.ram_bank = c.ram_bank;
+        if(c.addr >= 0xFF80)
+        {
+            poke.region = CheatRamRegion::hram;
+            poke.offset = c.addr - 0xFF80;
+        }
+        else if(c.addr >= 0xC000)
+        {
+            // 0xE000~0xFDFF is echo RAM of 0xC000~0xDDFF.
+            poke.region = CheatRamRegion::wram;
+            poke.offset = (c.addr - 0xC000) % 8_kb;
+        }
+        else
+        {
+            poke.region = CheatRamRegion::cram;
+            poke.offset = c.addr - 0xA000;
+        }
+        ram_pokes.push_back(poke);
+    }
+}
+void Cheats::apply_ram_pokes(Emulator* emu) const
+{
+    for(const CheatRamPoke& poke : ram_pokes)
+    {
+        switch(poke.region)
+        {
+            case CheatRamRegion::wram: emu->wram[poke.offset] = poke.value; break;
+            case CheatRamRegion::hram: emu->hram[poke.offset] = poke.value; break;
+            case CheatRamRegion::cram:
+            {
+                usize bank = poke.ram_bank >= 0 ? (usize)poke.ram_bank : emu->ram_bank_number;
+                usize offset = bank * 8_kb + poke.offset;
+                if(offset < emu->cram_size) emu->cram_write(offset, poke.value);
+                break;
+            }
+            default: lupanic(); break;
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+#include <Luna/Runtime/Vector.hpp>
+#include <Luna/Runtime/String.hpp>
+#include <Luna/Runtime/Blob.hpp>
+#include <Luna/Runtime/Result.hpp>
+using namespace Luna;
+
+enum class CheatType : u8
+{
+    //! One Game Genie code (ABC-DEF or ABC-DEF-GHI) that patches one byte of cartridge ROM.
+    game_genie,
+    //! One GameShark code (ABCDEFGH) that writes one byte of RAM every frame.
+    gameshark,
+};
+
+struct Cheat
+{
+    //! The code text.
+    String code;
+    CheatType type = CheatType::game_genie;
+    bool enabled = true;
+    //! The address to patch or write.
+    u16 addr = 0;
+    //! The new value.
+    u8 value = 0;
+    //! Game Genie: The original ROM value. The patch is only applied to banks whose byte at
+    //! `addr` equals this value. -1 patches all banks that can be mapped to `addr`.
+    i16 compare = -1;
+    //! GameShark: The cartridge RAM bank for 0xA000~0xBFFF. -1 writes to the bank currently mapped.
+    i8 ram_bank = -1;
+};
+
+//! Parses one Game Genie or GameShark code. Dashes and spaces are ignored.
+R<Cheat> parse_cheat_code(const c8* code);
+
+enum class CheatRamRegion : u8
+{
+    wram,
+    hram,
+    cram,
+};
+
+//! One RAM write of one enabled GameShark code.
+struct CheatRamPoke
+{
+    //! The offset in the region. For cartridge RAM, this is the offset in the bank.
+    u16 offset;
+    CheatRamRegion region;
+    u8 value;
+    i8 ram_bank;
+};
+
+struct Emulator;
+//! Cheat codes.
+//! ROM patches are applied by mapping private patched copies of affected ROM banks to
+//! `Emulator::rom_banks`, so ROM reads do not check for patches. RAM writes are collected
+//! to one compact list and applied once per frame at the start of VBlank.
+struct Cheats
+{
+    Vector<Cheat> cheats;
+    //! Copies of ROM banks patched by enabled Game Genie codes, 16KB per bank.
+    Blob patched_banks;
+    //! RAM writes of enabled GameShark codes.
+    Vector<CheatRamPoke> ram_pokes;
+
+    //! Rebuilds patched ROM banks and RAM writes. This must be called after cheats are changed.
+    void update(Emulator* emu);
+    //! Writes RAM values of enabled GameShark codes.
+    void apply_ram_pokes(Emulator* emu) const;
+};
\ No newline at end of file
@@ -11,10 +11,24 @@ void DebugWindow::gui()
     if(ImGui::Begin("Debug Window", &show))
     {
         cpu_gui();
+        profiler_gui();
+        ram_search_gui();
+        cheats_gui();
         serial_gui();
         tiles_gui();
+        bg_maps_gui();
+        oam_gui();
         ppu_gui();
         apu_gui();
+        if(vram_viewer)
+        {
+            // Uploads regions changed by inspectors shown in this frame.
+            auto r = vram_viewer->upload(g_app->cmdbuf);
+            if(failed(r))
+            {
+                log_error("LunaGB", "Failed to upload texture data for VRAM inspectors : %s", explain(r.errcode()));
+            }
+        }
     }
     ImGui::End();
 }
@@ -301,7 +315,7 @@ void DebugWindow::cpu_gui()
                 ImGui::TableNextColumn();
                 ImGui::Text("F");
                 ImGui::TableNextColumn();
-                ImGui::Text("%2.2X", (u32)cpu.f);
+                ImGui::Text("%2.2X", (u32)cpu.f());
 
                 ImGui::TableNextRow();
                 ImGui::TableSetColumnIndex(0);
@@ -402,55 +416,569 @@ void DebugWindow::cpu_gui()
             }
             else
             {
-                ImGui::Text("Next instruction: %s", get_opcode_name(g_app->emulator->bus_read(g_app->emulator->cpu.pc)));
+                Emulator* emu = g_app->emulator.get();
+                if(emu->breakpoints && emu->breakpoints->hit.type != BreakpointHitType::none)
+                {
+                    ImGui::Text("Paused: %s", describe_breakpoint_hit(emu->breakpoints->hit).c_str());
+                }
+                ImGui::Text("Next instruction: %s", get_opcode_name(emu->bus_read(emu->cpu.pc)));
                 if(ImGui::Button("Step CPU"))
                 {
-                    g_app->emulator->cpu.step(g_app->emulator.get());
+                    if(emu->breakpoints)
+                    {
+                        emu->breakpoints->skip(emu->cpu.pc);
+                        emu->breakpoints->hit.type = BreakpointHitType::none;
+                    }
+                    emu->cpu.step(emu);
+                }
+                ImGui::SameLine();
+                if(ImGui::Button("Continue"))
+                {
+                    emu->resume();
                 }
             }
         }
-        if(ImGui::CollapsingHeader("CPU Logging"))
+        if(ImGui::CollapsingHeader("Breakpoints"))
         {
-            if(ImGui::Button("Clear"))
-            {
-                cpu_log.clear();
-            }
-            if(cpu_logging)
+            breakpoints_gui();
+        }
+        if(ImGui::CollapsingHeader("CPU Trace"))
+        {
+            auto& recorder = g_app->emulator->trace_recorder;
+            if(recorder)
             {
-                if(ImGui::Button("Stop logging"))
+                ImGui::Text("Records: %llu (%llu written)", (u64)recorder->num_records, (u64)recorder->num_flushed_records);
+                if(ImGui::Button("Stop tracing"))
                 {
-                    cpu_logging = false;
+                    recorder.reset();
+                    g_app->emulator->update_features();
                 }
             }
             else
             {
-                if(ImGui::Button("Start logging"))
+                ImGui::InputScalar("PC begin", ImGuiDataType_U16, &cpu_trace_filter.pc_begin, NULL, NULL, "%04X", ImGuiInputTextFlags_CharsHexadecimal);
+                ImGui::InputScalar("PC end", ImGuiDataType_U16, &cpu_trace_filter.pc_end, NULL, NULL, "%04X", ImGuiInputTextFlags_CharsHexadecimal);
+                ImGui::InputInt("ROM bank (-1 for all)", &cpu_trace_filter.rom_bank);
+                if(ImGui::Button("Start tracing"))
                 {
-                    cpu_logging = true;
+                    Window::FileDialogFilter filter;
+                    filter.name = "LunaGB trace file";
+                    const c8* extension = "lgbtrace";
+                    filter.extensions = {&extension, 1};
+                    auto rpath = Window::save_file_dialog("Save", {&filter, 1});
+                    if (succeeded(rpath) && !rpath.get().empty())
+                    {
+                        if(rpath.get().extension() == Name())
+                        {
+                            rpath.get().replace_extension("lgbtrace");
+                        }
+                        UniquePtr<TraceRecorder> new_recorder(memnew<TraceRecorder>());
+                        new_recorder->filter = cpu_trace_filter;
+                        auto r = new_recorder->begin(rpath.get().encode().c_str());
+                        if(failed(r))
+                        {
+                            log_error("LunaGB", "Failed to start CPU tracing: %s", explain(r.errcode()));
+                        }
+                        else
+                        {
+                            recorder = move(new_recorder);
+                            g_app->emulator->update_features();
+                        }
+                    }
                 }
             }
-            if(ImGui::Button("Save"))
+            ImGui::Text("Use \"LunaGB-15 decode-trace <trace> <log>\" to convert traces to gameboy-doctor logs.");
+        }
+    }
+}
+void DebugWindow::breakpoints_gui()
+{
+    Emulator* emu = g_app->emulator.get();
+    if(!emu->breakpoints)
+    {
+        emu->breakpoints.reset(memnew<Breakpoints>());
+    }
+    Breakpoints* bps = emu->breakpoints.get();
+    bool changed = false;
+    usize remove_index = USIZE_MAX;
+    ImGui::Text("Execution breakpoints");
+    for(usize i = 0; i < bps->breakpoints.size(); ++i)
+    {
+        Breakpoint& b = bps->breakpoints[i];
+        ImGui::PushID((int)i);
+        changed |= ImGui::Checkbox("##enabled", &b.enabled);
+        ImGui::SameLine();
+        if(b.bank < 0) ImGui::Text("PC == %04X", (u32)b.addr);
+        else ImGui::Text("PC == %02X:%04X", (u32)b.bank, (u32)b.addr);
+        ImGui::SameLine();
+        if(ImGui::Button("Remove"))
+        {
+            remove_index = i;
+        }
+        ImGui::PopID();
+    }
+    if(remove_index != USIZE_MAX)
+    {
+        bps->breakpoints.erase(bps->breakpoints.begin() + remove_index);
+        remove_index = USIZE_MAX;
+        changed = true;
+    }
+    ImGui::PushID("New breakpoint");
+    ImGui::InputScalar("Address", ImGuiDataType_U16, &new_breakpoint.addr, NULL, NULL, "%04X", ImGuiInputTextFlags_CharsHexadecimal);
+    ImGui::InputInt("ROM bank (-1 for all)", &new_breakpoint.bank);
+    if(ImGui::Button("Add breakpoint"))
+    {
+        bps->breakpoints.push_back(new_breakpoint);
+        changed = true;
+    }
+    ImGui::PopID();
+    ImGui::Separator();
+    ImGui::Text("Memory watchpoints");
+    const c8* access_names[] = {"", "Read", "Write", "Read/Write"};
+    for(usize i = 0; i < bps->watchpoints.size(); ++i)
+    {
+        Watchpoint& w = bps->watchpoints[i];
+        ImGui::PushID((int)i);
+        changed |= ImGui::Checkbox("##enabled", &w.enabled);
+        ImGui::SameLine();
+        c8 condition[32];
+        if(w.condition == WatchpointCondition::always || w.condition == WatchpointCondition::changed)
+        {
+            snprintf(condition, 32, "%s", get_watchpoint_condition_name(w.condition));
+        }
+        else
+        {
+            snprintf(condition, 32, "value %s %02X", get_watchpoint_condition_name(w.condition), (u32)w.value);
+        }
+        ImGui::Text("%s %04X-%04X (bank %d), %s", access_names[(u8)w.access], (u32)w.addr_begin, (u32)w.addr_end, w.bank, condition);
+        ImGui::SameLine();
+        if(ImGui::Button("Remove"))
+        {
+            remove_index = i;
+        }
+        ImGui::PopID();
+    }
+    if(remove_index != USIZE_MAX)
+    {
+        bps->watchpoints.erase(bps->watchpoints.begin() + remove_index);
+        remove_index = USIZE_MAX;
+        changed = true;
+    }
+    ImGui::PushID("New watchpoint");
+    ImGui::InputScalar("Begin", ImGuiDataType_U16, &new_watchpoint.addr_begin, NULL, NULL, "%04X", ImGuiInputTextFlags_CharsHexadecimal);
+    ImGui::InputScalar("End", ImGuiDataType_U16, &new_watchpoint.addr_end, NULL, NULL, "%04X", ImGuiInputTextFlags_CharsHexadecimal);
+    ImGui::InputInt("Bank (-1 for all)", &new_watchpoint.bank);
+    int access = (int)new_watchpoint.access - 1;
+    if(ImGui::Combo("Access", &access, "Read\0Write\0Read/Write\0"))
+    {
+        new_watchpoint.access = (WatchpointAccess)(access + 1);
+    }
+    int condition = (int)new_watchpoint.condition;
+    if(ImGui::Combo("Condition", &condition, "Always\0Value ==\0Value !=\0Value <\0Value >\0Value changed\0"))
+    {
+        new_watchpoint.condition = (WatchpointCondition)condition;
+    }
+    ImGui::InputScalar("Value", ImGuiDataType_U8, &new_watchpoint.value, NULL, NULL, "%02X", ImGuiInputTextFlags_CharsHexadecimal);
+    if(ImGui::Button("Add watchpoint"))
+    {
+        Watchpoint w = new_watchpoint;
+        if(w.addr_end < w.addr_begin) w.addr_end = w.addr_begin;
+        bps->watchpoints.push_back(w);
+        changed = true;
+    }
+    ImGui::PopID();
+    ImGui::Separator();
+    ImGui::Text("IO register triggers");
+    for(usize i = 0; i < bps->io_triggers.size(); ++i)
+    {
+        IOTrigger& t = bps->io_triggers[i];
+        ImGui::PushID((int)i);
+        changed |= ImGui::Checkbox("##enabled", &t.enabled);
+        ImGui::SameLine();
+        ImGui::Text("%04X changed (current value: %02X)", (u32)t.addr, (u32)t.last_value);
+        ImGui::SameLine();
+        if(ImGui::Button("Remove"))
+        {
+            remove_index = i;
+        }
+        ImGui::PopID();
+    }
+    if(remove_index != USIZE_MAX)
+    {
+        bps->io_triggers.erase(bps->io_triggers.begin() + remove_index);
+        remove_index = USIZE_MAX;
+        changed = true;
+    }
+    ImGui::PushID("New IO trigger");
+    ImGui::InputScalar("Register", ImGuiDataType_U16, &new_io_trigger.addr, NULL, NULL, "%04X", ImGuiInputTextFlags_CharsHexadecimal);
+    if(ImGui::Button("Add IO trigger"))
+    {
+        if((new_io_trigger.addr >= 0xFF00 && new_io_trigger.addr <= 0xFF7F) || new_io_trigger.addr == 0xFFFF)
+        {
+            bps->io_triggers.push_back(new_io_trigger);
+            changed = true;
+        }
+        else
+        {
+            log_error("LunaGB", "%04X is not an IO register.", (u32)new_io_trigger.addr);
+        }
+    }
+    ImGui::PopID();
+    if(changed)
+    {
+        bps->update_bitmaps(emu);
+        emu->update_features();
+    }
+}
+//! Asks the user for one file path to save to.
+static Path save_file_path(const c8* filter_name, const c8* extension)
+{
+    Window::FileDialogFilter filter;
+    filter.name = filter_name;
+    filter.extensions = {&extension, 1};
+    auto rpath = Window::save_file_dialog("Save", {&filter, 1});
+    if(failed(rpath) || rpath.get().empty()) return Path();
+    if(rpath.get().extension() == Name())
+    {
+        rpath.get().replace_extension(extension);
+    }
+    return rpath.get();
+}
+void DebugWindow::profiler_gui()
+{
+    if(!g_app->emulator) return;
+    if(!ImGui::CollapsingHeader("Profiler")) return;
+    Emulator* emu = g_app->emulator.get();
+    if(!emu->profiler)
+    {
+        ImGui::Text("Profiles cycles spent on every instruction and routine, and memory accesses of every region.");
+        if(ImGui::Button("Start profiling"))
+        {
+            emu->profiler.reset(memnew<Profiler>());
+            emu->profiler->init(emu);
+            emu->access_counters.reset(memnew<AccessCounters>());
+            emu->update_features();
+            profiler_hot_addresses.clear();
+            profiler_routines.clear();
+        }
+        return;
+    }
+    Profiler* profiler = emu->profiler.get();
+    if(ImGui::Button("Stop profiling"))
+    {
+        emu->profiler.reset();
+        emu->access_counters.reset();
+        emu->update_features();
+        return;
+    }
+    ImGui::SameLine();
+    if(ImGui::Button("Reset"))
+    {
+        profiler->reset();
+        emu->access_counters->reset();
+        profiler_hot_addresses.clear();
+        profiler_routines.clear();
+    }
+    ImGui::SameLine();
+    if(ImGui::Button("Export CSV"))
+    {
+        Path path = save_file_path("CSV file", "csv");
+        if(!path.empty())
+        {
+            auto r = profiler->export_csv(path.encode().c_str());
+            if(failed(r)) log_error("LunaGB", "Failed to export profiling data: %s", explain(r.errcode()));
+        }
+    }
+    ImGui::SameLine();
+    if(ImGui::Button("Export flame graph"))
+    {
+        Path path = save_file_path("Collapsed stacks", "folded");
+        if(!path.empty())
+        {
+            auto r = profiler->export_flamegraph(path.encode().c_str());
+            if(failed(r)) log_error("LunaGB", "Failed to export flame graph: %s", explain(r.errcode()));
+        }
+    }
+    ImGui::Text("Profiled cycles: %llu (%.2f seconds)", (unsigned long long)profiler->total_cycles, (f64)profiler->total_cycles / CLOCK_FREQUENCY);
+    ImGui::Text("Call tree nodes: %u/%u", (u32)profiler->nodes.size(), PROFILER_MAX_CALL_NODES);
+    // Sorting is expensive for large ROMs, so results are only refreshed on request.
+    if(ImGui::Button("Refresh"))
+    {
+        profiler_hot_addresses.clear();
+        for(usize i = 0; i < profiler->cycles.size(); ++i)
+        {
+            if(profiler->cycles[i]) profiler_hot_addresses.push_back((u32)i);
+        }
+        sort(profiler_hot_addresses.begin(), profiler_hot_addresses.end(), [profiler](u32 lhs, u32 rhs) {
+            return profiler->cycles[lhs] > profiler->cycles[rhs];
+        });
+        profiler->get_routine_stats(profiler_routines);
+        sort(profiler_routines.begin(), profiler_routines.end(), [](const ProfilerRoutineStats& lhs, const ProfilerRoutineStats& rhs) {
+            return lhs.inclusive_cycles > rhs.inclusive_cycles;
+        });
+    }
+    f64 total_cycles = profiler->total_cycles ? (f64)profiler->total_cycles : 1.0;
+    if(ImGui::TreeNode("Hot instructions"))
+    {
+        if(ImGui::BeginTable("Hot instructions", 3, ImGuiTableFlags_Borders))
+        {
+            ImGui::TableSetupColumn("Address");
+            ImGui::TableSetupColumn("Cycles");
+            ImGui::TableSetupColumn("%");
+            ImGui::TableHeadersRow();
+            usize n = min<usize>(profiler_hot_addresses.size(), 64);
+            for(usize i = 0; i < n; ++i)
+            {
+                u32 addr = profiler_hot_addresses[i];
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%s", profiler->get_address_name(addr).c_str());
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", (unsigned long long)profiler->cycles[addr]);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", (f64)profiler->cycles[addr] * 100.0 / total_cycles);
+            }
+            ImGui::EndTable();
+        }
+        ImGui::TreePop();
+    }
+    if(ImGui::TreeNode("Routines"))
+    {
+        if(ImGui::BeginTable("Routines", 5, ImGuiTableFlags_Borders))
+        {
+            ImGui::TableSetupColumn("Routine");
+            ImGui::TableSetupColumn("Calls");
+            ImGui::TableSetupColumn("Inclusive cycles");
+            ImGui::TableSetupColumn("Inclusive %");
+            ImGui::TableSetupColumn("Self cycles");
+            ImGui::TableHeadersRow();
+            usize n = min<usize>(profiler_routines.size(), 64);
+            for(usize i = 0; i < n; ++i)
             {
-                Window::FileDialogFilter filter;
-                filter.name = "Text file";
-                const c8* extension = "txt";
-                filter.extensions = {&extension, 1};
-                auto rpath = Window::save_file_dialog("Save", {&filter, 1});
-                if (succeeded(rpath) && !rpath.get().empty())
+                const ProfilerRoutineStats& stats = profiler_routines[i];
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%s", profiler->get_address_name(stats.routine).c_str());
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", (unsigned long long)stats.calls);
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", (unsigned long long)stats.inclusive_cycles);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", (f64)stats.inclusive_cycles * 100.0 / total_cycles);
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", (unsigned long long)stats.self_cycles);
+            }
+            ImGui::EndTable();
+        }
+        ImGui::TreePop();
+    }
+    if(ImGui::TreeNode("Memory accesses"))
+    {
+        access_counters_gui(emu->access_counters.get());
+        ImGui::TreePop();
+    }
+}
+void DebugWindow::ram_search_gui()
+{
+    if(!g_app->emulator) return;
+    if(!ImGui::CollapsingHeader("RAM Search")) return;
+    Emulator* emu = g_app->emulator.get();
+    if(ram_search && ram_search_generation != emu->generation)
+    {
+        // The cartridge is changed.
+        ram_search.reset();
+        ram_search_results.clear();
+    }
+    ImGui::Combo("Width", &ram_search_width, "8-bit\0" "16-bit\0" "BCD (2 digits)\0" "BCD (4 digits)\0");
+    if(ImGui::Button(ram_search ? "Restart search" : "Start search"))
+    {
+        if(!ram_search) ram_search.reset(memnew<RamSearch>());
+        ram_search->reset(emu, (RamSearchWidth)ram_search_width);
+        ram_search_generation = emu->generation;
+        ram_search->get_candidates(emu, ram_search_results, 100);
+    }
+    if(!ram_search) return;
+    ImGui::Combo("Comparison", &ram_search_comparison, "==\0" "!=\0" "<\0" ">\0");
+    ImGui::RadioButton("Previous value", &ram_search_operand, (int)RamSearchOperand::previous);
+    ImGui::SameLine();
+    ImGui::RadioButton("Specified value", &ram_search_operand, (int)RamSearchOperand::value);
+    if(ram_search_operand == (int)RamSearchOperand::value)
+    {
+        ImGui::InputScalar("Value", ImGuiDataType_U32, &ram_search_value);
+    }
+    if(ImGui::Button("Filter"))
+    {
+        ram_search->filter(emu, (RamSearchComparison)ram_search_comparison, (RamSearchOperand)ram_search_operand, ram_search_value);
+        ram_search->get_candidates(emu, ram_search_results, 100);
+    }
+    ImGui::SameLine();
+    if(ImGui::Button("Refresh values"))
+    {
+        ram_search->get_candidates(emu, ram_search_results, 100);
+    }
+    ImGui::Text("%u candidates.", (u32)ram_search->count_candidates());
+    if(ImGui::BeginTable("RAM Search Results", 4, ImGuiTableFlags_Borders))
+    {
+        ImGui::TableSetupColumn("Address");
+        ImGui::TableSetupColumn("Value");
+        ImGui::TableSetupColumn("Previous");
+        ImGui::TableSetupColumn("");
+        ImGui::TableHeadersRow();
+        for(usize i = 0; i < ram_search_results.size(); ++i)
+        {
+            const RamSearchResult& result = ram_search_results[i];
+            ImGui::PushID((int)i);
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            if(result.addr >= 0xA000 && result.addr <= 0xBFFF) ImGui::Text("%02X:%04X", (u32)result.bank, (u32)result.addr);
+            else ImGui::Text("%04X", (u32)result.addr);
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", result.value);
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", result.previous_value);
+            ImGui::TableNextColumn();
+            if(ImGui::Button("Watch writes"))
+            {
+                if(!emu->breakpoints) emu->breakpoints.reset(memnew<Breakpoints>());
+                Watchpoint w;
+                w.addr_begin = result.addr;
+                w.addr_end = result.addr;
+                if(ram_search->width == RamSearchWidth::word || ram_search->width == RamSearchWidth::bcd_word) ++w.addr_end;
+                w.bank = (result.addr >= 0xA000 && result.addr <= 0xBFFF) ? result.bank : -1;
+                w.access = WatchpointAccess::write;
+                emu->breakpoints->watchpoints.push_back(w);
+                emu->breakpoints->update_bitmaps(emu);
+                emu->update_features();
+            }
+            ImGui::SameLine();
+            if(ImGui::Button("Freeze"))
+            {
+                // Add GameShark codes that keep the current raw bytes.
+                if(!emu->cheats) emu->cheats.reset(memnew<Cheats>());
+                bool cram = result.addr >= 0xA000 && result.addr <= 0xBFFF;
+                u32 num_bytes = (ram_search->width == RamSearchWidth::word || ram_search->width == RamSearchWidth::bcd_word) ? 2 : 1;
+                for(u32 j = 0; j < num_bytes; ++j)
                 {
-                    if(rpath.get().extension() == Name())
-                    {
-                        rpath.get().replace_extension("txt");
-                    }
-                    auto f = open_file(rpath.get().encode().c_str(), FileOpenFlag::write, FileCreationMode::create_always);
-                    if(succeeded(f))
-                    {
-                        auto _ = f.get()->write(cpu_log.c_str(), cpu_log.size(), nullptr);
-                    }
+                    u16 addr = (u16)(result.addr + j);
+                    u8 value = cram ? emu->cram[result.bank * 8_kb + (addr - 0xA000)] : emu->bus_read(addr);
+                    c8 code[16];
+                    snprintf(code, 16, "%02X%02X%02X%02X", cram ? 0x80 + (u32)result.bank : 0x01, (u32)value, (u32)(addr & 0xFF), (u32)(addr >> 8));
+                    auto cheat = parse_cheat_code(code);
+                    if(succeeded(cheat)) emu->cheats->cheats.push_back(cheat.get());
                 }
+                emu->cheats->update(emu);
             }
-            ImGui::Text("Log size: %llu bytes.", (u64)cpu_log.size());
+            ImGui::PopID();
         }
+        ImGui::EndTable();
+    }
+}
+void DebugWindow::cheats_gui()
+{
+    if(!g_app->emulator) return;
+    if(!ImGui::CollapsingHeader("Cheats")) return;
+    Emulator* emu = g_app->emulator.get();
+    if(!emu->cheats)
+    {
+        emu->cheats.reset(memnew<Cheats>());
+    }
+    Cheats* cheats = emu->cheats.get();
+    bool changed = false;
+    usize remove_index = USIZE_MAX;
+    for(usize i = 0; i < cheats->cheats.size(); ++i)
+    {
+        Cheat& c = cheats->cheats[i];
+        ImGui::PushID((int)i);
+        changed |= ImGui::Checkbox("##enabled", &c.enabled);
+        ImGui::SameLine();
+        if(c.type == CheatType::game_genie)
+        {
+            if(c.compare < 0) ImGui::Text("%s: ROM %04X = %02X", c.code.c_str(), (u32)c.addr, (u32)c.value);
+            else ImGui::Text("%s: ROM %04X = %02X if %02X", c.code.c_str(), (u32)c.addr, (u32)c.value, (u32)c.compare);
+        }
+        else
+        {
+            if(c.ram_bank < 0) ImGui::Text("%s: RAM %04X = %02X", c.code.c_str(), (u32)c.addr, (u32)c.value);
+            else ImGui::Text("%s: RAM %02X:%04X = %02X", c.code.c_str(), (u32)c.ram_bank, (u32)c.addr, (u32)c.value);
+        }
+        ImGui::SameLine();
+        if(ImGui::Button("Remove"))
+        {
+            remove_index = i;
+        }
+        ImGui::PopID();
+    }
+    if(remove_index != USIZE_MAX)
+    {
+        cheats->cheats.erase(cheats->cheats.begin() + remove_index);
+        changed = true;
+    }
+    ImGui::InputText("Game Genie / GameShark code", new_cheat_code, sizeof(new_cheat_code));
+    if(ImGui::Button("Add cheat"))
+    {
+        auto cheat = parse_cheat_code(new_cheat_code);
+        if(failed(cheat))
+        {
+            log_error("LunaGB", "Failed to add cheat: %s", explain(cheat.errcode()));
+        }
+        else
+        {
+            cheats->cheats.push_back(cheat.get());
+            new_cheat_code[0] = 0;
+            changed = true;
+        }
+    }
+    if(changed)
+    {
+        cheats->update(emu);
+    }
+}
+void DebugWindow::access_counters_gui(const AccessCounters* counters)
+{
+    struct MemoryRegion
+    {
+        const c8* name;
+        u16 begin;
+        u16 end;
+    };
+    constexpr MemoryRegion regions[] = {
+        {"ROM bank 0", 0x0000, 0x3FFF},
+        {"ROM bank N", 0x4000, 0x7FFF},
+        {"VRAM", 0x8000, 0x9FFF},
+        {"Cartridge RAM", 0xA000, 0xBFFF},
+        {"WRAM", 0xC000, 0xDFFF},
+        {"Echo RAM", 0xE000, 0xFDFF},
+        {"OAM/IO/HRAM", 0xFE00, 0xFFFF},
+    };
+    if(ImGui::BeginTable("Memory Access Counters", 4, ImGuiTableFlags_Borders))
+    {
+        ImGui::TableSetupColumn("Region");
+        ImGui::TableSetupColumn("Reads");
+        ImGui::TableSetupColumn("Writes");
+        ImGui::TableSetupColumn("Executes");
+        ImGui::TableHeadersRow();
+        for(const MemoryRegion& region : regions)
+        {
+            u64 reads = 0;
+            u64 writes = 0;
+            u64 executes = 0;
+            for(usize page = region.begin / ACCESS_COUNTER_PAGE_SIZE; page <= region.end / ACCESS_COUNTER_PAGE_SIZE; ++page)
+            {
+                reads += counters->reads[page];
+                writes += counters->writes[page];
+                executes += counters->executes[page];
+            }
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%s (%04X-%04X)", region.name, (u32)region.begin, (u32)region.end);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", reads);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", writes);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", executes);
+        }
+        ImGui::EndTable();
     }
 }
 void DebugWindow::serial_gui()
@@ -479,27 +1007,18 @@ void DebugWindow::serial_gui()
         }
     }
 }
-inline void decode_tile_line(const u8 data[2], u8 dst_color[32])
+bool DebugWindow::init_vram_viewer()
 {
-    for(i32 b = 7; b >= 0; --b)
+    if(vram_viewer) return true;
+    UniquePtr<VRAMViewer> viewer(memnew<VRAMViewer>());
+    auto r = viewer->init(g_app->rhi_device);
+    if(failed(r))
     {
-        u8 lo = (!!(data[0] & (1 << b)));
-        u8 hi = (!!(data[1] & (1 << b))) << 1;
-        u8 color = hi | lo;
-        // convert color.
-        switch(color)
-        {
-            case 0: color = 0xFF; break;
-            case 1: color = 0xAA; break;
-            case 2: color = 0x55; break;
-            case 3: color = 0x00; break;
-            default: lupanic(); break;
-        }
-        dst_color[(7 - b) * 4] = color;
-        dst_color[(7 - b) * 4 + 1] = color;
-        dst_color[(7 - b) * 4 + 2] = color;
-        dst_color[(7 - b) * 4 + 3] = 0xFF;
+        log_error("LunaGB", "Failed to create textures for VRAM inspectors : %s", explain(r.errcode()));
+        return false;
     }
+    vram_viewer = move(viewer);
+    return true;
 }
 void DebugWindow::tiles_gui()
 {
@@ -507,49 +1026,126 @@ void DebugWindow::tiles_gui()
     {
         if(ImGui::CollapsingHeader("Tiles"))
         {
-            u32 width = 16 * 8;
-            u32 height = 24 * 8;
-            // Create texture if not present.
-            if(!tile_texture)
+            if(!init_vram_viewer()) return;
+            vram_viewer->update_tiles(g_app->emulator.get());
+            // Draw.
+            f32 scale = 4.0f;
+            VRAMTexture& tiles = vram_viewer->tiles;
+            ImGui::Image(tiles.texture, {(f32)(tiles.columns * 8) * scale, (f32)(tiles.rows * 8) * scale});
+            if(ImGui::IsItemHovered())
             {
-                auto tex = g_app->rhi_device->new_texture(RHI::MemoryType::local, 
-                        RHI::TextureDesc::tex2d(RHI::Format::rgba8_unorm, RHI::TextureUsageFlag::copy_dest | RHI::TextureUsageFlag::read_texture,
-                            width, height, 1, 1));
-                if(failed(tex))
+                ImVec2 pos = ImGui::GetMousePos() - ImGui::GetItemRectMin();
+                u32 x = (u32)(pos.x / (8.0f * scale));
+                u32 y = (u32)(pos.y / (8.0f * scale));
+                if(x < tiles.columns && y < tiles.rows)
                 {
-                    log_error("LunaGB", "Failed to create texture for tile inspector : %s", explain(tex.errcode()));
-                    return;
+                    u32 tile = y * tiles.columns + x;
+                    ImGui::SetTooltip("Tile %u at 0x%04X", tile, 0x8000 + tile * 16);
                 }
-                tile_texture = tex.get();
             }
-            // Update texture data.
-            usize num_pixel_bytes = width * height * 4;
-            usize row_pitch = width * 4;
-            Blob pixel_bytes(num_pixel_bytes);
-            u8* pixels = pixel_bytes.data();
-            for(u32 y = 0; y < height / 8; ++y)
+        }
+    }
+}
+void DebugWindow::bg_maps_gui()
+{
+    if(g_app->emulator)
+    {
+        if(ImGui::CollapsingHeader("Background Maps"))
+        {
+            if(!init_vram_viewer()) return;
+            auto& ppu = g_app->emulator->ppu;
+            vram_viewer->update_bg_maps(g_app->emulator.get());
+            ImGui::Text("Tile data: 0x%04X, BGP: %2.2X", ppu.bgw_data_area(), (u32)ppu.bgp);
+            f32 scale = 2.0f;
+            f32 map_size = (f32)(VRAM_BG_MAP_TILES * 8) * scale;
+            for(u32 m = 0; m < 2; ++m)
             {
-                for(u32 x = 0; x < width / 8; ++x)
+                u16 map_area = m ? 0x9C00 : 0x9800;
+                if(m) ImGui::SameLine();
+                ImGui::BeginGroup();
+                ImGui::Text("0x%04X%s%s", (u32)map_area, ppu.bg_map_area() == map_area ? " BG" : "",
+                    ppu.window_map_area() == map_area ? " Window" : "");
+                ImGui::Image(vram_viewer->bg_maps[m].texture, {map_size, map_size});
+                if(ppu.bg_map_area() == map_area)
                 {
-                    u32 tile_index = y * width / 8 + x;
-                    usize tile_color_begin = y * row_pitch * 8 + x * 8 * 4;
-                    for(u32 line = 0; line < 8; ++line)
+                    // Draws the screen rectangle at (SCX, SCY), which wraps around the map edges.
+                    ImVec2 origin = ImGui::GetItemRectMin();
+                    ImDrawList* draw_list = ImGui::GetWindowDrawList();
+                    draw_list->PushClipRect(origin, origin + ImVec2(map_size, map_size), true);
+                    for(i32 dy = 0; dy <= 1; ++dy)
                     {
-                        decode_tile_line(g_app->emulator->vram + tile_index * 16 + line * 2, pixels + tile_color_begin + line * row_pitch);
+                        for(i32 dx = 0; dx <= 1; ++dx)
+                        {
+                            ImVec2 min = origin + ImVec2((f32)((i32)ppu.scroll_x - dx * 256) * scale, (f32)((i32)ppu.scroll_y - dy * 256) * scale);
+                            draw_list->AddRect(min, min + ImVec2(PPU_XRES * scale, PPU_YRES * scale), IM_COL32(255, 0, 0, 255), 0.0f, 0, 2.0f);
+                        }
                     }
+                    draw_list->PopClipRect();
                 }
+                ImGui::EndGroup();
             }
-            auto r = RHI::copy_resource_data(g_app->cmdbuf, {
-                RHI::CopyResourceData::write_texture(tile_texture, {0, 0}, 0, 0, 0, pixels, row_pitch, num_pixel_bytes, width, height, 1)
-            });
-            if(failed(r))
+        }
+    }
+}
+void DebugWindow::oam_gui()
+{
+    if(g_app->emulator)
+    {
+        if(ImGui::CollapsingHeader("OAM"))
+        {
+            if(!init_vram_viewer()) return;
+            // Sprites are drawn from the tile texture.
+            vram_viewer->update_tiles(g_app->emulator.get());
+            auto& ppu = g_app->emulator->ppu;
+            VRAMTexture& tiles = vram_viewer->tiles;
+            u8 obj_height = ppu.obj_height();
+            ImGui::Text("Size: 8x%u", (u32)obj_height);
+            if(ImGui::BeginTable("OAM", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY, ImVec2(0.0f, 400.0f)))
             {
-                log_error("LunaGB", "Failed to upload texture data for tile inspector : %s", explain(r.errcode()));
-                ImGui::End();
-                return;
+                ImGui::TableSetupScrollFreeze(0, 1);
+                ImGui::TableSetupColumn("#");
+                ImGui::TableSetupColumn("Sprite");
+                ImGui::TableSetupColumn("X");
+                ImGui::TableSetupColumn("Y");
+                ImGui::TableSetupColumn("Tile");
+                ImGui::TableSetupColumn("Flags");
+                ImGui::TableHeadersRow();
+                const OAMEntry* entries = (const OAMEntry*)g_app->emulator->oam;
+                for(u32 i = 0; i < 40; ++i)
+                {
+                    const OAMEntry& entry = entries[i];
+                    ImGui::TableNextRow();
+                    ImGui::TableSetColumnIndex(0);
+                    ImGui::Text("%u", i);
+                    ImGui::TableNextColumn();
+                    // The lowest bit of the tile index is ignored for 8x16 sprites.
+                    u8 first_tile = obj_height == 16 ? (entry.tile & 0xFE) : entry.tile;
+                    ImGui::BeginGroup();
+                    for(u32 t = 0; t < obj_height / 8u; ++t)
+                    {
+                        // Flipping 8x16 sprites vertically also swaps the two tiles.
+                        u32 tile = first_tile + (entry.y_flip() ? (obj_height / 8u - 1 - t) : t);
+                        f32 u0 = (f32)(tile % tiles.columns) / tiles.columns;
+                        f32 v0 = (f32)(tile / tiles.columns) / tiles.rows;
+                        f32 u1 = u0 + 1.0f / tiles.columns;
+                        f32 v1 = v0 + 1.0f / tiles.rows;
+                        if(entry.x_flip()) swap(u0, u1);
+                        if(entry.y_flip()) swap(v0, v1);
+                        ImGui::Image(tiles.texture, {16.0f, 16.0f}, {u0, v0}, {u1, v1});
+                    }
+                    ImGui::EndGroup();
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%d", (i32)entry.x - 8);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%d", (i32)entry.y - 16);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%2.2X", (u32)entry.tile);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("OBP%u%s%s%s", (u32)entry.dmg_palette(), entry.x_flip() ? " XFlip" : "",
+                        entry.y_flip() ? " YFlip" : "", entry.priority() ? " BehindBG" : "");
+                }
+                ImGui::EndTable();
             }
-            // Draw.
-            ImGui::Image(tile_texture, {(f32)(width * 4), (f32)(height * 4)});
         }
     }
 }
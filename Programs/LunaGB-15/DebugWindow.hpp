@@ -3,26 +3,63 @@
 #include <Luna/Runtime/String.hpp>
 #include <Luna/Runtime/Ref.hpp>
 #include <Luna/RHI/Texture.hpp>
+#include "TraceRecorder.hpp"
+#include "AccessCounters.hpp"
+#include "Profiler.hpp"
+#include "Breakpoints.hpp"
+#include "RamSearch.hpp"
+#include "VRAMViewer.hpp"
+#include <Luna/Runtime/UniquePtr.hpp>
 using namespace Luna;
 
 struct DebugWindow
 {
     bool show = false;
 
-    // CPU log.
-    String cpu_log;
-    bool cpu_logging = false;
+    // CPU trace.
+    TraceFilter cpu_trace_filter;
+
+    // Breakpoints being added.
+    Breakpoint new_breakpoint;
+    Watchpoint new_watchpoint;
+    IOTrigger new_io_trigger;
+
+    // Profiler, refreshed on request.
+    Vector<u32> profiler_hot_addresses;
+    Vector<ProfilerRoutineStats> profiler_routines;
+
+    // RAM search.
+    UniquePtr<RamSearch> ram_search;
+    //! The `Emulator::generation` of the emulator that `ram_search` is started for.
+    u64 ram_search_generation = 0;
+    int ram_search_width = 0;
+    int ram_search_comparison = 0;
+    int ram_search_operand = 0;
+    u32 ram_search_value = 0;
+    Vector<RamSearchResult> ram_search_results;
+
+    // Cheat code being added.
+    c8 new_cheat_code[32] = {};
 
     // Serial inspector.
     Vector<u8> serial_data;
 
-    // Tiles inspector
-    Ref<RHI::ITexture> tile_texture;
+    // Tiles, background maps and OAM inspectors. Created when any of them is shown for the first time.
+    UniquePtr<VRAMViewer> vram_viewer;
 
     void gui();
     void cpu_gui();
+    void breakpoints_gui();
+    void profiler_gui();
+    void ram_search_gui();
+    void cheats_gui();
+    void access_counters_gui(const AccessCounters* counters);
     void serial_gui();
+    //! Creates `vram_viewer` if not created. Returns `false` on failure.
+    bool init_vram_viewer();
     void tiles_gui();
+    void bg_maps_gui();
+    void oam_gui();
     void ppu_gui();
     void apu_gui();
 };
\ No newline at end of file
@@ -4,15 +4,21 @@
 #include <Luna/Runtime/File.hpp>
 #include <Luna/Runtime/Time.hpp>
 
-RV Emulator::init(Path cartridge_path, const void* cartridge_data, usize cartridge_data_size)
+RV Emulator::init(Path cartridge_path, IFileMapping* rom)
 {
-    luassert(cartridge_data && cartridge_data_size);
+    luassert(rom);
+    if(rom->get_size() < 0x150)
+    {
+        return set_error(BasicError::bad_data(), "The cartridge data is too small: %u bytes", (u32)rom->get_size());
+    }
+    static u64 next_generation = 0;
+    generation = atom_inc_u64(&next_generation);
     this->cartridge_path = cartridge_path;
-    rom_data = (byte_t*)memalloc(cartridge_data_size);
-    memcpy(rom_data, cartridge_data, cartridge_data_size);
-    rom_data_size = cartridge_data_size;
+    this->rom = rom;
+    rom_data = (const byte_t*)rom->get_data();
+    rom_data_size = rom->get_size();
     // Check cartridge data.
-    CartridgeHeader* header = get_cartridge_header(rom_data);
+    const CartridgeHeader* header = get_cartridge_header(rom_data);
     u8 checksum = 0;
     for (u16 address = 0x0134; address <= 0x014C; ++address)
     {
@@ -23,6 +29,11 @@ RV Emulator::init(Path cartridge_path, const void* cartridge_data, usize cartrid
         return set_error(BasicError::bad_data(), "The cartridge checksum dismatched. Expected: %u, computed: %u", (u32)header->checksum, (u32)checksum);
     }
     num_rom_banks = (((usize)32) << header->rom_size) / 16;
+    if(rom_data_size < num_rom_banks * 16_kb)
+    {
+        return set_error(BasicError::bad_data(), "The cartridge data is truncated. Expected: %u bytes, actual: %u bytes", (u32)(num_rom_banks * 16_kb), (u32)rom_data_size);
+    }
+    map_rom_banks();
     // Print cartridge load info.
     c8 title[16];
     snprintf(title, 16, "%s", header->title);
@@ -36,6 +47,7 @@ RV Emulator::init(Path cartridge_path, const void* cartridge_data, usize cartrid
     cpu.init();
     memzero(wram, 8_kb);
     memzero(vram, 8_kb);
+    mark_vram_dirty(0, 8_kb);
     memzero(oam, 160);
     memzero(hram, 128);
     int_flags = 0;
@@ -46,6 +58,10 @@ RV Emulator::init(Path cartridge_path, const void* cartridge_data, usize cartrid
     joypad.init();
     rtc.init();
     apu.init();
+    frame_buffers = Blob(PPU_FRAME_SIZE * 2);
+    memzero(frame_buffers.data(), frame_buffers.size());
+    apu_history.reset(memnew<APUSampleHistory>());
+    memzero(apu_history.get(), sizeof(APUSampleHistory));
     switch(header->ram_size)
     {
         case 2: cram_size = 8_kb; break;
@@ -66,25 +82,109 @@ RV Emulator::init(Path cartridge_path, const void* cartridge_data, usize cartrid
         if(is_cart_battery(header->cartridge_type))
         {
             load_cartridge_ram_data();
+            if(!cartridge_path.empty())
+            {
+                battery_save.reset(memnew<BatterySave>());
+                battery_save->init(this);
+            }
         }
     }
     return ok;
 }
 void Emulator::update(f64 delta_time)
 {
-    joypad.update(this);
-    if(is_cart_timer(get_cartridge_header(rom_data)->cartridge_type))
+    if(movie)
     {
-        rtc.update(delta_time);
+        movie->latch_input(this);
+    }
+    else
+    {
+        joypad.update(this);
+        if(is_cart_timer(get_cartridge_header(rom_data)->cartridge_type))
+        {
+            rtc.update(delta_time);
+        }
+    }
+    if(battery_save)
+    {
+        battery_save->update(this);
     }
     u64 frame_cycles = (u64)((f32)(4194304.0 * delta_time) * clock_speed_scale);
     u64 end_cycles = clock_cycles + frame_cycles;
-    while(clock_cycles < end_cycles)
+    cpu.run(this, end_cycles);
+    if(run_ahead_frames && !paused && !movie && !serial.link)
+    {
+        update_run_ahead();
+    }
+    else if(run_ahead && run_ahead->valid)
     {
-        if(paused) break;
-        cpu.step(this);
+        // Displays the front buffer instead of pixels produced by running ahead.
+        run_ahead->valid = false;
+        display_version = max(display_version, run_ahead->display_version) + 1;
     }
 }
+void Emulator::set_ppu_render_worker_enabled(bool enabled)
+{
+    if(enabled == (bool)ppu_renderer) return;
+    if(enabled)
+    {
+        ppu_renderer.reset(memnew<PPURenderer>());
+        ppu_renderer->init(this);
+    }
+    else
+    {
+        if(ppu.deferred_line)
+        {
+            ppu.draw_deferred_line_inline(this);
+        }
+        // Waits for all submitted lines, and merges `back_buffer_changed` of the worker so that
+        // the display version is still bumped at the end of this frame.
+        ppu_renderer->flush();
+        ppu_renderer.reset();
+    }
+}
+void Emulator::update_run_ahead()
+{
+    if(!run_ahead)
+    {
+        run_ahead.reset(memnew<RunAhead>());
+        run_ahead->snapshot.init(this);
+    }
+    run_ahead->snapshot.save(this);
+    // Detach host outputs so that frames run ahead have no side effects.
+    audio_sample_callback_t* callback = audio_sample_callback;
+    audio_sample_callback = nullptr;
+    UniquePtr<BatterySave> saved_battery_save = move(battery_save);
+    UniquePtr<VideoCapture> saved_video_capture = move(video_capture);
+    UniquePtr<AudioCapture> saved_audio_capture = move(audio_capture);
+    UniquePtr<TraceRecorder> saved_trace_recorder = move(trace_recorder);
+    UniquePtr<AccessCounters> saved_access_counters = move(access_counters);
+    UniquePtr<Profiler> saved_profiler = move(profiler);
+    UniquePtr<Breakpoints> saved_breakpoints = move(breakpoints);
+    update_features();
+    u64 end_cycles = clock_cycles + run_ahead_frames * FRAME_CYCLES;
+    cpu.run(this, end_cycles);
+    bool display_changed = !run_ahead->valid || memcmp(run_ahead->pixels, get_front_buffer(), sizeof(run_ahead->pixels)) != 0;
+    if(display_changed)
+    {
+        memcpy(run_ahead->pixels, get_front_buffer(), sizeof(run_ahead->pixels));
+    }
+    run_ahead->valid = true;
+    run_ahead->snapshot.load(this);
+    // Frames of the real state and frames run ahead change `display_version` even if the displayed
+    // pixels are the same, so the version is only incremented if pixels are changed.
+    display_version = display_changed ? max(display_version, run_ahead->display_version) + 1 : run_ahead->display_version;
+    run_ahead->display_version = display_version;
+    trace_recorder = move(saved_trace_recorder);
+    access_counters = move(saved_access_counters);
+    profiler = move(saved_profiler);
+    breakpoints = move(saved_breakpoints);
+    update_features();
+    battery_save = move(saved_battery_save);
+    video_capture = move(saved_video_capture);
+    audio_capture = move(saved_audio_capture);
+    audio_sample_callback = callback;
+}
 void Emulator::tick(u32 mcycles)
 {
     u32 tick_cycles = mcycles * 4;
@@ -100,23 +200,47 @@ void Emulator::tick(u32 mcycles)
         ppu.tick(this);
         apu.tick(this);
     }
+    if(movie && clock_cycles >= movie->next_frame_cycles)
+    {
+        movie->on_frame(this);
+    }
 }
 void Emulator::close()
 {
-    if(cram)
-    {
-        CartridgeHeader* header = get_cartridge_header(rom_data);
-        if(is_cart_battery(header->cartridge_type))
+    trace_recorder.reset();
+    access_counters.reset();
+    profiler.reset();
+    breakpoints.reset();
+    update_features();
+    cheats.reset();
+    video_capture.reset();
+    audio_capture.reset();
+    run_ahead.reset();
+    ppu_renderer.reset();
+    ppu.deferred_line = false;
+    if(movie)
+    {
+        auto r = movie->end();
+        if(failed(r))
         {
-            save_cartridge_ram_data();
+            log_error("LunaGB", "Failed to save movie: %s", explain(r.errcode()));
         }
+        movie.reset();
+    }
+    if(battery_save)
+    {
+        battery_save->close(this);
+        battery_save.reset();
+    }
+    if(cram)
+    {
         memfree(cram);
         cram = nullptr;
         cram_size = 0;
     }
     if (rom_data)
     {
-        memfree(rom_data);
+        rom.reset();
         rom_data = nullptr;
         rom_data_size = 0;
         log_info("LunaGB", "Cartridge Unloaded.");
@@ -144,10 +268,20 @@ u8 Emulator::bus_read(u16 addr)
         // Working RAM.
         return wram[addr - 0xC000];
     }
-    if(addr >= 0xFE00 && addr <= 0xFE9F)
+    if(addr <= 0xFDFF)
+    {
+        // Echo RAM, mirrors 0xC000~0xDDFF.
+        return wram[addr - 0xE000];
+    }
+    if(addr <= 0xFE9F)
     {
         return oam[addr - 0xFE00];
     }
+    if(addr <= 0xFEFF)
+    {
+        // Not usable, reads 0x00 on DMG.
+        return 0x00;
+    }
     if(addr == 0xFF00)
     {
         return joypad.bus_read();
@@ -183,9 +317,33 @@ u8 Emulator::bus_read(u16 addr)
         // IE
         return int_enable_flags | 0xE0;
     }
-    log_error("LunaGB", "Unsupported bus read address: 0x%04X", (u32)addr);
+    // Unmapped IO registers are open bus.
+    lulog_rate_limited(1.0, LogVerbosity::warning, "LunaGB", "Unmapped IO register read: 0x%04X", (u32)addr);
     return 0xFF;
 }
+u8 Emulator::peek(u16 addr)
+{
+    if(addr <= 0x7FFF)
+    {
+        return rom_banks[get_cartridge_rom_bank(this, addr)][addr % 16_kb];
+    }
+    if(addr >= 0xA000 && addr <= 0xBFFF)
+    {
+        return cram ? cartridge_read(this, addr) : 0xFF;
+    }
+    if(addr >= 0xFF00 && addr <= 0xFF7F)
+    {
+        // Only registers whose reads have no side effect are forwarded.
+        if(addr == 0xFF00 || (addr >= 0xFF01 && addr <= 0xFF02) || (addr >= 0xFF04 && addr <= 0xFF07) ||
+            addr == 0xFF0F || (addr >= 0xFF10 && addr <= 0xFF3F) || (addr >= 0xFF40 && addr <= 0xFF4B))
+        {
+            return bus_read(addr);
+        }
+        return 0xFF;
+    }
+    // VRAM, working RAM, OAM, high RAM and IE.
+    return bus_read(addr);
+}
 void Emulator::bus_write(u16 addr, u8 data)
 {
     if(addr <= 0x7FFF)
@@ -197,7 +355,17 @@ void Emulator::bus_write(u16 addr, u8 data)
     if(addr <= 0x9FFF)
     {
         // VRAM.
+        if(ppu.deferred_line)
+        {
+            ppu.draw_deferred_line_inline(this);
+        }
         vram[addr - 0x8000] = data;
+        u32 block = (addr - 0x8000) / VRAM_DIRTY_BLOCK_SIZE;
+        vram_dirty_bits[block / 64] |= (u64)1 << (block % 64);
+        if(ppu_renderer)
+        {
+            ppu_renderer->write_vram(this, addr - 0x8000, data);
+        }
         return;
     }
     if(addr <= 0xBFFF)
@@ -212,11 +380,22 @@ void Emulator::bus_write(u16 addr, u8 data)
         wram[addr - 0xC000] = data;
         return;
     }
-    if(addr >= 0xFE00 && addr <= 0xFE9F)
+    if(addr <= 0xFDFF)
+    {
+        // Echo RAM, mirrors 0xC000~0xDDFF.
+        wram[addr - 0xE000] = data;
+        return;
+    }
+    if(addr <= 0xFE9F)
     {
         oam[addr - 0xFE00] = data;
         return;
     }
+    if(addr <= 0xFEFF)
+    {
+        // Not usable, writes are ignored.
+        return;
+    }
     if(addr == 0xFF00)
     {
         joypad.bus_write(data);
@@ -245,7 +424,12 @@ void Emulator::bus_write(u16 addr, u8 data)
     }
     if(addr >= 0xFF40 && addr <= 0xFF4B)
     {
-        ppu.bus_write(addr, data);
+        // STAT, LY, LYC and DMA registers do not affect pixels being drawn.
+        if(ppu.deferred_line && addr != 0xFF41 && addr != 0xFF44 && addr != 0xFF45 && addr != 0xFF46)
+        {
+            ppu.draw_deferred_line_inline(this);
+        }
+        ppu.bus_write(this, addr, data);
         return;
     }
     if(addr >= 0xFF80 && addr <= 0xFFFE)
@@ -260,7 +444,7 @@ void Emulator::bus_write(u16 addr, u8 data)
         int_enable_flags = data & 0x1F;
         return;
     }
-    log_error("LunaGB", "Unsupported bus write address: 0x%04X", (u32)addr);
+    lulog_rate_limited(1.0, LogVerbosity::warning, "LunaGB", "Unmapped IO register write: 0x%04X", (u32)addr);
     return;
 }
 void Emulator::load_cartridge_ram_data()
@@ -293,28 +477,4 @@ void Emulator::load_cartridge_ram_data()
     }
     lucatch {}
     return;
-}
-void Emulator::save_cartridge_ram_data()
-{
-    lutry
-    {
-        if (cartridge_path.empty() || !cram) return;
-        Path path = cartridge_path;
-        path.replace_extension("sav");
-        lulet(f, open_file(path.encode().c_str(), FileOpenFlag::write, FileCreationMode::create_always));
-        luexp(f->write(cram, cram_size));
-        if(is_cart_timer(get_cartridge_header(rom_data)->cartridge_type))
-        {
-            // Save RTC state.
-            luexp(f->write(&rtc, sizeof(RTC)));
-            // Save current timestamp.
-            i64 timestamp = get_utc_timestamp();
-            luexp(f->write(&timestamp, sizeof(i64)));
-        }
-        log_info("LunaGB", "Save cartridge RAM data to %s.", path.encode().c_str());
-    }
-    lucatch
-    {
-        log_error("LunaGB", "Failed to save cartridge RAM data. Game progress may lost!");
-    }
 }
\ No newline at end of file
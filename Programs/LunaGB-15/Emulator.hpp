@@ -6,8 +6,23 @@
 #include "PPU.hpp"
 #include "Joypad.hpp"
 #include <Luna/Runtime/Path.hpp>
+#include <Luna/Runtime/File.hpp>
 #include "RTC.hpp"
 #include "APU.hpp"
+#include "TraceRecorder.hpp"
+#include "Movie.hpp"
+#include "BatterySave.hpp"
+#include "EmulatorState.hpp"
+#include "Snapshot.hpp"
+#include "AccessCounters.hpp"
+#include "Profiler.hpp"
+#include "Breakpoints.hpp"
+#include "Cheats.hpp"
+#include "VideoCapture.hpp"
+#include "AudioCapture.hpp"
+#include "PPURenderer.hpp"
+#include <Luna/Runtime/UniquePtr.hpp>
+#include <Luna/Runtime/Blob.hpp>
 using namespace Luna;
 
 constexpr u8 INT_VBLANK = 1;
@@ -16,66 +31,186 @@ constexpr u8 INT_TIMER = 4;
 constexpr u8 INT_SERIAL = 8;
 constexpr u8 INT_JOYPAD = 16;
 
-struct Emulator
-{
-    //! The cartridge file path. Used for saving cartridge RAM data if any.
-    Path cartridge_path;
+//! The number of clock cycles per second.
+constexpr u64 CLOCK_FREQUENCY = 4194304;
+//! The number of clock cycles per frame.
+constexpr u64 FRAME_CYCLES = PPU_CYCLES_PER_LINE * PPU_LINES_PER_FRAME;
+//! The number of ROM bank numbers that can be selected by supported MBCs.
+constexpr usize EMULATOR_MAX_ROM_BANKS = 128;
+//! The number of VRAM bytes tracked by one bit of `Emulator::vram_dirty_bits`, which is the size of one tile.
+constexpr usize VRAM_DIRTY_BLOCK_SIZE = 16;
+//! The number of 64-bit words of `Emulator::vram_dirty_bits`.
+constexpr usize VRAM_DIRTY_WORDS = 8_kb / VRAM_DIRTY_BLOCK_SIZE / 64;
 
-    byte_t* rom_data = nullptr;
-    usize rom_data_size = 0;
+// Debug features. The CPU core is compiled once for every combination of features, and the
+// core matching `Emulator::features` is selected at run time, so that disabled features do
+// not cost any check in the hot path.
+
+//! Records every executed instruction to `Emulator::trace_recorder`.
+constexpr u32 EMULATOR_FEATURE_TRACE = 0x01;
+//! Counts memory accesses to `Emulator::access_counters`.
+constexpr u32 EMULATOR_FEATURE_ACCESS_COUNTERS = 0x02;
+//! Profiles guest code to `Emulator::profiler`.
+constexpr u32 EMULATOR_FEATURE_PROFILER = 0x04;
+//! Checks execution breakpoints and IO triggers in `Emulator::breakpoints`.
+constexpr u32 EMULATOR_FEATURE_BREAKPOINTS = 0x08;
+//! Checks memory watchpoints in `Emulator::breakpoints`.
+constexpr u32 EMULATOR_FEATURE_WATCHPOINTS = 0x10;
+//! The number of feature combinations.
+constexpr u32 EMULATOR_NUM_FEATURE_SETS = 32;
+//! Features that change the behavior of bus accesses performed by instructions.
+constexpr u32 EMULATOR_BUS_FEATURES = EMULATOR_FEATURE_ACCESS_COUNTERS | EMULATOR_FEATURE_WATCHPOINTS;
 
+struct Emulator;
+using audio_sample_callback_t = void(Emulator* emu, f32 sample_l, f32 sample_r, void* userdata);
+
+struct Emulator : EmulatorState
+{
+    //! The cartridge ROM data mapped by `rom`.
+    const byte_t* rom_data = nullptr;
+    //! The memory map of cartridge ROM, one pointer to 16KB of data per bank number. MBCs read ROM
+    //! through this table. Bank numbers larger than the number of banks are mirrored, and banks
+    //! patched by cheats are mapped to patched copies.
+    const byte_t* rom_banks[EMULATOR_MAX_ROM_BANKS];
     //! The cartridge RAM.
     byte_t* cram = nullptr;
     //! The cartridge RAM size. 
     usize cram_size = 0;
-
     //! The number of ROM banks. 16KB per bank.
     usize num_rom_banks = 0;
-    //! MBC1/MBC2: The cartridge RAM is enabled for reading / writing.
-    //! MBC3: The cartridge RAM and cartridge timer enabled.
-    bool cram_enable = false;
-    //! MBC1/MBC2/MBC3: The ROM bank number controlling which rom bank is mapped to 0x4000~0x7FFF.
-    u8 rom_bank_number = 1;
-    //! MBC1: The RAM bank number register controlling which ram bank is mapped to 0xA000~0xBFFF.
-    //! If the cartridge ROM size is larger than 512KB (32 banks), this is used to control the 
-    //! high 2 bits of rom bank number, enabling the game to use at most 2MB of ROM data.
-    //! MBC3: The RAM bank number register controlling which ram bank/RTC register is mapped to 0xA000~0xBFFF.
-    //! 0-3: RAM banks.
-    //! 8-12: RTC registers.
-    u8 ram_bank_number = 0;
-    //! MBC1: The banking mode.
-    //! 0: 0000–3FFF and A000–BFFF are locked to bank 0 of ROM and SRAM respectively.
-    //! 1: 0000–3FFF and A000-BFFF can be bank-switched via the 4000–5FFF register.
-    u8 banking_mode = 0;
-
-    //! `true` if the emulation is paused.
-    bool paused = false;
-    //! The cycles counter.
-    u64 clock_cycles = 0;
+    usize rom_data_size = 0;
     //! The clock speed scale value.
     f32 clock_speed_scale = 1.0;
 
-    CPU cpu;
+    Serial serial;
 
-    byte_t vram[8_kb];
-    byte_t wram[8_kb];
-    byte_t oam[160];
-    byte_t hram[128];
+    // Host-side state.
 
-    //! 0xFF0F - The interruption flags.
-    u8 int_flags;
-    //! 0xFFFF - The interruption enabling flags.
-    u8 int_enable_flags;
+    //! The cartridge file path. Used for saving cartridge RAM data if any.
+    Path cartridge_path;
+    //! The cartridge ROM file mapping, shared by all emulators that open the same ROM file.
+    Ref<IFileMapping> rom;
+    //! One unique number assigned when the cartridge is loaded. Debug tools compare this instead of
+    //! the emulator address to detect cartridge changes, since one new emulator may be allocated at
+    //! the address of one closed emulator.
+    u64 generation = 0;
 
-    Timer timer;
-    Serial serial;
-    PPU ppu;
-    Joypad joypad;
-    RTC rtc;
-    APU apu;
+    //! The double-buffered RGBA frames drawn by PPU, `PPU_FRAME_SIZE` bytes per frame.
+    //! `ppu.current_back_buffer` selects the back buffer.
+    Blob frame_buffers;
+    //! The sample history of the APU high-pass filter.
+    UniquePtr<APUSampleHistory> apu_history;
+    //! Incremented when the pixels returned by `get_display_buffer` may be changed. The application
+    //! can skip uploading the display if this is not changed since the last upload.
+    u64 display_version = 0;
+    //! One bit for every `VRAM_DIRTY_BLOCK_SIZE` bytes of VRAM, set when the bytes may be changed.
+    //! Bits of tile data (0x8000~0x97FF) map to tiles, and bits of tile maps (0x9800~0x9FFF) map to
+    //! 16 map entries. Cleared by VRAM viewers of the debug window.
+    u64 vram_dirty_bits[VRAM_DIRTY_WORDS];
+    //! Marks bytes in [`begin`, `end`) of VRAM as changed.
+    void mark_vram_dirty(u16 begin, u16 end)
+    {
+        for(usize i = begin / VRAM_DIRTY_BLOCK_SIZE; i < (end + VRAM_DIRTY_BLOCK_SIZE - 1) / VRAM_DIRTY_BLOCK_SIZE; ++i)
+        {
+            vram_dirty_bits[i / 64] |= (u64)1 << (i % 64);
+        }
+    }
+
+    //! The debug features enabled, see `EMULATOR_FEATURE_TRACE` and other flags.
+    //! This is computed by `update_features`.
+    u32 features = 0;
+    //! The CPU trace recorder. `nullptr` if CPU tracing is not enabled.
+    UniquePtr<TraceRecorder> trace_recorder;
+    //! The memory access counters. `nullptr` if access counting is not enabled.
+    UniquePtr<AccessCounters> access_counters;
+    //! The guest code profiler. `nullptr` if profiling is not enabled.
+    UniquePtr<Profiler> profiler;
+    //! Breakpoints, watchpoints and IO triggers. `nullptr` if none is set.
+    UniquePtr<Breakpoints> breakpoints;
+    //! Cheat codes. `nullptr` if no cheat is added.
+    UniquePtr<Cheats> cheats;
+    //! The video capture. `nullptr` if video is not being captured.
+    UniquePtr<VideoCapture> video_capture;
+    //! The audio capture of APU output. `nullptr` if audio is not being captured.
+    UniquePtr<AudioCapture> audio_capture;
+    //! The battery save writer. `nullptr` if the cartridge does not have battery or the cartridge path is empty.
+    UniquePtr<BatterySave> battery_save;
+    //! The input movie being recorded or played. `nullptr` if no movie is active.
+    //! When one movie is active, joypad and RTC states are updated by the movie at movie frame
+    //! boundaries instead of `update`.
+    UniquePtr<Movie> movie;
+    //! The number of frames to run ahead after every update. 0 disables run-ahead.
+    //! Run-ahead is not performed when the emulation is paused, one movie is active or the link cable is connected.
+    u32 run_ahead_frames = 0;
+    //! The run-ahead state. Allocated when run-ahead is performed for the first time.
+    UniquePtr<RunAhead> run_ahead;
+
+    //! The render worker that draws scan lines on another thread, see `set_ppu_render_worker_enabled`.
+    //! `nullptr` to draw all scan lines on the emulation thread.
+    UniquePtr<PPURenderer> ppu_renderer;
+
+    //! The callback that receives audio samples generated by APU at `APU_SAMPLE_RATE`.
+    //! If this is `nullptr`, APU skips mixing audio samples.
+    audio_sample_callback_t* audio_sample_callback = nullptr;
+    void* audio_sample_callback_userdata = nullptr;
 
-    RV init(Path cartridge_path, const void* cartridge_data, usize cartridge_data_size);
+    //! Initializes the emulator.
+    //! @param[in] cartridge_path The cartridge file path used to load and save cartridge RAM data.
+    //! Pass empty path to disable loading and saving cartridge RAM data.
+    //! @param[in] rom The cartridge ROM data, see `open_rom`.
+    RV init(Path cartridge_path, IFileMapping* rom);
     void update(f64 delta_time);
+    //! Maps all ROM bank numbers to the cartridge ROM data without patches.
+    void map_rom_banks()
+    {
+        for(usize i = 0; i < EMULATOR_MAX_ROM_BANKS; ++i)
+        {
+            rom_banks[i] = rom_data + (i % num_rom_banks) * 16_kb;
+        }
+    }
+    //! Recomputes `features`. This must be called after any debug feature is enabled or disabled.
+    void update_features()
+    {
+        features = (trace_recorder ? EMULATOR_FEATURE_TRACE : 0) |
+            (access_counters ? EMULATOR_FEATURE_ACCESS_COUNTERS : 0) |
+            (profiler ? EMULATOR_FEATURE_PROFILER : 0) |
+            ((breakpoints && breakpoints->has_execute_checks()) ? EMULATOR_FEATURE_BREAKPOINTS : 0) |
+            ((breakpoints && breakpoints->has_memory_checks()) ? EMULATOR_FEATURE_WATCHPOINTS : 0);
+    }
+    //! Resumes the paused emulation. If the emulation is paused by the execution breakpoint at PC, the
+    //! instruction at PC is executed without hitting the breakpoint again. The last hit is cleared.
+    void resume()
+    {
+        if(breakpoints)
+        {
+            const BreakpointHit& hit = breakpoints->hit;
+            if(hit.type == BreakpointHitType::breakpoint && hit.pc == cpu.pc) breakpoints->skip(cpu.pc);
+            breakpoints->hit.type = BreakpointHitType::none;
+        }
+        paused = false;
+    }
+    //! Enables or disables drawing scan lines on the render worker thread. Lines are drawn on the
+    //! worker only if VRAM and PPU registers that affect pixels are not changed during drawing, so
+    //! the emulation result is the same in both modes.
+    void set_ppu_render_worker_enabled(bool enabled);
+    //! Runs `run_ahead_frames` frames ahead and rolls back to the current state.
+    //! Audio samples are not generated, and cartridge RAM is not saved for frames run ahead.
+    void update_run_ahead();
+    //! Gets the pixel data of the last completed frame.
+    const u8* get_front_buffer() const
+    {
+        return frame_buffers.data() + ((ppu.current_back_buffer + 1) % 2) * PPU_FRAME_SIZE;
+    }
+    //! Gets the pixel data of the frame being drawn.
+    u8* get_back_buffer()
+    {
+        return frame_buffers.data() + ppu.current_back_buffer * PPU_FRAME_SIZE;
+    }
+    //! Gets the pixel data that should be displayed in the application.
+    const u8* get_display_buffer() const
+    {
+        return (run_ahead && run_ahead->valid) ? run_ahead->pixels : get_front_buffer();
+    }
     //! Advances clock and updates all hardware states (except CPU).
     //! This is called from CPU instructions.
     //! @param[in] mcycles The number of machine cycles to tick.
@@ -88,6 +223,45 @@ struct Emulator
 
     u8 bus_read(u16 addr);
     void bus_write(u16 addr, u8 data);
+    //! Reads one byte without side effects (like logging or MBC state changes) for debug features.
+    //! Cartridge ROM is read from the banks currently mapped, and unmapped IO registers read 0xFF.
+    u8 peek(u16 addr);
+    //! Reads one byte from bus for CPU instructions, with debug features in `_Features` applied.
+    template <u32 _Features>
+    u8 bus_read(u16 addr)
+    {
+        if constexpr((_Features & EMULATOR_FEATURE_ACCESS_COUNTERS) != 0)
+        {
+            ++access_counters->reads[addr / ACCESS_COUNTER_PAGE_SIZE];
+        }
+        u8 data = bus_read(addr);
+        if constexpr((_Features & EMULATOR_FEATURE_WATCHPOINTS) != 0)
+        {
+            // The instruction is always completed, the emulation stops before the next instruction.
+            if(breakpoints->check_read(this, addr, data)) paused = true;
+        }
+        return data;
+    }
+    //! Writes one byte to bus for CPU instructions, with debug features in `_Features` applied.
+    template <u32 _Features>
+    void bus_write(u16 addr, u8 data)
+    {
+        if constexpr((_Features & EMULATOR_FEATURE_ACCESS_COUNTERS) != 0)
+        {
+            ++access_counters->writes[addr / ACCESS_COUNTER_PAGE_SIZE];
+        }
+        if constexpr((_Features & EMULATOR_FEATURE_WATCHPOINTS) != 0)
+        {
+            if(breakpoints->check_write(this, addr, data)) paused = true;
+        }
+        bus_write(addr, data);
+    }
+    //! Writes one byte to cartridge RAM.
+    void cram_write(usize offset, u8 data)
+    {
+        if(cram[offset] == data) return;
+        cram[offset] = data;
+        if(battery_save) battery_save->mark_dirty(offset, clock_cycles);
+    }
     void load_cartridge_ram_data();
-    void save_cartridge_ram_data();
 };
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+#include "CPU.hpp"
+#include "Timer.hpp"
+#include "PPU.hpp"
+#include "Joypad.hpp"
+#include "RTC.hpp"
+#include "APU.hpp"
+using namespace Luna;
+
+//! The emulation state of one emulator, which is saved and restored by snapshots.
+//! The state is trivially copyable and does not contain pointers, so that it can be copied
+//! between emulators with one `memcpy`. Fields are ordered by access frequency: the state accessed
+//! by every cycle or instruction comes first and fits in two cache lines, followed by device
+//! states and guest memory. Host-side buffers are stored in `Emulator`.
+struct EmulatorState
+{
+    // Hot state.
+
+    //! The cycles counter.
+    u64 clock_cycles = 0;
+    CPU cpu;
+    //! 0xFF0F - The interruption flags.
+    u8 int_flags = 0;
+    //! 0xFFFF - The interruption enabling flags.
+    u8 int_enable_flags = 0;
+    //! `true` if the emulation is paused.
+    bool paused = false;
+    //! Set to `true` when `LD B, B` is executed. Test ROMs use this instruction as software breakpoint.
+    bool software_breakpoint = false;
+    Timer timer;
+    //! MBC1/MBC2: The cartridge RAM is enabled for reading / writing.
+    //! MBC3: The cartridge RAM and cartridge timer enabled.
+    bool cram_enable = false;
+    //! MBC1/MBC2/MBC3: The ROM bank number controlling which rom bank is mapped to 0x4000~0x7FFF.
+    u8 rom_bank_number = 1;
+    //! MBC1: The RAM bank number register controlling which ram bank is mapped to 0xA000~0xBFFF.
+    //! If the cartridge ROM size is larger than 512KB (32 banks), this is used to control the 
+    //! high 2 bits of rom bank number, enabling the game to use at most 2MB of ROM data.
+    //! MBC3: The RAM bank number register controlling which ram bank/RTC register is mapped to 0xA000~0xBFFF.
+    //! 0-3: RAM banks.
+    //! 8-12: RTC registers.
+    u8 ram_bank_number = 0;
+    //! MBC1: The banking mode.
+    //! 0: 0000–3FFF and A000–BFFF are locked to bank 0 of ROM and SRAM respectively.
+    //! 1: 0000–3FFF and A000-BFFF can be bank-switched via the 4000–5FFF register.
+    u8 banking_mode = 0;
+
+    // Device states.
+
+    PPU ppu;
+    APU apu;
+    Joypad joypad;
+    RTC rtc;
+
+    // Guest memory.
+
+    byte_t vram[8_kb];
+    byte_t wram[8_kb];
+    byte_t oam[160];
+    byte_t hram[128];
+};
+static_assert(is_trivially_copyable_v<EmulatorState>, "EmulatorState must be trivially copyable");
+static_assert(is_standard_layout_v<EmulatorState>, "EmulatorState must be standard layout");
+static_assert(offsetof(EmulatorState, banking_mode) < 128, "Hot emulator state must fit in two cache lines");
\ No newline at end of file
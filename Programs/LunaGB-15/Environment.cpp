@@ -0,0 +1,180 @@
+#include "Environment.hpp"
+#include "Cartridge.hpp"
+#include "RomCache.hpp"
+#include <Luna/Runtime/Log.hpp>
+#include <Luna/Runtime/Time.hpp>
+#include <Luna/Runtime/Thread.hpp>
+
+RV Environment::init(const EnvironmentDesc& desc)
+{
+    lutry
+    {
+        if(!desc.num_instances)
+        {
+            return set_error(BasicError::bad_arguments(), "The number of instances must not be 0.");
+        }
+        observation_type = desc.observation_type;
+        observed_addresses = desc.observed_addresses;
+        if(observation_type == EnvironmentObservationType::screen)
+        {
+            observation_size = PPU_XRES * PPU_YRES;
+        }
+        else
+        {
+            for(u16 addr : observed_addresses)
+            {
+                if(!(addr >= 0xC000 && addr <= 0xDFFF) && !(addr >= 0xFF80 && addr <= 0xFFFE))
+                {
+                    return set_error(BasicError::bad_arguments(), "Address 0x%04X is not a WRAM or HRAM address.", (u32)addr);
+                }
+            }
+            observation_size = observed_addresses.size();
+        }
+        lulet(rom, open_rom(desc.rom_path));
+        has_rtc = is_cart_timer(get_cartridge_header((const byte_t*)rom->get_data())->cartridge_type);
+        // Power on the first instance and capture the reset snapshot.
+        instances.clear();
+        instances.reserve(desc.num_instances);
+        UniquePtr<Emulator> emu(memnew<Emulator>());
+        // Pass empty cartridge path so that cartridge RAM data is not loaded or saved.
+        luexp(emu->init(Path(), rom));
+        u64 warmup_cycles = desc.warmup_frames * FRAME_CYCLES;
+        emu->cpu.run(emu.get(), warmup_cycles);
+        emu->serial.output_buffer.clear();
+        reset_snapshot.reset(memnew<EmulatorSnapshot>());
+        reset_snapshot->init(emu.get());
+        reset_snapshot->save(emu.get());
+        instances.push_back(move(emu));
+        for(u32 i = 1; i < desc.num_instances; ++i)
+        {
+            emu.reset(memnew<Emulator>());
+            luexp(emu->init(Path(), rom));
+            instances.push_back(move(emu));
+        }
+        for(u32 i = 0; i < 256; ++i)
+        {
+            u8 shade = 0;
+            for(u8 s = 1; s < 4; ++s)
+            {
+                if(abs((i32)i - (i32)PPU_SHADE_COLORS[s][0]) < abs((i32)i - (i32)PPU_SHADE_COLORS[shade][0])) shade = s;
+            }
+            shade_table[i] = shade;
+        }
+        observations.resize(observation_size * desc.num_instances, false);
+        num_jobs = min(desc.num_instances, get_processors_count() * 4);
+        jobs.reserve(num_jobs);
+        for(u32 i = 0; i < desc.num_instances; ++i)
+        {
+            reset(i);
+        }
+    }
+    lucatchret;
+    return ok;
+}
+void Environment::reset(u32 index)
+{
+    reset_snapshot->load(instances[index].get());
+    update_observation(index);
+}
+struct EnvironmentJobParams
+{
+    Environment* env;
+    u32 begin;
+    u32 end;
+};
+static void run_environment_job(void* params)
+{
+    EnvironmentJobParams* p = (EnvironmentJobParams*)params;
+    p->env->step_instances(p->begin, p->end);
+}
+void Environment::step(Span<const u8> actions, u32 frames_per_step)
+{
+    luassert(actions.size() == instances.size());
+    step_actions = actions.data();
+    step_frames = frames_per_step;
+    // Split instances into a few jobs per worker, so that workers stay busy when instances
+    // run for different times without paying job overhead for every instance. Job parameters are
+    // allocated by the job system and released when the job finishes, so they are created every step.
+    u32 num_instances = get_num_instances();
+    jobs.clear();
+    for(u32 i = 0; i < num_jobs; ++i)
+    {
+        EnvironmentJobParams* params = (EnvironmentJobParams*)JobSystem::new_job(run_environment_job, sizeof(EnvironmentJobParams), alignof(EnvironmentJobParams));
+        params->env = this;
+        params->begin = (u32)((u64)num_instances * i / num_jobs);
+        params->end = (u32)((u64)num_instances * (i + 1) / num_jobs);
+        jobs.push_back(JobSystem::submit_job(params));
+    }
+    for(JobSystem::job_id_t job : jobs)
+    {
+        JobSystem::wait_job(job);
+    }
+}
+void Environment::step_instances(u32 begin, u32 end)
+{
+    for(u32 i = begin; i < end; ++i)
+    {
+        Emulator* emu = instances[i].get();
+        emu->joypad.set_buttons(step_actions[i]);
+        emu->joypad.update(emu);
+        if(has_rtc)
+        {
+            // Use emulated time rather than host time so that every episode is deterministic.
+            emu->rtc.update((f64)(step_frames * FRAME_CYCLES) / CLOCK_FREQUENCY);
+        }
+        u64 end_cycles = emu->clock_cycles + step_frames * FRAME_CYCLES;
+        emu->cpu.run(emu, end_cycles);
+        // Serial output is not observed, discard it so that the buffer does not grow.
+        emu->serial.output_buffer.clear();
+        update_observation(i);
+    }
+}
+void Environment::update_observation(u32 index)
+{
+    Emulator* emu = instances[index].get();
+    byte_t* dst = observations.data() + observation_size * index;
+    if(observation_type == EnvironmentObservationType::screen)
+    {
+        const u8* src = emu->get_front_buffer();
+        for(usize i = 0; i < PPU_XRES * PPU_YRES; ++i)
+        {
+            dst[i] = shade_table[src[i * 4]];
+        }
+    }
+    else
+    {
+        for(usize i = 0; i < observed_addresses.size(); ++i)
+        {
+            u16 addr = observed_addresses[i];
+            dst[i] = addr >= 0xFF80 ? emu->hram[addr - 0xFF80] : emu->wram[addr - 0xC000];
+        }
+    }
+}
+RV benchmark_environment(const c8* rom_path, u32 num_instances, u32 num_steps)
+{
+    lutry
+    {
+        UniquePtr<Environment> env(memnew<Environment>());
+        EnvironmentDesc desc;
+        desc.rom_path = rom_path;
+        desc.num_instances = num_instances;
+        luexp(env->init(desc));
+        Vector<u8> actions(num_instances, 0);
+        u64 begin_ticks = get_ticks();
+        for(u32 s = 0; s < num_steps; ++s)
+        {
+            // Change actions every few steps.
+            for(u32 i = 0; i < num_instances; ++i)
+            {
+                actions[i] = (u8)(((s / 8) + i) * 37);
+            }
+            env->step({actions.data(), actions.size()}, 1);
+        }
+        f64 time = (f64)(get_ticks() - begin_ticks) / get_ticks_per_second();
+        u64 num_frames = (u64)num_instances * num_steps;
+        log_info("LunaGB", "%llu frames of %u instances run in %f seconds (%.1f frames/s, %u processors).",
+            num_frames, num_instances, time, num_frames / time, get_processors_count());
+    }
+    lucatchret;
+    return ok;
+}
\ No newline at end of file
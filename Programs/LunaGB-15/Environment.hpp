@@ -0,0 +1,82 @@
+#pragma once
+#include <Luna/Runtime/Result.hpp>
+#include <Luna/Runtime/Path.hpp>
+#include <Luna/Runtime/Vector.hpp>
+#include <Luna/Runtime/Blob.hpp>
+#include <Luna/Runtime/Span.hpp>
+#include <Luna/Runtime/UniquePtr.hpp>
+#include <Luna/JobSystem/JobSystem.hpp>
+#include "Emulator.hpp"
+using namespace Luna;
+
+enum class EnvironmentObservationType : u8
+{
+    //! One shade index (0-3, 0 is the lightest) per pixel, PPU_XRES * PPU_YRES bytes per instance.
+    screen,
+    //! The selected WRAM/HRAM bytes, one byte per address in `EnvironmentDesc::observed_addresses`.
+    ram
+};
+
+struct EnvironmentDesc
+{
+    //! The cartridge ROM file path. All instances share one mapping of the ROM file.
+    Path rom_path;
+    //! The number of emulator instances.
+    u32 num_instances = 1;
+    EnvironmentObservationType observation_type = EnvironmentObservationType::screen;
+    //! The bus addresses to observe if `observation_type` is `EnvironmentObservationType::ram`.
+    //! Only WRAM (0xC000~0xDFFF) and HRAM (0xFF80~0xFFFE) addresses are allowed.
+    Vector<u16> observed_addresses;
+    //! The number of frames to run after power on before the reset snapshot is captured.
+    //! This can be used to skip boot screens shared by all episodes.
+    u32 warmup_frames = 0;
+};
+
+//! Runs many emulator instances of the same ROM in lockstep for automated play-testing agents.
+//! Instances are stepped in parallel using job system workers. Observations of all instances are
+//! written to one preallocated buffer. Every step allocates and submits `num_jobs` jobs, which does
+//! not grow with the number of instances.
+struct Environment
+{
+    EnvironmentObservationType observation_type;
+    Vector<u16> observed_addresses;
+    Vector<UniquePtr<Emulator>> instances;
+    //! The emulation state restored by `reset`.
+    UniquePtr<EmulatorSnapshot> reset_snapshot;
+    bool has_rtc = false;
+    //! The observation size of one instance in bytes.
+    usize observation_size = 0;
+    //! The observations of all instances, `observation_size` bytes per instance.
+    Blob observations;
+    //! Maps the red channel of the PPU output color to the shade index.
+    u8 shade_table[256];
+
+    // Per-step states read by worker jobs.
+
+    //! The number of jobs that instances are split into for every step.
+    u32 num_jobs = 0;
+    Vector<JobSystem::job_id_t> jobs;
+    const u8* step_actions = nullptr;
+    u32 step_frames = 0;
+
+    //! Creates all instances and captures the reset snapshot.
+    RV init(const EnvironmentDesc& desc);
+    u32 get_num_instances() const { return (u32)instances.size(); }
+    //! Restores the specified instance to the reset snapshot and updates its observation.
+    void reset(u32 index);
+    //! Runs all instances in parallel.
+    //! @param[in] actions The joypad state of every instance, see `Joypad::get_buttons`.
+    //! @param[in] frames_per_step The number of frames to run for every instance.
+    void step(Span<const u8> actions, u32 frames_per_step);
+    //! Gets the observation of the specified instance.
+    const byte_t* get_observation(u32 index) const
+    {
+        return observations.data() + observation_size * index;
+    }
+    //! Runs and updates observations of instances in [begin, end). This is called from job system worker threads.
+    void step_instances(u32 begin, u32 end);
+    void update_observation(u32 index);
+};
+
+//! Measures the aggregate throughput of one environment.
+RV benchmark_environment(const c8* rom_path, u32 num_instances, u32 num_steps);
\ No newline at end of file
@@ -6,319 +6,211 @@ inline constexpr u16 make_u16(u8 low, u8 high)
     return ((u16)low) | (((u16)high) << 8);
 }
 //! Reads 16-bit immediate data.
+template <u32 _Features>
 inline u16 read_d16(Emulator* emu)
 {
-    u16 r = make_u16(emu->bus_read(emu->cpu.pc), emu->bus_read(emu->cpu.pc + 1));
+    u16 r = make_u16(emu->bus_read<_Features>(emu->cpu.pc), emu->bus_read<_Features>(emu->cpu.pc + 1));
     emu->cpu.pc += 2;
     return r;
 }
 //! Reads 8-bit immediate data.
+template <u32 _Features>
 inline u8 read_d8(Emulator* emu)
 {
-    u8 r = emu->bus_read(emu->cpu.pc);
+    u8 r = emu->bus_read<_Features>(emu->cpu.pc);
     ++emu->cpu.pc;
     return r;
 }
 //! Sets the zero flag if `v` is 0, otherwise resets the zero flag.
 inline void set_zero_flag(Emulator* emu, u8 v)
 {
-    if(v)
-    {
-        emu->cpu.reset_fz();
-    }
-    else
-    {
-        emu->cpu.set_fz();
-    }
+    emu->cpu.flag_z_result = v;
 }
 //! Compares v1 with v2, and sets flags based on result.
 inline void cp_8(Emulator* emu, u16 v1, u16 v2)
 {
-    u8 r = (u8)v1 - (u8)v2;
-    set_zero_flag(emu, r);
-    emu->cpu.set_fn();
-    if((v1 & 0x0F) < (v2 & 0x0F)) emu->cpu.set_fh();
-    else emu->cpu.reset_fh();
-    if(v1 < v2) emu->cpu.set_fc();
-    else emu->cpu.reset_fc();
+    u16 r = v1 - v2;
+    emu->cpu.flag_z_result = (u8)r;
+    emu->cpu.flag_n = true;
+    emu->cpu.flag_h_carries = (u8)(v1 ^ v2 ^ r);
+    emu->cpu.flag_c = v1 < v2;
 }
 //! Pushes 16-bit data into stack.
+template <u32 _Features>
 inline void push_16(Emulator* emu, u16 v)
 {
     emu->cpu.sp -= 2;
-    emu->bus_write(emu->cpu.sp + 1, (u8)((v >> 8) & 0xFF));
-    emu->bus_write(emu->cpu.sp, (u8)(v & 0xFF));
+    emu->bus_write<_Features>(emu->cpu.sp + 1, (u8)((v >> 8) & 0xFF));
+    emu->bus_write<_Features>(emu->cpu.sp, (u8)(v & 0xFF));
 }
 //! Pops 16-bit data from stack.
+template <u32 _Features>
 inline u16 pop_16(Emulator* emu)
 {
-    u8 lo = emu->bus_read(emu->cpu.sp);
-    u8 hi = emu->bus_read(emu->cpu.sp + 1);
+    u8 lo = emu->bus_read<_Features>(emu->cpu.sp);
+    u8 hi = emu->bus_read<_Features>(emu->cpu.sp + 1);
     emu->cpu.sp += 2;
     return make_u16(lo, hi);
 }
 //! Increases 8-bit value.
 inline void inc_8(Emulator* emu, u8& v)
 {
-    ++v;
-    set_zero_flag(emu, v);
-    emu->cpu.reset_fn();
-    if((v & 0x0F) == 0x00)
-    {
-        emu->cpu.set_fh();
-    }
-    else
-    {
-        emu->cpu.reset_fh();
-    }
+    u8 r = v + 1;
+    emu->cpu.flag_z_result = r;
+    emu->cpu.flag_n = false;
+    emu->cpu.flag_h_carries = v ^ 0x01 ^ r;
+    v = r;
 }
 //! Decreases 8-bit value.
 inline void dec_8(Emulator* emu, u8& v)
 {
-    --v;
-    set_zero_flag(emu, v);
-    emu->cpu.set_fn();
-    if((v & 0x0F) == 0x0F)
-    {
-        emu->cpu.set_fh();
-    }
-    else
-    {
-        emu->cpu.reset_fh();
-    }
+    u8 r = v - 1;
+    emu->cpu.flag_z_result = r;
+    emu->cpu.flag_n = true;
+    emu->cpu.flag_h_carries = v ^ 0x01 ^ r;
+    v = r;
 }
 //! Adds two 8-bit values.
 inline u8 add_8(Emulator* emu, u16 v1, u16 v2)
 {
-    u8 r = (u8)(v1 + v2);
-    set_zero_flag(emu, r);
-    emu->cpu.reset_fn();
-    if((v1 & 0x0F) + (v2 & 0x0F) > 0x0F) emu->cpu.set_fh();
-    else emu->cpu.reset_fh();
-    if(v1 + v2 > 0xFF) emu->cpu.set_fc();
-    else emu->cpu.reset_fc();
-    return r;
+    u16 r = v1 + v2;
+    emu->cpu.flag_z_result = (u8)r;
+    emu->cpu.flag_n = false;
+    emu->cpu.flag_h_carries = (u8)(v1 ^ v2 ^ r);
+    emu->cpu.flag_c = r > 0xFF;
+    return (u8)r;
 }
 //! Adds two 16-bit values.
 inline u16 add_16(Emulator* emu, u32 v1, u32 v2)
 {
-    emu->cpu.reset_fn();
-    if((v1 & 0xFFF) + (v2 & 0xFFF) > 0xFFF) emu->cpu.set_fh();
-    else emu->cpu.reset_fh();
-    if(v1 + v2 > 0xFFFF) emu->cpu.set_fc();
-    else emu->cpu.reset_fc();
-    return (u16)(v1 + v2);
+    u32 r = v1 + v2;
+    emu->cpu.flag_n = false;
+    // Bit 12 of `v1 ^ v2 ^ r` is the carry from bit 11 to bit 12.
+    emu->cpu.flag_h_carries = (u8)((v1 ^ v2 ^ r) >> 8);
+    emu->cpu.flag_c = r > 0xFFFF;
+    return (u16)r;
 }
 //! Adds two 8-bit values with carry.
 inline u8 adc_8(Emulator* emu, u16 v1, u16 v2)
 {
     u16 c = emu->cpu.fc() ? 1 : 0;
-    u8 r = (u8)(v1 + v2 + c);
-    set_zero_flag(emu, r);
-    emu->cpu.reset_fn();
-    if(((v1 & 0x0F) + (v2 & 0x0F) + c) > 0x0F) emu->cpu.set_fh();
-    else emu->cpu.reset_fh();
-    if((v1 + v2 + c) > 0xFF) emu->cpu.set_fc();
-    else emu->cpu.reset_fc();
-    return r;
+    u16 r = v1 + v2 + c;
+    emu->cpu.flag_z_result = (u8)r;
+    emu->cpu.flag_n = false;
+    emu->cpu.flag_h_carries = (u8)(v1 ^ v2 ^ r);
+    emu->cpu.flag_c = r > 0xFF;
+    return (u8)r;
 }
 //! Subtracts two 8-bit values.
 inline u8 sub_8(Emulator* emu, u16 v1, u16 v2)
 {
-    u8 r = (u8)v1 - (u8)v2;
-    set_zero_flag(emu, r);
-    emu->cpu.set_fn();
-    if((v1 & 0x0F) < (v2 & 0x0F)) emu->cpu.set_fh();
-    else emu->cpu.reset_fh();
-    if(v1 < v2) emu->cpu.set_fc();
-    else emu->cpu.reset_fc();
-    return r;
+    u16 r = v1 - v2;
+    emu->cpu.flag_z_result = (u8)r;
+    emu->cpu.flag_n = true;
+    emu->cpu.flag_h_carries = (u8)(v1 ^ v2 ^ r);
+    emu->cpu.flag_c = v1 < v2;
+    return (u8)r;
 }
 //! Subtracts two 8-bit values with carry.
 inline u8 sbc_8(Emulator* emu, u16 v1, u16 v2)
 {
-    u8 c = emu->cpu.fc() ? 1 : 0;
-    u8 r = (u8)v1 - (u8)v2 - c;
-    set_zero_flag(emu, r);
-    emu->cpu.set_fn();
-    if((v1 & 0x0F) < ((v2 & 0x0F) + c)) emu->cpu.set_fh();
-    else emu->cpu.reset_fh();
-    if(v1 < (v2 + c)) emu->cpu.set_fc();
-    else emu->cpu.reset_fc();
-    return r;
+    u16 c = emu->cpu.fc() ? 1 : 0;
+    u16 r = v1 - v2 - c;
+    emu->cpu.flag_z_result = (u8)r;
+    emu->cpu.flag_n = true;
+    emu->cpu.flag_h_carries = (u8)(v1 ^ v2 ^ r);
+    emu->cpu.flag_c = v1 < (v2 + c);
+    return (u8)r;
+}
+//! Sets flags for logical operations.
+inline void set_logic_flags(Emulator* emu, u8 r, bool h)
+{
+    emu->cpu.flag_z_result = r;
+    emu->cpu.flag_n = false;
+    emu->cpu.flag_h_carries = h ? 0x10 : 0;
+    emu->cpu.flag_c = false;
 }
 //! Performs bitwise AND between two values.
 inline u8 and_8(Emulator* emu, u8 v1, u8 v2)
 {
     u8 r = v1 & v2;
-    set_zero_flag(emu, r);
-    emu->cpu.reset_fn();
-    emu->cpu.set_fh();
-    emu->cpu.reset_fc();
+    set_logic_flags(emu, r, true);
     return r;
 }
 //! Performs bitwise XOR between two values.
 inline u8 xor_8(Emulator* emu, u8 v1, u8 v2)
 {
     u8 r = v1 ^ v2;
-    set_zero_flag(emu, r);
-    emu->cpu.reset_fn();
-    emu->cpu.reset_fh();
-    emu->cpu.reset_fc();
+    set_logic_flags(emu, r, false);
     return r;
 }
 //! Performs bitwise OR between two values.
 inline u8 or_8(Emulator* emu, u8 v1, u8 v2)
 {
     u8 r = v1 | v2;
-    set_zero_flag(emu, r);
-    emu->cpu.reset_fn();
-    emu->cpu.reset_fh();
-    emu->cpu.reset_fc();
+    set_logic_flags(emu, r, false);
     return r;
 }
+//! Sets flags for rotate and shift operations.
+inline void set_shift_flags(Emulator* emu, u8 r, bool carry)
+{
+    emu->cpu.flag_z_result = r;
+    emu->cpu.flag_n = false;
+    emu->cpu.flag_h_carries = 0;
+    emu->cpu.flag_c = carry;
+}
 inline void rlc_8(Emulator* emu, u8& v)
 {
     bool carry = (v & 0x80) != 0;
-    v <<= 1;
-    if(carry)
-    {
-        v |= 0x01;
-        emu->cpu.set_fc();
-    }
-    else
-    {
-        emu->cpu.reset_fc();
-    }
-    set_zero_flag(emu, v);
-    emu->cpu.reset_fn();
-    emu->cpu.reset_fh();
+    v = (v << 1) | (carry ? 0x01 : 0);
+    set_shift_flags(emu, v, carry);
 }
 inline void rrc_8(Emulator* emu, u8& v)
 {
     bool carry = (v & 0x01) != 0;
-    v >>= 1;
-    if(carry)
-    {
-        v |= 0x80;
-        emu->cpu.set_fc();
-    }
-    else
-    {
-        emu->cpu.reset_fc();
-    }
-    set_zero_flag(emu, v);
-    emu->cpu.reset_fn();
-    emu->cpu.reset_fh();
+    v = (v >> 1) | (carry ? 0x80 : 0);
+    set_shift_flags(emu, v, carry);
 }
 inline void rl_8(Emulator* emu, u8& v)
 {
     bool carry = (v & 0x80) != 0;
-    v <<= 1;
-    if(emu->cpu.fc())
-    {
-        v |= 0x01;
-    }
-    if(carry)
-    {
-        emu->cpu.set_fc();
-    }
-    else
-    {
-        emu->cpu.reset_fc();
-    }
-    set_zero_flag(emu, v);
-    emu->cpu.reset_fn();
-    emu->cpu.reset_fh();
+    v = (v << 1) | (emu->cpu.fc() ? 0x01 : 0);
+    set_shift_flags(emu, v, carry);
 }
 inline void rr_8(Emulator* emu, u8& v)
 {
     bool carry = (v & 0x01) != 0;
-    v >>= 1;
-    if(emu->cpu.fc())
-    {
-        v |= 0x80;
-    }
-    if(carry)
-    {
-        emu->cpu.set_fc();
-    }
-    else
-    {
-        emu->cpu.reset_fc();
-    }
-    set_zero_flag(emu, v);
-    emu->cpu.reset_fn();
-    emu->cpu.reset_fh();
+    v = (v >> 1) | (emu->cpu.fc() ? 0x80 : 0);
+    set_shift_flags(emu, v, carry);
 }
 inline void sla_8(Emulator* emu, u8& v)
 {
     bool carry = (v & 0x80) != 0;
     v <<= 1;
-    if(carry)
-    {
-        emu->cpu.set_fc();
-    }
-    else
-    {
-        emu->cpu.reset_fc();
-    }
-    set_zero_flag(emu, v);
-    emu->cpu.reset_fn();
-    emu->cpu.reset_fh();
+    set_shift_flags(emu, v, carry);
 }
 inline void sra_8(Emulator* emu, u8& v)
 {
     bool carry = (v & 0x01) != 0;
     v = (v & 0x80) | ((v >> 1) & 0x7F);
-    if(carry)
-    {
-        emu->cpu.set_fc();
-    }
-    else
-    {
-        emu->cpu.reset_fc();
-    }
-    set_zero_flag(emu, v);
-    emu->cpu.reset_fn();
-    emu->cpu.reset_fh();
+    set_shift_flags(emu, v, carry);
 }
 inline void srl_8(Emulator* emu, u8& v)
 {
     bool carry = (v & 0x01) != 0;
     v = (v >> 1) & 0x7F;
-    if(carry)
-    {
-        emu->cpu.set_fc();
-    }
-    else
-    {
-        emu->cpu.reset_fc();
-    }
-    set_zero_flag(emu, v);
-    emu->cpu.reset_fn();
-    emu->cpu.reset_fh();
+    set_shift_flags(emu, v, carry);
 }
 inline void swap_8(Emulator* emu, u8& v)
 {
     v = ((v >> 4) & 0x0F) + ((v << 4) & 0xF0);
-    set_zero_flag(emu, v);
-    emu->cpu.reset_fc();
-    emu->cpu.reset_fn();
-    emu->cpu.reset_fh();
+    set_shift_flags(emu, v, false);
 }
 inline void bit_8(Emulator* emu, u8 v, u8 bit)
 {
-    if(bit_test(&v, bit))
-    {
-        emu->cpu.reset_fz();
-    }
-    else
-    {
-        emu->cpu.set_fz();
-    }
-    emu->cpu.reset_fn();
-    emu->cpu.set_fh();
+    emu->cpu.flag_z_result = v & (1 << bit);
+    emu->cpu.flag_n = false;
+    emu->cpu.flag_h_carries = 0x10;
 }
 inline void res_8(Emulator* emu, u8& v, u8 bit)
 {
@@ -329,48 +221,56 @@ inline void set_8(Emulator* emu, u8& v, u8 bit)
     bit_set(&v, bit);
 }
 //! NOP : Do nothing.
+template <u32 _Features>
 void x00_nop(Emulator* emu)
 {
     // Do nothing.
     emu->tick(1);
 }
 //! LD BC, d16 : Loads 16-bit immediate data to BC.
+template <u32 _Features>
 void x01_ld_bc_d16(Emulator* emu)
 {
-    emu->cpu.bc(read_d16(emu));
+    emu->cpu.bc(read_d16<_Features>(emu));
     emu->tick(3);
 }
 //! LD (BC), A : Stores A to the memory pointed by BC.
+template <u32 _Features>
 void x02_ld_mbc_a(Emulator* emu)
 {
-    emu->bus_write(emu->cpu.bc(), emu->cpu.a);
+    emu->bus_write<_Features>(emu->cpu.bc(), emu->cpu.a);
     emu->tick(2);
 }
 //! INC BC : Increases BC.
+template <u32 _Features>
 void x03_inc_bc(Emulator* emu)
 {
     emu->cpu.bc(emu->cpu.bc() + 1);
     emu->tick(2);
 }
 //! INC B : Increases B.
+template <u32 _Features>
 void x04_inc_b(Emulator* emu)
 {
     inc_8(emu, emu->cpu.b);
     emu->tick(1);
 }
 //! DEC B : Decreases B.
+template <u32 _Features>
 void x05_dec_b(Emulator* emu)
 {
     dec_8(emu, emu->cpu.b);
     emu->tick(1);
 }
 //! LD B, d8 : Loads 8-bit immediate data to B.
+template <u32 _Features>
 void x06_ld_b_d8(Emulator* emu)
 {
-    emu->cpu.b = read_d8(emu);
+    emu->cpu.b = read_d8<_Features>(emu);
     emu->tick(2);
 }
 //! RLCA : Rotates A left.
+template <u32 _Features>
 void x07_rlca(Emulator* emu)
 {
     rlc_8(emu, emu->cpu.a);
@@ -378,52 +278,60 @@ void x07_rlca(Emulator* emu)
     emu->tick(1);
 }
 //! LD (a16), SP : Stores SP to the specified address.
+template <u32 _Features>
 void x08_ld_a16_sp(Emulator* emu)
 {
-    u16 addr = read_d16(emu);
+    u16 addr = read_d16<_Features>(emu);
     emu->tick(2);
-    emu->bus_write(addr, (u8)(emu->cpu.sp & 0xFF));
+    emu->bus_write<_Features>(addr, (u8)(emu->cpu.sp & 0xFF));
     emu->tick(1);
-    emu->bus_write(addr + 1, (u8)(emu->cpu.sp >> 8));
+    emu->bus_write<_Features>(addr + 1, (u8)(emu->cpu.sp >> 8));
     emu->tick(2);
 }
 //! ADD HL, BC : Adds BC to HL.
+template <u32 _Features>
 void x09_add_hl_bc(Emulator* emu)
 {
     emu->cpu.hl(add_16(emu, emu->cpu.hl(), emu->cpu.bc()));
     emu->tick(2);
 }
 //! LD A (BC) : Loads value from memory pointed by BC to A.
+template <u32 _Features>
 void x0a_ld_a_mbc(Emulator* emu)
 {
-    emu->cpu.a = emu->bus_read(emu->cpu.bc());
+    emu->cpu.a = emu->bus_read<_Features>(emu->cpu.bc());
     emu->tick(2);
 }
 //! DEC BC : Decreases BC.
+template <u32 _Features>
 void x0b_dec_bc(Emulator* emu)
 {
     emu->cpu.bc(emu->cpu.bc() - 1);
     emu->tick(2);
 }
 //! INC C : Increases C.
+template <u32 _Features>
 void x0c_inc_c(Emulator* emu)
 {
     inc_8(emu, emu->cpu.c);
     emu->tick(1);
 }
 //! DEC C : Decreases C.
+template <u32 _Features>
 void x0d_dec_c(Emulator* emu)
 {
     dec_8(emu, emu->cpu.c);
     emu->tick(1);
 }
 //! LD C, d8 : Loads 8-bit immediate data to C.
+template <u32 _Features>
 void x0e_ld_c_d8(Emulator* emu)
 {
-    emu->cpu.c = read_d8(emu);
+    emu->cpu.c = read_d8<_Features>(emu);
     emu->tick(2);
 }
 //! RRCA : Rotates A right.
+template <u32 _Features>
 void x0f_rrca(Emulator* emu)
 {
     rrc_8(emu, emu->cpu.a);
@@ -431,49 +339,57 @@ void x0f_rrca(Emulator* emu)
     emu->tick(1);
 }
 //! STOP : Stops CPU.
+template <u32 _Features>
 void x10_stop(Emulator* emu)
 {
-    read_d8(emu); // always 0x00.
+    read_d8<_Features>(emu); // always 0x00.
     emu->paused = true;
     emu->tick(1);
 }
 //! LD DE, d16 : Loads 16-bit immediate data to DE.
+template <u32 _Features>
 void x11_ld_de_d16(Emulator* emu)
 {
-    emu->cpu.de(read_d16(emu));
+    emu->cpu.de(read_d16<_Features>(emu));
     emu->tick(3);
 }
 //! LD (DE), A : Stores A to the memory pointed by DE.
+template <u32 _Features>
 void x12_ld_mde_a(Emulator* emu)
 {
-    emu->bus_write(emu->cpu.de(), emu->cpu.a);
+    emu->bus_write<_Features>(emu->cpu.de(), emu->cpu.a);
     emu->tick(2);
 }
 //! INC DE : Increases DE.
+template <u32 _Features>
 void x13_inc_de(Emulator* emu)
 {
     emu->cpu.de(emu->cpu.de() + 1);
     emu->tick(2);
 }
 //! INC D : Increases D.
+template <u32 _Features>
 void x14_inc_d(Emulator* emu)
 {
     inc_8(emu, emu->cpu.d);
     emu->tick(1);
 }
 //! DEC D : Decreases D.
+template <u32 _Features>
 void x15_dec_d(Emulator* emu)
 {
     dec_8(emu, emu->cpu.d);
     emu->tick(1);
 }
 //! LD D, d8 : Loads 8-bit immediate data to D.
+template <u32 _Features>
 void x16_ld_d_d8(Emulator* emu)
 {
-    emu->cpu.d = read_d8(emu);
+    emu->cpu.d = read_d8<_Features>(emu);
     emu->tick(2);
 }
 //! RLA : Rotates A left through carry.
+template <u32 _Features>
 void x17_rla(Emulator* emu)
 {
     rl_8(emu, emu->cpu.a);
@@ -481,49 +397,57 @@ void x17_rla(Emulator* emu)
     emu->tick(1);
 }
 //! JR r8 : Jumps to PC + r8.
+template <u32 _Features>
 void x18_jr_r8(Emulator* emu)
 {
-    i8 offset = (i8)read_d8(emu);
+    i8 offset = (i8)read_d8<_Features>(emu);
     emu->cpu.pc += (i16)offset;
     emu->tick(3);
 }
 //! ADD HL, DE : Adds DE to HL.
+template <u32 _Features>
 void x19_add_hl_de(Emulator* emu)
 {
     emu->cpu.hl(add_16(emu, emu->cpu.hl(), emu->cpu.de()));
     emu->tick(2);
 }
 //! LD A (DE) : Loads value from memory pointed by DE to A.
+template <u32 _Features>
 void x1a_ld_a_mde(Emulator* emu)
 {
-    emu->cpu.a = emu->bus_read(emu->cpu.de());
+    emu->cpu.a = emu->bus_read<_Features>(emu->cpu.de());
     emu->tick(2);
 }
 //! DEC DE : Decreases DE.
+template <u32 _Features>
 void x1b_dec_de(Emulator* emu)
 {
     emu->cpu.de(emu->cpu.de() - 1);
     emu->tick(2);
 }
 //! INC E : Increases E.
+template <u32 _Features>
 void x1c_inc_e(Emulator* emu)
 {
     inc_8(emu, emu->cpu.e);
     emu->tick(1);
 }
 //! DEC E : Decreases E.
+template <u32 _Features>
 void x1d_dec_e(Emulator* emu)
 {
     dec_8(emu, emu->cpu.e);
     emu->tick(1);
 }
 //! LD E, d8 : Loads 8-bit immediate data to E.
+template <u32 _Features>
 void x1e_ld_e_d8(Emulator* emu)
 {
-    emu->cpu.e = read_d8(emu);
+    emu->cpu.e = read_d8<_Features>(emu);
     emu->tick(2);
 }
 //! RRA : Rotates A right through carry.
+template <u32 _Features>
 void x1f_rra(Emulator* emu)
 {
     rr_8(emu, emu->cpu.a);
@@ -531,9 +455,10 @@ void x1f_rra(Emulator* emu)
     emu->tick(1);
 }
 //! JR NZ, r8 : Jumps to PC + r8 if Z is 0.
+template <u32 _Features>
 void x20_jr_nz_r8(Emulator* emu)
 {
-    i8 offset = (i8)read_d8(emu);
+    i8 offset = (i8)read_d8<_Features>(emu);
     if(!emu->cpu.fz())
     {
         emu->cpu.pc += (i16)offset;
@@ -545,43 +470,50 @@ void x20_jr_nz_r8(Emulator* emu)
     }
 }
 //! LD HL, d16 : Loads 16-bit immediate data to HL.
+template <u32 _Features>
 void x21_ld_hl_d16(Emulator* emu)
 {
-    emu->cpu.hl(read_d16(emu));
+    emu->cpu.hl(read_d16<_Features>(emu));
     emu->tick(3);
 }
 //! LD (HL+), A : Stores A to the memory pointed by HL, then increases HL.
+template <u32 _Features>
 void x22_ldi_mhl_a(Emulator* emu)
 {
-    emu->bus_write(emu->cpu.hl(), emu->cpu.a);
+    emu->bus_write<_Features>(emu->cpu.hl(), emu->cpu.a);
     emu->cpu.hl(emu->cpu.hl() + 1);
     emu->tick(2);
 }
 //! INC HL : Increases HL.
+template <u32 _Features>
 void x23_inc_hl(Emulator* emu)
 {
     emu->cpu.hl(emu->cpu.hl() + 1);
     emu->tick(2);
 }
 //! INC H : Increases H.
+template <u32 _Features>
 void x24_inc_h(Emulator* emu)
 {
     inc_8(emu, emu->cpu.h);
     emu->tick(1);
 }
 //! DEC H : Decreases H.
+template <u32 _Features>
 void x25_dec_h(Emulator* emu)
 {
     dec_8(emu, emu->cpu.h);
     emu->tick(1);
 }
 //! LD H, d8 : Loads 8-bit immediate data to H.
+template <u32 _Features>
 void x26_ld_h_d8(Emulator* emu)
 {
-    emu->cpu.h = read_d8(emu);
+    emu->cpu.h = read_d8<_Features>(emu);
     emu->tick(2);
 }
 //! DAA : Decimal adjust for A.
+template <u32 _Features>
 void x27_daa(Emulator* emu)
 {
     if(emu->cpu.fn())
@@ -614,9 +546,10 @@ void x27_daa(Emulator* emu)
     emu->tick(1);
 }
 //! JR Z, r8 : Jumps to PC + r8 if Z is 1.
+template <u32 _Features>
 void x28_jr_z_r8(Emulator* emu)
 {
-    i8 offset = (i8)read_d8(emu);
+    i8 offset = (i8)read_d8<_Features>(emu);
     if(emu->cpu.fz())
     {
         emu->cpu.pc += (i16)offset;
@@ -628,43 +561,50 @@ void x28_jr_z_r8(Emulator* emu)
     }
 }
 //! ADD HL, HL : Adds HL to HL.
+template <u32 _Features>
 void x29_add_hl_hl(Emulator* emu)
 {
     emu->cpu.hl(add_16(emu, emu->cpu.hl(), emu->cpu.hl()));
     emu->tick(2);
 }
 //! LD A (HL+) : Loads value from memory pointed by HL to A, then increases HL.
+template <u32 _Features>
 void x2a_ldi_a_mhl(Emulator* emu)
 {
-    emu->cpu.a = emu->bus_read(emu->cpu.hl());
+    emu->cpu.a = emu->bus_read<_Features>(emu->cpu.hl());
     emu->cpu.hl(emu->cpu.hl() + 1);
     emu->tick(2);
 }
 //! DEC HL : Decreases HL.
+template <u32 _Features>
 void x2b_dec_hl(Emulator* emu)
 {
     emu->cpu.hl(emu->cpu.hl() - 1);
     emu->tick(2);
 }
 //! INC L : Increases L.
+template <u32 _Features>
 void x2c_inc_l(Emulator* emu)
 {
     inc_8(emu, emu->cpu.l);
     emu->tick(1);
 }
 //! DEC L : Decreases L.
+template <u32 _Features>
 void x2d_dec_l(Emulator* emu)
 {
     dec_8(emu, emu->cpu.l);
     emu->tick(1);
 }
 //! LD L, d8 : Loads 8-bit immediate data to L.
+template <u32 _Features>
 void x2e_ld_l_d8(Emulator* emu)
 {
-    emu->cpu.l = read_d8(emu);
+    emu->cpu.l = read_d8<_Features>(emu);
     emu->tick(2);
 }
 //! CPL : Takes complements of A (inverts every bit of A).
+template <u32 _Features>
 void x2f_cpl(Emulator* emu)
 {
     emu->cpu.a = emu->cpu.a ^ 0xFF;
@@ -673,9 +613,10 @@ void x2f_cpl(Emulator* emu)
     emu->tick(1);
 }
 //! JR NC, r8 : Jumps to PC + r8 if C is 0.
+template <u32 _Features>
 void x30_jr_nc_r8(Emulator* emu)
 {
-    i8 offset = (i8)read_d8(emu);
+    i8 offset = (i8)read_d8<_Features>(emu);
     if(!emu->cpu.fc())
     {
         emu->cpu.pc += (i16)offset;
@@ -687,51 +628,58 @@ void x30_jr_nc_r8(Emulator* emu)
     }
 }
 //! LD SP, d16 : Loads 16-bit immediate data to SP.
+template <u32 _Features>
 void x31_ld_sp_d16(Emulator* emu)
 {
-    emu->cpu.sp = read_d16(emu);
+    emu->cpu.sp = read_d16<_Features>(emu);
     emu->tick(3);
 }
 //! LD (HL-) A : Stores A to the memory pointed by HL, then decreases HL.
+template <u32 _Features>
 void x32_ldd_mhl_a(Emulator* emu)
 {
-    emu->bus_write(emu->cpu.hl(), emu->cpu.a);
+    emu->bus_write<_Features>(emu->cpu.hl(), emu->cpu.a);
     emu->cpu.hl(emu->cpu.hl() - 1);
     emu->tick(2);
 }
 //! INC SP : Increases SP.
+template <u32 _Features>
 void x33_inc_sp(Emulator* emu)
 {
     ++emu->cpu.sp;
     emu->tick(2);
 }
 //! INC (HL) : Increases data in memory pointed by HL.
+template <u32 _Features>
 void x34_inc_mhl(Emulator* emu)
 {
-    u8 data = emu->bus_read(emu->cpu.hl());
+    u8 data = emu->bus_read<_Features>(emu->cpu.hl());
     emu->tick(1);
     inc_8(emu, data);
-    emu->bus_write(emu->cpu.hl(), data);
+    emu->bus_write<_Features>(emu->cpu.hl(), data);
     emu->tick(2);
 }
 //! DEC (HL) : Decreases data in memory pointed by HL.
+template <u32 _Features>
 void x35_dec_mhl(Emulator* emu)
 {
-    u8 data = emu->bus_read(emu->cpu.hl());
+    u8 data = emu->bus_read<_Features>(emu->cpu.hl());
     emu->tick(1);
     dec_8(emu, data);
-    emu->bus_write(emu->cpu.hl(), data);
+    emu->bus_write<_Features>(emu->cpu.hl(), data);
     emu->tick(2);
 }
 //! LD (HL), d8 : Stores 8-bit immediate data to memory pointed by HL.
+template <u32 _Features>
 void x36_ld_mhl_d8(Emulator* emu)
 {
-    u8 data = read_d8(emu);
+    u8 data = read_d8<_Features>(emu);
     emu->tick(1);
-    emu->bus_write(emu->cpu.hl(), data);
+    emu->bus_write<_Features>(emu->cpu.hl(), data);
     emu->tick(2);
 }
 //! SCF : Sets C to 1.
+template <u32 _Features>
 void x37_scf(Emulator* emu)
 {
     emu->cpu.reset_fn();
@@ -740,9 +688,10 @@ void x37_scf(Emulator* emu)
     emu->tick(1);
 }
 //! JR C, r8 : Jumps to PC + r8 if C is 1.
+template <u32 _Features>
 void x38_jr_c_r8(Emulator* emu)
 {
-    i8 offset = (i8)read_d8(emu);
+    i8 offset = (i8)read_d8<_Features>(emu);
     if(emu->cpu.fc())
     {
         emu->cpu.pc += (i16)offset;
@@ -754,845 +703,976 @@ void x38_jr_c_r8(Emulator* emu)
     }
 }
 //! ADD HL, SP : Adds SP to HL.
+template <u32 _Features>
 void x39_add_hl_sp(Emulator* emu)
 {
     emu->cpu.hl(add_16(emu, emu->cpu.hl(), emu->cpu.sp));
     emu->tick(2);
 }
 //! LD A (HL-) : Loads value from memory pointed by HL to A, then decreases HL.
+template <u32 _Features>
 void x3a_ldd_a_mhl(Emulator* emu)
 {
-    emu->cpu.a = emu->bus_read(emu->cpu.hl());
+    emu->cpu.a = emu->bus_read<_Features>(emu->cpu.hl());
     emu->cpu.hl(emu->cpu.hl() - 1);
     emu->tick(2);
 }
 //! DEC SP : Decreases SP.
+template <u32 _Features>
 void x3b_dec_sp(Emulator* emu)
 {
     --emu->cpu.sp;
     emu->tick(2);
 }
 //! INC A : Increases A.
+template <u32 _Features>
 void x3c_inc_a(Emulator* emu)
 {
     inc_8(emu, emu->cpu.a);
     emu->tick(1);
 }
 //! DEC A : Decreases A.
+template <u32 _Features>
 void x3d_dec_a(Emulator* emu)
 {
     dec_8(emu, emu->cpu.a);
     emu->tick(1);
 }
 //! LD A, d8 : Loads 8-bit immediate data to A.
+template <u32 _Features>
 void x3e_ld_a_d8(Emulator* emu)
 {
-    emu->cpu.a = read_d8(emu);
+    emu->cpu.a = read_d8<_Features>(emu);
     emu->tick(2);
 }
 //! CCF : Flips C.
+template <u32 _Features>
 void x3f_ccf(Emulator* emu)
 {
     emu->cpu.reset_fn();
     emu->cpu.reset_fh();
-    if(emu->cpu.fc())
-    {
-        emu->cpu.reset_fc();
-    }
-    else
-    {
-        emu->cpu.set_fc();
-    }
+    emu->cpu.flag_c = !emu->cpu.flag_c;
     emu->tick(1);
 }
 //! LD B, B : Loads B to B.
+template <u32 _Features>
 void x40_ld_b_b(Emulator* emu)
 {
     emu->cpu.b = emu->cpu.b;
+    // Test ROMs (like mooneye-gb) use this instruction as software breakpoint.
+    emu->software_breakpoint = true;
     emu->tick(1);
 }
 //! LD B, C : Loads C to B.
+template <u32 _Features>
 void x41_ld_b_c(Emulator* emu)
 {
     emu->cpu.b = emu->cpu.c;
     emu->tick(1);
 }
 //! LD B, D : Loads D to B.
+template <u32 _Features>
 void x42_ld_b_d(Emulator* emu)
 {
     emu->cpu.b = emu->cpu.d;
     emu->tick(1);
 }
 //! LD B, E : Loads E to B.
+template <u32 _Features>
 void x43_ld_b_e(Emulator* emu)
 {
     emu->cpu.b = emu->cpu.e;
     emu->tick(1);
 }
 //! LD B, H : Loads H to B.
+template <u32 _Features>
 void x44_ld_b_h(Emulator* emu)
 {
     emu->cpu.b = emu->cpu.h;
     emu->tick(1);
 }
 //! LD B, L : Loads L to B.
+template <u32 _Features>
 void x45_ld_b_l(Emulator* emu)
 {
     emu->cpu.b = emu->cpu.l;
     emu->tick(1);
 }
 //! LD B, (HL) : Loads 8-bit data pointed by HL to B.
+template <u32 _Features>
 void x46_ld_b_mhl(Emulator* emu)
 {
-    emu->cpu.b = emu->bus_read(emu->cpu.hl());
+    emu->cpu.b = emu->bus_read<_Features>(emu->cpu.hl());
     emu->tick(2);
 }
 //! LD B, A : Loads A to B.
+template <u32 _Features>
 void x47_ld_b_a(Emulator* emu)
 {
     emu->cpu.b = emu->cpu.a;
     emu->tick(1);
 }
 //! LD C, B : Loads B to C.
+template <u32 _Features>
 void x48_ld_c_b(Emulator* emu)
 {
     emu->cpu.c = emu->cpu.b;
     emu->tick(1);
 }
 //! LD C, C : Loads C to C.
+template <u32 _Features>
 void x49_ld_c_c(Emulator* emu)
 {
     emu->cpu.c = emu->cpu.c;
     emu->tick(1);
 }
 //! LD C, D : Loads D to C.
+template <u32 _Features>
 void x4a_ld_c_d(Emulator* emu)
 {
     emu->cpu.c = emu->cpu.d;
     emu->tick(1);
 }
 //! LD C, E : Loads E to C.
+template <u32 _Features>
 void x4b_ld_c_e(Emulator* emu)
 {
     emu->cpu.c = emu->cpu.e;
     emu->tick(1);
 }
 //! LD C, H : Loads H to C.
+template <u32 _Features>
 void x4c_ld_c_h(Emulator* emu)
 {
     emu->cpu.c = emu->cpu.h;
     emu->tick(1);
 }
 //! LD C, L : Loads L to C.
+template <u32 _Features>
 void x4d_ld_c_l(Emulator* emu)
 {
     emu->cpu.c = emu->cpu.l;
     emu->tick(1);
 }
 //! LD C, (HL) : Loads 8-bit data pointed by HL to C.
+template <u32 _Features>
 void x4e_ld_c_mhl(Emulator* emu)
 {
-    emu->cpu.c = emu->bus_read(emu->cpu.hl());
+    emu->cpu.c = emu->bus_read<_Features>(emu->cpu.hl());
     emu->tick(2);
 }
 //! LD C, A : Loads A to C.
+template <u32 _Features>
 void x4f_ld_c_a(Emulator* emu)
 {
     emu->cpu.c = emu->cpu.a;
     emu->tick(1);
 }
 //! LD D, B : Loads B to D.
+template <u32 _Features>
 void x50_ld_d_b(Emulator* emu)
 {
     emu->cpu.d = emu->cpu.b;
     emu->tick(1);
 }
 //! LD D, C : Loads C to D.
+template <u32 _Features>
 void x51_ld_d_c(Emulator* emu)
 {
     emu->cpu.d = emu->cpu.c;
     emu->tick(1);
 }
 //! LD D, D : Loads D to D.
+template <u32 _Features>
 void x52_ld_d_d(Emulator* emu)
 {
     emu->cpu.d = emu->cpu.d;
     emu->tick(1);
 }
 //! LD D, E : Loads E to D.
+template <u32 _Features>
 void x53_ld_d_e(Emulator* emu)
 {
     emu->cpu.d = emu->cpu.e;
     emu->tick(1);
 }
 //! LD D, H : Loads H to D.
+template <u32 _Features>
 void x54_ld_d_h(Emulator* emu)
 {
     emu->cpu.d = emu->cpu.h;
     emu->tick(1);
 }
 //! LD D, L : Loads L to D.
+template <u32 _Features>
 void x55_ld_d_l(Emulator* emu)
 {
     emu->cpu.d = emu->cpu.l;
     emu->tick(1);
 }
 //! LD D, (HL) : Loads 8-bit data pointed by HL to D.
+template <u32 _Features>
 void x56_ld_d_mhl(Emulator* emu)
 {
-    emu->cpu.d = emu->bus_read(emu->cpu.hl());
+    emu->cpu.d = emu->bus_read<_Features>(emu->cpu.hl());
     emu->tick(2);
 }
 //! LD D, A : Loads A to D.
+template <u32 _Features>
 void x57_ld_d_a(Emulator* emu)
 {
     emu->cpu.d = emu->cpu.a;
     emu->tick(1);
 }
 //! LD E, B : Loads B to E.
+template <u32 _Features>
 void x58_ld_e_b(Emulator* emu)
 {
     emu->cpu.e = emu->cpu.b;
     emu->tick(1);
 }
 //! LD E, C : Loads C to E.
+template <u32 _Features>
 void x59_ld_e_c(Emulator* emu)
 {
     emu->cpu.e = emu->cpu.c;
     emu->tick(1);
 }
 //! LD E, D : Loads D to E.
+template <u32 _Features>
 void x5a_ld_e_d(Emulator* emu)
 {
     emu->cpu.e = emu->cpu.d;
     emu->tick(1);
 }
 //! LD E, E : Loads E to E.
+template <u32 _Features>
 void x5b_ld_e_e(Emulator* emu)
 {
     emu->cpu.e = emu->cpu.e;
     emu->tick(1);
 }
 //! LD E, H : Loads H to E.
+template <u32 _Features>
 void x5c_ld_e_h(Emulator* emu)
 {
     emu->cpu.e = emu->cpu.h;
     emu->tick(1);
 }
 //! LD E, L : Loads L to E.
+template <u32 _Features>
 void x5d_ld_e_l(Emulator* emu)
 {
     emu->cpu.e = emu->cpu.l;
     emu->tick(1);
 }
 //! LD E, (HL) : Loads 8-bit data pointed by HL to E.
+template <u32 _Features>
 void x5e_ld_e_mhl(Emulator* emu)
 {
-    emu->cpu.e = emu->bus_read(emu->cpu.hl());
+    emu->cpu.e = emu->bus_read<_Features>(emu->cpu.hl());
     emu->tick(2);
 }
 //! LD E, A : Loads A to E.
+template <u32 _Features>
 void x5f_ld_e_a(Emulator* emu)
 {
     emu->cpu.e = emu->cpu.a;
     emu->tick(1);
 }
 //! LD H, B : Loads B to H.
+template <u32 _Features>
 void x60_ld_h_b(Emulator* emu)
 {
     emu->cpu.h = emu->cpu.b;
     emu->tick(1);
 }
 //! LD H, C : Loads C to H.
+template <u32 _Features>
 void x61_ld_h_c(Emulator* emu)
 {
     emu->cpu.h = emu->cpu.c;
     emu->tick(1);
 }
 //! LD H, D : Loads D to H.
+template <u32 _Features>
 void x62_ld_h_d(Emulator* emu)
 {
     emu->cpu.h = emu->cpu.d;
     emu->tick(1);
 }
 //! LD H, E : Loads E to H.
+template <u32 _Features>
 void x63_ld_h_e(Emulator* emu)
 {
     emu->cpu.h = emu->cpu.e;
     emu->tick(1);
 }
 //! LD H, H : Loads H to H.
+template <u32 _Features>
 void x64_ld_h_h(Emulator* emu)
 {
     emu->cpu.h = emu->cpu.h;
     emu->tick(1);
 }
 //! LD H, L : Loads L to H.
+template <u32 _Features>
 void x65_ld_h_l(Emulator* emu)
 {
     emu->cpu.h = emu->cpu.l;
     emu->tick(1);
 }
 //! LD H, (HL) : Loads 8-bit data pointed by HL to H.
+template <u32 _Features>
 void x66_ld_h_mhl(Emulator* emu)
 {
-    emu->cpu.h = emu->bus_read(emu->cpu.hl());
+    emu->cpu.h = emu->bus_read<_Features>(emu->cpu.hl());
     emu->tick(2);
 }
 //! LD H, A : Loads A to H.
+template <u32 _Features>
 void x67_ld_h_a(Emulator* emu)
 {
     emu->cpu.h = emu->cpu.a;
     emu->tick(1);
 }
 //! LD L, B : Loads B to L.
+template <u32 _Features>
 void x68_ld_l_b(Emulator* emu)
 {
     emu->cpu.l = emu->cpu.b;
     emu->tick(1);
 }
 //! LD L, C : Loads C to L.
+template <u32 _Features>
 void x69_ld_l_c(Emulator* emu)
 {
     emu->cpu.l = emu->cpu.c;
     emu->tick(1);
 }
 //! LD L, D : Loads D to L.
+template <u32 _Features>
 void x6a_ld_l_d(Emulator* emu)
 {
     emu->cpu.l = emu->cpu.d;
     emu->tick(1);
 }
 //! LD L, E : Loads E to L.
+template <u32 _Features>
 void x6b_ld_l_e(Emulator* emu)
 {
     emu->cpu.l = emu->cpu.e;
     emu->tick(1);
 }
 //! LD L, H : Loads H to L.
+template <u32 _Features>
 void x6c_ld_l_h(Emulator* emu)
 {
     emu->cpu.l = emu->cpu.h;
     emu->tick(1);
 }
 //! LD L, L : Loads L to L.
+template <u32 _Features>
 void x6d_ld_l_l(Emulator* emu)
 {
     emu->cpu.l = emu->cpu.l;
     emu->tick(1);
 }
 //! LD L, (HL) : Loads 8-bit data pointed by HL to L.
+template <u32 _Features>
 void x6e_ld_l_mhl(Emulator* emu)
 {
-    emu->cpu.l = emu->bus_read(emu->cpu.hl());
+    emu->cpu.l = emu->bus_read<_Features>(emu->cpu.hl());
     emu->tick(2);
 }
 //! LD L, A : Loads A to L.
+template <u32 _Features>
 void x6f_ld_l_a(Emulator* emu)
 {
     emu->cpu.l = emu->cpu.a;
     emu->tick(1);
 }
 //! LD (HL), B : Stores B to the memory pointed by HL.
+template <u32 _Features>
 void x70_ld_mhl_b(Emulator* emu)
 {
-    emu->bus_write(emu->cpu.hl(), emu->cpu.b);
+    emu->bus_write<_Features>(emu->cpu.hl(), emu->cpu.b);
     emu->tick(2);
 }
 //! LD (HL), C : Stores C to the memory pointed by HL.
+template <u32 _Features>
 void x71_ld_mhl_c(Emulator* emu)
 {
-    emu->bus_write(emu->cpu.hl(), emu->cpu.c);
+    emu->bus_write<_Features>(emu->cpu.hl(), emu->cpu.c);
     emu->tick(2);
 }
 //! LD (HL), D : Stores D to the memory pointed by HL.
+template <u32 _Features>
 void x72_ld_mhl_d(Emulator* emu)
 {
-    emu->bus_write(emu->cpu.hl(), emu->cpu.d);
+    emu->bus_write<_Features>(emu->cpu.hl(), emu->cpu.d);
     emu->tick(2);
 }
 //! LD (HL), E : Stores E to the memory pointed by HL.
+template <u32 _Features>
 void x73_ld_mhl_e(Emulator* emu)
 {
-    emu->bus_write(emu->cpu.hl(), emu->cpu.e);
+    emu->bus_write<_Features>(emu->cpu.hl(), emu->cpu.e);
     emu->tick(2);
 }
 //! LD (HL), H : Stores H to the memory pointed by HL.
+template <u32 _Features>
 void x74_ld_mhl_h(Emulator* emu)
 {
-    emu->bus_write(emu->cpu.hl(), emu->cpu.h);
+    emu->bus_write<_Features>(emu->cpu.hl(), emu->cpu.h);
     emu->tick(2);
 }
 //! LD (HL), L : Stores L to the memory pointed by HL.
+template <u32 _Features>
 void x75_ld_mhl_l(Emulator* emu)
 {
-    emu->bus_write(emu->cpu.hl(), emu->cpu.l);
+    emu->bus_write<_Features>(emu->cpu.hl(), emu->cpu.l);
     emu->tick(2);
 }
 //! HALT : Pauses the CPU.
+template <u32 _Features>
 void x76_halt(Emulator* emu)
 {
     emu->cpu.halted = true;
     emu->tick(1);
 }
 //! LD (HL), A : Stores A to the memory pointed by HL.
+template <u32 _Features>
 void x77_ld_mhl_a(Emulator* emu)
 {
-    emu->bus_write(emu->cpu.hl(), emu->cpu.a);
+    emu->bus_write<_Features>(emu->cpu.hl(), emu->cpu.a);
     emu->tick(2);
 }
 //! LD A, B : Loads B to A.
+template <u32 _Features>
 void x78_ld_a_b(Emulator* emu)
 {
     emu->cpu.a = emu->cpu.b;
     emu->tick(1);
 }
 //! LD A, C : Loads C to A.
+template <u32 _Features>
 void x79_ld_a_c(Emulator* emu)
 {
     emu->cpu.a = emu->cpu.c;
     emu->tick(1);
 }
 //! LD A, D : Loads D to A.
+template <u32 _Features>
 void x7a_ld_a_d(Emulator* emu)
 {
     emu->cpu.a = emu->cpu.d;
     emu->tick(1);
 }
 //! LD A, E : Loads E to A.
+template <u32 _Features>
 void x7b_ld_a_e(Emulator* emu)
 {
     emu->cpu.a = emu->cpu.e;
     emu->tick(1);
 }
 //! LD A, H : Loads H to A.
+template <u32 _Features>
 void x7c_ld_a_h(Emulator* emu)
 {
     emu->cpu.a = emu->cpu.h;
     emu->tick(1);
 }
 //! LD A, L : Loads L to A.
+template <u32 _Features>
 void x7d_ld_a_l(Emulator* emu)
 {
     emu->cpu.a = emu->cpu.l;
     emu->tick(1);
 }
 //! LD A, (HL) : Loads 8-bit data pointed by HL to A.
+template <u32 _Features>
 void x7e_ld_a_mhl(Emulator* emu)
 {
-    emu->cpu.a = emu->bus_read(emu->cpu.hl());
+    emu->cpu.a = emu->bus_read<_Features>(emu->cpu.hl());
     emu->tick(2);
 }
 //! LD A, A : Loads A to A.
+template <u32 _Features>
 void x7f_ld_a_a(Emulator* emu)
 {
     emu->cpu.a = emu->cpu.a;
     emu->tick(1);
 }
 //! ADD A, B : Adds B to A.
+template <u32 _Features>
 void x80_add_a_b(Emulator* emu)
 {
     emu->cpu.a = add_8(emu, emu->cpu.a, emu->cpu.b);
     emu->tick(1);
 }
 //! ADD A, C : Adds C to A.
+template <u32 _Features>
 void x81_add_a_c(Emulator* emu)
 {
     emu->cpu.a = add_8(emu, emu->cpu.a, emu->cpu.c);
     emu->tick(1);
 }
 //! ADD A, D : Adds D to A.
+template <u32 _Features>
 void x82_add_a_d(Emulator* emu)
 {
     emu->cpu.a = add_8(emu, emu->cpu.a, emu->cpu.d);
     emu->tick(1);
 }
 //! ADD A, E : Adds E to A.
+template <u32 _Features>
 void x83_add_a_e(Emulator* emu)
 {
     emu->cpu.a = add_8(emu, emu->cpu.a, emu->cpu.e);
     emu->tick(1);
 }
 //! ADD A, H : Adds H to A.
+template <u32 _Features>
 void x84_add_a_h(Emulator* emu)
 {
     emu->cpu.a = add_8(emu, emu->cpu.a, emu->cpu.h);
     emu->tick(1);
 }
 //! ADD A, L : Adds L to A.
+template <u32 _Features>
 void x85_add_a_l(Emulator* emu)
 {
     emu->cpu.a = add_8(emu, emu->cpu.a, emu->cpu.l);
     emu->tick(1);
 }
 //! ADD A, (HL) : Adds data pointed by HL to A.
+template <u32 _Features>
 void x86_add_a_mhl(Emulator* emu)
 {
-    u8 data = emu->bus_read(emu->cpu.hl());
+    u8 data = emu->bus_read<_Features>(emu->cpu.hl());
     emu->tick(1);
     emu->cpu.a = add_8(emu, emu->cpu.a, data);
     emu->tick(1);
 }
 //! ADD A, A : Adds A to A.
+template <u32 _Features>
 void x87_add_a_a(Emulator* emu)
 {
     emu->cpu.a = add_8(emu, emu->cpu.a, emu->cpu.a);
     emu->tick(1);
 }
 //! ADC A, B : Adds B to A with carry.
+template <u32 _Features>
 void x88_adc_a_b(Emulator* emu)
 {
     emu->cpu.a = adc_8(emu, emu->cpu.a, emu->cpu.b);
     emu->tick(1);
 }
 //! ADC A, C : Adds C to A with carry.
+template <u32 _Features>
 void x89_adc_a_c(Emulator* emu)
 {
     emu->cpu.a = adc_8(emu, emu->cpu.a, emu->cpu.c);
     emu->tick(1);
 }
 //! ADC A, D : Adds D to A with carry.
+template <u32 _Features>
 void x8a_adc_a_d(Emulator* emu)
 {
     emu->cpu.a = adc_8(emu, emu->cpu.a, emu->cpu.d);
     emu->tick(1);
 }
 //! ADC A, E : Adds E to A with carry.
+template <u32 _Features>
 void x8b_adc_a_e(Emulator* emu)
 {
     emu->cpu.a = adc_8(emu, emu->cpu.a, emu->cpu.e);
     emu->tick(1);
 }
 //! ADC A, H : Adds H to A with carry.
+template <u32 _Features>
 void x8c_adc_a_h(Emulator* emu)
 {
     emu->cpu.a = adc_8(emu, emu->cpu.a, emu->cpu.h);
     emu->tick(1);
 }
 //! ADC A, L : Adds L to A with carry.
+template <u32 _Features>
 void x8d_adc_a_l(Emulator* emu)
 {
     emu->cpu.a = adc_8(emu, emu->cpu.a, emu->cpu.l);
     emu->tick(1);
 }
 //! ADC A, (HL) : Adds data pointed by HL to A with carry.
+template <u32 _Features>
 void x8e_adc_a_mhl(Emulator* emu)
 {
-    u8 data = emu->bus_read(emu->cpu.hl());
+    u8 data = emu->bus_read<_Features>(emu->cpu.hl());
     emu->tick(1);
     emu->cpu.a = adc_8(emu, emu->cpu.a, data);
     emu->tick(1);
 }
 //! ADC A, A : Adds A to A with carry.
+template <u32 _Features>
 void x8f_adc_a_a(Emulator* emu)
 {
     emu->cpu.a = adc_8(emu, emu->cpu.a, emu->cpu.a);
     emu->tick(1);
 }
 //! SUB B : Subtracts B from A.
+template <u32 _Features>
 void x90_sub_b(Emulator* emu)
 {
     emu->cpu.a = sub_8(emu, emu->cpu.a, emu->cpu.b);
     emu->tick(1);
 }
 //! SUB C : Subtracts C from A.
+template <u32 _Features>
 void x91_sub_c(Emulator* emu)
 {
     emu->cpu.a = sub_8(emu, emu->cpu.a, emu->cpu.c);
     emu->tick(1);
 }
 //! SUB D : Subtracts D from A.
+template <u32 _Features>
 void x92_sub_d(Emulator* emu)
 {
     emu->cpu.a = sub_8(emu, emu->cpu.a, emu->cpu.d);
     emu->tick(1);
 }
 //! SUB E : Subtracts E from A.
+template <u32 _Features>
 void x93_sub_e(Emulator* emu)
 {
     emu->cpu.a = sub_8(emu, emu->cpu.a, emu->cpu.e);
     emu->tick(1);
 }
 //! SUB H : Subtracts H from A.
+template <u32 _Features>
 void x94_sub_h(Emulator* emu)
 {
     emu->cpu.a = sub_8(emu, emu->cpu.a, emu->cpu.h);
     emu->tick(1);
 }
 //! SUB L : Subtracts L from A.
+template <u32 _Features>
 void x95_sub_l(Emulator* emu)
 {
     emu->cpu.a = sub_8(emu, emu->cpu.a, emu->cpu.l);
     emu->tick(1);
 }
 //! SUB (HL) : Subtracts data pointed by HL from A.
+template <u32 _Features>
 void x96_sub_mhl(Emulator* emu)
 {
-    u8 data = emu->bus_read(emu->cpu.hl());
+    u8 data = emu->bus_read<_Features>(emu->cpu.hl());
     emu->tick(1);
     emu->cpu.a = sub_8(emu, emu->cpu.a, data);
     emu->tick(1);
 }
 //! SUB A : Subtracts A from A.
+template <u32 _Features>
 void x97_sub_a(Emulator* emu)
 {
     emu->cpu.a = sub_8(emu, emu->cpu.a, emu->cpu.a);
     emu->tick(1);
 }
 //! SBC A, B : Subtracts B from A with carry.
+template <u32 _Features>
 void x98_sbc_a_b(Emulator* emu)
 {
     emu->cpu.a = sbc_8(emu, emu->cpu.a, emu->cpu.b);
     emu->tick(1);
 }
 //! SBC A, C : Subtracts C from A with carry.
+template <u32 _Features>
 void x99_sbc_a_c(Emulator* emu)
 {
     emu->cpu.a = sbc_8(emu, emu->cpu.a, emu->cpu.c);
     emu->tick(1);
 }
 //! SBC A, D : Subtracts D from A with carry.
+template <u32 _Features>
 void x9a_sbc_a_d(Emulator* emu)
 {
     emu->cpu.a = sbc_8(emu, emu->cpu.a, emu->cpu.d);
     emu->tick(1);
 }
 //! SBC A, E : Subtracts E from A with carry.
+template <u32 _Features>
 void x9b_sbc_a_e(Emulator* emu)
 {
     emu->cpu.a = sbc_8(emu, emu->cpu.a, emu->cpu.e);
     emu->tick(1);
 }
 //! SBC A, H : Subtracts H from A with carry.
+template <u32 _Features>
 void x9c_sbc_a_h(Emulator* emu)
 {
     emu->cpu.a = sbc_8(emu, emu->cpu.a, emu->cpu.h);
     emu->tick(1);
 }
 //! SBC A, L : Subtracts L from A with carry.
+template <u32 _Features>
 void x9d_sbc_a_l(Emulator* emu)
 {
     emu->cpu.a = sbc_8(emu, emu->cpu.a, emu->cpu.l);
     emu->tick(1);
 }
 //! SBC A, (HL) : Subtracts data pointed by HL from A with carry.
+template <u32 _Features>
 void x9e_sbc_a_mhl(Emulator* emu)
 {
-    u8 data = emu->bus_read(emu->cpu.hl());
+    u8 data = emu->bus_read<_Features>(emu->cpu.hl());
     emu->tick(1);
     emu->cpu.a = sbc_8(emu, emu->cpu.a, data);
     emu->tick(1);
 }
 //! SBC A, A : Subtracts A from A with carry.
+template <u32 _Features>
 void x9f_sbc_a_a(Emulator* emu)
 {
     emu->cpu.a = sbc_8(emu, emu->cpu.a, emu->cpu.a);
     emu->tick(1);
 }
 //! AND B : Performs bitwise AND on A and B.
+template <u32 _Features>
 void xa0_and_b(Emulator* emu)
 {
     emu->cpu.a = and_8(emu, emu->cpu.a, emu->cpu.b);
     emu->tick(1);
 }
 //! AND C : Performs bitwise AND on A and C.
+template <u32 _Features>
 void xa1_and_c(Emulator* emu)
 {
     emu->cpu.a = and_8(emu, emu->cpu.a, emu->cpu.c);
     emu->tick(1);
 }
 //! AND D : Performs bitwise AND on A and D.
+template <u32 _Features>
 void xa2_and_d(Emulator* emu)
 {
     emu->cpu.a = and_8(emu, emu->cpu.a, emu->cpu.d);
     emu->tick(1);
 }
 //! AND E : Performs bitwise AND on A and E.
+template <u32 _Features>
 void xa3_and_e(Emulator* emu)
 {
     emu->cpu.a = and_8(emu, emu->cpu.a, emu->cpu.e);
     emu->tick(1);
 }
 //! AND H : Performs bitwise AND on A and H.
+template <u32 _Features>
 void xa4_and_h(Emulator* emu)
 {
     emu->cpu.a = and_8(emu, emu->cpu.a, emu->cpu.h);
     emu->tick(1);
 }
 //! AND L : Performs bitwise AND on A and L.
+template <u32 _Features>
 void xa5_and_l(Emulator* emu)
 {
     emu->cpu.a = and_8(emu, emu->cpu.a, emu->cpu.l);
     emu->tick(1);
 }
 //! AND (HL) : Performs bitwise AND on A and data pointed by HL.
+template <u32 _Features>
 void xa6_and_mhl(Emulator* emu)
 {
-    u8 data = emu->bus_read(emu->cpu.hl());
+    u8 data = emu->bus_read<_Features>(emu->cpu.hl());
     emu->tick(1);
     emu->cpu.a = and_8(emu, emu->cpu.a, data);
     emu->tick(1);
 }
 //! AND A : Performs bitwise AND on A and A.
+template <u32 _Features>
 void xa7_and_a(Emulator* emu)
 {
     emu->cpu.a = and_8(emu, emu->cpu.a, emu->cpu.a);
     emu->tick(1);
 }
 //! XOR B : Performs bitwise XOR on A and B.
+template <u32 _Features>
 void xa8_xor_b(Emulator* emu)
 {
     emu->cpu.a = xor_8(emu, emu->cpu.a, emu->cpu.b);
     emu->tick(1);
 }
 //! XOR C : Performs bitwise XOR on A and C.
+template <u32 _Features>
 void xa9_xor_c(Emulator* emu)
 {
     emu->cpu.a = xor_8(emu, emu->cpu.a, emu->cpu.c);
     emu->tick(1);
 }
 //! XOR D : Performs bitwise XOR on A and D.
+template <u32 _Features>
 void xaa_xor_d(Emulator* emu)
 {
     emu->cpu.a = xor_8(emu, emu->cpu.a, emu->cpu.d);
     emu->tick(1);
 }
 //! XOR E : Performs bitwise XOR on A and E.
+template <u32 _Features>
 void xab_xor_e(Emulator* emu)
 {
     emu->cpu.a = xor_8(emu, emu->cpu.a, emu->cpu.e);
     emu->tick(1);
 }
 //! XOR H : Performs bitwise XOR on A and H.
+template <u32 _Features>
 void xac_xor_h(Emulator* emu)
 {
     emu->cpu.a = xor_8(emu, emu->cpu.a, emu->cpu.h);
     emu->tick(1);
 }
 //! XOR L : Performs bitwise XOR on A and L.
+template <u32 _Features>
 void xad_xor_l(Emulator* emu)
 {
     emu->cpu.a = xor_8(emu, emu->cpu.a, emu->cpu.l);
     emu->tick(1);
 }
 //! XOR (HL) : Performs bitwise XOR on A and data pointed by HL.
+template <u32 _Features>
 void xae_xor_mhl(Emulator* emu)
 {
-    u8 data = emu->bus_read(emu->cpu.hl());
+    u8 data = emu->bus_read<_Features>(emu->cpu.hl());
     emu->tick(1);
     emu->cpu.a = xor_8(emu, emu->cpu.a, data);
     emu->tick(1);
 }
 //! XOR A : Performs bitwise XOR on A and A.
+template <u32 _Features>
 void xaf_xor_a(Emulator* emu)
 {
     emu->cpu.a = xor_8(emu, emu->cpu.a, emu->cpu.a);
     emu->tick(1);
 }
 //! OR B : Performs bitwise OR on A and B.
+template <u32 _Features>
 void xb0_or_b(Emulator* emu)
 {
     emu->cpu.a = or_8(emu, emu->cpu.a, emu->cpu.b);
     emu->tick(1);
 }
 //! OR C : Performs bitwise OR on A and C.
+template <u32 _Features>
 void xb1_or_c(Emulator* emu)
 {
     emu->cpu.a = or_8(emu, emu->cpu.a, emu->cpu.c);
     emu->tick(1);
 }
 //! OR D : Performs bitwise OR on A and D.
+template <u32 _Features>
 void xb2_or_d(Emulator* emu)
 {
     emu->cpu.a = or_8(emu, emu->cpu.a, emu->cpu.d);
     emu->tick(1);
 }
 //! OR E : Performs bitwise OR on A and E.
+template <u32 _Features>
 void xb3_or_e(Emulator* emu)
 {
     emu->cpu.a = or_8(emu, emu->cpu.a, emu->cpu.e);
     emu->tick(1);
 }
 //! OR H : Performs bitwise OR on A and H.
+template <u32 _Features>
 void xb4_or_h(Emulator* emu)
 {
     emu->cpu.a = or_8(emu, emu->cpu.a, emu->cpu.h);
     emu->tick(1);
 }
 //! OR L : Performs bitwise OR on A and L.
+template <u32 _Features>
 void xb5_or_l(Emulator* emu)
 {
     emu->cpu.a = or_8(emu, emu->cpu.a, emu->cpu.l);
     emu->tick(1);
 }
 //! OR (HL) : Performs bitwise OR on A and data pointed by HL.
+template <u32 _Features>
 void xb6_or_mhl(Emulator* emu)
 {
-    u8 data = emu->bus_read(emu->cpu.hl());
+    u8 data = emu->bus_read<_Features>(emu->cpu.hl());
     emu->tick(1);
     emu->cpu.a = or_8(emu, emu->cpu.a, data);
     emu->tick(1);
 }
 //! OR A : Performs bitwise OR on A and A.
+template <u32 _Features>
 void xb7_or_a(Emulator* emu)
 {
     emu->cpu.a = or_8(emu, emu->cpu.a, emu->cpu.a);
     emu->tick(1);
 }
 //! CP B : Compares B with A.
+template <u32 _Features>
 void xb8_cp_b(Emulator* emu)
 {
     cp_8(emu, emu->cpu.a, emu->cpu.b);
     emu->tick(1);
 }
 //! CP C : Compares C with A.
+template <u32 _Features>
 void xb9_cp_c(Emulator* emu)
 {
     cp_8(emu, emu->cpu.a, emu->cpu.c);
     emu->tick(1);
 }
 //! CP D : Compares D with A.
+template <u32 _Features>
 void xba_cp_d(Emulator* emu)
 {
     cp_8(emu, emu->cpu.a, emu->cpu.d);
     emu->tick(1);
 }
 //! CP E : Compares E with A.
+template <u32 _Features>
 void xbb_cp_e(Emulator* emu)
 {
     cp_8(emu, emu->cpu.a, emu->cpu.e);
     emu->tick(1);
 }
 //! CP H : Compares H with A.
+template <u32 _Features>
 void xbc_cp_h(Emulator* emu)
 {
     cp_8(emu, emu->cpu.a, emu->cpu.h);
     emu->tick(1);
 }
 //! CP L : Compares L with A.
+template <u32 _Features>
 void xbd_cp_l(Emulator* emu)
 {
     cp_8(emu, emu->cpu.a, emu->cpu.l);
     emu->tick(1);
 }
 //! CP (HL) : Compares data pointed by HL with A.
+template <u32 _Features>
 void xbe_cp_mhl(Emulator* emu)
 {
-    cp_8(emu, emu->cpu.a, emu->bus_read(emu->cpu.hl()));
+    cp_8(emu, emu->cpu.a, emu->bus_read<_Features>(emu->cpu.hl()));
     emu->tick(2);
 }
 //! CP A : Compares A with A.
+template <u32 _Features>
 void xbf_cp_a(Emulator* emu)
 {
     cp_8(emu, emu->cpu.a, emu->cpu.a);
     emu->tick(1);
 }
 //! RET NZ : Returns the function if Z is 0.
+template <u32 _Features>
 void xc0_ret_nz(Emulator* emu)
 {
     if(!emu->cpu.fz())
     {
-        emu->cpu.pc = pop_16(emu);
+        emu->cpu.pc = pop_16<_Features>(emu);
         emu->tick(5);
     }
     else
@@ -1601,15 +1681,17 @@ void xc0_ret_nz(Emulator* emu)
     }
 }
 //! POP BC : Pops 16-bit data from stack to BC.
+template <u32 _Features>
 void xc1_pop_bc(Emulator* emu)
 {
-    emu->cpu.bc(pop_16(emu));
+    emu->cpu.bc(pop_16<_Features>(emu));
     emu->tick(3);
 }
 //! JP NZ, a16 : Jumps to the 16-bit address if Z is 0.
+template <u32 _Features>
 void xc2_jp_nz_a16(Emulator* emu)
 {
-    u16 addr = read_d16(emu);
+    u16 addr = read_d16<_Features>(emu);
     if(!emu->cpu.fz())
     {
         emu->cpu.pc = addr;
@@ -1621,20 +1703,22 @@ void xc2_jp_nz_a16(Emulator* emu)
     }
 }
 //! JP a16 : Jumps to the 16-bit address.
+template <u32 _Features>
 void xc3_jp_a16(Emulator* emu)
 {
-    u16 addr = read_d16(emu);
+    u16 addr = read_d16<_Features>(emu);
     emu->cpu.pc = addr;
     emu->tick(4);
 }
 //! CALL NZ, a16 : Calls the function if Z is 0.
+template <u32 _Features>
 void xc4_call_nz_a16(Emulator* emu)
 {
-    u16 addr = read_d16(emu);
+    u16 addr = read_d16<_Features>(emu);
     emu->tick(2);
     if(!emu->cpu.fz())
     {
-        push_16(emu, emu->cpu.pc);
+        push_16<_Features>(emu, emu->cpu.pc);
         emu->cpu.pc = addr;
         emu->tick(4);
     }
@@ -1644,32 +1728,36 @@ void xc4_call_nz_a16(Emulator* emu)
     }
 }
 //! PUSH BC : Pushes BC to the stack.
+template <u32 _Features>
 void xc5_push_bc(Emulator* emu)
 {
-    push_16(emu, emu->cpu.bc());
+    push_16<_Features>(emu, emu->cpu.bc());
     emu->tick(4);
 }
 //! ADD A, d8 : Adds 8-bit immediate data to A.
+template <u32 _Features>
 void xc6_add_a_d8(Emulator* emu)
 {
-    u8 data = read_d8(emu);
+    u8 data = read_d8<_Features>(emu);
     emu->tick(1);
     emu->cpu.a = add_8(emu, emu->cpu.a, data);
     emu->tick(1);
 }
 //! RST 00H : Pushes PC to stack and resets PC to 0x00.
+template <u32 _Features>
 void xc7_rst_00h(Emulator* emu)
 {
-    push_16(emu, emu->cpu.pc);
+    push_16<_Features>(emu, emu->cpu.pc);
     emu->cpu.pc = 0x0000;
     emu->tick(4);
 }
 //! RET Z : Returns the function if Z is 1.
+template <u32 _Features>
 void xc8_ret_z(Emulator* emu)
 {
     if(emu->cpu.fz())
     {
-        emu->cpu.pc = pop_16(emu);
+        emu->cpu.pc = pop_16<_Features>(emu);
         emu->tick(5);
     }
     else
@@ -1678,15 +1766,17 @@ void xc8_ret_z(Emulator* emu)
     }
 }
 //! RET : Returns the function.
+template <u32 _Features>
 void xc9_ret(Emulator* emu)
 {
-    emu->cpu.pc = pop_16(emu);
+    emu->cpu.pc = pop_16<_Features>(emu);
     emu->tick(4);
 }
 //! JP Z, a16 : Jumps to the 16-bit address if Z is 1.
+template <u32 _Features>
 void xca_jp_z_a16(Emulator* emu)
 {
-    u16 addr = read_d16(emu);
+    u16 addr = read_d16<_Features>(emu);
     if(emu->cpu.fz())
     {
         emu->cpu.pc = addr;
@@ -1698,9 +1788,10 @@ void xca_jp_z_a16(Emulator* emu)
     }
 }
 //! PREFIX CB : Invokes CB instructions.
+template <u32 _Features>
 void xcb_prefix_cb(Emulator* emu)
 {
-    u8 op = read_d8(emu);
+    u8 op = read_d8<_Features>(emu);
     emu->tick(1);
     u8 data_bits = op & 0x07;
     u8 data;
@@ -1713,7 +1804,7 @@ void xcb_prefix_cb(Emulator* emu)
         case 3: data = emu->cpu.e; break;
         case 4: data = emu->cpu.h; break;
         case 5: data = emu->cpu.l; break;
-        case 6: data = emu->bus_read(emu->cpu.hl()); emu->tick(1); break;
+        case 6: data = emu->bus_read<_Features>(emu->cpu.hl()); emu->tick(1); break;
         case 7: data = emu->cpu.a; break;
         default: lupanic(); break;
     }
@@ -1742,7 +1833,7 @@ void xcb_prefix_cb(Emulator* emu)
             case 3: emu->cpu.e = data; break;
             case 4: emu->cpu.h = data; break;
             case 5: emu->cpu.l = data; break;
-            case 6: emu->bus_write(emu->cpu.hl(), data); emu->tick(1); break;
+            case 6: emu->bus_write<_Features>(emu->cpu.hl(), data); emu->tick(1); break;
             case 7: emu->cpu.a = data; break;
             default: lupanic(); break;
         }
@@ -1750,13 +1841,14 @@ void xcb_prefix_cb(Emulator* emu)
     emu->tick(1);
 }
 //! CALL Z, a16 : Calls the function if Z is 1.
+template <u32 _Features>
 void xcc_call_z_a16(Emulator* emu)
 {
-    u16 addr = read_d16(emu);
+    u16 addr = read_d16<_Features>(emu);
     emu->tick(2);
     if(emu->cpu.fz())
     {
-        push_16(emu, emu->cpu.pc);
+        push_16<_Features>(emu, emu->cpu.pc);
         emu->cpu.pc = addr;
         emu->tick(4);
     }
@@ -1766,35 +1858,39 @@ void xcc_call_z_a16(Emulator* emu)
     }
 }
 //! CALL a16 : Calls the function.
+template <u32 _Features>
 void xcd_call_a16(Emulator* emu)
 {
-    u16 addr = read_d16(emu);
+    u16 addr = read_d16<_Features>(emu);
     emu->tick(2);
-    push_16(emu, emu->cpu.pc);
+    push_16<_Features>(emu, emu->cpu.pc);
     emu->cpu.pc = addr;
     emu->tick(4);
 }
 //! ADC A, d8 : Adds 8-bit immediate data to A with carry.
+template <u32 _Features>
 void xce_adc_a_d8(Emulator* emu)
 {
-    u8 data = read_d8(emu);
+    u8 data = read_d8<_Features>(emu);
     emu->tick(1);
     emu->cpu.a = adc_8(emu, emu->cpu.a, data);
     emu->tick(1);
 }
 //! RST 08H : Pushes PC to stack and resets PC to 0x08.
+template <u32 _Features>
 void xcf_rst_08h(Emulator* emu)
 {
-    push_16(emu, emu->cpu.pc);
+    push_16<_Features>(emu, emu->cpu.pc);
     emu->cpu.pc = 0x0008;
     emu->tick(4);
 }
 //! RET NC : Returns the function if C is 0.
+template <u32 _Features>
 void xd0_ret_nc(Emulator* emu)
 {
     if(!emu->cpu.fc())
     {
-        emu->cpu.pc = pop_16(emu);
+        emu->cpu.pc = pop_16<_Features>(emu);
         emu->tick(5);
     }
     else
@@ -1803,15 +1899,17 @@ void xd0_ret_nc(Emulator* emu)
     }
 }
 //! POP DE : Pops 16-bit data from stack to DE.
+template <u32 _Features>
 void xd1_pop_de(Emulator* emu)
 {
-    emu->cpu.de(pop_16(emu));
+    emu->cpu.de(pop_16<_Features>(emu));
     emu->tick(3);
 }
 //! JP NC, a16 : Jumps to the 16-bit address if C is 0.
+template <u32 _Features>
 void xd2_jp_nc_a16(Emulator* emu)
 {
-    u16 addr = read_d16(emu);
+    u16 addr = read_d16<_Features>(emu);
     if(!emu->cpu.fc())
     {
         emu->cpu.pc = addr;
@@ -1823,13 +1921,14 @@ void xd2_jp_nc_a16(Emulator* emu)
     }
 }
 //! CALL NC, a16 : Calls the function if C is 0.
+template <u32 _Features>
 void xd4_call_nc_a16(Emulator* emu)
 {
-    u16 addr = read_d16(emu);
+    u16 addr = read_d16<_Features>(emu);
     emu->tick(2);
     if(!emu->cpu.fc())
     {
-        push_16(emu, emu->cpu.pc);
+        push_16<_Features>(emu, emu->cpu.pc);
         emu->cpu.pc = addr;
         emu->tick(4);
     }
@@ -1839,32 +1938,36 @@ void xd4_call_nc_a16(Emulator* emu)
     }
 }
 //! PUSH DE : Pushes DE to the stack.
+template <u32 _Features>
 void xd5_push_de(Emulator* emu)
 {
-    push_16(emu, emu->cpu.de());
+    push_16<_Features>(emu, emu->cpu.de());
     emu->tick(4);
 }
 //! SUB d8 : Subtracts 8-bit immediate data from A.
+template <u32 _Features>
 void xd6_sub_d8(Emulator* emu)
 {
-    u8 data = read_d8(emu);
+    u8 data = read_d8<_Features>(emu);
     emu->tick(1);
     emu->cpu.a = sub_8(emu, emu->cpu.a, data);
     emu->tick(1);
 }
 //! RST 10H : Pushes PC to stack and resets PC to 0x10.
+template <u32 _Features>
 void xd7_rst_10h(Emulator* emu)
 {
-    push_16(emu, emu->cpu.pc);
+    push_16<_Features>(emu, emu->cpu.pc);
     emu->cpu.pc = 0x0010;
     emu->tick(4);
 }
 //! RET C : Returns the function if C is 1.
+template <u32 _Features>
 void xd8_ret_c(Emulator* emu)
 {
     if(emu->cpu.fc())
     {
-        emu->cpu.pc = pop_16(emu);
+        emu->cpu.pc = pop_16<_Features>(emu);
         emu->tick(5);
     }
     else
@@ -1873,15 +1976,17 @@ void xd8_ret_c(Emulator* emu)
     }
 }
 //! RETI : Returns and enables interruption.
+template <u32 _Features>
 void xd9_reti(Emulator* emu)
 {
     emu->cpu.enable_interrupt_master();
-    xc9_ret(emu);
+    xc9_ret<_Features>(emu);
 }
 //! JP C, a16 : Jumps to the 16-bit address if C is 1.
+template <u32 _Features>
 void xda_jp_c_a16(Emulator* emu)
 {
-    u16 addr = read_d16(emu);
+    u16 addr = read_d16<_Features>(emu);
     if(emu->cpu.fc())
     {
         emu->cpu.pc = addr;
@@ -1893,13 +1998,14 @@ void xda_jp_c_a16(Emulator* emu)
     }
 }
 //! CALL C, a16 : Calls the function if C is 1.
+template <u32 _Features>
 void xdc_call_c_a16(Emulator* emu)
 {
-    u16 addr = read_d16(emu);
+    u16 addr = read_d16<_Features>(emu);
     emu->tick(2);
     if(emu->cpu.fc())
     {
-        push_16(emu, emu->cpu.pc);
+        push_16<_Features>(emu, emu->cpu.pc);
         emu->cpu.pc = addr;
         emu->tick(4);
     }
@@ -1909,220 +2015,248 @@ void xdc_call_c_a16(Emulator* emu)
     }
 }
 //! SBC A, d8 : Subtracts 8-bit immediate data from A.
+template <u32 _Features>
 void xde_sbc_a_d8(Emulator* emu)
 {
-    u8 data = read_d8(emu);
+    u8 data = read_d8<_Features>(emu);
     emu->tick(1);
     emu->cpu.a = sbc_8(emu, emu->cpu.a, data);
     emu->tick(1);
 }
 //! RST 18H : Pushes PC to stack and resets PC to 0x18.
+template <u32 _Features>
 void xdf_rst_18h(Emulator* emu)
 {
-    push_16(emu, emu->cpu.pc);
+    push_16<_Features>(emu, emu->cpu.pc);
     emu->cpu.pc = 0x0018;
     emu->tick(4);
 }
 //! LDH (a8) A : Stores A to high memory address (0xFF00 + a8).
+template <u32 _Features>
 void xe0_ldh_m8_a(Emulator* emu)
 {
-    u8 addr = read_d8(emu);
+    u8 addr = read_d8<_Features>(emu);
     emu->tick(1);
-    emu->bus_write(0xFF00 + (u16)addr, emu->cpu.a);
+    emu->bus_write<_Features>(0xFF00 + (u16)addr, emu->cpu.a);
     emu->tick(2);
 }
 //! POP HL : Pops 16-bit data from stack to HL.
+template <u32 _Features>
 void xe1_pop_hl(Emulator* emu)
 {
-    emu->cpu.hl(pop_16(emu));
+    emu->cpu.hl(pop_16<_Features>(emu));
     emu->tick(3);
 }
 //! LD (C), A : Stores A to memory at 0xFF00 + C.
+template <u32 _Features>
 void xe2_ld_mc_a(Emulator* emu)
 {
-    emu->bus_write(0xFF00 + (u16)emu->cpu.c, emu->cpu.a);
+    emu->bus_write<_Features>(0xFF00 + (u16)emu->cpu.c, emu->cpu.a);
     emu->tick(2);
 }
 //! PUSH HL : Pushes HL to the stack.
+template <u32 _Features>
 void xe5_push_hl(Emulator* emu)
 {
-    push_16(emu, emu->cpu.hl());
+    push_16<_Features>(emu, emu->cpu.hl());
     emu->tick(4);
 }
 //! AND d8 : Performs bitwise AND between A and 8-bit immediate data.
+template <u32 _Features>
 void xe6_and_d8(Emulator* emu)
 {
-    u8 data = read_d8(emu);
+    u8 data = read_d8<_Features>(emu);
     emu->tick(1);
     emu->cpu.a = and_8(emu, emu->cpu.a, data);
     emu->tick(1);
 }
 //! RST 20H : Pushes PC to stack and resets PC to 0x20.
+template <u32 _Features>
 void xe7_rst_20h(Emulator* emu)
 {
-    push_16(emu, emu->cpu.pc);
+    push_16<_Features>(emu, emu->cpu.pc);
     emu->cpu.pc = 0x0020;
     emu->tick(4);
 }
 //! ADD SP, r8 : Adds 8-bit immediate signed integer to SP.
+template <u32 _Features>
 void xe8_add_sp_r8(Emulator* emu)
 {
     emu->cpu.reset_fz();
     emu->cpu.reset_fn();
     u16 v1 = emu->cpu.sp;
-    i16 v2 = (i16)((i8)read_d8(emu));
+    i16 v2 = (i16)((i8)read_d8<_Features>(emu));
     emu->tick(1);
     u16 r = v1 + v2;
     u16 check = v1 ^ v2 ^ r;
-    if(check & 0x10) emu->cpu.set_fh();
-    else emu->cpu.reset_fh();
-    if(check & 0x100) emu->cpu.set_fc();
-    else emu->cpu.reset_fc();
+    emu->cpu.flag_h_carries = (u8)check;
+    emu->cpu.flag_c = (check & 0x100) != 0;
     emu->cpu.sp = r;
     emu->tick(3);
 }
 //! JP HL : Jumps to HL.
+template <u32 _Features>
 void xe9_jp_hl(Emulator* emu)
 {
     emu->cpu.pc = emu->cpu.hl();
     emu->tick(1);
 }
 //! LD (a16), A : Stores A to the memory address.
+template <u32 _Features>
 void xea_ld_a16_a(Emulator* emu)
 {
-    u16 addr = read_d16(emu);
+    u16 addr = read_d16<_Features>(emu);
     emu->tick(2);
-    emu->bus_write(addr, emu->cpu.a);
+    emu->bus_write<_Features>(addr, emu->cpu.a);
     emu->tick(2);
 }
 //! XOR d8 : Performs bitwise XOR between A and 8-bit immediate data.
+template <u32 _Features>
 void xee_xor_d8(Emulator* emu)
 {
-    u8 data = read_d8(emu);
+    u8 data = read_d8<_Features>(emu);
     emu->tick(1);
     emu->cpu.a = xor_8(emu, emu->cpu.a, data);
     emu->tick(1);
 }
 //! RST 28H : Pushes PC to stack and resets PC to 0x28.
+template <u32 _Features>
 void xef_rst_28h(Emulator* emu)
 {
-    push_16(emu, emu->cpu.pc);
+    push_16<_Features>(emu, emu->cpu.pc);
     emu->cpu.pc = 0x0028;
     emu->tick(4);
 }
 //! LDH A, (a8) : Loads data in high memory address (0xFF00 + a8) to A.
+template <u32 _Features>
 void xf0_ldh_a_m8(Emulator* emu)
 {
-    u8 addr = read_d8(emu);
+    u8 addr = read_d8<_Features>(emu);
     emu->tick(1);
-    emu->cpu.a = emu->bus_read(0xFF00 + (u16)addr);
+    emu->cpu.a = emu->bus_read<_Features>(0xFF00 + (u16)addr);
     emu->tick(2);
 }
 //! POP AF : Pops 16-bit data from stack to AF.
+template <u32 _Features>
 void xf1_pop_af(Emulator* emu)
 {
-    emu->cpu.af(pop_16(emu));
+    emu->cpu.af(pop_16<_Features>(emu));
     emu->tick(3);
 }
 //! LD A, (C) : Loads data at memory 0xFF00 + C to A.
+template <u32 _Features>
 void xf2_ld_a_mc(Emulator* emu)
 {
-    emu->cpu.a = emu->bus_read(0xFF00 + (u16)emu->cpu.c);
+    emu->cpu.a = emu->bus_read<_Features>(0xFF00 + (u16)emu->cpu.c);
     emu->tick(2);
 }
 //! DI : Disable interrupts.
+template <u32 _Features>
 void xf3_di(Emulator* emu)
 {
     emu->cpu.disable_interrupt_master();
     emu->tick(1);
 }
 //! PUSH AF : Pushes AF to the stack.
+template <u32 _Features>
 void xf5_push_af(Emulator* emu)
 {
-    push_16(emu, emu->cpu.af());
+    push_16<_Features>(emu, emu->cpu.af());
     emu->tick(4);
 }
 //! OR d8 : Performs bitwise OR between A and 8-bit immediate data.
+template <u32 _Features>
 void xf6_or_d8(Emulator* emu)
 {
-    u8 data = read_d8(emu);
+    u8 data = read_d8<_Features>(emu);
     emu->tick(1);
     emu->cpu.a = or_8(emu, emu->cpu.a, data);
     emu->tick(1);
 }
 //! RST 30H : Pushes PC to stack and resets PC to 0x30.
+template <u32 _Features>
 void xf7_rst_30h(Emulator* emu)
 {
-    push_16(emu, emu->cpu.pc);
+    push_16<_Features>(emu, emu->cpu.pc);
     emu->cpu.pc = 0x0030;
     emu->tick(4);
 }
 //! LD HL, SP + r8 : Loads SP + r8 to HL.
+template <u32 _Features>
 void xf8_ld_hl_sp_r8(Emulator* emu)
 {
     emu->cpu.reset_fz();
     emu->cpu.reset_fn();
     u16 v1 = emu->cpu.sp;
-    i16 v2 = (i16)((i8)read_d8(emu));
+    i16 v2 = (i16)((i8)read_d8<_Features>(emu));
     emu->tick(1);
     u16 r = v1 + v2;
     u16 check = v1 ^ v2 ^ r;
-    if(check & 0x10) emu->cpu.set_fh();
-    else emu->cpu.reset_fh();
-    if(check & 0x100) emu->cpu.set_fc();
-    else emu->cpu.reset_fc();
+    emu->cpu.flag_h_carries = (u8)check;
+    emu->cpu.flag_c = (check & 0x100) != 0;
     emu->cpu.hl(r);
     emu->tick(2);
 }
 //! LD SP, HL : Loads HL to SP.
+template <u32 _Features>
 void xf9_ld_sp_hl(Emulator* emu)
 {
     emu->cpu.sp = emu->cpu.hl();
     emu->tick(2);
 }
 //! LD A, (a16) : Loads data at memory address to A.
+template <u32 _Features>
 void xfa_ld_a_a16(Emulator* emu)
 {
-    u16 addr = read_d16(emu);
+    u16 addr = read_d16<_Features>(emu);
     emu->tick(2);
-    emu->cpu.a = emu->bus_read(addr);
+    emu->cpu.a = emu->bus_read<_Features>(addr);
     emu->tick(2);
 }
 //! EI : Enable interruption.
+template <u32 _Features>
 void xfb_ei(Emulator* emu)
 {
     emu->cpu.enable_interrupt_master();
     emu->tick(1);
 }
 //! CP d8 : Compares A with 8-bit immediate data.
+template <u32 _Features>
 void xfe_cp_d8(Emulator* emu)
 {
-    cp_8(emu, emu->cpu.a, read_d8(emu));
+    cp_8(emu, emu->cpu.a, read_d8<_Features>(emu));
     emu->tick(2);
 }
 //! RST 38H : Pushes PC to stack and resets PC to 0x38.
+template <u32 _Features>
 void xff_rst_38h(Emulator* emu)
 {
-    push_16(emu, emu->cpu.pc);
+    push_16<_Features>(emu, emu->cpu.pc);
     emu->cpu.pc = 0x0038;
     emu->tick(4);
 }
-instruction_func_t* instructions_map[256] = 
-{
-    x00_nop,      x01_ld_bc_d16, x02_ld_mbc_a,  x03_inc_bc, x04_inc_b,   x05_dec_b,   x06_ld_b_d8,   x07_rlca, x08_ld_a16_sp, x09_add_hl_bc, x0a_ld_a_mbc,  x0b_dec_bc, x0c_inc_c, x0d_dec_c, x0e_ld_c_d8, x0f_rrca, 
-    x10_stop,     x11_ld_de_d16, x12_ld_mde_a,  x13_inc_de, x14_inc_d,   x15_dec_d,   x16_ld_d_d8,   x17_rla,  x18_jr_r8,     x19_add_hl_de, x1a_ld_a_mde,  x1b_dec_de, x1c_inc_e, x1d_dec_e, x1e_ld_e_d8, x1f_rra, 
-    x20_jr_nz_r8, x21_ld_hl_d16, x22_ldi_mhl_a, x23_inc_hl, x24_inc_h,   x25_dec_h,   x26_ld_h_d8,   x27_daa, x28_jr_z_r8,   x29_add_hl_hl, x2a_ldi_a_mhl, x2b_dec_hl, x2c_inc_l, x2d_dec_l, x2e_ld_l_d8, x2f_cpl, 
-    x30_jr_nc_r8, x31_ld_sp_d16, x32_ldd_mhl_a, x33_inc_sp, x34_inc_mhl, x35_dec_mhl, x36_ld_mhl_d8, x37_scf, x38_jr_c_r8,   x39_add_hl_sp, x3a_ldd_a_mhl, x3b_dec_sp, x3c_inc_a, x3d_dec_a, x3e_ld_a_d8, x3f_ccf, 
-    x40_ld_b_b,   x41_ld_b_c,   x42_ld_b_d,   x43_ld_b_e,   x44_ld_b_h,   x45_ld_b_l,   x46_ld_b_mhl, x47_ld_b_a,   x48_ld_c_b, x49_ld_c_c, x4a_ld_c_d, x4b_ld_c_e, x4c_ld_c_h, x4d_ld_c_l, x4e_ld_c_mhl, x4f_ld_c_a,
-    x50_ld_d_b,   x51_ld_d_c,   x52_ld_d_d,   x53_ld_d_e,   x54_ld_d_h,   x55_ld_d_l,   x56_ld_d_mhl, x57_ld_d_a,   x58_ld_e_b, x59_ld_e_c, x5a_ld_e_d, x5b_ld_e_e, x5c_ld_e_h, x5d_ld_e_l, x5e_ld_e_mhl, x5f_ld_e_a,
-    x60_ld_h_b,   x61_ld_h_c,   x62_ld_h_d,   x63_ld_h_e,   x64_ld_h_h,   x65_ld_h_l,   x66_ld_h_mhl, x67_ld_h_a,   x68_ld_l_b, x69_ld_l_c, x6a_ld_l_d, x6b_ld_l_e, x6c_ld_l_h, x6d_ld_l_l, x6e_ld_l_mhl, x6f_ld_l_a,
-    x70_ld_mhl_b, x71_ld_mhl_c, x72_ld_mhl_d, x73_ld_mhl_e, x74_ld_mhl_h, x75_ld_mhl_l, x76_halt,     x77_ld_mhl_a, x78_ld_a_b, x79_ld_a_c, x7a_ld_a_d, x7b_ld_a_e, x7c_ld_a_h, x7d_ld_a_l, x7e_ld_a_mhl, x7f_ld_a_a,
-    x80_add_a_b, x81_add_a_c, x82_add_a_d, x83_add_a_e, x84_add_a_h, x85_add_a_l, x86_add_a_mhl, x87_add_a_a, x88_adc_a_b, x89_adc_a_c, x8a_adc_a_d, x8b_adc_a_e, x8c_adc_a_h, x8d_adc_a_l, x8e_adc_a_mhl, x8f_adc_a_a,
-    x90_sub_b, x91_sub_c, x92_sub_d, x93_sub_e, x94_sub_h, x95_sub_l, x96_sub_mhl, x97_sub_a, x98_sbc_a_b, x99_sbc_a_c, x9a_sbc_a_d, x9b_sbc_a_e, x9c_sbc_a_h, x9d_sbc_a_l, x9e_sbc_a_mhl, x9f_sbc_a_a,
-    xa0_and_b, xa1_and_c, xa2_and_d, xa3_and_e, xa4_and_h, xa5_and_l, xa6_and_mhl, xa7_and_a, xa8_xor_b, xa9_xor_c, xaa_xor_d, xab_xor_e, xac_xor_h, xad_xor_l, xae_xor_mhl, xaf_xor_a,
-    xb0_or_b,  xb1_or_c,  xb2_or_d,  xb3_or_e,  xb4_or_h,  xb5_or_l,  xb6_or_mhl,  xb7_or_a,  xb8_cp_b, xb9_cp_c, xba_cp_d, xbb_cp_e, xbc_cp_h, xbd_cp_l, xbe_cp_mhl, xbf_cp_a,
-    xc0_ret_nz,   xc1_pop_bc, xc2_jp_nz_a16, xc3_jp_a16, xc4_call_nz_a16, xc5_push_bc, xc6_add_a_d8, xc7_rst_00h, xc8_ret_z,       xc9_ret,      xca_jp_z_a16, xcb_prefix_cb, xcc_call_z_a16, xcd_call_a16, xce_adc_a_d8, xcf_rst_08h, 
-    xd0_ret_nc,   xd1_pop_de, xd2_jp_nc_a16, nullptr,    xd4_call_nc_a16, xd5_push_de, xd6_sub_d8,   xd7_rst_10h, xd8_ret_c,       xd9_reti,     xda_jp_c_a16, nullptr,       xdc_call_c_a16, nullptr,      xde_sbc_a_d8, xdf_rst_18h, 
-    xe0_ldh_m8_a, xe1_pop_hl, xe2_ld_mc_a,   nullptr,    nullptr,         xe5_push_hl, xe6_and_d8,   xe7_rst_20h, xe8_add_sp_r8,   xe9_jp_hl,    xea_ld_a16_a, nullptr,       nullptr,        nullptr,      xee_xor_d8,   xef_rst_28h, 
-    xf0_ldh_a_m8, xf1_pop_af, xf2_ld_a_mc,   xf3_di,     nullptr,         xf5_push_af, xf6_or_d8,    xf7_rst_30h, xf8_ld_hl_sp_r8, xf9_ld_sp_hl, xfa_ld_a_a16, xfb_ei,        nullptr,        nullptr,      xfe_cp_d8,    xff_rst_38h
-};
\ No newline at end of file
+template <u32 _Features>
+instruction_func_t* const Instructions<_Features>::map[256] = 
+{
+    x00_nop<_Features>,      x01_ld_bc_d16<_Features>, x02_ld_mbc_a<_Features>,  x03_inc_bc<_Features>, x04_inc_b<_Features>,   x05_dec_b<_Features>,   x06_ld_b_d8<_Features>,   x07_rlca<_Features>, x08_ld_a16_sp<_Features>, x09_add_hl_bc<_Features>, x0a_ld_a_mbc<_Features>,  x0b_dec_bc<_Features>, x0c_inc_c<_Features>, x0d_dec_c<_Features>, x0e_ld_c_d8<_Features>, x0f_rrca<_Features>, 
+    x10_stop<_Features>,     x11_ld_de_d16<_Features>, x12_ld_mde_a<_Features>,  x13_inc_de<_Features>, x14_inc_d<_Features>,   x15_dec_d<_Features>,   x16_ld_d_d8<_Features>,   x17_rla<_Features>,  x18_jr_r8<_Features>,     x19_add_hl_de<_Features>, x1a_ld_a_mde<_Features>,  x1b_dec_de<_Features>, x1c_inc_e<_Features>, x1d_dec_e<_Features>, x1e_ld_e_d8<_Features>, x1f_rra<_Features>, 
+    x20_jr_nz_r8<_Features>, x21_ld_hl_d16<_Features>, x22_ldi_mhl_a<_Features>, x23_inc_hl<_Features>, x24_inc_h<_Features>,   x25_dec_h<_Features>,   x26_ld_h_d8<_Features>,   x27_daa<_Features>, x28_jr_z_r8<_Features>,   x29_add_hl_hl<_Features>, x2a_ldi_a_mhl<_Features>, x2b_dec_hl<_Features>, x2c_inc_l<_Features>, x2d_dec_l<_Features>, x2e_ld_l_d8<_Features>, x2f_cpl<_Features>, 
+    x30_jr_nc_r8<_Features>, x31_ld_sp_d16<_Features>, x32_ldd_mhl_a<_Features>, x33_inc_sp<_Features>, x34_inc_mhl<_Features>, x35_dec_mhl<_Features>, x36_ld_mhl_d8<_Features>, x37_scf<_Features>, x38_jr_c_r8<_Features>,   x39_add_hl_sp<_Features>, x3a_ldd_a_mhl<_Features>, x3b_dec_sp<_Features>, x3c_inc_a<_Features>, x3d_dec_a<_Features>, x3e_ld_a_d8<_Features>, x3f_ccf<_Features>, 
+    x40_ld_b_b<_Features>,   x41_ld_b_c<_Features>,   x42_ld_b_d<_Features>,   x43_ld_b_e<_Features>,   x44_ld_b_h<_Features>,   x45_ld_b_l<_Features>,   x46_ld_b_mhl<_Features>, x47_ld_b_a<_Features>,   x48_ld_c_b<_Features>, x49_ld_c_c<_Features>, x4a_ld_c_d<_Features>, x4b_ld_c_e<_Features>, x4c_ld_c_h<_Features>, x4d_ld_c_l<_Features>, x4e_ld_c_mhl<_Features>, x4f_ld_c_a<_Features>,
+    x50_ld_d_b<_Features>,   x51_ld_d_c<_Features>,   x52_ld_d_d<_Features>,   x53_ld_d_e<_Features>,   x54_ld_d_h<_Features>,   x55_ld_d_l<_Features>,   x56_ld_d_mhl<_Features>, x57_ld_d_a<_Features>,   x58_ld_e_b<_Features>, x59_ld_e_c<_Features>, x5a_ld_e_d<_Features>, x5b_ld_e_e<_Features>, x5c_ld_e_h<_Features>, x5d_ld_e_l<_Features>, x5e_ld_e_mhl<_Features>, x5f_ld_e_a<_Features>,
+    x60_ld_h_b<_Features>,   x61_ld_h_c<_Features>,   x62_ld_h_d<_Features>,   x63_ld_h_e<_Features>,   x64_ld_h_h<_Features>,   x65_ld_h_l<_Features>,   x66_ld_h_mhl<_Features>, x67_ld_h_a<_Features>,   x68_ld_l_b<_Features>, x69_ld_l_c<_Features>, x6a_ld_l_d<_Features>, x6b_ld_l_e<_Features>, x6c_ld_l_h<_Features>, x6d_ld_l_l<_Features>, x6e_ld_l_mhl<_Features>, x6f_ld_l_a<_Features>,
+    x70_ld_mhl_b<_Features>, x71_ld_mhl_c<_Features>, x72_ld_mhl_d<_Features>, x73_ld_mhl_e<_Features>, x74_ld_mhl_h<_Features>, x75_ld_mhl_l<_Features>, x76_halt<_Features>,     x77_ld_mhl_a<_Features>, x78_ld_a_b<_Features>, x79_ld_a_c<_Features>, x7a_ld_a_d<_Features>, x7b_ld_a_e<_Features>, x7c_ld_a_h<_Features>, x7d_ld_a_l<_Features>, x7e_ld_a_mhl<_Features>, x7f_ld_a_a<_Features>,
+    x80_add_a_b<_Features>, x81_add_a_c<_Features>, x82_add_a_d<_Features>, x83_add_a_e<_Features>, x84_add_a_h<_Features>, x85_add_a_l<_Features>, x86_add_a_mhl<_Features>, x87_add_a_a<_Features>, x88_adc_a_b<_Features>, x89_adc_a_c<_Features>, x8a_adc_a_d<_Features>, x8b_adc_a_e<_Features>, x8c_adc_a_h<_Features>, x8d_adc_a_l<_Features>, x8e_adc_a_mhl<_Features>, x8f_adc_a_a<_Features>,
+    x90_sub_b<_Features>, x91_sub_c<_Features>, x92_sub_d<_Features>, x93_sub_e<_Features>, x94_sub_h<_Features>, x95_sub_l<_Features>, x96_sub_mhl<_Features>, x97_sub_a<_Features>, x98_sbc_a_b<_Features>, x99_sbc_a_c<_Features>, x9a_sbc_a_d<_Features>, x9b_sbc_a_e<_Features>, x9c_sbc_a_h<_Features>, x9d_sbc_a_l<_Features>, x9e_sbc_a_mhl<_Features>, x9f_sbc_a_a<_Features>,
+    xa0_and_b<_Features>, xa1_and_c<_Features>, xa2_and_d<_Features>, xa3_and_e<_Features>, xa4_and_h<_Features>, xa5_and_l<_Features>, xa6_and_mhl<_Features>, xa7_and_a<_Features>, xa8_xor_b<_Features>, xa9_xor_c<_Features>, xaa_xor_d<_Features>, xab_xor_e<_Features>, xac_xor_h<_Features>, xad_xor_l<_Features>, xae_xor_mhl<_Features>, xaf_xor_a<_Features>,
+    xb0_or_b<_Features>,  xb1_or_c<_Features>,  xb2_or_d<_Features>,  xb3_or_e<_Features>,  xb4_or_h<_Features>,  xb5_or_l<_Features>,  xb6_or_mhl<_Features>,  xb7_or_a<_Features>,  xb8_cp_b<_Features>, xb9_cp_c<_Features>, xba_cp_d<_Features>, xbb_cp_e<_Features>, xbc_cp_h<_Features>, xbd_cp_l<_Features>, xbe_cp_mhl<_Features>, xbf_cp_a<_Features>,
+    xc0_ret_nz<_Features>,   xc1_pop_bc<_Features>, xc2_jp_nz_a16<_Features>, xc3_jp_a16<_Features>, xc4_call_nz_a16<_Features>, xc5_push_bc<_Features>, xc6_add_a_d8<_Features>, xc7_rst_00h<_Features>, xc8_ret_z<_Features>,       xc9_ret<_Features>,      xca_jp_z_a16<_Features>, xcb_prefix_cb<_Features>, xcc_call_z_a16<_Features>, xcd_call_a16<_Features>, xce_adc_a_d8<_Features>, xcf_rst_08h<_Features>, 
+    xd0_ret_nc<_Features>,   xd1_pop_de<_Features>, xd2_jp_nc_a16<_Features>, nullptr,    xd4_call_nc_a16<_Features>, xd5_push_de<_Features>, xd6_sub_d8<_Features>,   xd7_rst_10h<_Features>, xd8_ret_c<_Features>,       xd9_reti<_Features>,     xda_jp_c_a16<_Features>, nullptr,       xdc_call_c_a16<_Features>, nullptr,      xde_sbc_a_d8<_Features>, xdf_rst_18h<_Features>, 
+    xe0_ldh_m8_a<_Features>, xe1_pop_hl<_Features>, xe2_ld_mc_a<_Features>,   nullptr,    nullptr,         xe5_push_hl<_Features>, xe6_and_d8<_Features>,   xe7_rst_20h<_Features>, xe8_add_sp_r8<_Features>,   xe9_jp_hl<_Features>,    xea_ld_a16_a<_Features>, nullptr,       nullptr,        nullptr,      xee_xor_d8<_Features>,   xef_rst_28h<_Features>, 
+    xf0_ldh_a_m8<_Features>, xf1_pop_af<_Features>, xf2_ld_a_mc<_Features>,   xf3_di<_Features>,     nullptr,         xf5_push_af<_Features>, xf6_or_d8<_Features>,    xf7_rst_30h<_Features>, xf8_ld_hl_sp_r8<_Features>, xf9_ld_sp_hl<_Features>, xfa_ld_a_a16<_Features>, xfb_ei<_Features>,        nullptr,        nullptr,      xfe_cp_d8<_Features>,    xff_rst_38h<_Features>
+};
+// Instructions are only specialized for features that affect bus accesses.
+template struct Instructions<0>;
+template struct Instructions<EMULATOR_FEATURE_ACCESS_COUNTERS>;
+template struct Instructions<EMULATOR_FEATURE_WATCHPOINTS>;
+template struct Instructions<EMULATOR_FEATURE_ACCESS_COUNTERS | EMULATOR_FEATURE_WATCHPOINTS>;
\ No newline at end of file
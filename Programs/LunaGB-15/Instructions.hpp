@@ -1,7 +1,14 @@
 #pragma once
+#include <Luna/Runtime/Base.hpp>
+using namespace Luna;
 
 struct Emulator;
 using instruction_func_t = void(Emulator* emu);
 
-//! A map of all instruction functions by their opcodes.
-extern instruction_func_t* instructions_map[256];
\ No newline at end of file
+//! Instructions specialized for one combination of `EMULATOR_BUS_FEATURES` flags.
+template <u32 _Features>
+struct Instructions
+{
+    //! A map of all instruction functions by their opcodes.
+    static instruction_func_t* const map[256];
+};
\ No newline at end of file
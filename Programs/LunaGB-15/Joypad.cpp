@@ -27,6 +27,30 @@ u8 Joypad::get_key_state() const
     }
     return v;
 }
+u8 Joypad::get_buttons() const
+{
+    u8 v = 0;
+    if(right) bit_set(&v, 0);
+    if(left) bit_set(&v, 1);
+    if(up) bit_set(&v, 2);
+    if(down) bit_set(&v, 3);
+    if(a) bit_set(&v, 4);
+    if(b) bit_set(&v, 5);
+    if(select) bit_set(&v, 6);
+    if(start) bit_set(&v, 7);
+    return v;
+}
+void Joypad::set_buttons(u8 buttons)
+{
+    right = bit_test(&buttons, 0);
+    left = bit_test(&buttons, 1);
+    up = bit_test(&buttons, 2);
+    down = bit_test(&buttons, 3);
+    a = bit_test(&buttons, 4);
+    b = bit_test(&buttons, 5);
+    select = bit_test(&buttons, 6);
+    start = bit_test(&buttons, 7);
+}
 void Joypad::update(Emulator* emu)
 {
     u8 v = get_key_state();
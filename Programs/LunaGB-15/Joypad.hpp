@@ -18,6 +18,9 @@ struct Joypad
 
     void init();
     u8 get_key_state() const;
+    //! Packs all button states to one byte: bit 0-7 are right, left, up, down, A, B, select and start.
+    u8 get_buttons() const;
+    void set_buttons(u8 buttons);
     void update(Emulator* emu);
     u8 bus_read();
     void bus_write(u8 v);
@@ -0,0 +1,99 @@
+#include "LineCompositor.hpp"
+#include "ByteVector.hpp"
+
+//! The RGBA color of every shade.
+struct ShadeTable
+{
+    u32 colors[4];
+    ShadeTable()
+    {
+        for(u32 i = 0; i < 4; ++i)
+        {
+            u8 c[4] = { PPU_SHADE_COLORS[i][0], PPU_SHADE_COLORS[i][1], PPU_SHADE_COLORS[i][2], 255 };
+            memcpy(&colors[i], c, 4);
+        }
+    }
+};
+static const ShadeTable g_shade_table;
+
+inline void write_shades(const u8* shades, u8* dst, u32 num_pixels)
+{
+    for(u32 i = 0; i < num_pixels; ++i)
+    {
+        memcpy(dst + i * 4, &g_shade_table.colors[shades[i]], 4);
+    }
+}
+inline u8 apply_palette(u8 color, u8 palette)
+{
+    return (palette >> (color * 2)) & 0x03;
+}
+void composite_line_scalar(const PPULinePixels& line, u8* dst, u32 num_pixels)
+{
+    luassert(num_pixels <= PPU_XRES);
+    u8 shades[PPU_XRES];
+    for(u32 i = 0; i < num_pixels; ++i)
+    {
+        // Calculate background color.
+        u8 bg_color = apply_palette(line.bgw_colors[i], line.bgw_palettes[i]);
+        // Draw object if:
+        // 1. Color index is not 0 (transparent) and:
+        // 2. Background priority is not greater than object priority, or the background color is 00.
+        bool draw_obj = line.obj_colors[i] && (!line.obj_bg_priorities[i] || bg_color == 0);
+        shades[i] = draw_obj ? apply_palette(line.obj_colors[i], line.obj_palettes[i]) : bg_color;
+    }
+    write_shades(shades, dst, num_pixels);
+}
+#ifdef BYTE_VECTOR_SIMD
+//! Applies palettes to 16 color indices. Every palette holds 4 2-bit shades, the shade of color
+//! `c` is selected by comparing `c` with every index.
+inline byte_vec_t vec_apply_palette(byte_vec_t color, byte_vec_t palette)
+{
+    byte_vec_t mask = vec_splat(0x03);
+    byte_vec_t r = vec_and(palette, mask);
+    r = vec_select(vec_eq(color, vec_splat(1)), vec_and(vec_shr<2>(palette), mask), r);
+    r = vec_select(vec_eq(color, vec_splat(2)), vec_and(vec_shr<4>(palette), mask), r);
+    r = vec_select(vec_eq(color, vec_splat(3)), vec_and(vec_shr<6>(palette), mask), r);
+    return r;
+}
+//! Maps 16 shades to one color channel.
+inline byte_vec_t vec_shade_channel(byte_vec_t shade, u32 channel)
+{
+    byte_vec_t r = vec_splat(PPU_SHADE_COLORS[0][channel]);
+    r = vec_select(vec_eq(shade, vec_splat(1)), vec_splat(PPU_SHADE_COLORS[1][channel]), r);
+    r = vec_select(vec_eq(shade, vec_splat(2)), vec_splat(PPU_SHADE_COLORS[2][channel]), r);
+    r = vec_select(vec_eq(shade, vec_splat(3)), vec_splat(PPU_SHADE_COLORS[3][channel]), r);
+    return r;
+}
+void composite_line(const PPULinePixels& line, u8* dst, u32 num_pixels)
+{
+    luassert(num_pixels <= PPU_XRES);
+    static_assert(PPU_XRES % 16 == 0, "The line width must be times of 16");
+    byte_vec_t zero = vec_splat(0);
+    for(u32 i = 0; i < num_pixels; i += 16)
+    {
+        byte_vec_t bg_color = vec_apply_palette(vec_load(line.bgw_colors + i), vec_load(line.bgw_palettes + i));
+        byte_vec_t obj_color_index = vec_load(line.obj_colors + i);
+        byte_vec_t obj_color = vec_apply_palette(obj_color_index, vec_load(line.obj_palettes + i));
+        // `obj_bg_priorities` are 0 or 1.
+        byte_vec_t obj_above = vec_or(vec_eq(vec_load(line.obj_bg_priorities + i), zero), vec_eq(bg_color, zero));
+        byte_vec_t transparent = vec_eq(obj_color_index, zero);
+        byte_vec_t shade = vec_select(transparent, bg_color, vec_select(obj_above, obj_color, bg_color));
+        if(i + 16 <= num_pixels)
+        {
+            vec_store_rgba(dst + i * 4, vec_shade_channel(shade, 0), vec_shade_channel(shade, 1), vec_shade_channel(shade, 2), vec_splat(255));
+        }
+        else
+        {
+            // The last pixels of one partially drawn line.
+            u8 shades[16];
+            vec_store(shades, shade);
+            write_shades(shades, dst + i * 4, num_pixels - i);
+        }
+    }
+}
+#else
+void composite_line(const PPULinePixels& line, u8* dst, u32 num_pixels)
+{
+    composite_line_scalar(line, dst, num_pixels);
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,9 @@
+#pragma once
+#include "PPU.hpp"
+
+//! Composites the first `num_pixels` pixels of one line: applies palettes, resolves object and
+//! background priority and writes RGBA pixels to `dst`.
+//! Uses SSE2 or Neon when available, the result is the same as `composite_line_scalar`.
+void composite_line(const PPULinePixels& line, u8* dst, u32 num_pixels);
+//! The scalar reference implementation of `composite_line`.
+void composite_line_scalar(const PPULinePixels& line, u8* dst, u32 num_pixels);
\ No newline at end of file
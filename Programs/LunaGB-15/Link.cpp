@@ -0,0 +1,399 @@
+#include "Link.hpp"
+#include "Emulator.hpp"
+#include "RomCache.hpp"
+#include <Luna/Runtime/Log.hpp>
+#include <Luna/Runtime/Time.hpp>
+
+enum class LinkMessageType : u8
+{
+    //! The peer master completes one transfer, `data` is the byte shifted out by the master.
+    exchange = 1,
+    //! Replies `exchange`, `data` is the byte shifted out by the slave.
+    reply = 2,
+    //! The peer closes the connection.
+    bye = 3
+};
+struct LinkMessage
+{
+    LinkMessageType type;
+    u8 data;
+    //! The sequence number of the transfer, used to match replies with transfers.
+    u16 sequence;
+    u32 reserved;
+    //! The clock cycles of the sender measured from the first serial clock tick after connection.
+    u64 cycles;
+};
+
+void LinkCable::connect(Emulator* a, Emulator* b)
+{
+    emulators[0] = a;
+    emulators[1] = b;
+    ports[0].peer = &ports[1];
+    ports[1].peer = &ports[0];
+    for(u32 i = 0; i < 2; ++i)
+    {
+        Serial& serial = emulators[i]->serial;
+        serial.link = &ports[i];
+        ports[i].set_slave_state(serial.transfer_enable() && !serial.is_master(), serial.sb);
+    }
+}
+void LinkCable::disconnect()
+{
+    for(u32 i = 0; i < 2; ++i)
+    {
+        if(emulators[i]) emulators[i]->serial.link = nullptr;
+        emulators[i] = nullptr;
+        ports[i].peer = nullptr;
+        ports[i].state = LinkEndState();
+    }
+}
+bool LinkCable::is_transfer_in_flight() const
+{
+    return emulators[0]->serial.transferring || emulators[1]->serial.transferring ||
+        ports[0].state.received || ports[1].state.received;
+}
+void LinkCable::run(u64 cycles)
+{
+    u64 end_cycles[2] = { emulators[0]->clock_cycles + cycles, emulators[1]->clock_cycles + cycles };
+    while(true)
+    {
+        // Run the emulator that falls behind.
+        bool finished[2] = {
+            emulators[0]->clock_cycles >= end_cycles[0] || emulators[0]->paused,
+            emulators[1]->clock_cycles >= end_cycles[1] || emulators[1]->paused
+        };
+        if(finished[0] && finished[1]) break;
+        u32 i;
+        if(finished[0]) i = 1;
+        else if(finished[1]) i = 0;
+        else i = emulators[0]->clock_cycles <= emulators[1]->clock_cycles ? 0 : 1;
+        Emulator* emu = emulators[i];
+        Emulator* other = emulators[1 - i];
+        bool in_flight = is_transfer_in_flight();
+        u64 target = end_cycles[i];
+        if(in_flight)
+        {
+            // The bound is kept even if the peer has finished, so that the peer never handles the
+            // transfer later than this end. One paused peer does not proceed, so this end can only
+            // run until its side of the transfer completes.
+            target = min(target, other->clock_cycles + (other->paused ? LINK_TRANSFER_CYCLES : LINK_LOOKAHEAD_CYCLES));
+            // Wait for the peer in the next call.
+            if(emu->clock_cycles >= target) break;
+        }
+        while(emu->clock_cycles < target && !emu->paused)
+        {
+            emu->cpu.step(emu);
+            // Synchronize two emulators once one transfer starts.
+            if(!in_flight && is_transfer_in_flight()) break;
+        }
+    }
+}
+static RV read_socket(Network::ISocket* socket, void* buffer, usize size)
+{
+    usize read_bytes = 0;
+    while(read_bytes < size)
+    {
+        usize sz;
+        auto r = socket->read((u8*)buffer + read_bytes, size - read_bytes, &sz);
+        if(failed(r)) return r;
+        if(!sz) return set_error(NetworkError::connection_reset(), "The link cable is disconnected.");
+        read_bytes += sz;
+    }
+    return ok;
+}
+static RV write_socket(Network::ISocket* socket, const void* buffer, usize size)
+{
+    usize written_bytes = 0;
+    while(written_bytes < size)
+    {
+        usize sz;
+        auto r = socket->write((const u8*)buffer + written_bytes, size - written_bytes, &sz);
+        if(failed(r)) return r;
+        written_bytes += sz;
+    }
+    return ok;
+}
+static void socket_link_receive_run(void* params)
+{
+    SocketLinkPort* port = (SocketLinkPort*)params;
+    port->receive_run();
+}
+static R<Ref<Network::ISocket>> new_tcp_socket()
+{
+    return Network::new_socket(Network::AddressFamily::ipv4, Network::SocketType::stream, Network::Protocol::tcp);
+}
+static Network::SocketAddress get_ipv4_address(u8 a, u8 b, u8 c, u8 d, u16 port)
+{
+    Network::SocketAddress address;
+    address.family = Network::AddressFamily::ipv4;
+    address.ipv4.address = { a, b, c, d };
+    address.ipv4.port = port;
+    return address;
+}
+RV SocketLinkPort::host(u16 port)
+{
+    lutry
+    {
+        this->port = port;
+        luset(listen_socket, new_tcp_socket());
+        luexp(listen_socket->bind(get_ipv4_address(0, 0, 0, 0, port)));
+        luexp(listen_socket->listen(1));
+        connected = false;
+        exiting = false;
+        receive_thread = new_thread(socket_link_receive_run, this, "Link cable receiver");
+        log_info("LunaGB", "Waiting for link cable connection on port %u.", (u32)port);
+    }
+    lucatchret;
+    return ok;
+}
+RV SocketLinkPort::connect(const c8* address, u16 port)
+{
+    lutry
+    {
+        u32 a, b, c, d;
+        if(sscanf(address, "%u.%u.%u.%u", &a, &b, &c, &d) != 4 || a > 255 || b > 255 || c > 255 || d > 255)
+        {
+            return set_error(BasicError::bad_arguments(), "%s is not a valid IPv4 address.", address);
+        }
+        this->port = port;
+        luset(socket, new_tcp_socket());
+        luexp(socket->connect(get_ipv4_address((u8)a, (u8)b, (u8)c, (u8)d, port)));
+        connected = true;
+        exiting = false;
+        receive_thread = new_thread(socket_link_receive_run, this, "Link cable receiver");
+        log_info("LunaGB", "Link cable connected to %s:%u.", address, (u32)port);
+    }
+    lucatchret;
+    return ok;
+}
+bool SocketLinkPort::is_connected()
+{
+    LockGuard guard(lock);
+    return connected;
+}
+void SocketLinkPort::close()
+{
+    if(!receive_thread) return;
+    lock.lock();
+    exiting = true;
+    bool was_connected = connected;
+    lock.unlock();
+    if(was_connected)
+    {
+        // The receive thread exits when the peer replies `bye` or closes the connection.
+        send_message((u8)LinkMessageType::bye, 0, 0, 0);
+        u64 timeout_ticks = (u64)(LINK_CLOSE_TIMEOUT * get_ticks_per_second());
+        u64 begin_ticks = get_ticks();
+        while(!receive_thread->try_wait() && get_ticks() - begin_ticks <= timeout_ticks)
+        {
+            sleep(10);
+        }
+    }
+    if(!receive_thread->try_wait())
+    {
+        // Wake up the receive thread that is still waiting for connection, or for one peer that does not reply.
+        lock.lock();
+        Ref<Network::ISocket> s = socket ? socket : listen_socket;
+        lock.unlock();
+        auto r = s->shutdown();
+        if(failed(r))
+        {
+            log_error("LunaGB", "Failed to shut down link cable connection: %s", explain(r.errcode()));
+        }
+    }
+    receive_thread->wait();
+    receive_thread.reset();
+    socket.reset();
+    listen_socket.reset();
+    connected = false;
+}
+u64 SocketLinkPort::get_link_cycles(u64 clock_cycles)
+{
+    if(clock_origin == U64_MAX) clock_origin = clock_cycles;
+    return clock_cycles - clock_origin;
+}
+void SocketLinkPort::set_slave_state(bool ready, u8 data)
+{
+    LockGuard guard(lock);
+    state.ready = ready;
+    state.ready_data = data;
+}
+bool SocketLinkPort::exchange(u64 clock_cycles, u8 data, u8& reply)
+{
+    lock.lock();
+    if(!connected)
+    {
+        lock.unlock();
+        reply = 0xFF;
+        return true;
+    }
+    u16 sequence = next_sequence++;
+    waiting_reply = true;
+    waiting_sequence = sequence;
+    waiting_ticks = get_ticks();
+    has_reply = false;
+    lock.unlock();
+    send_message((u8)LinkMessageType::exchange, data, sequence, get_link_cycles(clock_cycles));
+    // The transfer is completed in `poll_reply` when the peer reaches the same clock cycles and replies.
+    return false;
+}
+bool SocketLinkPort::poll_reply(u8& reply)
+{
+    LockGuard guard(lock);
+    if(!waiting_reply)
+    {
+        reply = 0xFF;
+        return true;
+    }
+    u64 timeout_ticks = (u64)(LINK_REPLY_TIMEOUT * get_ticks_per_second());
+    if(!has_reply && connected && get_ticks() - waiting_ticks <= timeout_ticks)
+    {
+        return false;
+    }
+    reply = has_reply ? reply_data : 0xFF;
+    waiting_reply = false;
+    return true;
+}
+bool SocketLinkPort::receive(u64 clock_cycles, u8& data)
+{
+    lock.lock();
+    if(!connected)
+    {
+        lock.unlock();
+        return false;
+    }
+    u64 cycles = get_link_cycles(clock_cycles);
+    // Wait until this end reaches the clock cycles of the master.
+    if(!has_request || cycles < request_cycles)
+    {
+        lock.unlock();
+        return false;
+    }
+    has_request = false;
+    u8 reply = state.exchange(request_data);
+    bool received = state.receive(data);
+    u16 sequence = request_sequence;
+    lock.unlock();
+    send_message((u8)LinkMessageType::reply, reply, sequence, cycles);
+    return received;
+}
+void SocketLinkPort::send_message(u8 type, u8 data, u16 sequence, u64 cycles)
+{
+    LinkMessage message;
+    message.type = (LinkMessageType)type;
+    message.data = data;
+    message.sequence = sequence;
+    message.reserved = 0;
+    message.cycles = cycles;
+    LockGuard guard(send_lock);
+    auto r = write_socket(socket, &message, sizeof(LinkMessage));
+    if(failed(r))
+    {
+        log_error("LunaGB", "Failed to send link cable message: %s", explain(r.errcode()));
+    }
+}
+void SocketLinkPort::receive_run()
+{
+    if(!socket)
+    {
+        Network::SocketAddress address;
+        auto s = listen_socket->accept(address);
+        LockGuard guard(lock);
+        if(exiting) return;
+        if(failed(s))
+        {
+            log_error("LunaGB", "Failed to accept link cable connection: %s", explain(s.errcode()));
+            return;
+        }
+        socket = s.get();
+        connected = true;
+        log_info("LunaGB", "Link cable connected.");
+    }
+    while(true)
+    {
+        LinkMessage message;
+        auto r = read_socket(socket, &message, sizeof(LinkMessage));
+        if(failed(r)) break;
+        if(message.type == LinkMessageType::exchange)
+        {
+            lock.lock();
+            if(waiting_reply)
+            {
+                // Both ends are transferring as master, so none of them receives data from the other.
+                lock.unlock();
+                send_message((u8)LinkMessageType::reply, 0xFF, message.sequence, 0);
+            }
+            else
+            {
+                // The transfer is handled by the emulation thread in `receive`.
+                has_request = true;
+                request_data = message.data;
+                request_sequence = message.sequence;
+                request_cycles = message.cycles;
+                lock.unlock();
+            }
+        }
+        else if(message.type == LinkMessageType::reply)
+        {
+            LockGuard guard(lock);
+            if(waiting_reply && message.sequence == waiting_sequence)
+            {
+                has_reply = true;
+                reply_data = message.data;
+            }
+        }
+        else if(message.type == LinkMessageType::bye)
+        {
+            lock.lock();
+            bool closing = exiting;
+            connected = false;
+            lock.unlock();
+            if(!closing)
+            {
+                send_message((u8)LinkMessageType::bye, 0, 0, 0);
+            }
+            break;
+        }
+    }
+    lock.lock();
+    connected = false;
+    lock.unlock();
+    log_info("LunaGB", "Link cable disconnected.");
+}
+RV run_linked_emulators(const c8* rom_path_a, const c8* rom_path_b, f64 seconds)
+{
+    lutry
+    {
+        lulet(rom_a, open_rom(rom_path_a));
+        lulet(rom_b, open_rom(rom_path_b));
+        UniquePtr<Emulator> a(memnew<Emulator>());
+        UniquePtr<Emulator> b(memnew<Emulator>());
+        luexp(a->init(Path(), rom_a));
+        luexp(b->init(Path(), rom_b));
+        LinkCable cable;
+        cable.connect(a.get(), b.get());
+        u64 total_cycles = (u64)(seconds * CLOCK_FREQUENCY);
+        u64 begin_ticks = get_ticks();
+        usize transfers[2] = { 0, 0 };
+        while(a->clock_cycles < total_cycles && !(a->paused && b->paused))
+        {
+            u64 last_cycles = a->clock_cycles + b->clock_cycles;
+            cable.run(FRAME_CYCLES);
+            // One emulator is paused while the other waits for it to complete one transfer.
+            if(a->clock_cycles + b->clock_cycles == last_cycles) break;
+            Emulator* emus[2] = { a.get(), b.get() };
+            for(u32 i = 0; i < 2; ++i)
+            {
+                transfers[i] += emus[i]->serial.output_buffer.size();
+                emus[i]->serial.output_buffer.clear();
+            }
+        }
+        cable.disconnect();
+        f64 time = (f64)(get_ticks() - begin_ticks) / get_ticks_per_second();
+        f64 emulated_time = (f64)a->clock_cycles / CLOCK_FREQUENCY;
+        log_info("LunaGB", "%f seconds emulated in %f seconds (%.1fx realtime), %llu/%llu bytes transferred.",
+            emulated_time, time, emulated_time / time, (u64)transfers[0], (u64)transfers[1]);
+    }
+    lucatchret;
+    return ok;
+}
\ No newline at end of file
@@ -0,0 +1,189 @@
+#pragma once
+#include <Luna/Runtime/Result.hpp>
+#include <Luna/Runtime/Thread.hpp>
+#include <Luna/Runtime/SpinLock.hpp>
+#include <Luna/Network/Network.hpp>
+using namespace Luna;
+
+//! The maximum number of clock cycles one linked emulator can run ahead of the other while one
+//! transfer is in flight. This equals the period of one serial clock tick at 8192Hz.
+constexpr u64 LINK_LOOKAHEAD_CYCLES = 512;
+//! The number of clock cycles of one transfer, which shifts 8 bits at 8192Hz.
+constexpr u64 LINK_TRANSFER_CYCLES = LINK_LOOKAHEAD_CYCLES * 8;
+
+//! The maximum wall time in seconds the master waits for the peer to reply one transfer.
+//! If the peer does not reply in time, the transfer completes as if no peer is connected.
+constexpr f64 LINK_REPLY_TIMEOUT = 0.5;
+//! The maximum wall time in seconds `SocketLinkPort::close` waits for the peer to reply `bye`.
+//! If the peer does not reply in time, the connection is shut down.
+constexpr f64 LINK_CLOSE_TIMEOUT = 1.0;
+
+//! One end of the link cable.
+//! The master (internal clock) shifts out 8 bits and shifts in 8 bits from the slave (external clock)
+//! at the same time, so one transfer exchanges one byte between two ends.
+struct LinkPort
+{
+    virtual ~LinkPort() {}
+    //! Publishes whether this end is waiting for the peer to start one transfer (transfer enabled
+    //! with external clock), and the byte that will be shifted out when the peer starts one transfer.
+    virtual void set_slave_state(bool ready, u8 data) = 0;
+    //! Called by the master when one transfer completes.
+    //! @param[in] clock_cycles The clock cycles of the master when the transfer completes.
+    //! @param[in] data The byte shifted out by the master.
+    //! @param[out] reply Returns the byte shifted out by the slave, or 0xFF if the peer is not ready.
+    //! @return Returns `false` if the reply is not available yet. In such case, the master keeps the
+    //! transfer in progress and calls `poll_reply` on every serial clock tick until the reply is available.
+    virtual bool exchange(u64 clock_cycles, u8 data, u8& reply) = 0;
+    //! Fetches the reply of the last `exchange` that returned `false`.
+    //! @param[out] reply Returns the byte shifted out by the slave, or 0xFF if the peer is not ready.
+    //! @return Returns `false` if the reply is still not available.
+    virtual bool poll_reply(u8& reply)
+    {
+        reply = 0xFF;
+        return true;
+    }
+    //! Called on every serial clock tick when this end is not transferring as master.
+    //! @param[in] clock_cycles The current clock cycles of this end.
+    //! @param[out] data Returns the byte shifted in from the master.
+    //! @return Returns `true` if one transfer started by the peer is completed.
+    virtual bool receive(u64 clock_cycles, u8& data) = 0;
+};
+
+//! The slave state of one link end.
+struct LinkEndState
+{
+    //! `true` if this end is ready to be clocked by the peer.
+    bool ready = false;
+    //! The byte to shift out when the peer starts one transfer.
+    u8 ready_data = 0xFF;
+    //! `true` if one byte is shifted in and not fetched by `receive` yet.
+    bool received = false;
+    u8 received_data = 0xFF;
+
+    //! Completes one transfer started by the peer.
+    u8 exchange(u8 data)
+    {
+        if(!ready) return 0xFF;
+        ready = false;
+        received = true;
+        received_data = data;
+        return ready_data;
+    }
+    bool receive(u8& data)
+    {
+        if(!received) return false;
+        received = false;
+        data = received_data;
+        return true;
+    }
+};
+
+//! The link port that connects two emulators in the same process.
+//! The master completes one transfer using the published slave state directly, since `LinkCable`
+//! keeps two emulators synchronized while one transfer is in flight.
+struct InProcessLinkPort : LinkPort
+{
+    InProcessLinkPort* peer = nullptr;
+    LinkEndState state;
+
+    virtual void set_slave_state(bool ready, u8 data) override
+    {
+        state.ready = ready;
+        state.ready_data = data;
+    }
+    virtual bool exchange(u64 /*clock_cycles*/, u8 data, u8& reply) override
+    {
+        reply = peer ? peer->state.exchange(data) : 0xFF;
+        return true;
+    }
+    virtual bool receive(u64 /*clock_cycles*/, u8& data) override
+    {
+        return state.receive(data);
+    }
+};
+
+struct Emulator;
+//! Connects two emulators in the same process, and runs them in lockstep.
+struct LinkCable
+{
+    Emulator* emulators[2] = { nullptr, nullptr };
+    InProcessLinkPort ports[2];
+
+    void connect(Emulator* a, Emulator* b);
+    void disconnect();
+    //! `true` if one transfer is started and not completed by both ends.
+    bool is_transfer_in_flight() const;
+    //! Runs both emulators for the specified number of clock cycles.
+    //! While no transfer is in flight, every emulator runs freely until it starts one transfer. While one
+    //! transfer is in flight, two emulators run alternately and never run more than `LINK_LOOKAHEAD_CYCLES`
+    //! ahead of each other, or `LINK_TRANSFER_CYCLES` ahead of one paused peer. If one emulator cannot
+    //! proceed without exceeding this limit, it stops early and catches up in the next call.
+    void run(u64 cycles);
+};
+
+//! The link port that connects to one emulator in another process using TCP.
+//! Clock cycles of two ends are measured from the first serial clock tick after the connection is
+//! established. When the master completes one transfer, it sends the byte with its clock cycles to the
+//! peer and keeps the transfer in progress until the peer replies, so the emulation thread is never
+//! blocked by the network. The peer handles the transfer on its emulation thread once its clock reaches
+//! the clock of the master, so that the slave state used is the state at the same emulated time. No
+//! synchronization happens while no transfer is in flight.
+struct SocketLinkPort : LinkPort
+{
+    u16 port = 0;
+    Ref<Network::ISocket> listen_socket;
+    Ref<Network::ISocket> socket;
+    Ref<IThread> receive_thread;
+    //! Serializes messages sent from the emulation thread and the receive thread.
+    SpinLock send_lock;
+
+    // Emulation thread states.
+
+    //! The clock cycles of the first serial clock tick after the connection is established.
+    u64 clock_origin = U64_MAX;
+    u16 next_sequence = 0;
+
+    // States shared with the receive thread, protected by `lock`.
+
+    SpinLock lock;
+    LinkEndState state;
+    //! `true` if the master is waiting for one reply.
+    bool waiting_reply = false;
+    u16 waiting_sequence = 0;
+    //! The ticks when the reply being waited is requested.
+    u64 waiting_ticks = 0;
+    bool has_reply = false;
+    u8 reply_data = 0xFF;
+    //! The transfer started by the peer and not handled yet.
+    bool has_request = false;
+    u8 request_data = 0;
+    u16 request_sequence = 0;
+    u64 request_cycles = 0;
+    bool connected = false;
+    bool exiting = false;
+
+    //! Listens on the specified port and accepts one peer in background.
+    RV host(u16 port);
+    //! Connects to one peer hosting on the specified IPv4 address and port.
+    RV connect(const c8* address, u16 port);
+    bool is_connected();
+    //! Closes the connection and waits for the receive thread to exit. This never waits longer than
+    //! `LINK_CLOSE_TIMEOUT` for the peer.
+    void close();
+    ~SocketLinkPort()
+    {
+        close();
+    }
+
+    virtual void set_slave_state(bool ready, u8 data) override;
+    virtual bool exchange(u64 clock_cycles, u8 data, u8& reply) override;
+    virtual bool poll_reply(u8& reply) override;
+    virtual bool receive(u64 clock_cycles, u8& data) override;
+
+    u64 get_link_cycles(u64 clock_cycles);
+    void send_message(u8 type, u8 data, u16 sequence, u64 cycles);
+    void receive_run();
+};
+
+//! Runs two emulators connected by one in-process link cable headlessly.
+RV run_linked_emulators(const c8* rom_path_a, const c8* rom_path_b, f64 seconds);
\ No newline at end of file
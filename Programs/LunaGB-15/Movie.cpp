@@ -0,0 +1,256 @@
+#include "Movie.hpp"
+#include "Emulator.hpp"
+#include "Cartridge.hpp"
+#include "RomCache.hpp"
+#include <Luna/Runtime/File.hpp>
+#include <Luna/Runtime/Log.hpp>
+#include <Luna/Runtime/Hash.hpp>
+#include <Luna/Runtime/Time.hpp>
+
+u64 hash_emulator_ram(Emulator* emu)
+{
+    u64 h = memhash64(emu->vram, 8_kb);
+    h = memhash64(emu->wram, 8_kb, h);
+    h = memhash64(emu->oam, 160, h);
+    h = memhash64(emu->hram, 128, h);
+    if(emu->cram)
+    {
+        h = memhash64(emu->cram, emu->cram_size, h);
+    }
+    return h;
+}
+void Movie::begin_recording(Emulator* emu, const Path& path)
+{
+    mode = MovieMode::recording;
+    this->path = path;
+    rom_hash = memhash64(emu->rom_data, emu->rom_data_size);
+    start_cram = emu->cram ? Blob(emu->cram, emu->cram_size) : Blob();
+    start_rtc = emu->rtc;
+    input_runs.clear();
+    checkpoints.clear();
+    num_frames = 0;
+    current_frame = 0;
+    next_frame_cycles = emu->clock_cycles;
+    input_buttons = emu->joypad.get_buttons();
+    applied_buttons = input_buttons;
+    finished = false;
+    desynced = false;
+}
+RV Movie::load(const Path& path)
+{
+    lutry
+    {
+        lulet(f, open_file(path.encode().c_str(), FileOpenFlag::read, FileCreationMode::open_existing));
+        MovieFileHeader header;
+        luexp(f->read(&header, sizeof(MovieFileHeader)));
+        if(memcmp(header.magic, "LGBMOVIE", 8) || header.version != MOVIE_FILE_VERSION)
+        {
+            return set_error(BasicError::bad_data(), "%s is not a valid LunaGB movie file.", path.encode().c_str());
+        }
+        this->path = path;
+        mode = MovieMode::playing;
+        checkpoint_interval = header.checkpoint_interval;
+        rom_hash = header.rom_hash;
+        num_frames = header.num_frames;
+        start_cram.clear();
+        if(header.cram_size)
+        {
+            start_cram.resize(header.cram_size, false);
+            luexp(f->read(start_cram.data(), header.cram_size));
+        }
+        luexp(f->read(&start_rtc, sizeof(RTC)));
+        input_runs.resize(header.num_input_runs);
+        luexp(f->read(input_runs.data(), sizeof(MovieInputRun) * header.num_input_runs));
+        u64 num_input_frames = 0;
+        for(const MovieInputRun& run : input_runs)
+        {
+            num_input_frames += run.num_frames;
+        }
+        if(num_input_frames != header.num_frames)
+        {
+            return set_error(BasicError::bad_data(), "%s is corrupted: %llu input frames are recorded for %llu frames.",
+                path.encode().c_str(), (unsigned long long)num_input_frames, (unsigned long long)header.num_frames);
+        }
+        checkpoints.resize(header.num_checkpoints);
+        luexp(f->read(checkpoints.data(), sizeof(MovieCheckpoint) * header.num_checkpoints));
+    }
+    lucatchret;
+    return ok;
+}
+RV Movie::begin_playing(Emulator* emu)
+{
+    luassert(mode == MovieMode::playing);
+    if(memhash64(emu->rom_data, emu->rom_data_size) != rom_hash)
+    {
+        return set_error(BasicError::bad_arguments(), "The movie is not recorded using this cartridge.");
+    }
+    if(start_cram.size() != emu->cram_size)
+    {
+        return set_error(BasicError::bad_data(), "The cartridge RAM size dismatched. Expected: %u, actual: %u", (u32)start_cram.size(), (u32)emu->cram_size);
+    }
+    if(emu->cram_size)
+    {
+        memcpy(emu->cram, start_cram.data(), emu->cram_size);
+    }
+    emu->rtc = start_rtc;
+    current_frame = 0;
+    next_frame_cycles = emu->clock_cycles;
+    input_run_index = 0;
+    input_run_frame = 0;
+    checkpoint_index = 0;
+    finished = false;
+    desynced = false;
+    return ok;
+}
+RV Movie::end()
+{
+    if(mode != MovieMode::recording) return ok;
+    lutry
+    {
+        lulet(f, open_file(path.encode().c_str(), FileOpenFlag::write, FileCreationMode::create_always));
+        MovieFileHeader header;
+        memcpy(header.magic, "LGBMOVIE", 8);
+        header.version = MOVIE_FILE_VERSION;
+        header.checkpoint_interval = checkpoint_interval;
+        header.rom_hash = rom_hash;
+        header.num_frames = num_frames;
+        header.cram_size = (u32)start_cram.size();
+        header.num_input_runs = (u32)input_runs.size();
+        header.num_checkpoints = (u32)checkpoints.size();
+        header.reserved = 0;
+        luexp(f->write(&header, sizeof(MovieFileHeader)));
+        if(!start_cram.empty())
+        {
+            luexp(f->write(start_cram.data(), start_cram.size()));
+        }
+        luexp(f->write(&start_rtc, sizeof(RTC)));
+        luexp(f->write(input_runs.data(), sizeof(MovieInputRun) * input_runs.size()));
+        luexp(f->write(checkpoints.data(), sizeof(MovieCheckpoint) * checkpoints.size()));
+        log_info("LunaGB", "Movie saved to %s, %llu frames, %u input runs.", path.encode().c_str(), num_frames, (u32)input_runs.size());
+    }
+    lucatchret;
+    return ok;
+}
+void Movie::latch_input(Emulator* emu)
+{
+    if(mode != MovieMode::recording) return;
+    input_buttons = emu->joypad.get_buttons();
+    emu->joypad.set_buttons(applied_buttons);
+}
+void Movie::on_frame(Emulator* emu)
+{
+    if(mode == MovieMode::recording)
+    {
+        record_frame(emu);
+    }
+    else
+    {
+        play_frame(emu);
+    }
+    if(finished || desynced)
+    {
+        // Stop receiving frame callbacks.
+        next_frame_cycles = U64_MAX;
+        return;
+    }
+    if(is_cart_timer(get_cartridge_header(emu->rom_data)->cartridge_type))
+    {
+        // Use emulated time rather than host time so that RTC is deterministic.
+        emu->rtc.update((f64)MOVIE_FRAME_CYCLES / CLOCK_FREQUENCY);
+    }
+    ++current_frame;
+    next_frame_cycles += MOVIE_FRAME_CYCLES;
+}
+void Movie::record_frame(Emulator* emu)
+{
+    if(current_frame % checkpoint_interval == 0)
+    {
+        MovieCheckpoint checkpoint;
+        checkpoint.frame = current_frame;
+        checkpoint.frame_hash = memhash64(emu->get_front_buffer(), PPU_XRES * PPU_YRES * 4);
+        checkpoint.ram_hash = hash_emulator_ram(emu);
+        checkpoints.push_back(checkpoint);
+    }
+    u8 buttons = input_buttons;
+    if(input_runs.empty() || input_runs.back().buttons != buttons || input_runs.back().num_frames == U16_MAX)
+    {
+        MovieInputRun run;
+        run.num_frames = 1;
+        run.buttons = buttons;
+        run.reserved = 0;
+        input_runs.push_back(run);
+    }
+    else
+    {
+        ++input_runs.back().num_frames;
+    }
+    applied_buttons = buttons;
+    emu->joypad.set_buttons(buttons);
+    emu->joypad.update(emu);
+    num_frames = current_frame + 1;
+}
+void Movie::play_frame(Emulator* emu)
+{
+    if(current_frame >= num_frames || input_run_index >= input_runs.size())
+    {
+        finished = true;
+        return;
+    }
+    if(checkpoint_index < checkpoints.size() && checkpoints[checkpoint_index].frame == current_frame)
+    {
+        const MovieCheckpoint& checkpoint = checkpoints[checkpoint_index];
+        u64 frame_hash = memhash64(emu->get_front_buffer(), PPU_XRES * PPU_YRES * 4);
+        u64 ram_hash = hash_emulator_ram(emu);
+        if(frame_hash != checkpoint.frame_hash || ram_hash != checkpoint.ram_hash)
+        {
+            log_error("LunaGB", "Movie desynced at frame %llu: frame hash %016llX (expected %016llX), RAM hash %016llX (expected %016llX).",
+                current_frame, frame_hash, checkpoint.frame_hash, ram_hash, checkpoint.ram_hash);
+            desynced = true;
+            return;
+        }
+        ++checkpoint_index;
+    }
+    const MovieInputRun& run = input_runs[input_run_index];
+    emu->joypad.set_buttons(run.buttons);
+    ++input_run_frame;
+    if(input_run_frame >= run.num_frames)
+    {
+        ++input_run_index;
+        input_run_frame = 0;
+    }
+    emu->joypad.update(emu);
+}
+RV replay_movie(const c8* rom_path, const c8* movie_path)
+{
+    lutry
+    {
+        lulet(rom, open_rom(rom_path));
+        UniquePtr<Movie> movie(memnew<Movie>());
+        luexp(movie->load(movie_path));
+        UniquePtr<Emulator> emu(memnew<Emulator>());
+        // Pass empty cartridge path so that cartridge RAM data is restored from the movie.
+        luexp(emu->init(Path(), rom));
+        luexp(movie->begin_playing(emu.get()));
+        Movie* m = movie.get();
+        emu->movie = move(movie);
+        u64 begin_ticks = get_ticks();
+        while(!m->finished && !m->desynced && !emu->paused)
+        {
+            emu->cpu.step(emu.get());
+        }
+        f64 time = (f64)(get_ticks() - begin_ticks) / get_ticks_per_second();
+        f64 emulated_time = (f64)emu->clock_cycles / CLOCK_FREQUENCY;
+        log_info("LunaGB", "%llu frames replayed in %f seconds (%.1fx realtime).", m->current_frame, time, emulated_time / time);
+        if(m->desynced)
+        {
+            return set_error(BasicError::failure(), "Movie desynced at frame %llu.", m->current_frame);
+        }
+        if(!m->finished)
+        {
+            return set_error(BasicError::failure(), "Emulation stopped at frame %llu.", m->current_frame);
+        }
+        log_info("LunaGB", "All %u checkpoints matched.", (u32)m->checkpoints.size());
+    }
+    lucatchret;
+    return ok;
+}
\ No newline at end of file
@@ -0,0 +1,118 @@
+#pragma once
+#include <Luna/Runtime/Result.hpp>
+#include <Luna/Runtime/Path.hpp>
+#include <Luna/Runtime/Vector.hpp>
+#include <Luna/Runtime/Blob.hpp>
+#include "RTC.hpp"
+using namespace Luna;
+
+//! The number of clock cycles of one movie frame. Inputs are applied at movie frame boundaries
+//! rather than host frame boundaries, so that the same input sequence always produces the same
+//! emulation result regardless of the host frame rate.
+constexpr u64 MOVIE_FRAME_CYCLES = 70224;
+constexpr u32 MOVIE_FILE_VERSION = 1;
+
+//! One run of frames that have the same joypad state.
+struct MovieInputRun
+{
+    u16 num_frames;
+    //! The joypad state, see `Joypad::get_buttons`.
+    u8 buttons;
+    u8 reserved;
+};
+
+//! The emulator state hashes captured when recording.
+struct MovieCheckpoint
+{
+    u64 frame;
+    //! The hash of the front buffer of PPU.
+    u64 frame_hash;
+    //! The hash of VRAM, WRAM, OAM, HRAM and cartridge RAM.
+    u64 ram_hash;
+};
+
+//! The header written at the beginning of every movie file.
+//! The header is followed by the cartridge RAM data, the RTC state, input runs and checkpoints.
+struct MovieFileHeader
+{
+    //! Always "LGBMOVIE".
+    c8 magic[8];
+    u32 version;
+    //! The number of frames between two checkpoints.
+    u32 checkpoint_interval;
+    //! The hash of the cartridge ROM data.
+    u64 rom_hash;
+    //! The number of frames recorded.
+    u64 num_frames;
+    u32 cram_size;
+    u32 num_input_runs;
+    u32 num_checkpoints;
+    u32 reserved;
+};
+
+enum class MovieMode : u8
+{
+    recording,
+    playing
+};
+
+struct Emulator;
+struct Movie
+{
+    MovieMode mode = MovieMode::recording;
+    //! The movie file path. The movie is written to this path when recording ends.
+    Path path;
+
+    u64 rom_hash = 0;
+    u32 checkpoint_interval = 60;
+    //! The cartridge RAM data when the movie starts.
+    Blob start_cram;
+    //! The RTC state when the movie starts.
+    RTC start_rtc;
+    Vector<MovieInputRun> input_runs;
+    Vector<MovieCheckpoint> checkpoints;
+    u64 num_frames = 0;
+
+    // Runtime states.
+
+    //! The index of the next frame to begin.
+    u64 current_frame = 0;
+    //! The clock cycles when the next frame begins.
+    u64 next_frame_cycles = 0;
+    usize input_run_index = 0;
+    u32 input_run_frame = 0;
+    usize checkpoint_index = 0;
+    //! Recording: The joypad state set by the host, latched in `latch_input`.
+    u8 input_buttons = 0;
+    //! Recording: The joypad state applied at the last frame boundary.
+    u8 applied_buttons = 0;
+    //! `true` if all frames are played.
+    bool finished = false;
+    //! `true` if one checkpoint mismatched when playing.
+    bool desynced = false;
+
+    //! Starts recording. This should be called right after the emulator is initialized.
+    void begin_recording(Emulator* emu, const Path& path);
+    //! Loads one movie file for playing.
+    RV load(const Path& path);
+    //! Starts playing the loaded movie. This should be called right after the emulator is initialized
+    //! without cartridge path, so that cartridge RAM data is restored from the movie.
+    RV begin_playing(Emulator* emu);
+    //! Ends the movie. If the movie is recording, writes the movie file.
+    RV end();
+    //! Latches the joypad state set by the host, and restores the joypad state that is applied
+    //! at the last frame boundary, so that host input only takes effect at frame boundaries.
+    //! This is called by the emulator before running one update.
+    void latch_input(Emulator* emu);
+    //! Called by the emulator when `clock_cycles` reaches `next_frame_cycles`.
+    void on_frame(Emulator* emu);
+
+    void record_frame(Emulator* emu);
+    void play_frame(Emulator* emu);
+};
+
+//! Computes the hash of all emulator RAM.
+u64 hash_emulator_ram(Emulator* emu);
+
+//! Replays one movie headlessly as fast as possible and validates all checkpoints.
+RV replay_movie(const c8* rom_path, const c8* movie_path);
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "PPU.hpp"
 #include "Emulator.hpp"
+#include "LineCompositor.hpp"
 
 void PPU::increase_ly(Emulator* emu)
 {
@@ -42,8 +43,14 @@ void PPU::init()
     dma_offset = 0;
     dma_start_delay = 0;
     line_cycles = 0;
-    memzero(pixels, sizeof(pixels));
+    bgw_queue.clear();
+    obj_queue.clear();
+    num_sprites = 0;
+    deferred_line = false;
+    memzero(&line_pixels, sizeof(line_pixels));
     current_back_buffer = 0;
+    back_buffer_changed = false;
+    frame_count = 0;
 }
 void PPU::tick(Emulator* emu)
 {
@@ -72,11 +79,16 @@ u8 PPU::bus_read(u16 addr)
     luassert(addr >= 0xFF40 && addr <= 0xFF4B);
     return ((u8*)(&lcdc))[addr - 0xFF40];
 }
-void PPU::bus_write(u16 addr, u8 data)
+void PPU::bus_write(Emulator* emu, u16 addr, u8 data)
 {
     luassert(addr >= 0xFF40 && addr <= 0xFF4B);
     if(addr == 0xFF40 && enabled() && !bit_test(&data, 7))
     {
+        if(get_mode() == PPUMode::drawing && draw_x)
+        {
+            // Outputs pixels drawn before LCD is disabled.
+            composite_line_pixels(emu->frame_buffers.data(), draw_x);
+        }
         // Reset mode to HBLANK.
         lcds &= 0x7C;
         // Reset LY.
@@ -116,23 +128,25 @@ void PPU::tick_oam_scan(Emulator* emu)
     if(line_cycles >= 80)
     {
         set_mode(PPUMode::drawing);
-        fetch_window = false;
-        fetch_state = PPUFetchState::tile;
-        fetch_x = 0;
-        push_x = 0;
-        draw_x = 0;
+        begin_drawing();
+        // Pixels left in queues (when LCD is disabled during drawing) are drawn by this line, so
+        // such lines are always drawn inline.
+        deferred_line = emu->ppu_renderer && bgw_queue.empty() && obj_queue.empty();
+        if(deferred_line)
+        {
+            drawing_end_cycles = compute_drawing_end_cycles();
+        }
     }
     // Can be any tick between 0 and 79. 
     // The real PPU finishes OAM scanning in 80 cycles, but we can do it in one cycle.
     if(line_cycles == 1)
     {
-        sprites.clear();
-        sprites.reserve(10);
+        num_sprites = 0;
         u8 sprite_height = obj_height();
         // Scan all 40 entries.
         for(u8 i = 0; i < 40; ++i)
         {
-            if(sprites.size() >= 10)
+            if(num_sprites >= PPU_MAX_SPRITES_PER_LINE)
             {
                 // We can hold at most 10 sprites per line.
                 break;
@@ -141,18 +155,32 @@ void PPU::tick_oam_scan(Emulator* emu)
             // Check if this sprite is in this scanline.
             if(entry->y <= ly + 16 && entry->y + sprite_height > ly + 16)
             {
-                auto iter = sprites.begin();
-                while(iter != sprites.end())
+                u8 pos = 0;
+                while(pos < num_sprites)
                 {
-                    if(iter->x > entry->x) break;
-                    ++iter;
+                    if(sprites[pos].x > entry->x) break;
+                    ++pos;
                 }
-                sprites.insert(iter, *entry);
+                for(u8 j = num_sprites; j > pos; --j)
+                {
+                    sprites[j] = sprites[j - 1];
+                }
+                sprites[pos] = *entry;
+                ++num_sprites;
             }
         }
     }
 }
-void PPU::tick_drawing(Emulator* emu)
+void PPU::begin_drawing()
+{
+    fetch_window = false;
+    fetch_state = PPUFetchState::tile;
+    fetch_x = 0;
+    push_x = 0;
+    draw_x = 0;
+}
+template <bool _Pixels>
+bool PPU::tick_drawing_cycle(const byte_t* vram, u8* frame_buffers)
 {
     // The fetcher is ticked once per 2 cycles.
     if((line_cycles % 2) == 0)
@@ -160,31 +188,91 @@ void PPU::tick_drawing(Emulator* emu)
         switch(fetch_state)
         {
             case PPUFetchState::tile:
-                fetcher_get_tile(emu); break;
+                fetcher_get_tile<_Pixels>(vram); break;
             case PPUFetchState::data0:
-                fetcher_get_data(emu, 0); break;
+                fetcher_get_data<_Pixels>(vram, 0); break;
             case PPUFetchState::data1:
-                fetcher_get_data(emu, 1); break;
+                fetcher_get_data<_Pixels>(vram, 1); break;
             case PPUFetchState::idle:
                 fetch_state = PPUFetchState::push; break;
             case PPUFetchState::push:
-                fetcher_push_pixels(); break;
+                fetcher_push_pixels<_Pixels>(); break;
             default: lupanic(); break;
         }
         if(draw_x >= PPU_XRES)
         {
             luassert(line_cycles >= 252 && line_cycles <= 369);
-            set_mode(PPUMode::hblank);
-            if(hblank_int_enabled())
+            if constexpr(_Pixels)
             {
-                emu->int_flags |= INT_LCD_STAT;
+                composite_line_pixels(frame_buffers, PPU_XRES);
             }
-            bgw_queue.clear();
-            obj_queue.clear();
+            return true;
         }
     }
     // LCD driver is ticked once per cycle.
-    lcd_draw_pixel();
+    lcd_draw_pixel<_Pixels>();
+    return false;
+}
+u32 PPU::compute_drawing_end_cycles()
+{
+    // Runs the fetcher without reading VRAM and producing pixels. The length of drawing mode
+    // only depends on registers, which are not changed until the line is drawn inline.
+    u32 begin_cycles = line_cycles;
+    do
+    {
+        ++line_cycles;
+    } while(!tick_drawing_cycle<false>(nullptr, nullptr));
+    u32 end_cycles = line_cycles;
+    line_cycles = begin_cycles;
+    begin_drawing();
+    bgw_queue.clear();
+    return end_cycles;
+}
+void PPU::draw_line(const byte_t* vram, u8* frame_buffers)
+{
+    begin_drawing();
+    bgw_queue.clear();
+    obj_queue.clear();
+    line_cycles = 80;
+    do
+    {
+        ++line_cycles;
+    } while(!tick_drawing_cycle<true>(vram, frame_buffers));
+}
+void PPU::draw_deferred_line_inline(Emulator* emu)
+{
+    luassert(deferred_line && get_mode() == PPUMode::drawing);
+    deferred_line = false;
+    // Draws pixels from the beginning of the line to the current cycle.
+    u32 cycles = line_cycles;
+    begin_drawing();
+    line_cycles = 80;
+    while(line_cycles < cycles)
+    {
+        ++line_cycles;
+        bool end = tick_drawing_cycle<true>(emu->vram, emu->frame_buffers.data());
+        luassert(!end);
+        (void)end;
+    }
+}
+void PPU::tick_drawing(Emulator* emu)
+{
+    bool end = deferred_line ? (line_cycles == drawing_end_cycles) : tick_drawing_cycle<true>(emu->vram, emu->frame_buffers.data());
+    if(end)
+    {
+        set_mode(PPUMode::hblank);
+        if(hblank_int_enabled())
+        {
+            emu->int_flags |= INT_LCD_STAT;
+        }
+        bgw_queue.clear();
+        obj_queue.clear();
+        if(deferred_line)
+        {
+            emu->ppu_renderer->submit_line(*this);
+            deferred_line = false;
+        }
+    }
 }
 void PPU::tick_hblank(Emulator* emu)
 {
@@ -195,11 +283,30 @@ void PPU::tick_hblank(Emulator* emu)
         {
             set_mode(PPUMode::vblank);
             emu->int_flags |= INT_VBLANK;
+            if(emu->cheats)
+            {
+                emu->cheats->apply_ram_pokes(emu);
+            }
             if(vblank_int_enabled())
             {
                 emu->int_flags |= INT_LCD_STAT;
             }
+            if(emu->ppu_renderer)
+            {
+                // Waits for lines drawn by the render worker before presenting the frame.
+                emu->ppu_renderer->sync(emu);
+            }
             current_back_buffer = (current_back_buffer + 1) % 2;
+            if(back_buffer_changed)
+            {
+                back_buffer_changed = false;
+                ++emu->display_version;
+            }
+            ++frame_count;
+            if(emu->video_capture)
+            {
+                emu->video_capture->on_frame(emu->get_front_buffer());
+            }
         }
         else
         {
@@ -231,7 +338,8 @@ void PPU::tick_vblank(Emulator* emu)
         line_cycles = 0;
     }
 }
-void PPU::fetcher_get_background_tile(Emulator* emu)
+template <bool _Pixels>
+void PPU::fetcher_get_background_tile(const byte_t* vram)
 {
     // The y position of the next pixel to fetch relative to 256x256 tile map origin.
     u8 map_y = ly + scroll_y;
@@ -239,52 +347,59 @@ void PPU::fetcher_get_background_tile(Emulator* emu)
     u8 map_x = fetch_x + scroll_x;
     // The address to read map index.
     // ((map_y / 8) * 32) : 32 bytes per row in tile maps.
-    u16 addr = bg_map_area() + (map_x / 8) + ((map_y / 8) * 32);
-    // Read tile index.
-    u8 tile_index = emu->bus_read(addr);
-    if(bgw_data_area() == 0x8800)
-    {
-        // If LCDC.4=0, then range 0x9000~0x97FF is mapped to [0, 127], and range 0x8800~0x8FFF is mapped to [128, 255].
-        // We can achieve this by simply add 128 to the fetched data, which will overflow and reset the value if greater 
-        // than 127.
-        tile_index += 128;
+    if constexpr(_Pixels)
+    {
+        u16 addr = bg_map_area() + (map_x / 8) + ((map_y / 8) * 32);
+        // Read tile index.
+        u8 tile_index = vram[addr - 0x8000];
+        if(bgw_data_area() == 0x8800)
+        {
+            // If LCDC.4=0, then range 0x9000~0x97FF is mapped to [0, 127], and range 0x8800~0x8FFF is mapped to [128, 255].
+            // We can achieve this by simply add 128 to the fetched data, which will overflow and reset the value if greater 
+            // than 127.
+            tile_index += 128;
+        }
+        // Calculate data address offset from bgw data area beginning.
+        // tile_index * 16 : every tile takes 16 bytes.
+        // (map_y % 8) * 2 : every row takes 2 bytes.
+        bgw_data_addr_offset = ((u16)tile_index * 16) + (u16)(map_y % 8) * 2;
     }
-    // Calculate data address offset from bgw data area beginning.
-    // tile_index * 16 : every tile takes 16 bytes.
-    // (map_y % 8) * 2 : every row takes 2 bytes.
-    bgw_data_addr_offset = ((u16)tile_index * 16) + (u16)(map_y % 8) * 2;
     // Calculate tile X position.
     i32 tile_x = (i32)(fetch_x) + (i32)(scroll_x);
     tile_x = (tile_x / 8) * 8 - (i32)scroll_x;
     tile_x_begin = (i16)tile_x;
 }
-void PPU::fetcher_get_window_tile(Emulator* emu)
+template <bool _Pixels>
+void PPU::fetcher_get_window_tile(const byte_t* vram)
 {
-    u8 window_x = (fetch_x + 7 - wx);
-    u8 window_y = window_line;
-    u16 window_addr = window_map_area() + (window_x / 8) + ((window_y / 8) * 32);
-    u8 tile_index = emu->bus_read(window_addr);
-    if(bgw_data_area() == 0x8800)
-    {
-        // If LCDC.4=0, then range 0x9000~0x97FF is mapped to [0, 127], and range 0x8800~0x8FFF is mapped to [128, 255].
-        // We can achieve this by simply add 128 to the fetched data, which will overflow and reset the value if greater 
-        // than 127.
-        tile_index += 128;
+    if constexpr(_Pixels)
+    {
+        u8 window_x = (fetch_x + 7 - wx);
+        u8 window_y = window_line;
+        u16 window_addr = window_map_area() + (window_x / 8) + ((window_y / 8) * 32);
+        u8 tile_index = vram[window_addr - 0x8000];
+        if(bgw_data_area() == 0x8800)
+        {
+            // If LCDC.4=0, then range 0x9000~0x97FF is mapped to [0, 127], and range 0x8800~0x8FFF is mapped to [128, 255].
+            // We can achieve this by simply add 128 to the fetched data, which will overflow and reset the value if greater 
+            // than 127.
+            tile_index += 128;
+        }
+        // Calculate data address offset from bgw data area beginning.
+        // tile_index * 16 : every tile takes 16 bytes.
+        // (window_tile_y % 8) * 2 : every row takes 2 bytes.
+        bgw_data_addr_offset = ((u16)tile_index * 16) + (u16)(window_y % 8) * 2;
     }
-    // Calculate data address offset from bgw data area beginning.
-    // tile_index * 16 : every tile takes 16 bytes.
-    // (window_tile_y % 8) * 2 : every row takes 2 bytes.
-    bgw_data_addr_offset = ((u16)tile_index * 16) + (u16)(window_y % 8) * 2;
     // Calculate tile X position.
     i32 tile_x = (i32)(fetch_x) - ((i32)(wx) - 7);
     tile_x = (tile_x / 8) * 8 + (i32)(wx) - 7;
     tile_x_begin = (i16)tile_x;
 }
-void PPU::fetcher_get_sprite_tile(Emulator* emu)
+void PPU::fetcher_get_sprite_tile()
 {
     num_fetched_sprites = 0;
     // Load this sprite tile.
-    for(u8 i = 0; i < (u8)sprites.size(); ++i)
+    for(u8 i = 0; i < num_sprites; ++i)
     {
         i32 sp_x = (i32)sprites[i].x - 8;
         // If the first or last pixel of the sprite row falls in this fetch 
@@ -301,7 +416,7 @@ void PPU::fetcher_get_sprite_tile(Emulator* emu)
         }
     }
 }
-void PPU::fetcher_get_sprite_data(Emulator* emu, u8 data_index)
+void PPU::fetcher_get_sprite_data(const byte_t* vram, u8 data_index)
 {
     u8 sprite_height = obj_height();
     for(u8 i = 0; i < num_fetched_sprites; ++i)
@@ -317,9 +432,10 @@ void PPU::fetcher_get_sprite_data(Emulator* emu, u8 data_index)
         {
             tile &= 0xFE; // Clear the last 1 bit if in double tile mode.
         }
-        sprite_fetched_data[(i * 2) + data_index] = emu->bus_read(0x8000 + (tile * 16) + ty * 2 + data_index);
+        sprite_fetched_data[(i * 2) + data_index] = vram[(tile * 16) + ty * 2 + data_index];
     }
 }
+template <bool _Pixels>
 void PPU::fetcher_push_bgw_pixels()
 {
     // Load tile data.
@@ -345,7 +461,13 @@ void PPU::fetcher_push_bgw_pixels()
         }
         // Now we can stream pixel.
         BGWPixel pixel;
-        if(bg_window_enable())
+        if(!_Pixels)
+        {
+            // Only the number of pixels is used.
+            pixel.color = 0;
+            pixel.palette = 0;
+        }
+        else if(bg_window_enable())
         {
             u8 b = 7 - i;
             u8 lo = (!!(b1 & (1 << b)));
@@ -407,52 +529,61 @@ void PPU::fetcher_push_sprite_pixels(u8 push_begin, u8 push_end)
         obj_queue.push_back(pixel);
     }
 }
-void PPU::fetcher_get_tile(Emulator* emu)
+template <bool _Pixels>
+void PPU::fetcher_get_tile(const byte_t* vram)
 {
     if(bg_window_enable())
     {
         if(fetch_window)
         {
-            fetcher_get_window_tile(emu);
+            fetcher_get_window_tile<_Pixels>(vram);
         }
         else
         {
-            fetcher_get_background_tile(emu);
+            fetcher_get_background_tile<_Pixels>(vram);
         }
     }
     else
     {
         tile_x_begin = fetch_x;
     }
-    if(obj_enable())
+    if(_Pixels && obj_enable())
     {
-        fetcher_get_sprite_tile(emu);
+        fetcher_get_sprite_tile();
     }
     fetch_state = PPUFetchState::data0;
     fetch_x += 8;
 }
-void PPU::fetcher_get_data(Emulator* emu, u8 data_index)
+template <bool _Pixels>
+void PPU::fetcher_get_data(const byte_t* vram, u8 data_index)
 {
-    if(bg_window_enable())
+    if constexpr(_Pixels)
     {
-        bgw_fetched_data[data_index] = emu->bus_read(bgw_data_area() + bgw_data_addr_offset + data_index);
-    }
-    if(obj_enable())
-    {
-        fetcher_get_sprite_data(emu, data_index);
+        if(bg_window_enable())
+        {
+            bgw_fetched_data[data_index] = vram[bgw_data_area() - 0x8000 + bgw_data_addr_offset + data_index];
+        }
+        if(obj_enable())
+        {
+            fetcher_get_sprite_data(vram, data_index);
+        }
     }
     if(data_index == 0) fetch_state = PPUFetchState::data1;
     else fetch_state = PPUFetchState::idle;
 }
+template <bool _Pixels>
 void PPU::fetcher_push_pixels()
 {
     bool pushed = false;
     if(bgw_queue.size() < 8)
     {
         u8 push_begin = push_x;
-        fetcher_push_bgw_pixels();
+        fetcher_push_bgw_pixels<_Pixels>();
         u8 push_end = push_x;
-        fetcher_push_sprite_pixels(push_begin, push_end);
+        if constexpr(_Pixels)
+        {
+            fetcher_push_sprite_pixels(push_begin, push_end);
+        }
         pushed = true;
     }
     if(pushed)
@@ -460,46 +591,43 @@ void PPU::fetcher_push_pixels()
         fetch_state = PPUFetchState::tile;
     }
 }
-inline u8 apply_palette(u8 color, u8 palette)
-{
-    switch(color)
-    {
-        case 0: color = palette & 0x03; break;
-        case 1: color = ((palette >> 2) & 0x03); break;
-        case 2: color = ((palette >> 4) & 0x03); break;
-        case 3: color = ((palette >> 6) & 0x03); break;
-        default: lupanic(); break;
-    }
-    return color;
-}
+template <bool _Pixels>
 void PPU::lcd_draw_pixel()
 {
     // The LCD driver is drived by BGW queue only, it works when at least 8 pixels are in BGW queue.
     if(bgw_queue.size() >= 8) 
     {
         if (draw_x >= PPU_XRES) return;
+        if constexpr(!_Pixels)
+        {
+            // Object pixels are not pushed.
+            bgw_queue.pop_front();
+            ++draw_x;
+            return;
+        }
         BGWPixel bgw_pixel = bgw_queue.front();
         bgw_queue.pop_front();
         ObjectPixel obj_pixel = obj_queue.front();
         obj_queue.pop_front();
-        // Calculate background color.
-        u8 bg_color = apply_palette(bgw_pixel.color, bgw_pixel.palette);
-        // Draw object if:
-        // 1. Color index is not 0 (transparent) and:
-        // 2. Background priority is not greater than object priority, or the background color is 00.
-        bool draw_obj = obj_pixel.color && (!obj_pixel.bg_priority || bg_color == 0);
-        // Calculate obj color.
-        u8 obj_color = apply_palette(obj_pixel.color, obj_pixel.palette & 0xFC);
-        // Selects the final color.
-        u8 color = draw_obj ? obj_color : bg_color;
-        // Output pixel.
-        switch(color)
-        {
-            case 0: set_pixel(draw_x, ly, 153, 161, 120, 255); break;
-            case 1: set_pixel(draw_x, ly, 87, 93, 67, 255); break;
-            case 2: set_pixel(draw_x, ly, 42, 46, 32, 255); break;
-            case 3: set_pixel(draw_x, ly, 10, 10, 2, 255); break;
-        }
+        // Palettes and priority are applied for the whole line in `composite_line_pixels`.
+        line_pixels.bgw_colors[draw_x] = bgw_pixel.color;
+        line_pixels.bgw_palettes[draw_x] = bgw_pixel.palette;
+        line_pixels.obj_colors[draw_x] = obj_pixel.color;
+        line_pixels.obj_palettes[draw_x] = obj_pixel.palette & 0xFC;
+        line_pixels.obj_bg_priorities[draw_x] = obj_pixel.bg_priority ? 1 : 0;
         ++draw_x;
     }
+}
+void PPU::composite_line_pixels(u8* frame_buffers, u32 num_pixels)
+{
+    luassert(ly < PPU_YRES);
+    usize line_offset = (usize)ly * PPU_XRES * 4;
+    u8* dst = frame_buffers + current_back_buffer * PPU_FRAME_SIZE + line_offset;
+    composite_line(line_pixels, dst, num_pixels);
+    if(!back_buffer_changed)
+    {
+        // Lines partially drawn are always treated as changed.
+        const u8* front = frame_buffers + ((current_back_buffer + 1) % 2) * PPU_FRAME_SIZE + line_offset;
+        back_buffer_changed = num_pixels != PPU_XRES || memcmp(dst, front, PPU_XRES * 4) != 0;
+    }
 }
\ No newline at end of file
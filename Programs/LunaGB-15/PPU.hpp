@@ -1,6 +1,5 @@
 #pragma once
-#include <Luna/Runtime/RingDeque.hpp>
-#include <Luna/Runtime/Vector.hpp>
+#include <Luna/Runtime/MemoryUtils.hpp>
 
 using namespace Luna;
 
@@ -54,10 +53,74 @@ struct ObjectPixel
 };
 static_assert(sizeof(OAMEntry) == 4, "Wrong OAM entry size");
 
+//! The fixed-capacity FIFO queue used by the pixel fetcher.
+//! The fetcher pushes 8 pixels only when less than 8 pixels are in the queue, so the queue never
+//! holds more than 15 pixels. Storing pixels inline keeps PPU trivially copyable, so that PPU state
+//! can be saved and restored with `memcpy`.
+template <typename _Ty>
+struct PixelFIFO
+{
+    static constexpr u8 CAPACITY = 16;
+    _Ty m_buffer[CAPACITY];
+    u8 m_begin;
+    u8 m_size;
+
+    u8 size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    void clear()
+    {
+        m_begin = 0;
+        m_size = 0;
+    }
+    const _Ty& front() const
+    {
+        luassert(m_size);
+        return m_buffer[m_begin];
+    }
+    void push_back(const _Ty& value)
+    {
+        luassert(m_size < CAPACITY);
+        m_buffer[(m_begin + m_size) % CAPACITY] = value;
+        ++m_size;
+    }
+    void pop_front()
+    {
+        luassert(m_size);
+        m_begin = (m_begin + 1) % CAPACITY;
+        --m_size;
+    }
+};
+
 constexpr u32 PPU_LINES_PER_FRAME = 154;
 constexpr u32 PPU_CYCLES_PER_LINE = 456;
 constexpr u32 PPU_YRES = 144;
 constexpr u32 PPU_XRES = 160;
+//! The size of one RGBA frame in bytes.
+constexpr usize PPU_FRAME_SIZE = PPU_XRES * PPU_YRES * 4;
+//! The RGB color of every shade, from the lightest (0) to the darkest (3).
+constexpr u8 PPU_SHADE_COLORS[4][3] = {
+    {153, 161, 120},
+    {87, 93, 67},
+    {42, 46, 32},
+    {10, 10, 2}
+};
+//! The maximum number of sprites that can be displayed on one scan line.
+constexpr u8 PPU_MAX_SPRITES_PER_LINE = 10;
+//! The pixels drawn by the LCD driver for the current line before palettes and priority are
+//! applied. Pixels are composited to RGBA when the line is completed.
+struct PPULinePixels
+{
+    //! The background/window color indices.
+    u8 bgw_colors[PPU_XRES];
+    //! The background palettes.
+    u8 bgw_palettes[PPU_XRES];
+    //! The object color indices, 0 if no object covers the pixel.
+    u8 obj_colors[PPU_XRES];
+    //! The object palettes with the lower 2 bits cleared.
+    u8 obj_palettes[PPU_XRES];
+    //! 1 if the background has priority over the object, 0 otherwise.
+    u8 obj_bg_priorities[PPU_XRES];
+};
 struct Emulator;
 struct PPU
 {
@@ -95,9 +158,9 @@ struct PPU
     //! The number of cycles used for this scan line.
     u32 line_cycles;
     //! The FIFO queue for background/window pixels.
-    RingDeque<BGWPixel> bgw_queue;
+    PixelFIFO<BGWPixel> bgw_queue;
     //! The FIFO queue for objects (sprites).
-    RingDeque<ObjectPixel> obj_queue;
+    PixelFIFO<ObjectPixel> obj_queue;
     //! true when we are fetching window tiles.
     //! false when we are fetching background tiles.
     bool fetch_window;
@@ -115,7 +178,8 @@ struct PPU
     //! May be negative if scroll_x is not times of 8.
     i16 tile_x_begin;
     //! The loaded sprite data during OAM scan stage, sorted by their X position.
-    Vector<OAMEntry> sprites;
+    OAMEntry sprites[PPU_MAX_SPRITES_PER_LINE];
+    u8 num_sprites;
     //! The sprites used in the current fetch.
     OAMEntry fetched_sprites[3];
     u8 num_fetched_sprites;
@@ -128,22 +192,24 @@ struct PPU
     //! The X position of the next pixel to draw to the back buffer in screen coordinates.
     //! If draw_x >= PPU_XRES then all pixels are drawn, so we can start HBLANK.
     u8 draw_x;
-    //! Contains the pixel data that should be displayed in the application.
-    //! Every pixel of the data is represented by four bytes, arranged in RGBA order.
+    //! `true` if pixels of the current line are drawn by `Emulator::ppu_renderer` when the line
+    //! ends. Set when drawing starts, and cleared if the line must be drawn inline.
+    bool deferred_line;
+    //! The value of `line_cycles` when drawing of the current deferred line ends.
+    u32 drawing_end_cycles;
+    //! The index of the frame buffer being drawn, see `Emulator::frame_buffers`.
     //! We use double buffer to prevent tearing when presenting frames.
-    u8 pixels[PPU_XRES * PPU_YRES * 4 * 2];
     u8 current_back_buffer;
-    void set_pixel(i32 x, i32 y, u8 r, u8 g, u8 b, u8 a)
-    {
-        luassert(x >= 0 || x < PPU_XRES);
-        luassert(y >= 0 || y < PPU_YRES);
-        u8* dst = pixels + current_back_buffer * PPU_XRES * PPU_YRES * 4;
-        u8* pixel = (u8*)pixel_offset(dst, (usize)x, (usize)y, 4, 4 * PPU_XRES);
-        pixel[0] = r;
-        pixel[1] = g;
-        pixel[2] = b;
-        pixel[3] = a;
-    }
+    //! `true` if any line drawn to the back buffer in this frame differs from the same line of the
+    //! front buffer. Checked and cleared when the frame is completed.
+    bool back_buffer_changed;
+    //! The number of frames completed since the PPU is initialized.
+    u64 frame_count;
+    //! The pixels drawn for the current line.
+    PPULinePixels line_pixels;
+    //! Composites the first `num_pixels` pixels of `line_pixels` to the current line of the back
+    //! buffer in `frame_buffers`, and compares the line with the front buffer.
+    void composite_line_pixels(u8* frame_buffers, u32 num_pixels);
 
     bool enabled() const { return bit_test(&lcdc, 7); }
     
@@ -194,7 +260,7 @@ struct PPU
     void init();
     void tick(Emulator* emu);
     u8 bus_read(u16 addr);
-    void bus_write(u16 addr, u8 data);
+    void bus_write(Emulator* emu, u16 addr, u8 data);
     
     void tick_dma(Emulator* emu);
     void tick_oam_scan(Emulator* emu);
@@ -202,16 +268,42 @@ struct PPU
     void tick_hblank(Emulator* emu);
     void tick_vblank(Emulator* emu);
 
-    void fetcher_get_background_tile(Emulator* emu);
-    void fetcher_get_window_tile(Emulator* emu);
-    void fetcher_get_sprite_tile(Emulator* emu);
-    void fetcher_get_sprite_data(Emulator* emu, u8 data_index);
+    //! Resets the fetcher for one new scan line.
+    void begin_drawing();
+    //! Ticks the fetcher and the LCD driver for one drawing cycle. Returns `true` if all pixels
+    //! of this line are pushed and HBLANK should be started.
+    //! @param[in] vram The VRAM data the fetcher reads from.
+    //! @param[in] frame_buffers The frame buffers to draw the line to, see `Emulator::frame_buffers`.
+    //! If `_Pixels` is `false`, only the timing of the fetcher is emulated, VRAM is not read
+    //! and no pixel is drawn.
+    template <bool _Pixels>
+    bool tick_drawing_cycle(const byte_t* vram, u8* frame_buffers);
+    //! Computes the `line_cycles` value when drawing of the current line ends without changing
+    //! the fetcher state. Called when drawing starts.
+    u32 compute_drawing_end_cycles();
+    //! Draws the whole current line to the back buffer in `frame_buffers`. Called by the render worker.
+    void draw_line(const byte_t* vram, u8* frame_buffers);
+    //! Draws pixels of the deferred line until the current cycle, so that the remaining pixels can be
+    //! drawn inline. Called before VRAM or PPU registers are changed during drawing.
+    void draw_deferred_line_inline(Emulator* emu);
+
+    template <bool _Pixels>
+    void fetcher_get_background_tile(const byte_t* vram);
+    template <bool _Pixels>
+    void fetcher_get_window_tile(const byte_t* vram);
+    void fetcher_get_sprite_tile();
+    void fetcher_get_sprite_data(const byte_t* vram, u8 data_index);
+    template <bool _Pixels>
     void fetcher_push_bgw_pixels();
     void fetcher_push_sprite_pixels(u8 push_begin, u8 push_end);
 
-    void fetcher_get_tile(Emulator* emu);
-    void fetcher_get_data(Emulator* emu, u8 data_index);
+    template <bool _Pixels>
+    void fetcher_get_tile(const byte_t* vram);
+    template <bool _Pixels>
+    void fetcher_get_data(const byte_t* vram, u8 data_index);
+    template <bool _Pixels>
     void fetcher_push_pixels();
 
+    template <bool _Pixels>
     void lcd_draw_pixel();
 };
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include "PPURenderer.hpp"
+#include "Emulator.hpp"
+#include <Luna/Runtime/Atomic.hpp>
+
+static void ppu_render_worker_run(void* params)
+{
+    PPURenderer* renderer = (PPURenderer*)params;
+    while(true)
+    {
+        renderer->data_signal->wait();
+        bool exiting = atom_add_u32(&renderer->exiting, 0) != 0;
+        u32 begin = renderer->drawn_lines;
+        u32 end = atom_add_u32(&renderer->submitted_lines, 0);
+        // Lines in [begin, end) will not be touched by the emulation thread until
+        // `drawn_lines` is updated.
+        for(u32 i = begin; i != end; ++i)
+        {
+            renderer->draw_line(renderer->lines[i % PPU_RENDER_RING_LINES]);
+            atom_exchange_u32(&renderer->drawn_lines, i + 1);
+        }
+        if(exiting) break;
+    }
+}
+void PPURenderer::init(Emulator* emu)
+{
+    this->emu = emu;
+    memcpy(vram, emu->vram, sizeof(vram));
+    num_vram_writes = 0;
+    num_applied_vram_writes = 0;
+    submitted_lines = 0;
+    drawn_lines = 0;
+    exiting = 0;
+    ppu.init();
+    data_signal = new_signal(false);
+    worker_thread = new_thread(ppu_render_worker_run, this, "PPU render worker");
+}
+void PPURenderer::close()
+{
+    if(!worker_thread) return;
+    atom_exchange_u32(&exiting, 1);
+    data_signal->trigger();
+    worker_thread->wait();
+    worker_thread.reset();
+    data_signal.reset();
+}
+void PPURenderer::submit_line(const PPU& ppu)
+{
+    u32 submitted = submitted_lines;
+    // Waits if the ring is full, which only happens if LCD is switched off and on within one frame.
+    while(submitted - atom_add_u32(&drawn_lines, 0) >= PPU_RENDER_RING_LINES)
+    {
+        data_signal->trigger();
+        yield_current_thread();
+    }
+    PPURenderLine& line = lines[submitted % PPU_RENDER_RING_LINES];
+    line.lcdc = ppu.lcdc;
+    line.scroll_y = ppu.scroll_y;
+    line.scroll_x = ppu.scroll_x;
+    line.ly = ppu.ly;
+    line.bgp = ppu.bgp;
+    line.obp0 = ppu.obp0;
+    line.obp1 = ppu.obp1;
+    line.wy = ppu.wy;
+    line.wx = ppu.wx;
+    line.window_line = ppu.window_line;
+    line.num_sprites = ppu.num_sprites;
+    line.back_buffer = ppu.current_back_buffer;
+    memcpy(line.sprites, ppu.sprites, sizeof(OAMEntry) * ppu.num_sprites);
+    line.num_vram_writes = num_vram_writes;
+    atom_exchange_u32(&submitted_lines, submitted + 1);
+    if(((submitted + 1) % PPU_RENDER_BATCH_LINES) == 0)
+    {
+        data_signal->trigger();
+    }
+}
+void PPURenderer::flush()
+{
+    u32 submitted = submitted_lines;
+    if(atom_add_u32(&drawn_lines, 0) != submitted)
+    {
+        data_signal->trigger();
+        while(atom_add_u32(&drawn_lines, 0) != submitted)
+        {
+            yield_current_thread();
+        }
+    }
+    // The worker thread is idle now.
+    if(ppu.back_buffer_changed)
+    {
+        emu->ppu.back_buffer_changed = true;
+        ppu.back_buffer_changed = false;
+    }
+}
+void PPURenderer::sync(Emulator* emu)
+{
+    flush();
+    memcpy(vram, emu->vram, sizeof(vram));
+    num_vram_writes = 0;
+    num_applied_vram_writes = 0;
+}
+void PPURenderer::draw_line(const PPURenderLine& line)
+{
+    for(u32 i = num_applied_vram_writes; i < line.num_vram_writes; ++i)
+    {
+        vram[vram_writes[i].offset] = vram_writes[i].data;
+    }
+    num_applied_vram_writes = line.num_vram_writes;
+    ppu.lcdc = line.lcdc;
+    ppu.scroll_y = line.scroll_y;
+    ppu.scroll_x = line.scroll_x;
+    ppu.ly = line.ly;
+    ppu.bgp = line.bgp;
+    ppu.obp0 = line.obp0;
+    ppu.obp1 = line.obp1;
+    ppu.wy = line.wy;
+    ppu.wx = line.wx;
+    ppu.window_line = line.window_line;
+    ppu.num_sprites = line.num_sprites;
+    ppu.current_back_buffer = line.back_buffer;
+    memcpy(ppu.sprites, line.sprites, sizeof(OAMEntry) * line.num_sprites);
+    // Other lines of the back buffer are not written by the emulation thread.
+    ppu.draw_line(vram, emu->frame_buffers.data());
+}
\ No newline at end of file
@@ -0,0 +1,107 @@
+#pragma once
+#include <Luna/Runtime/Thread.hpp>
+#include <Luna/Runtime/Signal.hpp>
+#include "PPU.hpp"
+using namespace Luna;
+
+//! The number of scan lines that can be submitted but not drawn.
+constexpr u32 PPU_RENDER_RING_LINES = PPU_YRES;
+//! The render worker is woken up once every this number of submitted lines.
+constexpr u32 PPU_RENDER_BATCH_LINES = 16;
+//! The maximum number of VRAM writes recorded between two synchronizations.
+constexpr u32 PPU_RENDER_MAX_VRAM_WRITES = 4096;
+
+//! One VRAM write recorded for the render worker.
+struct PPURenderVRAMWrite
+{
+    u16 offset;
+    u8 data;
+};
+
+//! The PPU registers and sprites used to draw one scan line, captured when the line ends.
+struct PPURenderLine
+{
+    u8 lcdc;
+    u8 scroll_y;
+    u8 scroll_x;
+    u8 ly;
+    u8 bgp;
+    u8 obp0;
+    u8 obp1;
+    u8 wy;
+    u8 wx;
+    u8 window_line;
+    u8 num_sprites;
+    //! The back buffer index to draw the line to.
+    u8 back_buffer;
+    OAMEntry sprites[PPU_MAX_SPRITES_PER_LINE];
+    //! The number of VRAM writes that should be applied before drawing the line.
+    u32 num_vram_writes;
+};
+
+//! Draws scan lines on one worker thread.
+//! PPU still emulates the timing of every line on the emulation thread, and submits lines whose
+//! VRAM and registers are not changed during drawing to the worker. The worker keeps its own copy of
+//! VRAM that is updated by replaying VRAM writes recorded by the emulation thread, so that writes
+//! after one line is submitted do not affect that line.
+struct PPURenderer
+{
+    Emulator* emu = nullptr;
+
+    // States shared with the worker thread.
+
+    //! The ring of submitted lines.
+    PPURenderLine lines[PPU_RENDER_RING_LINES];
+    //! VRAM writes recorded since the last synchronization.
+    PPURenderVRAMWrite vram_writes[PPU_RENDER_MAX_VRAM_WRITES];
+    //! The number of recorded VRAM writes, only modified by the emulation thread.
+    u32 num_vram_writes = 0;
+    //! The number of lines submitted, only accessed by atomic operations.
+    volatile u32 submitted_lines = 0;
+    //! The number of lines drawn, only accessed by atomic operations.
+    volatile u32 drawn_lines = 0;
+    volatile u32 exiting = 0;
+
+    // Worker states, only accessed by the worker thread, or when no line is pending.
+
+    //! The VRAM copy used by the worker.
+    byte_t vram[8_kb];
+    //! The number of VRAM writes applied to `vram`.
+    u32 num_applied_vram_writes = 0;
+    //! The PPU used to draw lines.
+    PPU ppu;
+
+    Ref<IThread> worker_thread;
+    Ref<ISignal> data_signal;
+
+    //! Copies VRAM and starts the worker thread.
+    void init(Emulator* emu);
+    //! Draws all submitted lines and stops the worker thread.
+    void close();
+    ~PPURenderer()
+    {
+        close();
+    }
+    //! Submits the current line of `ppu`. Called when drawing of one deferred line ends.
+    void submit_line(const PPU& ppu);
+    //! Records one VRAM write. Called after `Emulator::vram` is written.
+    void write_vram(Emulator* emu, u16 offset, u8 data)
+    {
+        if(num_vram_writes == PPU_RENDER_MAX_VRAM_WRITES)
+        {
+            sync(emu);
+            return;
+        }
+        vram_writes[num_vram_writes].offset = offset;
+        vram_writes[num_vram_writes].data = data;
+        ++num_vram_writes;
+    }
+    //! Waits until all submitted lines are drawn, and merges `PPU::back_buffer_changed` of lines
+    //! drawn by the worker to the emulator PPU.
+    void flush();
+    //! Waits until all submitted lines are drawn, then copies VRAM from the emulator and discards
+    //! recorded writes. This must be called when VRAM is changed without calling `write_vram`.
+    void sync(Emulator* emu);
+    //! Draws one submitted line. Called by the worker thread.
+    void draw_line(const PPURenderLine& line);
+};
\ No newline at end of file
@@ -0,0 +1,256 @@
+#include "Profiler.hpp"
+#include "Emulator.hpp"
+#include "Cartridge.hpp"
+#include <Luna/Runtime/File.hpp>
+#include <Luna/Runtime/Log.hpp>
+#include <Luna/Runtime/HashMap.hpp>
+
+//! Checks whether the opcode is CALL or RST.
+inline bool is_call_opcode(u8 opcode)
+{
+    // CALL a16, CALL cc, a16, RST n.
+    return opcode == 0xCD || (opcode & 0xE7) == 0xC4 || (opcode & 0xC7) == 0xC7;
+}
+//! Checks whether the opcode is RET or RETI.
+inline bool is_return_opcode(u8 opcode)
+{
+    // RET, RETI, RET cc.
+    return opcode == 0xC9 || opcode == 0xD9 || (opcode & 0xE7) == 0xC0;
+}
+void Profiler::init(const Emulator* emu)
+{
+    rom_size = emu->num_rom_banks * 16_kb;
+    cycles.resize(rom_size + 32_kb);
+    nodes.reserve(PROFILER_MAX_CALL_NODES);
+    reset();
+}
+void Profiler::reset()
+{
+    memzero(cycles.data(), cycles.size() * sizeof(u64));
+    nodes.clear();
+    ProfilerCallNode root;
+    root.routine = PROFILER_ROOT_ROUTINE;
+    root.parent = U32_MAX;
+    root.first_child = U32_MAX;
+    root.next_sibling = U32_MAX;
+    root.self_cycles = 0;
+    root.calls = 0;
+    nodes.push_back(root);
+    call_stack[0].node = 0;
+    call_stack[0].sp = 0xFFFF;
+    call_depth = 1;
+    total_cycles = 0;
+}
+u32 Profiler::get_banked_address(const Emulator* emu, u16 addr) const
+{
+    if(addr <= 0x7FFF)
+    {
+        usize bank_offset = (get_cartridge_rom_bank(emu, addr) * 16_kb) % rom_size;
+        return (u32)(bank_offset + addr % 16_kb);
+    }
+    return (u32)(rom_size + (addr - 0x8000));
+}
+String Profiler::get_address_name(u32 banked_address) const
+{
+    c8 buf[16];
+    if(banked_address == PROFILER_ROOT_ROUTINE)
+    {
+        return String("root");
+    }
+    if(banked_address < 16_kb)
+    {
+        snprintf(buf, 16, "00:%04X", banked_address);
+    }
+    else if(banked_address < rom_size)
+    {
+        snprintf(buf, 16, "%02X:%04X", (u32)(banked_address / 16_kb), (u32)(0x4000 + banked_address % 16_kb));
+    }
+    else
+    {
+        snprintf(buf, 16, "--:%04X", (u32)(0x8000 + banked_address - rom_size));
+    }
+    return String(buf);
+}
+void Profiler::on_instruction(const Emulator* emu, u16 pc, u8 opcode, u16 sp, u64 cycles)
+{
+    this->cycles[get_banked_address(emu, pc)] += cycles;
+    nodes[call_stack[call_depth - 1].node].self_cycles += cycles;
+    total_cycles += cycles;
+    // A conditional call or return is taken only if SP is changed.
+    if(is_call_opcode(opcode) && emu->cpu.sp == (u16)(sp - 2))
+    {
+        push_call(emu, emu->cpu.pc, emu->cpu.sp);
+    }
+    else if(is_return_opcode(opcode) && emu->cpu.sp == (u16)(sp + 2))
+    {
+        pop_call(sp);
+    }
+}
+void Profiler::on_interrupt(const Emulator* emu, u64 cycles)
+{
+    push_call(emu, emu->cpu.pc, emu->cpu.sp);
+    nodes[call_stack[call_depth - 1].node].self_cycles += cycles;
+    total_cycles += cycles;
+}
+void Profiler::on_halt(const Emulator* emu, u64 cycles)
+{
+    this->cycles[get_banked_address(emu, emu->cpu.pc)] += cycles;
+    nodes[call_stack[call_depth - 1].node].self_cycles += cycles;
+    total_cycles += cycles;
+}
+void Profiler::push_call(const Emulator* emu, u16 target, u16 sp)
+{
+    // Discard frames whose return addresses are overwritten, which happens if the game resets SP
+    // instead of returning.
+    while(call_depth > 1 && call_stack[call_depth - 1].sp <= sp)
+    {
+        --call_depth;
+    }
+    if(call_depth == PROFILER_MAX_CALL_DEPTH) return;
+    u32 routine = get_banked_address(emu, target);
+    u32 parent = call_stack[call_depth - 1].node;
+    u32 node = nodes[parent].first_child;
+    while(node != U32_MAX && nodes[node].routine != routine)
+    {
+        node = nodes[node].next_sibling;
+    }
+    if(node == U32_MAX)
+    {
+        if(nodes.size() == PROFILER_MAX_CALL_NODES) return;
+        ProfilerCallNode n;
+        n.routine = routine;
+        n.parent = parent;
+        n.first_child = U32_MAX;
+        n.next_sibling = nodes[parent].first_child;
+        n.self_cycles = 0;
+        n.calls = 0;
+        node = (u32)nodes.size();
+        nodes.push_back(n);
+        nodes[parent].first_child = node;
+    }
+    ++nodes[node].calls;
+    call_stack[call_depth].node = node;
+    call_stack[call_depth].sp = sp;
+    ++call_depth;
+}
+void Profiler::pop_call(u16 sp)
+{
+    // Find the frame whose return address is popped. Returns that do not match any frame
+    // (like calls dropped because the call stack is full) are ignored.
+    for(u32 i = call_depth - 1; i > 0; --i)
+    {
+        if(call_stack[i].sp == sp)
+        {
+            call_depth = i;
+            return;
+        }
+    }
+}
+void Profiler::get_routine_stats(Vector<ProfilerRoutineStats>& out_stats) const
+{
+    out_stats.clear();
+    // Child nodes are always created after their parents, so inclusive cycles can be
+    // accumulated in reverse order.
+    Vector<u64> inclusive_cycles(nodes.size(), 0);
+    for(usize i = nodes.size(); i > 0; --i)
+    {
+        usize node = i - 1;
+        inclusive_cycles[node] += nodes[node].self_cycles;
+        if(nodes[node].parent != U32_MAX)
+        {
+            inclusive_cycles[nodes[node].parent] += inclusive_cycles[node];
+        }
+    }
+    HashMap<u32, usize> routine_indices;
+    for(usize i = 1; i < nodes.size(); ++i)
+    {
+        const ProfilerCallNode& n = nodes[i];
+        usize index;
+        auto iter = routine_indices.find(n.routine);
+        if(iter == routine_indices.end())
+        {
+            ProfilerRoutineStats stats;
+            stats.routine = n.routine;
+            stats.self_cycles = 0;
+            stats.inclusive_cycles = 0;
+            stats.calls = 0;
+            index = out_stats.size();
+            routine_indices.insert(make_pair(n.routine, index));
+            out_stats.push_back(stats);
+        }
+        else
+        {
+            index = iter->second;
+        }
+        ProfilerRoutineStats& stats = out_stats[index];
+        stats.self_cycles += n.self_cycles;
+        stats.calls += n.calls;
+        // Skip recursive calls, whose cycles are already counted by the outer call.
+        bool recursive = false;
+        for(u32 p = n.parent; p != U32_MAX; p = nodes[p].parent)
+        {
+            if(nodes[p].routine == n.routine)
+            {
+                recursive = true;
+                break;
+            }
+        }
+        if(!recursive)
+        {
+            stats.inclusive_cycles += inclusive_cycles[i];
+        }
+    }
+}
+RV Profiler::export_csv(const c8* path) const
+{
+    lutry
+    {
+        lulet(f, open_file(path, FileOpenFlag::write, FileCreationMode::create_always));
+        String text("address,cycles,percent\n");
+        c8 line[64];
+        for(usize i = 0; i < cycles.size(); ++i)
+        {
+            if(!cycles[i]) continue;
+            snprintf(line, 64, "%s,%llu,%.4f\n", get_address_name((u32)i).c_str(), (unsigned long long)cycles[i],
+                total_cycles ? (f64)cycles[i] * 100.0 / total_cycles : 0.0);
+            text.append(line);
+        }
+        luexp(f->write(text.c_str(), text.size()));
+        log_info("LunaGB", "Profiling data saved to %s.", path);
+    }
+    lucatchret;
+    return ok;
+}
+RV Profiler::export_flamegraph(const c8* path) const
+{
+    lutry
+    {
+        lulet(f, open_file(path, FileOpenFlag::write, FileCreationMode::create_always));
+        String text;
+        String stack;
+        Vector<u32> routines;
+        c8 line[32];
+        for(usize i = 0; i < nodes.size(); ++i)
+        {
+            if(!nodes[i].self_cycles) continue;
+            routines.clear();
+            for(u32 n = (u32)i; n != U32_MAX; n = nodes[n].parent)
+            {
+                routines.push_back(nodes[n].routine);
+            }
+            stack.clear();
+            for(usize j = routines.size(); j > 0; --j)
+            {
+                stack.append(get_address_name(routines[j - 1]));
+                if(j != 1) stack.push_back(';');
+            }
+            snprintf(line, 32, " %llu\n", (unsigned long long)nodes[i].self_cycles);
+            text.append(stack);
+            text.append(line);
+        }
+        luexp(f->write(text.c_str(), text.size()));
+        log_info("LunaGB", "Flame graph saved to %s.", path);
+    }
+    lucatchret;
+    return ok;
+}
\ No newline at end of file
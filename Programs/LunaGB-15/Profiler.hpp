@@ -0,0 +1,99 @@
+#pragma once
+#include <Luna/Runtime/Result.hpp>
+#include <Luna/Runtime/Vector.hpp>
+#include <Luna/Runtime/String.hpp>
+using namespace Luna;
+
+//! The maximum depth of the call stack tracked by the profiler. Deeper calls are attributed to the caller.
+constexpr u32 PROFILER_MAX_CALL_DEPTH = 256;
+//! The maximum number of call tree nodes. New call paths are attributed to the caller once the tree is full.
+constexpr u32 PROFILER_MAX_CALL_NODES = 65536;
+//! The routine of the root call tree node, which represents code not called by any routine.
+constexpr u32 PROFILER_ROOT_ROUTINE = U32_MAX;
+
+//! One node of the call tree. One node represents one routine called from the routine of its parent node.
+struct ProfilerCallNode
+{
+    //! The banked address of the routine entry point.
+    u32 routine;
+    u32 parent;
+    u32 first_child;
+    u32 next_sibling;
+    //! The number of clock cycles spent in the routine, excluding cycles spent in routines it calls.
+    u64 self_cycles;
+    //! The number of times the routine is called from the parent routine.
+    u64 calls;
+};
+
+//! One entry of the call stack tracked by the profiler.
+struct ProfilerCallFrame
+{
+    //! The call tree node of the routine.
+    u32 node;
+    //! The SP register after the return address is pushed.
+    u16 sp;
+};
+
+//! Statistics of one routine, see `Profiler::get_routine_stats`.
+struct ProfilerRoutineStats
+{
+    //! The banked address of the routine entry point.
+    u32 routine;
+    //! The number of clock cycles spent in the routine, excluding cycles spent in routines it calls.
+    u64 self_cycles;
+    //! The number of clock cycles spent in the routine and all routines it calls.
+    u64 inclusive_cycles;
+    u64 calls;
+};
+
+struct Emulator;
+//! Profiles guest code. Cycles are accumulated for every banked address, which identifies one byte of ROM
+//! data for addresses in 0x0000~0x7FFF, and one CPU address for other addresses.
+//! Calls and returns are tracked to build one call tree, from which inclusive cycles of every routine
+//! and flame graphs are generated.
+struct Profiler
+{
+    //! The ROM data size covered by banked addresses.
+    usize rom_size = 0;
+    //! Clock cycles spent in instructions at every banked address.
+    Vector<u64> cycles;
+    //! The call tree. The first node is the root node.
+    Vector<ProfilerCallNode> nodes;
+    ProfilerCallFrame call_stack[PROFILER_MAX_CALL_DEPTH];
+    u32 call_depth = 0;
+    //! The number of clock cycles profiled.
+    u64 total_cycles = 0;
+
+    //! Allocates profiling data for the cartridge loaded in the emulator.
+    void init(const Emulator* emu);
+    //! Clears all profiling data.
+    void reset();
+
+    //! Gets the banked address of the specified CPU address.
+    u32 get_banked_address(const Emulator* emu, u16 addr) const;
+    //! Gets the human-readable name of one banked address, like "01:4A2C".
+    String get_address_name(u32 banked_address) const;
+
+    //! Called after one instruction is executed.
+    //! @param[in] pc The PC register before the instruction is executed.
+    //! @param[in] opcode The opcode of the instruction.
+    //! @param[in] sp The SP register before the instruction is executed.
+    //! @param[in] cycles The number of clock cycles spent.
+    void on_instruction(const Emulator* emu, u16 pc, u8 opcode, u16 sp, u64 cycles);
+    //! Called after one interrupt is serviced.
+    void on_interrupt(const Emulator* emu, u64 cycles);
+    //! Called when the CPU is halted for one step.
+    void on_halt(const Emulator* emu, u64 cycles);
+
+    void push_call(const Emulator* emu, u16 target, u16 sp);
+    void pop_call(u16 sp);
+
+    //! Computes statistics of every called routine. Cycles spent in recursive calls are counted once for
+    //! inclusive cycles.
+    void get_routine_stats(Vector<ProfilerRoutineStats>& out_stats) const;
+    //! Writes cycles of every executed banked address as CSV.
+    RV export_csv(const c8* path) const;
+    //! Writes the call tree in the collapsed stack format, which can be rendered by flamegraph.pl,
+    //! speedscope and other flame graph tools.
+    RV export_flamegraph(const c8* path) const;
+};
\ No newline at end of file
@@ -0,0 +1,294 @@
+#include "RamSearch.hpp"
+#include "Emulator.hpp"
+#include "ByteVector.hpp"
+
+//! Filter parameters shared by all chunks.
+struct RamSearchFilterParams
+{
+    RamSearchComparison comparison;
+    bool word;
+    bool bcd;
+    bool use_previous;
+    //! The value to compare with, encoded in the same format as memory.
+    u8 value_lo;
+    u8 value_hi;
+};
+
+inline bool is_valid_bcd(u8 v)
+{
+    return (v & 0x0F) <= 0x09 && (v & 0xF0) <= 0x90;
+}
+inline u32 encode_bcd(u32 v)
+{
+    return (v % 10) | (((v / 10) % 10) << 4) | (((v / 100) % 10) << 8) | (((v / 1000) % 10) << 12);
+}
+inline u32 decode_bcd(u32 v)
+{
+    return (v & 0x0F) + ((v >> 4) & 0x0F) * 10 + ((v >> 8) & 0x0F) * 100 + ((v >> 12) & 0x0F) * 1000;
+}
+inline u32 popcount64(u64 v)
+{
+    v = v - ((v >> 1) & 0x5555555555555555ULL);
+    v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+    v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (u32)((v * 0x0101010101010101ULL) >> 56);
+}
+//! Tests one value. `size` is the size of the region, used to reject words crossing the region end.
+static bool test_value(const RamSearchFilterParams& p, const u8* cur, const u8* prev, usize i, usize size)
+{
+    if(p.word && i + 1 >= size) return false;
+    u8 c_lo = cur[i];
+    u8 r_lo = p.use_previous ? prev[i] : p.value_lo;
+    u8 c_hi = p.word ? cur[i + 1] : 0;
+    u8 r_hi = p.word ? (p.use_previous ? prev[i + 1] : p.value_hi) : 0;
+    if(p.bcd && !(is_valid_bcd(c_lo) && is_valid_bcd(c_hi) && is_valid_bcd(r_lo) && is_valid_bcd(r_hi))) return false;
+    // Packed BCD values have the same order as binary values.
+    u32 c = (u32)c_lo | ((u32)c_hi << 8);
+    u32 r = (u32)r_lo | ((u32)r_hi << 8);
+    switch(p.comparison)
+    {
+        case RamSearchComparison::equal: return c == r;
+        case RamSearchComparison::not_equal: return c != r;
+        case RamSearchComparison::less: return c < r;
+        case RamSearchComparison::greater: return c > r;
+        default: lupanic(); return false;
+    }
+}
+#ifdef BYTE_VECTOR_SIMD
+inline byte_vec_t vec_valid_bcd(byte_vec_t v)
+{
+    return vec_and(vec_ge(vec_splat(0x09), vec_and(v, vec_splat(0x0F))), vec_ge(vec_splat(0x99), v));
+}
+//! Tests 16 values starting at `cur` and returns one mask with one bit per value.
+//! For words, the byte after the last value is also read.
+template <RamSearchComparison _Comparison, bool _Word, bool _Bcd, bool _UsePrevious>
+inline u64 test_values_16(const u8* cur, const u8* prev, byte_vec_t value_lo, byte_vec_t value_hi)
+{
+    byte_vec_t c_lo = vec_load(cur);
+    byte_vec_t r_lo = _UsePrevious ? vec_load(prev) : value_lo;
+    byte_vec_t eq = vec_eq(c_lo, r_lo);
+    byte_vec_t gt = vec_gt(c_lo, r_lo);
+    byte_vec_t lt = vec_gt(r_lo, c_lo);
+    byte_vec_t valid = vec_splat(0xFF);
+    if constexpr(_Bcd)
+    {
+        // Specified values are always encoded as valid BCD.
+        valid = _UsePrevious ? vec_and(vec_valid_bcd(c_lo), vec_valid_bcd(r_lo)) : vec_valid_bcd(c_lo);
+    }
+    if constexpr(_Word)
+    {
+        // The high byte of the value at lane i is at lane i of the vector loaded from the next byte.
+        byte_vec_t c_hi = vec_load(cur + 1);
+        byte_vec_t r_hi = _UsePrevious ? vec_load(prev + 1) : value_hi;
+        byte_vec_t eq_hi = vec_eq(c_hi, r_hi);
+        gt = vec_or(vec_gt(c_hi, r_hi), vec_and(eq_hi, gt));
+        lt = vec_or(vec_gt(r_hi, c_hi), vec_and(eq_hi, lt));
+        eq = vec_and(eq, eq_hi);
+        if constexpr(_Bcd)
+        {
+            valid = vec_and(valid, _UsePrevious ? vec_and(vec_valid_bcd(c_hi), vec_valid_bcd(r_hi)) : vec_valid_bcd(c_hi));
+        }
+    }
+    byte_vec_t r;
+    if constexpr(_Comparison == RamSearchComparison::equal) r = eq;
+    else if constexpr(_Comparison == RamSearchComparison::not_equal) r = vec_not(eq);
+    else if constexpr(_Comparison == RamSearchComparison::less) r = lt;
+    else r = gt;
+    if constexpr(_Bcd) r = vec_and(r, valid);
+    return vec_movemask(r);
+}
+//! Filters `num_chunks` chunks of 64 values. The filter parameters are template arguments so that
+//! every combination compiles to one branch-free loop.
+template <RamSearchComparison _Comparison, bool _Word, bool _Bcd, bool _UsePrevious>
+static void filter_chunks(const RamSearchFilterParams& p, const u8* cur, const u8* prev, u64* cand, usize num_chunks)
+{
+    byte_vec_t value_lo = vec_splat(p.value_lo);
+    byte_vec_t value_hi = vec_splat(p.value_hi);
+    for(usize i = 0; i < num_chunks; ++i)
+    {
+        // Chunks without candidates are common after the first few filters.
+        if(!cand[i]) continue;
+        const u8* c = cur + i * 64;
+        const u8* v = prev + i * 64;
+        cand[i] &= test_values_16<_Comparison, _Word, _Bcd, _UsePrevious>(c, v, value_lo, value_hi) |
+            (test_values_16<_Comparison, _Word, _Bcd, _UsePrevious>(c + 16, v + 16, value_lo, value_hi) << 16) |
+            (test_values_16<_Comparison, _Word, _Bcd, _UsePrevious>(c + 32, v + 32, value_lo, value_hi) << 32) |
+            (test_values_16<_Comparison, _Word, _Bcd, _UsePrevious>(c + 48, v + 48, value_lo, value_hi) << 48);
+    }
+}
+template <RamSearchComparison _Comparison, bool _Word, bool _Bcd>
+inline void filter_chunks(const RamSearchFilterParams& p, const u8* cur, const u8* prev, u64* cand, usize num_chunks)
+{
+    if(p.use_previous) filter_chunks<_Comparison, _Word, _Bcd, true>(p, cur, prev, cand, num_chunks);
+    else filter_chunks<_Comparison, _Word, _Bcd, false>(p, cur, prev, cand, num_chunks);
+}
+template <RamSearchComparison _Comparison>
+inline void filter_chunks(const RamSearchFilterParams& p, const u8* cur, const u8* prev, u64* cand, usize num_chunks)
+{
+    if(p.word)
+    {
+        if(p.bcd) filter_chunks<_Comparison, true, true>(p, cur, prev, cand, num_chunks);
+        else filter_chunks<_Comparison, true, false>(p, cur, prev, cand, num_chunks);
+    }
+    else
+    {
+        if(p.bcd) filter_chunks<_Comparison, false, true>(p, cur, prev, cand, num_chunks);
+        else filter_chunks<_Comparison, false, false>(p, cur, prev, cand, num_chunks);
+    }
+}
+static void filter_chunks(const RamSearchFilterParams& p, const u8* cur, const u8* prev, u64* cand, usize num_chunks)
+{
+    switch(p.comparison)
+    {
+        case RamSearchComparison::equal: filter_chunks<RamSearchComparison::equal>(p, cur, prev, cand, num_chunks); break;
+        case RamSearchComparison::not_equal: filter_chunks<RamSearchComparison::not_equal>(p, cur, prev, cand, num_chunks); break;
+        case RamSearchComparison::less: filter_chunks<RamSearchComparison::less>(p, cur, prev, cand, num_chunks); break;
+        case RamSearchComparison::greater: filter_chunks<RamSearchComparison::greater>(p, cur, prev, cand, num_chunks); break;
+        default: lupanic(); break;
+    }
+}
+#endif
+void RamSearch::reset(const Emulator* emu, RamSearchWidth width)
+{
+    this->width = width;
+    num_regions = 0;
+    size = 0;
+    auto add_region = [&](const c8* name, u16 base_addr, usize region_size)
+    {
+        regions[num_regions++] = {name, base_addr, size, region_size};
+        size = align_upper(size + region_size, 64);
+    };
+    add_region("WRAM", 0xC000, 8_kb);
+    // 0xFFFF is IE, which is not part of HRAM.
+    add_region("HRAM", 0xFF80, 127);
+    if(emu->cram_size)
+    {
+        add_region("Cartridge RAM", 0xA000, emu->cram_size);
+    }
+    candidates.resize(size / 64);
+    for(u64& c : candidates) c = U64_MAX;
+    bool word = width == RamSearchWidth::word || width == RamSearchWidth::bcd_word;
+    for(u32 i = 0; i < num_regions; ++i)
+    {
+        usize end = regions[i].offset + regions[i].size;
+        // Words cannot start at the last byte of one region.
+        usize padding_begin = word ? end - 1 : end;
+        for(usize j = padding_begin; j < align_upper(end, 64); ++j)
+        {
+            bit_reset(candidates.data(), j);
+        }
+    }
+    previous.resize(size, false);
+    memzero(previous.data(), size);
+    take_snapshot(emu);
+}
+const u8* RamSearch::get_region_data(const Emulator* emu, u32 region) const
+{
+    switch(region)
+    {
+        case 0: return emu->wram;
+        case 1: return emu->hram;
+        case 2: return emu->cram;
+        default: lupanic(); return nullptr;
+    }
+}
+void RamSearch::take_snapshot(const Emulator* emu)
+{
+    for(u32 i = 0; i < num_regions; ++i)
+    {
+        memcpy(previous.data() + regions[i].offset, get_region_data(emu, i), regions[i].size);
+    }
+}
+void RamSearch::filter(const Emulator* emu, RamSearchComparison comparison, RamSearchOperand operand, u32 value)
+{
+    apply_filter(emu, comparison, operand, value);
+    take_snapshot(emu);
+}
+void RamSearch::apply_filter(const Emulator* emu, RamSearchComparison comparison, RamSearchOperand operand, u32 value)
+{
+    RamSearchFilterParams p;
+    p.comparison = comparison;
+    p.word = width == RamSearchWidth::word || width == RamSearchWidth::bcd_word;
+    p.bcd = width == RamSearchWidth::bcd_byte || width == RamSearchWidth::bcd_word;
+    p.use_previous = operand == RamSearchOperand::previous;
+    if(p.bcd) value = encode_bcd(value);
+    p.value_lo = (u8)(value & 0xFF);
+    p.value_hi = (u8)((value >> 8) & 0xFF);
+    for(u32 r = 0; r < num_regions; ++r)
+    {
+        const RamSearchRegion& region = regions[r];
+        const u8* cur = get_region_data(emu, r);
+        const u8* prev = previous.data() + region.offset;
+        u64* cand = candidates.data() + region.offset / 64;
+        usize num_chunks = align_upper(region.size, 64) / 64;
+        usize num_simd_chunks = 0;
+#ifdef BYTE_VECTOR_SIMD
+        // SIMD code reads whole chunks, so the partial last chunk is tested by scalar code. Words in the
+        // last whole chunk read one byte past the chunk, which is out of the region if the chunk ends the region.
+        num_simd_chunks = region.size / 64;
+        if(p.word && num_simd_chunks == num_chunks) --num_simd_chunks;
+        filter_chunks(p, cur, prev, cand, num_simd_chunks);
+#endif
+        for(usize i = num_simd_chunks; i < num_chunks; ++i)
+        {
+            u64 bits = cand[i];
+            while(bits)
+            {
+                u64 bit = bits & (~bits + 1);
+                bits &= bits - 1;
+                usize offset = i * 64 + popcount64(bit - 1);
+                if(!test_value(p, cur, prev, offset, region.size))
+                {
+                    cand[i] &= ~bit;
+                }
+            }
+        }
+    }
+}
+usize RamSearch::count_candidates() const
+{
+    usize n = 0;
+    for(u64 c : candidates) n += popcount64(c);
+    return n;
+}
+void RamSearch::get_candidates(const Emulator* emu, Vector<RamSearchResult>& out_results, usize max_results) const
+{
+    out_results.clear();
+    bool word = width == RamSearchWidth::word || width == RamSearchWidth::bcd_word;
+    bool bcd = width == RamSearchWidth::bcd_byte || width == RamSearchWidth::bcd_word;
+    for(u32 r = 0; r < num_regions; ++r)
+    {
+        const RamSearchRegion& region = regions[r];
+        const u8* cur = get_region_data(emu, r);
+        const u8* prev = previous.data() + region.offset;
+        for(usize i = 0; i < region.size; ++i)
+        {
+            if(!bit_test(candidates.data(), region.offset + i)) continue;
+            if(out_results.size() >= max_results) return;
+            RamSearchResult result;
+            if(region.base_addr == 0xA000)
+            {
+                result.addr = (u16)(0xA000 + i % 8_kb);
+                result.bank = (u8)(i / 8_kb);
+            }
+            else
+            {
+                result.addr = (u16)(region.base_addr + i);
+                result.bank = 0;
+            }
+            result.value = cur[i];
+            result.previous_value = prev[i];
+            if(word)
+            {
+                result.value |= (u32)cur[i + 1] << 8;
+                result.previous_value |= (u32)prev[i + 1] << 8;
+            }
+            if(bcd)
+            {
+                result.value = decode_bcd(result.value);
+                result.previous_value = decode_bcd(result.previous_value);
+            }
+            out_results.push_back(result);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+#pragma once
+#include <Luna/Runtime/Blob.hpp>
+#include <Luna/Runtime/Vector.hpp>
+using namespace Luna;
+
+//! The width and encoding of values being searched.
+enum class RamSearchWidth : u8
+{
+    //! One unsigned byte.
+    byte,
+    //! One unsigned little-endian 16-bit word.
+    word,
+    //! One byte of 2-digit packed BCD (00~99).
+    bcd_byte,
+    //! One little-endian word of 4-digit packed BCD (0000~9999).
+    bcd_word,
+};
+
+enum class RamSearchComparison : u8
+{
+    equal,
+    not_equal,
+    less,
+    greater,
+};
+
+//! The value that current values are compared with.
+enum class RamSearchOperand : u8
+{
+    //! Compares with values in the previous snapshot, like "changed" or "increased".
+    previous,
+    //! Compares with one specified value.
+    value,
+};
+
+//! One memory region searched.
+struct RamSearchRegion
+{
+    const c8* name;
+    //! The CPU address of the first byte of the region.
+    u16 base_addr;
+    //! The offset of the region in the search space, which is always a multiple of 64.
+    usize offset;
+    usize size;
+};
+
+//! One candidate address, see `RamSearch::get_candidates`.
+struct RamSearchResult
+{
+    //! The CPU address of the value.
+    u16 addr;
+    //! The cartridge RAM bank for 0xA000~0xBFFF, 0 otherwise.
+    u8 bank;
+    //! The current value. BCD values are decoded.
+    u32 value;
+    //! The value in the previous snapshot. BCD values are decoded.
+    u32 previous_value;
+};
+
+//! The maximum number of searched regions: WRAM, HRAM and cartridge RAM.
+constexpr u32 RAM_SEARCH_MAX_REGIONS = 3;
+
+struct Emulator;
+//! Searches WRAM, HRAM and cartridge RAM for addresses whose values match a series of filters.
+//! Candidates are stored as one bitmap over the search space, one bit for every value starting
+//! at that byte. Filters compare 64 bytes at a time using SIMD byte comparisons, and skip 64-byte
+//! chunks without candidates. The first filters are bound by loading the current and previous
+//! memory, later filters only load chunks that still have candidates.
+struct RamSearch
+{
+    RamSearchWidth width = RamSearchWidth::byte;
+    RamSearchRegion regions[RAM_SEARCH_MAX_REGIONS];
+    u32 num_regions = 0;
+    //! The size of the search space. Every region starts at a multiple of 64 bytes, and bytes between
+    //! regions are never candidates.
+    usize size = 0;
+    //! The memory snapshot taken by the last `reset`, `filter` or `take_snapshot` call.
+    Blob previous;
+    //! One bit per byte in the search space. The bit is set if the value starting at that byte
+    //! is still one candidate.
+    Vector<u64> candidates;
+
+    //! Restarts the search. All values become candidates.
+    void reset(const Emulator* emu, RamSearchWidth width);
+    //! Copies current memory to the previous snapshot.
+    void take_snapshot(const Emulator* emu);
+    //! Removes candidates that do not satisfy `current <comparison> operand`, then takes one
+    //! new snapshot. `value` is used if `operand` is `RamSearchOperand::value`, and is
+    //! specified in decimal for BCD widths.
+    void filter(const Emulator* emu, RamSearchComparison comparison, RamSearchOperand operand, u32 value);
+    //! Same as `filter`, but does not take one new snapshot.
+    void apply_filter(const Emulator* emu, RamSearchComparison comparison, RamSearchOperand operand, u32 value);
+    //! Gets the number of candidates.
+    usize count_candidates() const;
+    //! Gets at most `max_results` candidates.
+    void get_candidates(const Emulator* emu, Vector<RamSearchResult>& out_results, usize max_results) const;
+
+    //! Gets the memory of one region.
+    const u8* get_region_data(const Emulator* emu, u32 region) const;
+};
\ No newline at end of file
@@ -0,0 +1,48 @@
+#include "RingWriter.hpp"
+
+static void ring_writer_run(void* params)
+{
+    RingWriter* writer = (RingWriter*)params;
+    while(true)
+    {
+        writer->data_signal->wait();
+        bool exiting = atom_add_u32(&writer->exiting, 0) != 0;
+        u32 begin = writer->flushed;
+        u32 end = atom_add_u32(&writer->committed, 0);
+        // Slots in [begin, end) will not be touched by the producer until `flushed` is updated.
+        for(u32 i = begin; i != end; ++i)
+        {
+            writer->write_func(writer->userdata, i);
+            atom_exchange_u32(&writer->flushed, i + 1);
+        }
+        if(exiting) break;
+    }
+}
+RV RingWriter::start(u32 num_slots, ring_write_func_t* write_func, void* userdata, const c8* thread_name)
+{
+    stop();
+    this->num_slots = num_slots;
+    this->write_func = write_func;
+    this->userdata = userdata;
+    committed = 0;
+    flushed = 0;
+    exiting = 0;
+    data_signal = new_signal(false);
+    writer_thread = new_thread(ring_writer_run, this, thread_name);
+    if(!writer_thread)
+    {
+        data_signal.reset();
+        return set_error(BasicError::bad_platform_call(), "Failed to create thread %s.", thread_name);
+    }
+    return ok;
+}
+void RingWriter::stop()
+{
+    if(!writer_thread) return;
+    // Stop the writer thread after all committed slots are written.
+    atom_exchange_u32(&exiting, 1);
+    data_signal->trigger();
+    writer_thread->wait();
+    writer_thread.reset();
+    data_signal.reset();
+}
\ No newline at end of file
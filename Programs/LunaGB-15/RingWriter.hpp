@@ -0,0 +1,59 @@
+#pragma once
+#include <Luna/Runtime/Result.hpp>
+#include <Luna/Runtime/Thread.hpp>
+#include <Luna/Runtime/Signal.hpp>
+#include <Luna/Runtime/Atomic.hpp>
+using namespace Luna;
+
+//! Called by the writer thread for every committed slot.
+//! @param[in] userdata The user data passed to `RingWriter::start`.
+//! @param[in] index The number of slots committed before this slot. The slot position in the
+//! ring is `index % num_slots`.
+using ring_write_func_t = void(void* userdata, u32 index);
+
+//! Hands over slots of one ring buffer from one producer thread to one background writer thread.
+//! The producer fills slots in order and commits them, the writer thread writes committed slots
+//! in order. The ring buffer is owned by the user, and counters are shared through atomic
+//! operations, so committing slots never locks.
+struct RingWriter
+{
+    u32 num_slots = 0;
+    ring_write_func_t* write_func = nullptr;
+    void* userdata = nullptr;
+
+    //! The number of slots committed by the producer. Slots in [flushed, committed) are
+    //! owned by the writer thread.
+    volatile u32 committed = 0;
+    //! The number of slots written by the writer thread.
+    volatile u32 flushed = 0;
+    volatile u32 exiting = 0;
+
+    Ref<IThread> writer_thread;
+    Ref<ISignal> data_signal;
+
+    //! Starts the writer thread.
+    RV start(u32 num_slots, ring_write_func_t* write_func, void* userdata, const c8* thread_name);
+    //! Writes all committed slots and stops the writer thread.
+    void stop();
+    ~RingWriter()
+    {
+        stop();
+    }
+    bool is_running() const { return writer_thread.valid(); }
+
+    //! Gets the number of slots written. Slots before this can be filled again by the producer.
+    u32 get_flushed() { return atom_add_u32(&flushed, 0); }
+    //! Checks whether the slot after `count` committed slots is still owned by the writer thread.
+    bool is_full(u32 count) { return count - get_flushed() >= num_slots; }
+    //! Hands over all slots before `count` to the writer thread.
+    void commit(u32 count)
+    {
+        atom_exchange_u32(&committed, count);
+        data_signal->trigger();
+    }
+    //! Waits until the slot after `count` committed slots can be filled by the producer.
+    void wait_for_slot(u32 count)
+    {
+        while(is_full(count)) yield_current_thread();
+    }
+};
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include "RomCache.hpp"
+#include <Luna/Runtime/HashMap.hpp>
+#include <Luna/Runtime/SpinLock.hpp>
+#include <Luna/Runtime/Name.hpp>
+
+struct RomCache
+{
+    SpinLock lock;
+    //! The mapped ROM files. Entries are not retained by the cache, and expired entries are removed when ROMs are opened.
+    HashMap<Name, WeakRef<IFileMapping>> roms;
+};
+
+static RomCache* g_rom_cache = nullptr;
+
+R<Ref<IFileMapping>> open_rom(const Path& path)
+{
+    luassert(g_rom_cache);
+    Name key = path.encode();
+    {
+        LockGuard guard(g_rom_cache->lock);
+        auto iter = g_rom_cache->roms.find(key);
+        if(iter != g_rom_cache->roms.end())
+        {
+            Ref<IFileMapping> rom = iter->second.pin();
+            if(rom) return rom;
+            g_rom_cache->roms.erase(iter);
+        }
+    }
+    // Maps the file outside of the lock, so that other threads are not blocked by file I/O.
+    auto mapping = map_file(path.encode().c_str());
+    if(failed(mapping)) return mapping.errcode();
+    Ref<IFileMapping> rom = mapping.get();
+    Ref<IFileMapping> mapped_rom;
+    {
+        LockGuard guard(g_rom_cache->lock);
+        // Another thread may map the same file meanwhile, in which case its mapping is shared.
+        auto iter = g_rom_cache->roms.find(key);
+        if(iter != g_rom_cache->roms.end())
+        {
+            mapped_rom = iter->second.pin();
+        }
+        if(!mapped_rom)
+        {
+            // Removes expired entries of other files.
+            for(auto i = g_rom_cache->roms.begin(); i != g_rom_cache->roms.end();)
+            {
+                if(i->second.pin()) ++i;
+                else i = g_rom_cache->roms.erase(i);
+            }
+            WeakRef<IFileMapping> weak_rom;
+            weak_rom = rom;
+            g_rom_cache->roms.insert_or_assign(key, move(weak_rom));
+            return rom;
+        }
+    }
+    // The unused mapping of this call is released after the lock is released.
+    return mapped_rom;
+}
+
+struct ModuleRomCache : public Module
+{
+    virtual const c8* get_name() override { return "RomCache"; }
+    virtual RV on_init() override
+    {
+        g_rom_cache = memnew<RomCache>();
+        return ok;
+    }
+    virtual void on_close() override
+    {
+        memdelete(g_rom_cache);
+        g_rom_cache = nullptr;
+    }
+};
+
+Module* module_rom_cache()
+{
+    static ModuleRomCache m;
+    return &m;
+}
\ No newline at end of file
@@ -0,0 +1,15 @@
+#pragma once
+#include <Luna/Runtime/File.hpp>
+#include <Luna/Runtime/Path.hpp>
+#include <Luna/Runtime/Module.hpp>
+using namespace Luna;
+
+//! Opens one cartridge ROM file.
+//! ROM files are mapped to memory as read-only, and all emulator instances that open the same file
+//! share one mapping. The mapping is released when the last reference is released.
+//! @param[in] path The ROM file path.
+//! @return Returns the ROM file mapping.
+R<Ref<IFileMapping>> open_rom(const Path& path);
+
+//! Gets the module that manages the ROM cache. This module must be initialized before calling `open_rom`.
+Module* module_rom_cache();
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "Serial.hpp"
 #include "Emulator.hpp"
+#include "Link.hpp"
 
 void Serial::begin_transfer()
 {
@@ -9,6 +10,15 @@ void Serial::begin_transfer()
 }
 void Serial::process_transfer(Emulator* emu)
 {
+    if(waiting_reply)
+    {
+        u8 data = 0xFF;
+        if(link && !link->poll_reply(data)) return;
+        waiting_reply = false;
+        sb = data;
+        end_transfer(emu);
+        return;
+    }
     sb <<= 1;
     // Set lowest bit to 1.
     ++sb;
@@ -16,6 +26,17 @@ void Serial::process_transfer(Emulator* emu)
     if(transfer_bit < 0)
     {
         transfer_bit = 0;
+        if(link)
+        {
+            // Exchange the byte with the slave.
+            u8 data;
+            if(!link->exchange(emu->clock_cycles, out_byte, data))
+            {
+                waiting_reply = true;
+                return;
+            }
+            sb = data;
+        }
         end_transfer(emu);
     }
 }
@@ -25,6 +46,14 @@ void Serial::end_transfer(Emulator* emu)
     bit_reset(&sc, 7);
     transferring = false;
     emu->int_flags |= INT_SERIAL;
+    update_link_state();
+}
+void Serial::update_link_state()
+{
+    if(link)
+    {
+        link->set_slave_state(transfer_enable() && !is_master(), sb);
+    }
 }
 void Serial::tick(Emulator* emu)
 {
@@ -36,6 +65,17 @@ void Serial::tick(Emulator* emu)
     {
         process_transfer(emu);
     }
+    else if(link)
+    {
+        // Completes one transfer started by the peer master.
+        u8 data;
+        if(link->receive(emu->clock_cycles, data))
+        {
+            out_byte = sb;
+            sb = data;
+            end_transfer(emu);
+        }
+    }
 }
 u8 Serial::bus_read(u16 addr)
 {
@@ -49,11 +89,13 @@ void Serial::bus_write(u16 addr, u8 data)
     if(addr == 0xFF01)
     {
         sb = data;
+        update_link_state();
         return;
     }
     if(addr == 0xFF02)
     {
         sc = 0x7C | (data & 0x83);
+        update_link_state();
         return;
     }
 }
\ No newline at end of file
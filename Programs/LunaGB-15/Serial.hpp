@@ -3,6 +3,7 @@
 using namespace Luna;
 
 struct Emulator;
+struct LinkPort;
 struct Serial
 {
     //! 0xFF01 Serial transfer data.
@@ -22,6 +23,13 @@ struct Serial
     u8 out_byte;
     // The transferring bit index (7 to 0).
     i8 transfer_bit;
+    //! `true` if all bits are shifted and the master is waiting for the link port to fetch the byte
+    //! shifted out by the slave.
+    bool waiting_reply = false;
+
+    //! The link port connected to this serial port, or `nullptr` if no link cable is connected.
+    //! The link port is not owned by the serial port.
+    LinkPort* link = nullptr;
     
     bool is_master() const { return bit_test(&sc, 0); }
     bool transfer_enable() const { return bit_test(&sc, 7); }
@@ -29,12 +37,15 @@ struct Serial
     void begin_transfer();
     void process_transfer(Emulator* emu);
     void end_transfer(Emulator* emu);
+    //! Publishes the slave state to the link port.
+    void update_link_state();
 
     void init()
     {
         sb = 0xFF;
         sc = 0x7C;
         transferring = false;
+        waiting_reply = false;
     }
     void tick(Emulator* emu);
     u8 bus_read(u16 addr);
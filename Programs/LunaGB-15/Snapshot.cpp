@@ -0,0 +1,75 @@
+#include "Snapshot.hpp"
+#include "Emulator.hpp"
+
+void EmulatorSnapshot::init(const Emulator* emu)
+{
+    cram.resize(emu->cram_size, false);
+}
+void EmulatorSnapshot::save(const Emulator* emu)
+{
+    if(emu->ppu_renderer)
+    {
+        // Waits for pixels drawn by the render worker.
+        emu->ppu_renderer->flush();
+    }
+    state = *emu;
+    serial_sb = emu->serial.sb;
+    serial_sc = emu->serial.sc;
+    serial_transferring = emu->serial.transferring;
+    serial_out_byte = emu->serial.out_byte;
+    serial_transfer_bit = emu->serial.transfer_bit;
+    serial_waiting_reply = emu->serial.waiting_reply;
+    serial_output_size = emu->serial.output_buffer.size();
+    memcpy(frame_buffers, emu->frame_buffers.data(), sizeof(frame_buffers));
+    memcpy(&apu_history, emu->apu_history.get(), sizeof(APUSampleHistory));
+    luassert(cram.size() == emu->cram_size);
+    if(emu->cram_size)
+    {
+        memcpy(cram.data(), emu->cram, emu->cram_size);
+    }
+}
+void EmulatorSnapshot::load(Emulator* emu) const
+{
+    if(emu->ppu_renderer)
+    {
+        // The render worker must not write pixels when PPU state is restored.
+        emu->ppu_renderer->flush();
+    }
+    // Only marks VRAM blocks that are restored to different values, so that loading snapshots for
+    // run-ahead does not invalidate VRAM viewers.
+    for(u16 i = 0; i < 8_kb; i += VRAM_DIRTY_BLOCK_SIZE)
+    {
+        if(memcmp(emu->vram + i, state.vram + i, VRAM_DIRTY_BLOCK_SIZE))
+        {
+            emu->mark_vram_dirty(i, i + VRAM_DIRTY_BLOCK_SIZE);
+        }
+    }
+    static_cast<EmulatorState&>(*emu) = state;
+    emu->serial.sb = serial_sb;
+    emu->serial.sc = serial_sc;
+    emu->serial.transferring = serial_transferring;
+    emu->serial.out_byte = serial_out_byte;
+    emu->serial.transfer_bit = serial_transfer_bit;
+    emu->serial.waiting_reply = serial_waiting_reply;
+    while(emu->serial.output_buffer.size() > serial_output_size)
+    {
+        emu->serial.output_buffer.pop_back();
+    }
+    memcpy(emu->frame_buffers.data(), frame_buffers, sizeof(frame_buffers));
+    ++emu->display_version;
+    memcpy(emu->apu_history.get(), &apu_history, sizeof(APUSampleHistory));
+    luassert(cram.size() == emu->cram_size);
+    if(emu->cram_size)
+    {
+        memcpy(emu->cram, cram.data(), emu->cram_size);
+    }
+    if(emu->ppu_renderer)
+    {
+        emu->ppu_renderer->sync(emu);
+    }
+    else if(emu->ppu.deferred_line)
+    {
+        // The snapshot is saved when the render worker is enabled.
+        emu->ppu.draw_deferred_line_inline(emu);
+    }
+}
\ No newline at end of file
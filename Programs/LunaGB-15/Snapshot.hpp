@@ -0,0 +1,52 @@
+#pragma once
+#include <Luna/Runtime/Blob.hpp>
+#include "EmulatorState.hpp"
+using namespace Luna;
+
+struct Emulator;
+//! One in-memory copy of the emulation state of one emulator.
+//! Host states like the cartridge ROM mapping, battery save, movie, trace recorder and callbacks are
+//! not included. All memory is allocated in `init`, so that saving and loading snapshots only copies
+//! memory and never allocates.
+struct EmulatorSnapshot
+{
+    EmulatorState state;
+    // Serial registers. The serial output buffer is read by the host, so only its size is saved,
+    // and bytes sent after the snapshot is saved are discarded when the snapshot is loaded.
+    u8 serial_sb;
+    u8 serial_sc;
+    bool serial_transferring;
+    u8 serial_out_byte;
+    i8 serial_transfer_bit;
+    bool serial_waiting_reply;
+    usize serial_output_size;
+    //! The frame buffers, including lines of the frame being drawn.
+    u8 frame_buffers[PPU_FRAME_SIZE * 2];
+    APUSampleHistory apu_history;
+
+    //! The cartridge RAM data.
+    Blob cram;
+
+    //! Allocates memory for the cartridge RAM of the specified emulator.
+    void init(const Emulator* emu);
+    //! Saves the emulation state of the emulator to this snapshot.
+    void save(const Emulator* emu);
+    //! Restores the emulation state of the emulator from this snapshot.
+    void load(Emulator* emu) const;
+};
+
+//! The run-ahead state.
+//! When run-ahead is enabled, the emulator runs some frames ahead after every update using the current
+//! input, presents the last frame produced, then rolls back to the real state. This hides the input
+//! latency of games that react to input one or more frames later.
+struct RunAhead
+{
+    //! The snapshot of the real state.
+    EmulatorSnapshot snapshot;
+    //! The last frame produced by running ahead.
+    u8 pixels[PPU_XRES * PPU_YRES * 4];
+    //! `true` if `pixels` is produced by the last update.
+    bool valid = false;
+    //! The `Emulator::display_version` of `pixels`.
+    u64 display_version = 0;
+};
\ No newline at end of file
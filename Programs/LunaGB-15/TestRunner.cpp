@@ -0,0 +1,372 @@
+#include "TestRunner.hpp"
+#include "Emulator.hpp"
+#include "RomCache.hpp"
+#include "LineCompositor.hpp"
+#include <Luna/Runtime/File.hpp>
+#include <Luna/Runtime/Log.hpp>
+#include <Luna/Runtime/Time.hpp>
+#include <Luna/Runtime/Hash.hpp>
+#include <Luna/Runtime/StringUtils.hpp>
+#include <Luna/JobSystem/JobSystem.hpp>
+#include <Luna/VariantUtils/JSON.hpp>
+#include <Luna/VariantUtils/XML.hpp>
+
+inline const c8* get_test_result_name(TestResult result)
+{
+    switch(result)
+    {
+        case TestResult::passed: return "passed";
+        case TestResult::failed: return "failed";
+        case TestResult::timeout: return "timeout";
+        case TestResult::error: return "error";
+        default: lupanic(); return "";
+    }
+}
+//! Checks the test result reported by the emulator.
+//! @return Returns `true` if the test is finished.
+static bool check_test_result(Emulator* emu, TestCase& test)
+{
+    if(emu->software_breakpoint)
+    {
+        const CPU& cpu = emu->cpu;
+        if(cpu.b == 3 && cpu.c == 5 && cpu.d == 8 && cpu.e == 13 && cpu.h == 21 && cpu.l == 34)
+        {
+            test.result = TestResult::passed;
+            test.message = "Fibonacci registers matched.";
+        }
+        else
+        {
+            test.result = TestResult::failed;
+            c8 buf[128];
+            snprintf(buf, 128, "Registers mismatched: B: %02X C: %02X D: %02X E: %02X H: %02X L: %02X",
+                (u32)cpu.b, (u32)cpu.c, (u32)cpu.d, (u32)cpu.e, (u32)cpu.h, (u32)cpu.l);
+            test.message = buf;
+        }
+        return true;
+    }
+    if(emu->paused)
+    {
+        test.result = TestResult::error;
+        test.message = "Invalid instruction executed.";
+        return true;
+    }
+    // Read serial output.
+    auto& output_buffer = emu->serial.output_buffer;
+    bool serial_updated = !output_buffer.empty();
+    while(!output_buffer.empty())
+    {
+        test.serial_output.push_back((c8)output_buffer.front());
+        output_buffer.pop_front();
+    }
+    if(serial_updated)
+    {
+        if(strstr(test.serial_output.c_str(), "Passed"))
+        {
+            test.result = TestResult::passed;
+            test.message = "Passed message received from serial port.";
+            return true;
+        }
+        if(strstr(test.serial_output.c_str(), "Failed"))
+        {
+            test.result = TestResult::failed;
+            test.message = "Failed message received from serial port.";
+            return true;
+        }
+    }
+    if(emu->ppu.frame_count != test.frames)
+    {
+        test.frames = emu->ppu.frame_count;
+        test.frame_hash = memhash64(emu->get_front_buffer(), PPU_XRES * PPU_YRES * 4);
+        if(test.has_expected_frame_hash && test.frame_hash == test.expected_frame_hash)
+        {
+            test.result = TestResult::passed;
+            test.message = "Frame hash matched.";
+            return true;
+        }
+    }
+    return false;
+}
+//! Checks that `composite_line` writes the same pixels as `composite_line_scalar` for random
+//! lines of every length, and does not write pixels after `num_pixels`.
+static void test_composite_line(TestCase& test)
+{
+    PPULinePixels line;
+    u8 expected[PPU_XRES * 4];
+    u8 actual[PPU_XRES * 4];
+    u32 seed = 1;
+    auto next_random = [&]() { seed = seed * 1664525 + 1013904223; return (u8)(seed >> 24); };
+    for(u32 round = 0; round < 4096; ++round)
+    {
+        for(u32 i = 0; i < PPU_XRES; ++i)
+        {
+            line.bgw_colors[i] = next_random() & 0x03;
+            line.bgw_palettes[i] = next_random();
+            // Some rounds have no object, so that transparent objects are tested with every background.
+            line.obj_colors[i] = (round % 4) ? next_random() & 0x03 : 0;
+            line.obj_palettes[i] = next_random() & 0xFC;
+            line.obj_bg_priorities[i] = next_random() & 0x01;
+        }
+        u32 num_pixels = round % (PPU_XRES + 1);
+        memset(expected, 0xCD, sizeof(expected));
+        memset(actual, 0xCD, sizeof(actual));
+        composite_line_scalar(line, expected, num_pixels);
+        composite_line(line, actual, num_pixels);
+        for(u32 i = 0; i < PPU_XRES * 4; ++i)
+        {
+            if(expected[i] != actual[i])
+            {
+                test.result = TestResult::failed;
+                c8 buf[128];
+                snprintf(buf, 128, "Pixel %u of %u mismatched in round %u: expected %02X, got %02X.",
+                    i / 4, num_pixels, round, (u32)expected[i], (u32)actual[i]);
+                test.message = buf;
+                return;
+            }
+        }
+    }
+    test.result = TestResult::passed;
+    test.message = "SIMD and scalar lines matched.";
+}
+struct BuiltinTest
+{
+    const c8* name;
+    void (*func)(TestCase& test);
+};
+static const BuiltinTest builtin_tests[] =
+{
+    {"builtin/composite_line", test_composite_line},
+};
+void run_test(TestCase& test)
+{
+    u64 begin_ticks = get_ticks();
+    if(test.builtin_func)
+    {
+        test.builtin_func(test);
+        test.time = (f64)(get_ticks() - begin_ticks) / get_ticks_per_second();
+        return;
+    }
+    lutry
+    {
+        lulet(rom, open_rom(test.rom_path));
+        UniquePtr<Emulator> emu(memnew<Emulator>());
+        // Pass empty cartridge path so that cartridge RAM data is not loaded or saved.
+        luexp(emu->init(Path(), rom));
+        test.result = TestResult::timeout;
+        test.message = "Test timeout.";
+        while(emu->clock_cycles < test.timeout_cycles)
+        {
+            // Check results once per frame, or when one software breakpoint is hit.
+            u64 end_cycles = min(emu->clock_cycles + FRAME_CYCLES, test.timeout_cycles);
+            while(emu->clock_cycles < end_cycles && !emu->software_breakpoint && !emu->paused)
+            {
+                emu->cpu.step(emu.get());
+            }
+            if(check_test_result(emu.get(), test)) break;
+        }
+        test.cycles = emu->clock_cycles;
+    }
+    lucatch
+    {
+        test.result = TestResult::error;
+        test.message = explain(luerr);
+    }
+    test.time = (f64)(get_ticks() - begin_ticks) / get_ticks_per_second();
+}
+static RV find_test_roms(const Path& dir, Vector<TestCase>& tests)
+{
+    lutry
+    {
+        lulet(iter, open_dir(dir.encode().c_str()));
+        while(iter->is_valid())
+        {
+            const c8* filename = iter->get_filename();
+            if(strcmp(filename, ".") && strcmp(filename, ".."))
+            {
+                Path path = dir;
+                path.push_back(filename);
+                if(test_flags(iter->get_attributes(), FileAttributeFlag::directory))
+                {
+                    luexp(find_test_roms(path, tests));
+                }
+                else if(path.extension() == "gb")
+                {
+                    TestCase test;
+                    test.rom_path = path;
+                    // Load expected frame hash if present.
+                    Path hash_path = path;
+                    hash_path.replace_extension("framehash");
+                    auto hash_file = open_file(hash_path.encode().c_str(), FileOpenFlag::read, FileCreationMode::open_existing);
+                    if(succeeded(hash_file))
+                    {
+                        c8 buf[32];
+                        memzero(buf, sizeof(buf));
+                        luexp(hash_file.get()->read(buf, sizeof(buf) - 1));
+                        test.expected_frame_hash = strtou64(buf, nullptr, 16);
+                        test.has_expected_frame_hash = true;
+                    }
+                    tests.push_back(move(test));
+                }
+            }
+            iter->move_next();
+        }
+    }
+    lucatchret;
+    return ok;
+}
+struct TestJobParams
+{
+    TestCase* test;
+};
+static void run_test_job(void* params)
+{
+    TestJobParams* p = (TestJobParams*)params;
+    run_test(*(p->test));
+}
+static RV write_json_report(const Path& path, const Vector<TestCase>& tests, f64 time)
+{
+    lutry
+    {
+        Variant report(VariantType::object);
+        Variant tests_array(VariantType::array);
+        u64 num_passed = 0;
+        for(const TestCase& test : tests)
+        {
+            Variant t(VariantType::object);
+            t["rom"] = test.rom_path.encode().c_str();
+            t["result"] = get_test_result_name(test.result);
+            t["message"] = test.message.c_str();
+            t["serial_output"] = test.serial_output.c_str();
+            t["cycles"] = test.cycles;
+            t["frames"] = test.frames;
+            c8 hash[32];
+            snprintf(hash, 32, "%016llX", (u64)test.frame_hash);
+            t["frame_hash"] = hash;
+            t["time"] = test.time;
+            tests_array.push_back(move(t));
+            if(test.result == TestResult::passed) ++num_passed;
+        }
+        report["total"] = (u64)tests.size();
+        report["passed"] = num_passed;
+        report["failed"] = (u64)tests.size() - num_passed;
+        report["time"] = time;
+        report["tests"] = move(tests_array);
+        lulet(f, open_file(path.encode().c_str(), FileOpenFlag::write, FileCreationMode::create_always));
+        luexp(VariantUtils::write_json(f, report));
+    }
+    lucatchret;
+    return ok;
+}
+static RV write_junit_report(const Path& path, const Vector<TestCase>& tests, f64 time)
+{
+    lutry
+    {
+        u64 num_failures = 0;
+        u64 num_errors = 0;
+        Variant suite = VariantUtils::new_xml_element("testsuite");
+        auto& suite_content = VariantUtils::get_xml_content(suite);
+        c8 buf[64];
+        for(const TestCase& test : tests)
+        {
+            Variant testcase = VariantUtils::new_xml_element("testcase");
+            auto& attributes = VariantUtils::get_xml_attributes(testcase);
+            attributes["name"] = test.rom_path.filename();
+            attributes["classname"] = test.rom_path.encode().c_str();
+            snprintf(buf, 64, "%f", test.time);
+            attributes["time"] = buf;
+            auto& content = VariantUtils::get_xml_content(testcase);
+            if(test.result == TestResult::failed || test.result == TestResult::timeout)
+            {
+                Variant failure = VariantUtils::new_xml_element("failure");
+                VariantUtils::get_xml_attributes(failure)["message"] = test.message.c_str();
+                VariantUtils::get_xml_attributes(failure)["type"] = get_test_result_name(test.result);
+                content.push_back(move(failure));
+                ++num_failures;
+            }
+            else if(test.result == TestResult::error)
+            {
+                Variant error = VariantUtils::new_xml_element("error");
+                VariantUtils::get_xml_attributes(error)["message"] = test.message.c_str();
+                content.push_back(move(error));
+                ++num_errors;
+            }
+            if(!test.serial_output.empty())
+            {
+                Variant system_out = VariantUtils::new_xml_element("system-out");
+                VariantUtils::get_xml_content(system_out).push_back(test.serial_output.c_str());
+                content.push_back(move(system_out));
+            }
+            suite_content.push_back(move(testcase));
+        }
+        auto& attributes = VariantUtils::get_xml_attributes(suite);
+        attributes["name"] = "LunaGB";
+        snprintf(buf, 64, "%llu", (u64)tests.size());
+        attributes["tests"] = buf;
+        snprintf(buf, 64, "%llu", num_failures);
+        attributes["failures"] = buf;
+        snprintf(buf, 64, "%llu", num_errors);
+        attributes["errors"] = buf;
+        snprintf(buf, 64, "%f", time);
+        attributes["time"] = buf;
+        lulet(f, open_file(path.encode().c_str(), FileOpenFlag::write, FileCreationMode::create_always));
+        luexp(VariantUtils::write_xml(f, suite));
+    }
+    lucatchret;
+    return ok;
+}
+RV run_tests(const TestRunnerDesc& desc, u32& num_failed)
+{
+    lutry
+    {
+        Vector<TestCase> tests;
+        for(const BuiltinTest& builtin : builtin_tests)
+        {
+            TestCase test;
+            test.rom_path = builtin.name;
+            test.builtin_func = builtin.func;
+            tests.push_back(move(test));
+        }
+        usize num_builtin_tests = tests.size();
+        luexp(find_test_roms(desc.rom_dir, tests));
+        log_info("LunaGB", "%u test ROMs found in %s.", (u32)(tests.size() - num_builtin_tests), desc.rom_dir.encode().c_str());
+        u64 begin_ticks = get_ticks();
+        // Run every test ROM in one job.
+        Vector<JobSystem::job_id_t> jobs;
+        jobs.reserve(tests.size());
+        for(TestCase& test : tests)
+        {
+            test.timeout_cycles = desc.timeout_cycles;
+            TestJobParams* params = (TestJobParams*)JobSystem::new_job(run_test_job, sizeof(TestJobParams), alignof(TestJobParams));
+            params->test = &test;
+            jobs.push_back(JobSystem::submit_job(params));
+        }
+        for(JobSystem::job_id_t job : jobs)
+        {
+            JobSystem::wait_job(job);
+        }
+        f64 time = (f64)(get_ticks() - begin_ticks) / get_ticks_per_second();
+        num_failed = 0;
+        for(const TestCase& test : tests)
+        {
+            if(test.result == TestResult::passed)
+            {
+                log_info("LunaGB", "[PASSED] %s", test.rom_path.encode().c_str());
+            }
+            else
+            {
+                log_error("LunaGB", "[%s] %s : %s", get_test_result_name(test.result), test.rom_path.encode().c_str(), test.message.c_str());
+                ++num_failed;
+            }
+        }
+        log_info("LunaGB", "%u/%u tests passed in %f seconds.", (u32)tests.size() - num_failed, (u32)tests.size(), time);
+        if(!desc.json_report_path.empty())
+        {
+            luexp(write_json_report(desc.json_report_path, tests, time));
+        }
+        if(!desc.junit_report_path.empty())
+        {
+            luexp(write_junit_report(desc.junit_report_path, tests, time));
+        }
+    }
+    lucatchret;
+    return ok;
+}
\ No newline at end of file
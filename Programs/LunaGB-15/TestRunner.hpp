@@ -0,0 +1,70 @@
+#pragma once
+#include <Luna/Runtime/Result.hpp>
+#include <Luna/Runtime/Path.hpp>
+#include <Luna/Runtime/String.hpp>
+using namespace Luna;
+
+enum class TestResult : u8
+{
+    passed,
+    failed,
+    //! The test does not finish before the timeout.
+    timeout,
+    //! The ROM cannot be loaded or executed.
+    error
+};
+
+//! One test ROM to run.
+//! The test result is detected by:
+//! 1. Serial output containing "Passed" or "Failed" (blargg test ROMs).
+//! 2. Register values when `LD B, B` is executed (mooneye-gb test ROMs). The test passes if
+//! B, C, D, E, H, L are 3, 5, 8, 13, 21, 34.
+//! 3. The frame hash matching the hash stored in "<rom name>.framehash" file, if such file exists
+//! (acid test ROMs).
+//! Built-in tests that check emulator code without ROMs are also run as test cases.
+struct TestCase
+{
+    //! The test ROM path, or the name of one built-in test.
+    Path rom_path;
+    //! Runs one built-in test instead of one test ROM if not `nullptr`.
+    void (*builtin_func)(TestCase& test) = nullptr;
+    //! The expected frame hash. Only valid if `has_expected_frame_hash` is `true`.
+    u64 expected_frame_hash = 0;
+    bool has_expected_frame_hash = false;
+    //! The maximum number of clock cycles to run.
+    u64 timeout_cycles = 0;
+
+    // Test outputs.
+
+    TestResult result = TestResult::error;
+    String message;
+    //! All data sent through serial port.
+    String serial_output;
+    //! The number of clock cycles executed.
+    u64 cycles = 0;
+    //! The number of frames rendered.
+    u64 frames = 0;
+    //! The hash of the last rendered frame.
+    u64 frame_hash = 0;
+    //! The wall time used to run this test in seconds.
+    f64 time = 0;
+};
+
+struct TestRunnerDesc
+{
+    //! The directory to search test ROMs (*.gb) recursively.
+    Path rom_dir;
+    //! The path to write JSON report. Empty if not needed.
+    Path json_report_path;
+    //! The path to write JUnit XML report. Empty if not needed.
+    Path junit_report_path;
+    //! The maximum number of clock cycles to run for every ROM.
+    u64 timeout_cycles;
+};
+
+//! Runs all built-in tests and all test ROMs in the specified directory concurrently using job system.
+//! @param[in] desc The test runner options.
+//! @param[out] num_failed Returns the number of tests that do not pass.
+RV run_tests(const TestRunnerDesc& desc, u32& num_failed);
+//! Runs one test ROM or built-in test. This is called from job system worker threads.
+void run_test(TestCase& test);
\ No newline at end of file
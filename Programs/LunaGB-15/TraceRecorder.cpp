@@ -0,0 +1,151 @@
+#include "TraceRecorder.hpp"
+#include "Emulator.hpp"
+#include "Cartridge.hpp"
+#include <Luna/Runtime/Log.hpp>
+#include <Luna/Runtime/String.hpp>
+#include <Luna/Runtime/Blob.hpp>
+
+static void write_trace_block(void* userdata, u32 index)
+{
+    TraceRecorder* recorder = (TraceRecorder*)userdata;
+    TraceRecord* block = recorder->records + (usize)(index % recorder->num_blocks) * TRACE_BLOCK_RECORDS;
+    auto r = recorder->file->write(block, sizeof(TraceRecord) * TRACE_BLOCK_RECORDS);
+    if(failed(r))
+    {
+        log_error("LunaGB", "Failed to write CPU trace: %s", explain(r.errcode()));
+    }
+}
+RV TraceRecorder::begin(const c8* path, u32 ring_blocks)
+{
+    lutry
+    {
+        end();
+        luassert(ring_blocks >= 2);
+        luset(file, open_file(path, FileOpenFlag::write, FileCreationMode::create_always));
+        TraceFileHeader header;
+        memcpy(header.magic, "LGBTRACE", 8);
+        header.version = TRACE_FILE_VERSION;
+        header.record_size = sizeof(TraceRecord);
+        luexp(file->write(&header, sizeof(TraceFileHeader)));
+        num_blocks = ring_blocks;
+        records = (TraceRecord*)memalloc(sizeof(TraceRecord) * TRACE_BLOCK_RECORDS * num_blocks, alignof(TraceRecord));
+        write_block = 0;
+        write_offset = 0;
+        num_records = 0;
+        num_flushed_records = 0;
+        luexp(writer.start(num_blocks, write_trace_block, this, "CPU trace writer"));
+    }
+    lucatch
+    {
+        file.reset();
+        if(records)
+        {
+            memfree(records, alignof(TraceRecord));
+            records = nullptr;
+        }
+        num_blocks = 0;
+        return luerr;
+    }
+    return ok;
+}
+void TraceRecorder::end()
+{
+    if(!file) return;
+    writer.stop();
+    // Write the last partial block.
+    if(write_offset)
+    {
+        TraceRecord* block = records + (usize)(write_block % num_blocks) * TRACE_BLOCK_RECORDS;
+        auto r = file->write(block, sizeof(TraceRecord) * write_offset);
+        if(failed(r))
+        {
+            log_error("LunaGB", "Failed to write CPU trace: %s", explain(r.errcode()));
+        }
+    }
+    num_flushed_records = num_records;
+    file.reset();
+    memfree(records, alignof(TraceRecord));
+    records = nullptr;
+    num_blocks = 0;
+    log_info("LunaGB", "CPU trace finished, %llu records written.", num_records);
+}
+void TraceRecorder::record(Emulator* emu)
+{
+    const CPU& cpu = emu->cpu;
+    u8 rom_bank = (cpu.pc >= 0x4000 && cpu.pc <= 0x7FFF) ? (u8)get_cartridge_rom_bank(emu, cpu.pc) : 0;
+    if(cpu.pc < filter.pc_begin || cpu.pc > filter.pc_end) return;
+    if(filter.rom_bank >= 0 && (i32)rom_bank != filter.rom_bank) return;
+    TraceRecord* rec = records + (usize)(write_block % num_blocks) * TRACE_BLOCK_RECORDS + write_offset;
+    rec->clock_cycles = emu->clock_cycles;
+    rec->pc = cpu.pc;
+    rec->sp = cpu.sp;
+    rec->a = cpu.a;
+    rec->f = cpu.f();
+    rec->b = cpu.b;
+    rec->c = cpu.c;
+    rec->d = cpu.d;
+    rec->e = cpu.e;
+    rec->h = cpu.h;
+    rec->l = cpu.l;
+    for(u16 i = 0; i < 4; ++i)
+    {
+        rec->pcmem[i] = emu->peek(cpu.pc + i);
+    }
+    rec->rom_bank = rom_bank;
+    ++num_records;
+    ++write_offset;
+    if(write_offset == TRACE_BLOCK_RECORDS)
+    {
+        commit_block();
+    }
+}
+void TraceRecorder::commit_block()
+{
+    ++write_block;
+    write_offset = 0;
+    writer.commit(write_block);
+    // If the ring is full, wait for the writer thread so that no record is lost.
+    writer.wait_for_slot(write_block);
+    num_flushed_records = (u64)writer.get_flushed() * TRACE_BLOCK_RECORDS;
+}
+RV decode_trace_file(const c8* trace_path, const c8* log_path)
+{
+    lutry
+    {
+        lulet(src, open_file(trace_path, FileOpenFlag::read, FileCreationMode::open_existing));
+        lulet(dst, open_file(log_path, FileOpenFlag::write, FileCreationMode::create_always));
+        TraceFileHeader header;
+        luexp(src->read(&header, sizeof(TraceFileHeader)));
+        if(memcmp(header.magic, "LGBTRACE", 8) || header.version != TRACE_FILE_VERSION || header.record_size != sizeof(TraceRecord))
+        {
+            return set_error(BasicError::bad_data(), "%s is not a valid LunaGB trace file.", trace_path);
+        }
+        Blob buffer(sizeof(TraceRecord) * TRACE_BLOCK_RECORDS, alignof(TraceRecord));
+        const TraceRecord* records = (const TraceRecord*)buffer.data();
+        String text;
+        c8 line[128];
+        u64 num_records = 0;
+        while(true)
+        {
+            usize read_bytes = 0;
+            luexp(src->read(buffer.data(), sizeof(TraceRecord) * TRACE_BLOCK_RECORDS, &read_bytes));
+            usize n = read_bytes / sizeof(TraceRecord);
+            if(!n) break;
+            text.clear();
+            for(usize i = 0; i < n; ++i)
+            {
+                const TraceRecord& r = records[i];
+                snprintf(line, 128, "A:%02X F:%02X B:%02X C:%02X D:%02X E:%02X H:%02X L:%02X SP:%04X PC:%04X PCMEM:%02X,%02X,%02X,%02X\n",
+                    (u32)r.a, (u32)r.f, (u32)r.b, (u32)r.c, (u32)r.d, (u32)r.e, (u32)r.h, (u32)r.l,
+                    (u32)r.sp, (u32)r.pc,
+                    (u32)r.pcmem[0], (u32)r.pcmem[1], (u32)r.pcmem[2], (u32)r.pcmem[3]);
+                text.append(line);
+            }
+            num_records += n;
+            luexp(dst->write(text.c_str(), text.size()));
+        }
+        log_info("LunaGB", "%llu trace records decoded to %s.", num_records, log_path);
+    }
+    lucatchret;
+    return ok;
+}
\ No newline at end of file
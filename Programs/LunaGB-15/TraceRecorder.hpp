@@ -0,0 +1,100 @@
+#pragma once
+#include <Luna/Runtime/Result.hpp>
+#include <Luna/Runtime/File.hpp>
+#include "RingWriter.hpp"
+using namespace Luna;
+
+//! One packed CPU trace record, captured before every executed instruction.
+struct TraceRecord
+{
+    //! The clock cycles counter when the instruction is fetched.
+    u64 clock_cycles;
+    u16 pc;
+    u16 sp;
+    u8 a;
+    u8 f;
+    u8 b;
+    u8 c;
+    u8 d;
+    u8 e;
+    u8 h;
+    u8 l;
+    //! The opcode and the following 3 bytes at PC.
+    u8 pcmem[4];
+    //! The ROM bank that PC is located in. 0 if PC is not in 0x4000~0x7FFF.
+    u8 rom_bank;
+    u8 reserved[7];
+};
+static_assert(sizeof(TraceRecord) == 32, "Wrong trace record size");
+
+//! The header written at the beginning of every trace file.
+struct TraceFileHeader
+{
+    //! Always "LGBTRACE".
+    c8 magic[8];
+    u32 version;
+    //! Always sizeof(TraceRecord).
+    u32 record_size;
+};
+
+constexpr u32 TRACE_FILE_VERSION = 1;
+//! The number of records in one ring block. The ring is handed over to the writer thread
+//! block by block, so shared counters are only touched once per block.
+constexpr u32 TRACE_BLOCK_RECORDS = 4096;
+
+//! Restricts which instructions are recorded.
+struct TraceFilter
+{
+    //! The first PC to record (inclusive).
+    u16 pc_begin = 0x0000;
+    //! The last PC to record (inclusive).
+    u16 pc_end = 0xFFFF;
+    //! The ROM bank to record. -1 records all banks.
+    i32 rom_bank = -1;
+};
+
+struct Emulator;
+struct TraceRecorder
+{
+    TraceFilter filter;
+
+    //! The ring buffer storing `num_blocks * TRACE_BLOCK_RECORDS` records.
+    TraceRecord* records = nullptr;
+    u32 num_blocks = 0;
+
+    // Producer states, only accessed by the emulation thread.
+
+    //! The number of blocks filled by the emulation thread.
+    u32 write_block = 0;
+    //! The number of records written to the current block.
+    u32 write_offset = 0;
+
+    Ref<IFile> file;
+    //! Writes committed blocks to `file`.
+    RingWriter writer;
+
+    //! The number of records captured.
+    u64 num_records = 0;
+    //! The number of records written to the file.
+    u64 num_flushed_records = 0;
+
+    //! Opens the trace file and starts the writer thread.
+    //! @param[in] path The trace file path.
+    //! @param[in] ring_blocks The number of blocks of the ring buffer.
+    RV begin(const c8* path, u32 ring_blocks = 64);
+    //! Flushes all records and closes the trace file.
+    void end();
+    ~TraceRecorder()
+    {
+        end();
+    }
+    bool is_recording() const { return file.valid(); }
+
+    //! Captures the CPU state before executing the next instruction.
+    void record(Emulator* emu);
+    void commit_block();
+};
+
+//! Converts one binary trace file to text log that is compatible with gameboy-doctor.
+//! See https://github.com/robert/gameboy-doctor
+RV decode_trace_file(const c8* trace_path, const c8* log_path);
\ No newline at end of file
@@ -0,0 +1,200 @@
+#include "VRAMViewer.hpp"
+#include <Luna/Runtime/MemoryUtils.hpp>
+
+RV VRAMTexture::init(RHI::IDevice* device, u32 columns, u32 rows)
+{
+    lutry
+    {
+        this->columns = columns;
+        this->rows = rows;
+        luset(texture, device->new_texture(RHI::MemoryType::local,
+            RHI::TextureDesc::tex2d(RHI::Format::rgba8_unorm, RHI::TextureUsageFlag::copy_dest | RHI::TextureUsageFlag::read_texture,
+                columns * 8, rows * 8, 1, 1)));
+        pixels = Blob(get_row_pitch() * rows * 8);
+        memzero(pixels.data(), pixels.size());
+        dirty_begin.resize(rows, 0);
+        dirty_end.resize(rows, 0);
+    }
+    lucatchret;
+    return ok;
+}
+//! Decodes one tile to 8x8 RGBA pixels.
+//! @param[in] data The 16-byte tile data.
+//! @param[in] palette The palette that maps color indices to shades, like BGP.
+static void decode_tile(const u8* data, u8 palette, u8* dst, usize row_pitch)
+{
+    for(u32 line = 0; line < 8; ++line)
+    {
+        u8 lo = data[line * 2];
+        u8 hi = data[line * 2 + 1];
+        u8* dst_line = dst + line * row_pitch;
+        for(u32 x = 0; x < 8; ++x)
+        {
+            u32 bit = 7 - x;
+            u8 color = ((lo >> bit) & 0x01) | (((hi >> bit) & 0x01) << 1);
+            u8 shade = (palette >> (color * 2)) & 0x03;
+            dst_line[x * 4] = PPU_SHADE_COLORS[shade][0];
+            dst_line[x * 4 + 1] = PPU_SHADE_COLORS[shade][1];
+            dst_line[x * 4 + 2] = PPU_SHADE_COLORS[shade][2];
+            dst_line[x * 4 + 3] = 0xFF;
+        }
+    }
+}
+inline bool test_dirty_bit(const u64* bits, u32 block)
+{
+    return (bits[block / 64] & ((u64)1 << (block % 64))) != 0;
+}
+RV VRAMViewer::init(RHI::IDevice* device)
+{
+    lutry
+    {
+        luexp(tiles.init(device, VRAM_TILE_TEXTURE_COLUMNS, VRAM_NUM_TILES / VRAM_TILE_TEXTURE_COLUMNS));
+        for(auto& map : bg_maps)
+        {
+            luexp(map.init(device, VRAM_BG_MAP_TILES, VRAM_BG_MAP_TILES));
+        }
+        // Every texture is decoded and uploaded once initially.
+        memset(tiles_dirty_bits, 0xFF, sizeof(tiles_dirty_bits));
+        memset(bg_maps_dirty_bits, 0xFF, sizeof(bg_maps_dirty_bits));
+        bg_maps_tile_data_area = 0xFFFF;
+        bg_maps_bgp = 0xFFFF;
+        // The upload buffer can hold all region rows of all textures.
+        u64 upload_buffer_size = 0;
+        VRAMTexture* textures[] = { &tiles, &bg_maps[0], &bg_maps[1] };
+        for(VRAMTexture* tex : textures)
+        {
+            u64 size, alignment;
+            device->get_texture_data_placement_info(tex->columns * 8, 8, 1, RHI::Format::rgba8_unorm, &size, &alignment);
+            upload_buffer_size += align_upper(size, alignment) * tex->rows;
+        }
+        luset(upload_buffer, device->new_buffer(RHI::MemoryType::upload, RHI::BufferDesc(RHI::BufferUsageFlag::copy_source, upload_buffer_size)));
+    }
+    lucatchret;
+    return ok;
+}
+void VRAMViewer::fetch_dirty_bits(Emulator* emu)
+{
+    for(usize i = 0; i < VRAM_DIRTY_WORDS; ++i)
+    {
+        tiles_dirty_bits[i] |= emu->vram_dirty_bits[i];
+        bg_maps_dirty_bits[i] |= emu->vram_dirty_bits[i];
+        emu->vram_dirty_bits[i] = 0;
+    }
+}
+void VRAMViewer::update_tiles(Emulator* emu)
+{
+    fetch_dirty_bits(emu);
+    for(u32 i = 0; i < VRAM_NUM_TILES; ++i)
+    {
+        if(!test_dirty_bit(tiles_dirty_bits, i)) continue;
+        u32 x = i % VRAM_TILE_TEXTURE_COLUMNS;
+        u32 y = i / VRAM_TILE_TEXTURE_COLUMNS;
+        // The identity palette.
+        decode_tile(emu->vram + i * 16, 0xE4, tiles.get_region(x, y), tiles.get_row_pitch());
+        tiles.mark_dirty(x, y);
+    }
+    memzero(tiles_dirty_bits, sizeof(tiles_dirty_bits));
+}
+void VRAMViewer::update_bg_maps(Emulator* emu)
+{
+    fetch_dirty_bits(emu);
+    u16 tile_data_area = emu->ppu.bgw_data_area() == 0x8000 ? 1 : 0;
+    u16 bgp = emu->ppu.bgp;
+    // Every entry is redrawn if the tile data area or BGP is changed.
+    bool redraw_all = tile_data_area != bg_maps_tile_data_area || bgp != bg_maps_bgp;
+    for(u32 m = 0; m < 2; ++m)
+    {
+        for(u32 i = 0; i < VRAM_BG_MAP_TILES * VRAM_BG_MAP_TILES; ++i)
+        {
+            u32 map_offset = 0x1800 + m * 0x400 + i;
+            u8 tile_index = emu->vram[map_offset];
+            // Tile 0~127 are at 0x9000~0x97FF if the tile data area is 0x8800~0x97FF.
+            u32 tile = (tile_data_area || tile_index >= 128) ? tile_index : tile_index + 256;
+            if(!redraw_all && !test_dirty_bit(bg_maps_dirty_bits, map_offset / VRAM_DIRTY_BLOCK_SIZE) && !test_dirty_bit(bg_maps_dirty_bits, tile))
+            {
+                continue;
+            }
+            u32 x = i % VRAM_BG_MAP_TILES;
+            u32 y = i / VRAM_BG_MAP_TILES;
+            decode_tile(emu->vram + tile * 16, (u8)bgp, bg_maps[m].get_region(x, y), bg_maps[m].get_row_pitch());
+            bg_maps[m].mark_dirty(x, y);
+        }
+    }
+    memzero(bg_maps_dirty_bits, sizeof(bg_maps_dirty_bits));
+    bg_maps_tile_data_area = tile_data_area;
+    bg_maps_bgp = bgp;
+}
+//! The location of one changed region row in the upload buffer.
+struct VRAMUploadPlacement
+{
+    VRAMTexture* texture;
+    u32 row;
+    u64 offset;
+    u64 row_pitch;
+    u64 slice_pitch;
+};
+RV VRAMViewer::upload(RHI::ICommandBuffer* cmdbuf)
+{
+    lutry
+    {
+        auto device = cmdbuf->get_device();
+        VRAMTexture* textures[] = { &tiles, &bg_maps[0], &bg_maps[1] };
+        Vector<VRAMUploadPlacement> placements;
+        Vector<RHI::TextureBarrier> barriers;
+        u64 upload_size = 0;
+        for(VRAMTexture* tex : textures)
+        {
+            bool changed = false;
+            for(u32 y = 0; y < tex->rows; ++y)
+            {
+                if(tex->dirty_begin[y] >= tex->dirty_end[y]) continue;
+                u64 size, alignment;
+                VRAMUploadPlacement placement;
+                placement.texture = tex;
+                placement.row = y;
+                device->get_texture_data_placement_info((tex->dirty_end[y] - tex->dirty_begin[y]) * 8, 8, 1, RHI::Format::rgba8_unorm,
+                    &size, &alignment, &placement.row_pitch, &placement.slice_pitch);
+                placement.offset = align_upper(upload_size, alignment);
+                upload_size = placement.offset + size;
+                placements.push_back(placement);
+                changed = true;
+            }
+            if(changed)
+            {
+                barriers.emplace_back(tex->texture, RHI::SubresourceIndex(0, 0), RHI::TextureStateFlag::automatic, RHI::TextureStateFlag::copy_dest);
+            }
+        }
+        if(placements.empty()) return ok;
+        luassert(upload_size <= upload_buffer->get_desc().size);
+        u8* upload_data;
+        luexp(upload_buffer->map(0, 0, (void**)&upload_data));
+        for(auto& p : placements)
+        {
+            VRAMTexture* tex = p.texture;
+            u32 begin = tex->dirty_begin[p.row];
+            u32 end = tex->dirty_end[p.row];
+            memcpy_bitmap(upload_data + p.offset, tex->get_region(begin, p.row), (end - begin) * 8 * 4, 8,
+                (usize)p.row_pitch, tex->get_row_pitch());
+        }
+        upload_buffer->unmap(0, USIZE_MAX);
+        cmdbuf->begin_copy_pass();
+        cmdbuf->resource_barrier({}, {barriers.data(), barriers.size()});
+        for(auto& p : placements)
+        {
+            VRAMTexture* tex = p.texture;
+            u32 begin = tex->dirty_begin[p.row];
+            u32 end = tex->dirty_end[p.row];
+            cmdbuf->copy_buffer_to_texture(tex->texture, RHI::SubresourceIndex(0, 0), begin * 8, p.row * 8, 0,
+                upload_buffer, p.offset, (u32)p.row_pitch, (u32)p.slice_pitch, (end - begin) * 8, 8, 1);
+            tex->dirty_end[p.row] = 0;
+            tex->dirty_begin[p.row] = 0;
+        }
+        cmdbuf->end_copy_pass();
+        // Waits for the copy, so that the upload buffer can be reused in the next frame.
+        luexp(cmdbuf->submit({}, {}, true));
+        cmdbuf->wait();
+        luexp(cmdbuf->reset());
+    }
+    lucatchret;
+    return ok;
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+#include <Luna/RHI/Device.hpp>
+#include <Luna/Runtime/Blob.hpp>
+#include <Luna/Runtime/Vector.hpp>
+#include "Emulator.hpp"
+using namespace Luna;
+
+//! The number of tiles in VRAM.
+constexpr u32 VRAM_NUM_TILES = 384;
+//! The number of tiles in one row of the tile texture.
+constexpr u32 VRAM_TILE_TEXTURE_COLUMNS = 16;
+//! The number of tiles in one row or column of one background map.
+constexpr u32 VRAM_BG_MAP_TILES = 32;
+
+//! One texture of VRAM viewers, whose host copy is updated in 8x8 regions.
+struct VRAMTexture
+{
+    Ref<RHI::ITexture> texture;
+    //! The RGBA pixels of the texture.
+    Blob pixels;
+    //! The number of 8x8 regions in one row and one column.
+    u32 columns = 0;
+    u32 rows = 0;
+    //! The first and the last changed regions of every region row that are not uploaded, or
+    //! `dirty_begin >= dirty_end` if no region of the row is changed.
+    Vector<u32> dirty_begin;
+    Vector<u32> dirty_end;
+
+    RV init(RHI::IDevice* device, u32 columns, u32 rows);
+    //! Gets the top-left pixel of one region.
+    u8* get_region(u32 x, u32 y)
+    {
+        return pixels.data() + ((usize)y * 8 * columns * 8 + x * 8) * 4;
+    }
+    usize get_row_pitch() const
+    {
+        return (usize)columns * 8 * 4;
+    }
+    //! Marks one region as changed.
+    void mark_dirty(u32 x, u32 y)
+    {
+        if(dirty_begin[y] >= dirty_end[y])
+        {
+            dirty_begin[y] = x;
+            dirty_end[y] = x + 1;
+        }
+        else
+        {
+            dirty_begin[y] = min(dirty_begin[y], x);
+            dirty_end[y] = max(dirty_end[y], x + 1);
+        }
+    }
+};
+
+//! Decodes VRAM tiles and background maps to textures for the debug window.
+//! Only tiles and map entries whose VRAM blocks are marked in `Emulator::vram_dirty_bits` are
+//! decoded, and only changed regions are uploaded through one persistent upload buffer.
+struct VRAMViewer
+{
+    //! All tiles, `VRAM_TILE_TEXTURE_COLUMNS` tiles per row, drawn with the identity palette.
+    VRAMTexture tiles;
+    //! The background maps at 0x9800 and 0x9C00, drawn with BGP and the tile data area selected by LCDC.
+    VRAMTexture bg_maps[2];
+    //! Dirty bits of `Emulator::vram_dirty_bits` not applied to `tiles` and `bg_maps`.
+    u64 tiles_dirty_bits[VRAM_DIRTY_WORDS];
+    u64 bg_maps_dirty_bits[VRAM_DIRTY_WORDS];
+    //! The tile data area and BGP used to draw `bg_maps`, 0xFFFF if `bg_maps` are not drawn.
+    u16 bg_maps_tile_data_area = 0xFFFF;
+    u16 bg_maps_bgp = 0xFFFF;
+    //! The buffer used to upload changed regions of all textures.
+    Ref<RHI::IBuffer> upload_buffer;
+
+    RV init(RHI::IDevice* device);
+    //! Decodes changed tiles to `tiles`.
+    void update_tiles(Emulator* emu);
+    //! Decodes changed map entries to `bg_maps`.
+    void update_bg_maps(Emulator* emu);
+    //! Uploads changed regions of all textures.
+    RV upload(RHI::ICommandBuffer* cmdbuf);
+    //! Moves dirty bits from the emulator to `tiles_dirty_bits` and `bg_maps_dirty_bits`.
+    void fetch_dirty_bits(Emulator* emu);
+};
\ No newline at end of file
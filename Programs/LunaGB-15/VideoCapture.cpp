@@ -0,0 +1,257 @@
+#include "VideoCapture.hpp"
+#include <Luna/Runtime/Log.hpp>
+#include <Luna/Runtime/Blob.hpp>
+#include <Luna/Image/Image.hpp>
+
+//! Gets the shade index of one pixel. Shades are told apart by the red channel, pixels not
+//! drawn by PPU yet are mapped to the nearest shade.
+inline u8 get_shade_index(const u8* pixel)
+{
+    u8 r = pixel[0];
+    if(r >= (PPU_SHADE_COLORS[0][0] + PPU_SHADE_COLORS[1][0]) / 2) return 0;
+    if(r >= (PPU_SHADE_COLORS[1][0] + PPU_SHADE_COLORS[2][0]) / 2) return 1;
+    if(r >= (PPU_SHADE_COLORS[2][0] + PPU_SHADE_COLORS[3][0]) / 2) return 2;
+    return 3;
+}
+static void pack_frame(const u8* pixels, u8* dst)
+{
+    for(usize i = 0; i < VIDEO_PACKED_FRAME_SIZE; ++i)
+    {
+        const u8* p = pixels + i * 16;
+        dst[i] = get_shade_index(p) | (get_shade_index(p + 4) << 2) | (get_shade_index(p + 8) << 4) | (get_shade_index(p + 12) << 6);
+    }
+}
+static void unpack_frame(const u8* src, u8* pixels)
+{
+    for(usize i = 0; i < PPU_XRES * PPU_YRES; ++i)
+    {
+        u8 shade = (src[i / 4] >> ((i % 4) * 2)) & 0x03;
+        u8* p = pixels + i * 4;
+        p[0] = PPU_SHADE_COLORS[shade][0];
+        p[1] = PPU_SHADE_COLORS[shade][1];
+        p[2] = PPU_SHADE_COLORS[shade][2];
+        p[3] = 255;
+    }
+}
+//! Encodes the XOR of two packed frames. The encoded data is one sequence of runs, each starting
+//! with one control byte `c`: if `c < 0x80`, `c + 1` literal bytes follow; otherwise, the next
+//! `c - 0x7F` bytes are unchanged.
+static void encode_frame_delta(const u8* frame, const u8* last_frame, Vector<u8>& out)
+{
+    out.clear();
+    usize i = 0;
+    while(i < VIDEO_PACKED_FRAME_SIZE)
+    {
+        usize run = 0;
+        while(i + run < VIDEO_PACKED_FRAME_SIZE && run < 128 && frame[i + run] == last_frame[i + run]) ++run;
+        if(run)
+        {
+            out.push_back((u8)(0x7F + run));
+            i += run;
+            continue;
+        }
+        // Literal bytes end at the first unchanged byte pair, so single unchanged bytes do not split runs.
+        while(i + run < VIDEO_PACKED_FRAME_SIZE && run < 128 &&
+            !(i + run + 1 < VIDEO_PACKED_FRAME_SIZE && frame[i + run] == last_frame[i + run] && frame[i + run + 1] == last_frame[i + run + 1])) ++run;
+        out.push_back((u8)(run - 1));
+        for(usize j = 0; j < run; ++j)
+        {
+            out.push_back(frame[i + j] ^ last_frame[i + j]);
+        }
+        i += run;
+    }
+}
+static bool decode_frame_delta(const u8* data, usize size, u8* frame)
+{
+    usize i = 0;
+    usize src = 0;
+    while(src < size)
+    {
+        u8 c = data[src++];
+        if(c >= 0x80)
+        {
+            i += c - 0x7F;
+            if(i > VIDEO_PACKED_FRAME_SIZE) return false;
+            continue;
+        }
+        usize run = (usize)c + 1;
+        if(i + run > VIDEO_PACKED_FRAME_SIZE || src + run > size) return false;
+        for(usize j = 0; j < run; ++j)
+        {
+            frame[i + j] ^= data[src + j];
+        }
+        i += run;
+        src += run;
+    }
+    return i == VIDEO_PACKED_FRAME_SIZE;
+}
+static RV write_png(const c8* path, const u8* pixels)
+{
+    lutry
+    {
+        lulet(f, open_file(path, FileOpenFlag::write, FileCreationMode::create_always));
+        Image::ImageDesc desc;
+        desc.format = Image::ImageFormat::rgba8_unorm;
+        desc.width = PPU_XRES;
+        desc.height = PPU_YRES;
+        Blob data(pixels, VIDEO_FRAME_SIZE);
+        luexp(Image::write_png_file(f.get(), desc, data));
+    }
+    lucatchret;
+    return ok;
+}
+static void write_video_frame(void* userdata, u32 index)
+{
+    VideoCapture* capture = (VideoCapture*)userdata;
+    u32 slot = index % capture->num_buffers;
+    auto r = capture->write_frame_data(capture->frames + (usize)slot * VIDEO_FRAME_SIZE, capture->frame_indices[slot]);
+    if(failed(r))
+    {
+        log_error("LunaGB", "Failed to write video frame: %s", explain(r.errcode()));
+    }
+}
+RV VideoCapture::begin(const c8* path, VideoCaptureFormat format, u32 pool_frames)
+{
+    lutry
+    {
+        end();
+        luassert(pool_frames >= 2);
+        this->path = path;
+        this->format = format;
+        if(format == VideoCaptureFormat::lgbvideo)
+        {
+            luset(file, open_file(path, FileOpenFlag::write, FileCreationMode::create_always));
+            VideoFileHeader header;
+            memcpy(header.magic, "LGBVIDEO", 8);
+            header.version = VIDEO_FILE_VERSION;
+            header.width = PPU_XRES;
+            header.height = PPU_YRES;
+            luexp(file->write(&header, sizeof(VideoFileHeader)));
+        }
+        num_buffers = pool_frames;
+        frames = (u8*)memalloc(VIDEO_FRAME_SIZE * num_buffers);
+        frame_indices = (u32*)memalloc(sizeof(u32) * num_buffers);
+        write_frame = 0;
+        num_frames = 0;
+        num_dropped_frames = 0;
+        memzero(last_packed_frame, sizeof(last_packed_frame));
+        encoded.reserve(VIDEO_PACKED_FRAME_SIZE * 2);
+        luexp(writer.start(num_buffers, write_video_frame, this, "Video capture writer"));
+    }
+    lucatch
+    {
+        file.reset();
+        memfree(frames);
+        frames = nullptr;
+        memfree(frame_indices);
+        frame_indices = nullptr;
+        num_buffers = 0;
+        return luerr;
+    }
+    return ok;
+}
+void VideoCapture::end()
+{
+    if(!writer.is_running()) return;
+    writer.stop();
+    file.reset();
+    memfree(frames);
+    frames = nullptr;
+    memfree(frame_indices);
+    frame_indices = nullptr;
+    num_buffers = 0;
+    log_info("LunaGB", "Video capture finished, %u frames written, %u frames dropped.", num_frames - num_dropped_frames, num_dropped_frames);
+}
+void VideoCapture::on_frame(const u8* pixels)
+{
+    u32 frame_index = num_frames++;
+    if(writer.is_full(write_frame))
+    {
+        // The writer thread cannot keep up, drop this frame instead of waiting.
+        ++num_dropped_frames;
+        return;
+    }
+    u32 slot = write_frame % num_buffers;
+    memcpy(frames + (usize)slot * VIDEO_FRAME_SIZE, pixels, VIDEO_FRAME_SIZE);
+    frame_indices[slot] = frame_index;
+    ++write_frame;
+    writer.commit(write_frame);
+}
+RV VideoCapture::write_frame_data(const u8* pixels, u32 frame_index)
+{
+    lutry
+    {
+        if(format == VideoCaptureFormat::png)
+        {
+            c8 name[32];
+            snprintf(name, 32, "_%06u.png", frame_index);
+            String file_path = path;
+            file_path.append(name);
+            luexp(write_png(file_path.c_str(), pixels));
+        }
+        else
+        {
+            pack_frame(pixels, packed_frame);
+            encode_frame_delta(packed_frame, last_packed_frame, encoded);
+            memcpy(last_packed_frame, packed_frame, VIDEO_PACKED_FRAME_SIZE);
+            VideoFrameHeader header;
+            header.frame_index = frame_index;
+            header.size = (u32)encoded.size();
+            luexp(file->write(&header, sizeof(VideoFrameHeader)));
+            luexp(file->write(encoded.data(), encoded.size()));
+        }
+    }
+    lucatchret;
+    return ok;
+}
+RV save_screenshot(const c8* path, const u8* pixels)
+{
+    lutry
+    {
+        luexp(write_png(path, pixels));
+        log_info("LunaGB", "Screenshot saved to %s.", path);
+    }
+    lucatchret;
+    return ok;
+}
+RV decode_video_file(const c8* video_path, const c8* output_prefix)
+{
+    lutry
+    {
+        lulet(src, open_file(video_path, FileOpenFlag::read, FileCreationMode::open_existing));
+        VideoFileHeader header;
+        luexp(src->read(&header, sizeof(VideoFileHeader)));
+        if(memcmp(header.magic, "LGBVIDEO", 8) || header.version != VIDEO_FILE_VERSION || header.width != PPU_XRES || header.height != PPU_YRES)
+        {
+            return set_error(BasicError::bad_data(), "%s is not a valid LunaGB video file.", video_path);
+        }
+        u8 frame[VIDEO_PACKED_FRAME_SIZE];
+        memzero(frame, sizeof(frame));
+        Vector<u8> data;
+        Blob pixels(VIDEO_FRAME_SIZE);
+        c8 name[32];
+        u32 num_frames = 0;
+        while(true)
+        {
+            VideoFrameHeader frame_header;
+            usize read_bytes = 0;
+            luexp(src->read(&frame_header, sizeof(VideoFrameHeader), &read_bytes));
+            if(read_bytes < sizeof(VideoFrameHeader)) break;
+            data.resize(frame_header.size);
+            luexp(src->read(data.data(), data.size(), &read_bytes));
+            if(read_bytes != data.size() || !decode_frame_delta(data.data(), data.size(), frame))
+            {
+                return set_error(BasicError::bad_data(), "Frame %u of %s is corrupted.", frame_header.frame_index, video_path);
+            }
+            unpack_frame(frame, pixels.data());
+            snprintf(name, 32, "_%06u.png", frame_header.frame_index);
+            String file_path(output_prefix);
+            file_path.append(name);
+            luexp(write_png(file_path.c_str(), pixels.data()));
+            ++num_frames;
+        }
+        log_info("LunaGB", "%u frames decoded from %s.", num_frames, video_path);
+    }
+    lucatchret;
+    return ok;
+}
\ No newline at end of file
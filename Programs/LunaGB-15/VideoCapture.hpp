@@ -0,0 +1,107 @@
+#pragma once
+#include <Luna/Runtime/Result.hpp>
+#include <Luna/Runtime/File.hpp>
+#include <Luna/Runtime/String.hpp>
+#include <Luna/Runtime/Vector.hpp>
+#include "PPU.hpp"
+#include "RingWriter.hpp"
+using namespace Luna;
+
+enum class VideoCaptureFormat : u8
+{
+    //! One PNG file per frame, named `<path>_<frame index>.png`.
+    png,
+    //! One LunaGB video file. Every frame is stored as 2-bit shade indices and compressed
+    //! against the previous frame. Use `decode_video_file` to convert it to PNG files.
+    lgbvideo,
+};
+
+//! The header written at the beginning of every LunaGB video file.
+struct VideoFileHeader
+{
+    //! Always "LGBVIDEO".
+    c8 magic[8];
+    u32 version;
+    u16 width;
+    u16 height;
+};
+
+//! The header written before every frame in one LunaGB video file.
+struct VideoFrameHeader
+{
+    //! The index of the frame since the capture is started. Indices of frames dropped by the
+    //! capture are skipped.
+    u32 frame_index;
+    //! The size of the compressed frame data following this header.
+    u32 size;
+};
+
+constexpr u32 VIDEO_FILE_VERSION = 1;
+//! The size of one captured RGBA frame.
+constexpr usize VIDEO_FRAME_SIZE = PPU_XRES * PPU_YRES * 4;
+//! The size of one frame stored as 2-bit shade indices.
+constexpr usize VIDEO_PACKED_FRAME_SIZE = PPU_XRES * PPU_YRES / 4;
+
+//! Captures frames produced by PPU and writes them on one background thread.
+//! Finished frames are copied into one fixed pool of frame buffers, then encoded and written
+//! by the writer thread. The emulation thread never waits for the writer thread: if all
+//! buffers are in use, the frame is dropped.
+struct VideoCapture
+{
+    VideoCaptureFormat format = VideoCaptureFormat::lgbvideo;
+    //! The video file path, or the path prefix of PNG files.
+    String path;
+
+    //! The pool storing `num_buffers` RGBA frames.
+    u8* frames = nullptr;
+    //! The capture index of every frame in the pool.
+    u32* frame_indices = nullptr;
+    u32 num_buffers = 0;
+
+    // Producer states, only accessed by the emulation thread.
+
+    //! The number of frames copied to the pool.
+    u32 write_frame = 0;
+    //! The number of frames produced since the capture is started, including dropped frames.
+    u32 num_frames = 0;
+    //! The number of frames dropped because the pool is full.
+    u32 num_dropped_frames = 0;
+
+    //! Encodes and writes committed frames.
+    RingWriter writer;
+
+    // Writer states, only accessed by the writer thread.
+
+    Ref<IFile> file;
+    //! The last frame written, as 2-bit shade indices.
+    u8 last_packed_frame[VIDEO_PACKED_FRAME_SIZE];
+    //! The frame being written, as 2-bit shade indices.
+    u8 packed_frame[VIDEO_PACKED_FRAME_SIZE];
+    //! The encoding buffer.
+    Vector<u8> encoded;
+
+    //! Starts capturing and starts the writer thread.
+    //! @param[in] path The video file path, or the path prefix of PNG files.
+    //! @param[in] pool_frames The number of frame buffers. At most this number of frames are
+    //! waiting to be written at the same time.
+    RV begin(const c8* path, VideoCaptureFormat format, u32 pool_frames = 16);
+    //! Writes all captured frames and stops capturing.
+    void end();
+    ~VideoCapture()
+    {
+        end();
+    }
+    bool is_capturing() const { return writer.is_running(); }
+
+    //! Captures one finished frame. Called by PPU at the start of VBlank.
+    void on_frame(const u8* pixels);
+
+    //! Encodes and writes one frame. Called by the writer thread.
+    RV write_frame_data(const u8* pixels, u32 frame_index);
+};
+
+//! Saves one RGBA frame to one PNG file.
+RV save_screenshot(const c8* path, const u8* pixels);
+
+//! Converts one LunaGB video file to PNG files named `<output prefix>_<frame index>.png`.
+RV decode_video_file(const c8* video_path, const c8* output_prefix);
\ No newline at end of file
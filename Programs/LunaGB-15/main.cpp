@@ -2,40 +2,222 @@
 #include <Luna/Runtime/Runtime.hpp>
 #include <Luna/Runtime/Module.hpp>
 #include <Luna/Runtime/Log.hpp>
+#include <Luna/Runtime/StringUtils.hpp>
+#include <Luna/Runtime/File.hpp>
+#include <Luna/Runtime/Time.hpp>
+#include <cstdlib>
 
 // For module interfaces.
 #include <Luna/Window/Window.hpp>
 #include <Luna/RHI/RHI.hpp>
 #include <Luna/AHI/AHI.hpp>
 #include <Luna/ImGui/ImGui.hpp>
+#include <Luna/JobSystem/JobSystem.hpp>
+#include <Luna/VariantUtils/VariantUtils.hpp>
+#include <Luna/Network/Network.hpp>
+#include <Luna/Image/Image.hpp>
+#include <Luna/ShaderCompiler/ShaderCompiler.hpp>
+
+#include "TestRunner.hpp"
+#include "RomCache.hpp"
+#include "Environment.hpp"
+#include "Link.hpp"
 
 App* g_app;
 
-RV run_app()
+//! Gets the per-user directory to cache compiled shaders, or the directory next to the executable if
+//! the per-user cache directory is not known. Parent directories are created if they do not exist.
+static Path get_shader_cache_dir()
+{
+    Path path;
+#if defined(LUNA_PLATFORM_WINDOWS)
+    const c8* local_app_data = getenv("LOCALAPPDATA");
+    if(local_app_data && *local_app_data) path = local_app_data;
+#else
+    const c8* xdg_cache_home = getenv("XDG_CACHE_HOME");
+    const c8* home = getenv("HOME");
+    if(xdg_cache_home && *xdg_cache_home)
+    {
+        path = xdg_cache_home;
+    }
+    else if(home && *home)
+    {
+        path = home;
+#if defined(LUNA_PLATFORM_MACOS)
+        path.push_back("Library");
+        path.push_back("Caches");
+#else
+        path.push_back(".cache");
+#endif
+    }
+#endif
+    if(path.empty())
+    {
+        path = get_process_path();
+        path.pop_back();
+    }
+    else
+    {
+        // Errors are ignored if the directories already exist.
+        auto _ = create_dir(path.encode().c_str());
+        path.push_back("LunaGB");
+        _ = create_dir(path.encode().c_str());
+    }
+    path.push_back("ShaderCache");
+    return path;
+}
+
+//! Logs the initialization time of every module and the application, measured from `startup_ticks`.
+static void log_startup_report(u64 startup_ticks, u64 app_init_begin_ticks, u64 app_init_end_ticks)
+{
+    f64 ms_per_tick = 1000.0 / get_ticks_per_second();
+    log_info("LunaGB", "Startup report (milliseconds since the runtime is initialized):");
+    log_info("LunaGB", "%-16s %10s %10s  %s", "Step", "Begin", "Duration", "Thread");
+    for(auto& t : get_module_init_times())
+    {
+        log_info("LunaGB", "%-16s %10.2f %10.2f  %s", t.module->get_name(), (t.begin_ticks - startup_ticks) * ms_per_tick,
+            (t.end_ticks - t.begin_ticks) * ms_per_tick, t.on_worker_thread ? "worker" : "main");
+    }
+    log_info("LunaGB", "%-16s %10.2f %10.2f  %s", "App::init", (app_init_begin_ticks - startup_ticks) * ms_per_tick,
+        (app_init_end_ticks - app_init_begin_ticks) * ms_per_tick, "main");
+    log_info("LunaGB", "Total: %.2f", (app_init_end_ticks - startup_ticks) * ms_per_tick);
+}
+
+RV run_app(u64 startup_ticks, bool startup_report)
 {
     lutry
     {
         // Add modules.
-        luexp(add_modules({module_window(), module_rhi(), module_ahi(), module_imgui()}));
+        luexp(add_modules({module_window(), module_rhi(), module_ahi(), module_imgui(), module_network(), module_image(), module_rom_cache()}));
+        // Compiled shaders are cached in the per-user cache directory, so that only the first launch compiles
+        // shaders. This must be set before ImGui compiles its shaders in `init_modules`.
+        ShaderCompiler::set_cache_dir(get_shader_cache_dir());
         // Initialize modules.
         luexp(init_modules());
         // Run the application.
+        u64 app_init_begin_ticks = get_ticks();
         luexp(g_app->init());
+        if(startup_report)
+        {
+            log_startup_report(startup_ticks, app_init_begin_ticks, get_ticks());
+        }
         while(!g_app->is_exiting)
         {
             luexp(g_app->update());
+            // Reports messages suppressed by rate-limited logs that have not been logged since.
+            flush_suppressed_logs();
         }
     }
     lucatchret;
     return ok;
 }
 
-int main()
+RV run_command(int argc, c8* argv[])
+{
+    // Command-line tools do not need window, graphics and audio modules.
+    RV r = add_modules({module_job_system(), module_variant_utils(), module_image(), module_rom_cache()});
+    if(succeeded(r)) r = init_modules();
+    if(failed(r)) return r;
+    if(!strcmp(argv[1], "decode-trace"))
+    {
+        if(argc < 4)
+        {
+            return set_error(BasicError::bad_arguments(), "Usage: %s decode-trace <trace file> <log file>", argv[0]);
+        }
+        return decode_trace_file(argv[2], argv[3]);
+    }
+    if(!strcmp(argv[1], "replay-movie"))
+    {
+        if(argc < 4)
+        {
+            return set_error(BasicError::bad_arguments(), "Usage: %s replay-movie <ROM file> <movie file>", argv[0]);
+        }
+        return replay_movie(argv[2], argv[3]);
+    }
+    if(!strcmp(argv[1], "decode-video"))
+    {
+        if(argc < 4)
+        {
+            return set_error(BasicError::bad_arguments(), "Usage: %s decode-video <video file> <output prefix>", argv[0]);
+        }
+        return decode_video_file(argv[2], argv[3]);
+    }
+    if(!strcmp(argv[1], "link"))
+    {
+        if(argc < 4)
+        {
+            return set_error(BasicError::bad_arguments(), "Usage: %s link <ROM file A> <ROM file B> [seconds]", argv[0]);
+        }
+        f64 seconds = argc > 4 ? strtod(argv[4], nullptr) : 60.0;
+        return run_linked_emulators(argv[2], argv[3], seconds);
+    }
+    if(!strcmp(argv[1], "bench-env"))
+    {
+        if(argc < 3)
+        {
+            return set_error(BasicError::bad_arguments(), "Usage: %s bench-env <ROM file> [instances] [steps]", argv[0]);
+        }
+        u32 num_instances = argc > 3 ? (u32)strtou64(argv[3], nullptr, 10) : 256;
+        u32 num_steps = argc > 4 ? (u32)strtou64(argv[4], nullptr, 10) : 600;
+        return benchmark_environment(argv[2], num_instances, num_steps);
+    }
+    if(!strcmp(argv[1], "test"))
+    {
+        if(argc < 3)
+        {
+            return set_error(BasicError::bad_arguments(), "Usage: %s test <ROM directory> [--json <report file>] [--junit <report file>] [--timeout <cycles>]", argv[0]);
+        }
+        TestRunnerDesc desc;
+        desc.rom_dir = argv[2];
+        // Run every ROM for at most 2 minutes of emulated time by default.
+        desc.timeout_cycles = CLOCK_FREQUENCY * 120;
+        for(int i = 3; i + 1 < argc; i += 2)
+        {
+            if(!strcmp(argv[i], "--json")) desc.json_report_path = argv[i + 1];
+            else if(!strcmp(argv[i], "--junit")) desc.junit_report_path = argv[i + 1];
+            else if(!strcmp(argv[i], "--timeout")) desc.timeout_cycles = strtou64(argv[i + 1], nullptr, 10);
+            else return set_error(BasicError::bad_arguments(), "Unknown option: %s", argv[i]);
+        }
+        lutry
+        {
+            u32 num_failed = 0;
+            luexp(run_tests(desc, num_failed));
+            if(num_failed)
+            {
+                return set_error(BasicError::failure(), "%u tests failed.", num_failed);
+            }
+        }
+        lucatchret;
+        return ok;
+    }
+    return set_error(BasicError::bad_arguments(), "Unknown command: %s", argv[1]);
+}
+
+int main(int argc, c8* argv[])
 {
     bool inited = Luna::init();
     if(!inited) return -1;
+    u64 startup_ticks = get_ticks();
+    // `--startup-report` runs the application and logs the time spent on every startup step.
+    bool startup_report = argc == 2 && !strcmp(argv[1], "--startup-report");
+    if(argc > 1 && !startup_report)
+    {
+        // Run command-line tools without creating the window.
+        set_log_to_platform_enabled(true);
+        RV r = run_command(argc, argv);
+        if(failed(r))
+        {
+            log_error("LunaGB", explain(r.errcode()));
+        }
+        Luna::close();
+        return failed(r) ? -1 : 0;
+    }
+    if(startup_report)
+    {
+        set_log_to_platform_enabled(true);
+    }
     g_app = memnew<App>();
-    RV r = run_app();
+    RV r = run_app(startup_ticks, startup_report);
     if(failed(r))
     {
         log_error("LunaGB", explain(r.errcode()));
@@ -2,5 +2,5 @@ target("LunaGB-15")
     set_luna_sdk_program()
     add_headerfiles("**.hpp")
     add_files("**.cpp")
-    add_deps("Runtime", "Window", "RHI", "ShaderCompiler", "ImGui", "HID", "AHI")
+    add_deps("Runtime", "Window", "RHI", "ShaderCompiler", "ImGui", "HID", "AHI", "JobSystem", "VariantUtils", "Network", "Image")
 target_end()
\ No newline at end of file